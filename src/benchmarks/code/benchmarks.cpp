@@ -0,0 +1,893 @@
+#include "benchmarks.h"
+#include "map.h"
+#include "map_graph.h"
+#include "routing.h"
+#include "edge_weights.h"
+#include "route_repair.h"
+#include "route_alternatives.h"
+#include "pareto_routes.h"
+#include "isochrone.h"
+#include "schedules.h"
+#include "projection.h"
+#include "node_order.h"
+#include "string_interner.h"
+#include "image_cache.h"
+#include "raster_import.h"
+#include "map_import.h"
+#include "campus_generator.h"
+#include <stdio.h>
+#include <time.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <malloc.h>
+#include <png.h>
+
+//side length of the grid maps searched by the benchmarks
+#define BENCHMARK_GRID_SIDE 200
+
+//how many queries every benchmark runs
+#define BENCHMARK_N_QUERIES 100
+
+//multi-criteria searches are run on a grid about the size of a whole campus map
+#define PARETO_BENCHMARK_GRID_SIDE 60
+
+//how many budgets every isochrone is grown through
+#define ISOCHRONE_BENCHMARK_N_BUDGETS 10
+
+//rooms in the map whose names and pictures are interned
+#define STRINGS_BENCHMARK_N_NODES 100000
+
+//node pictures along the path of the image cache benchmark, each the size of a phone photo
+#define IMAGES_BENCHMARK_N_PICTURES 24
+#define IMAGES_BENCHMARK_PICTURE_WIDTH 2000
+#define IMAGES_BENCHMARK_PICTURE_HEIGHT 1500
+
+//side of the aerial picture the raster importer benchmark traces, with a path every RASTER_BENCHMARK_PATH_SPACING pixels
+#define RASTER_BENCHMARK_SIDE 4096
+#define RASTER_BENCHMARK_PATH_SPACING 128
+
+//side of the grid of footways written to the files the map importer benchmark reads
+#define IMPORT_BENCHMARK_GRID_SIDE 700
+
+//sizes in nodes of the generated campuses, each ten times the one before
+#define CAMPUS_BENCHMARK_MIN_NODES 1000
+#define CAMPUS_BENCHMARK_MAX_NODES 1000000
+
+int main(){
+	cost_profile_benchmark();
+	edge_weights_benchmark();
+	route_repair_benchmark();
+	route_alternatives_benchmark();
+	pareto_routes_benchmark();
+	isochrone_benchmark();
+	schedules_benchmark();
+	projection_benchmark();
+	node_order_benchmark();
+	hot_nodes_benchmark();
+	string_interner_benchmark();
+	image_cache_benchmark();
+	raster_import_benchmark();
+	map_import_benchmark();
+	campus_generator_benchmark();
+	fputs("End of benchmarks\n",stdout);
+}
+
+double get_benchmark_time(void){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return (double) now.tv_sec + ((double) now.tv_nsec)*1e-9;
+}
+
+/*
+ * A side by side grid of nodes about 10 meters apart. The edge types cycle so every
+ * profile has both cheap, expensive and impassable edges to deal with.
+ */
+static void build_grid_map(map_t * map,size_t side){
+	const uint8_t edge_types[6] = {EDGE_TYPE_SIDEWALK,EDGE_TYPE_ROAD,EDGE_TYPE_STAIRS,EDGE_TYPE_RAMP,EDGE_TYPE_SIDEWALK,EDGE_TYPE_CROSSWALK};
+	
+	for(size_t y = 0;y < side;y++){
+		for(size_t x = 0;x < side;x++){
+			add_node_to_map(map,create_map_node(create_cord(-76.7130 + x*0.0001,39.2550 + y*0.0001)));
+		}
+	}
+	
+	for(size_t y = 0;y < side;y++){
+		for(size_t x = 0;x < side;x++){
+			size_t index = y*side + x;
+			if(x+1 < side) connect_nodes_in_map_by_indices(map,index,index+1,edge_types[(x+y)%6]);
+			if(y+1 < side) connect_nodes_in_map_by_indices(map,index,index+side,edge_types[(x+2*y)%6]);
+		}
+	}
+}
+
+//The same pseudo random queries on every run so timings can be compared.
+static uint32_t next_benchmark_random(uint32_t * state){
+	*state = (*state)*1664525u + 1013904223u;
+	return (*state) >> 8;
+}
+
+void cost_profile_benchmark(){
+	map_t map = init_map();
+	build_grid_map(&map,BENCHMARK_GRID_SIDE);
+	map_graph_t * graph = create_map_graph(&map);
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	
+	uint32_t starts[BENCHMARK_N_QUERIES];
+	uint32_t ends[BENCHMARK_N_QUERIES];
+	uint32_t random_state = 12345;
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++){
+		starts[i] = next_benchmark_random(&random_state) % graph->n_nodes;
+		ends[i] = next_benchmark_random(&random_state) % graph->n_nodes;
+	}
+	
+	fprintf(stdout,"Cost profiles, %lu queries on a %d by %d grid:\n",(size_t) BENCHMARK_N_QUERIES,BENCHMARK_GRID_SIDE,BENCHMARK_GRID_SIDE);
+	for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+		edge_cost_function_t edge_cost_function = get_route_profile_cost_function(profile);
+		
+		double pointer_total = 0;
+		double start_time = get_benchmark_time();
+		for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++){
+			if(search_map_graph_through_pointer(graph,context,starts[i],ends[i],edge_cost_function)) pointer_total += context->cost[ends[i]];
+		}
+		double pointer_time = get_benchmark_time() - start_time;
+		
+		double profile_total = 0;
+		start_time = get_benchmark_time();
+		for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++){
+			if(search_map_graph_with_profile(graph,context,starts[i],ends[i],profile)) profile_total += context->cost[ends[i]];
+		}
+		double profile_time = get_benchmark_time() - start_time;
+		
+		fprintf(stdout,"\tprofile %u: function pointer %.3fs, edge weights %.3fs, speedup %.2fx, totals %s\n",profile,pointer_time,profile_time,
+			pointer_time/profile_time,(fabs(pointer_total - profile_total) <= 1e-4*pointer_total) ? "match" : "DIFFER");
+	}
+	
+	delete_route_search_context(context);
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+void edge_weights_benchmark(){
+	map_t map = init_map();
+	build_grid_map(&map,BENCHMARK_GRID_SIDE);
+	
+	double start_time = get_benchmark_time();
+	map_graph_t * full = create_map_graph(&map);
+	double full_time = get_benchmark_time() - start_time;
+	
+	//a small edit, the kind the editor makes between two snapshots
+	for(size_t i = 0;i < 10;i++){
+		set_connection_type_for_nodes_by_indices(&map,i,i+1,EDGE_TYPE_ROAD);
+	}
+	
+	start_time = get_benchmark_time();
+	map_graph_t * refreshed = create_map_graph_from_previous(&map,full);
+	double refreshed_time = get_benchmark_time() - start_time;
+	
+	fprintf(stdout,"Edge weights, %lu edges: full snapshot %.4fs, snapshot after an edit %.4fs with %lu edges measured again\n",
+		full->n_edges,full_time,refreshed_time,refreshed->weights->n_refreshed);
+	
+	release_map_graph(refreshed);
+	release_map_graph(full);
+	clear_map(&map);
+}
+
+void route_repair_benchmark(){
+	map_t map = init_map();
+	build_grid_map(&map,BENCHMARK_GRID_SIDE);
+	map_graph_t * graph = create_map_graph(&map);
+	edge_closures_t * closures = create_edge_closures(graph);
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	
+	double full_time = 0;
+	double repair_time = 0;
+	size_t n_repaired = 0;
+	size_t n_mismatches = 0;
+	uint32_t random_state = 54321;
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++){
+		uint32_t start = next_benchmark_random(&random_state) % graph->n_nodes;
+		uint32_t end = next_benchmark_random(&random_state) % graph->n_nodes;
+		
+		route_repair_t * repair = create_route_repair(graph,closures,0,start,end,calculate_walker_edge_cost);
+		if(!repair_route(repair)){
+			delete_route_repair(repair);
+			continue;
+		}
+		
+		//close an edge up to 40 steps before the end of the route, the part a device has not walked yet
+		uint32_t node = end;
+		for(size_t steps = 0;node != start && steps < 40;steps++){
+			const map_edge_t * edge = &(graph->edges[repair->previous_edge[node]]);
+			node = (edge->a == &(graph->nodes[node])) ? (edge->b - graph->nodes) : (edge->a - graph->nodes);
+		}
+		uint32_t closed_edge = repair->previous_edge[(node == start) ? end : node];
+		close_map_graph_edge(closures,closed_edge,CLOSURE_ALWAYS_START,CLOSURE_ALWAYS_END);
+		
+		double start_time = get_benchmark_time();
+		update_route_repair_edge(repair,closed_edge);
+		bool repaired = repair_route(repair);
+		repair_time += get_benchmark_time() - start_time;
+		
+		start_time = get_benchmark_time();
+		bool found = search_map_graph_with_closures(graph,context,start,end,calculate_walker_edge_cost,closures,0);
+		full_time += get_benchmark_time() - start_time;
+		
+		if(repaired != found || (found && fabs(repair->g[end] - context->cost[end]) > 1e-6*context->cost[end])) n_mismatches++;
+		n_repaired++;
+		
+		reopen_map_graph_edge(closures,closed_edge);
+		delete_route_repair(repair);
+	}
+	
+	fprintf(stdout,"Route repair, %lu routes with an edge closed on them: full search %.4fs, repair %.4fs, speedup %.2fx, %lu differ\n",
+		n_repaired,full_time,repair_time,full_time/repair_time,n_mismatches);
+	
+	delete_route_search_context(context);
+	delete_edge_closures(closures);
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+void route_alternatives_benchmark(){
+	map_t map = init_map();
+	build_grid_map(&map,BENCHMARK_GRID_SIDE);
+	map_graph_t * graph = create_map_graph(&map);
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	
+	const size_t max_paths = 5;
+	size_t n_queries = 0;
+	size_t n_paths = 0;
+	size_t n_spur_searches = 0;
+	double slowest = 0;
+	uint32_t random_state = 777;
+	double start_time = get_benchmark_time();
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++){
+		uint32_t start = next_benchmark_random(&random_state) % graph->n_nodes;
+		uint32_t end = next_benchmark_random(&random_state) % graph->n_nodes;
+		
+		double query_start = get_benchmark_time();
+		route_alternatives_t * alternatives = find_route_alternatives(graph,context,start,end,ROUTE_PROFILE_WALKER,max_paths);
+		double query_time = get_benchmark_time() - query_start;
+		if(query_time > slowest) slowest = query_time;
+		
+		if(alternatives != NULL){
+			n_paths += alternatives->n_paths;
+			n_spur_searches += alternatives->n_spur_searches;
+		}
+		n_queries++;
+		delete_route_alternatives(alternatives);
+	}
+	double total_time = get_benchmark_time() - start_time;
+	
+	fprintf(stdout,"Route alternatives, %lu queries for %lu routes: %.4fs per query, slowest %.4fs, %lu routes found, %.1f spur searches per query\n",
+		n_queries,max_paths,total_time/n_queries,slowest,n_paths,((double) n_spur_searches)/n_queries);
+	
+	delete_route_search_context(context);
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+void pareto_routes_benchmark(){
+	map_t map = init_map();
+	build_grid_map(&map,PARETO_BENCHMARK_GRID_SIDE);
+	map_graph_t * graph = create_map_graph(&map);
+	
+	const uint8_t criteria = ROUTE_CRITERION_COST | ROUTE_CRITERION_STAIRS | ROUTE_CRITERION_OUTDOORS;
+	size_t n_paths = 0;
+	size_t n_labels = 0;
+	size_t n_truncated = 0;
+	double slowest = 0;
+	uint32_t random_state = 999;
+	double start_time = get_benchmark_time();
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++){
+		uint32_t start = next_benchmark_random(&random_state) % graph->n_nodes;
+		uint32_t end = next_benchmark_random(&random_state) % graph->n_nodes;
+		
+		double query_start = get_benchmark_time();
+		pareto_routes_t * routes = find_pareto_routes(graph,start,end,ROUTE_PROFILE_WALKER,criteria,DEFAULT_PARETO_MAX_LABELS);
+		double query_time = get_benchmark_time() - query_start;
+		if(query_time > slowest) slowest = query_time;
+		
+		if(routes != NULL){
+			n_paths += routes->n_paths;
+			n_labels += routes->n_labels;
+			if(routes->truncated) n_truncated++;
+		}
+		delete_pareto_routes(routes);
+	}
+	double total_time = get_benchmark_time() - start_time;
+	
+	fprintf(stdout,"Pareto routes, %lu queries on cost, stairs and outdoors on a %d by %d grid: %.4fs per query, slowest %.4fs, %.1f routes and %.0f labels per query, %lu truncated\n",
+		(size_t) BENCHMARK_N_QUERIES,PARETO_BENCHMARK_GRID_SIDE,PARETO_BENCHMARK_GRID_SIDE,total_time/BENCHMARK_N_QUERIES,slowest,((double) n_paths)/BENCHMARK_N_QUERIES,((double) n_labels)/BENCHMARK_N_QUERIES,n_truncated);
+	
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+void isochrone_benchmark(){
+	map_t map = init_map();
+	build_grid_map(&map,BENCHMARK_GRID_SIDE);
+	map_graph_t * graph = create_map_graph(&map);
+	
+	//a slider dragged from 1 to ISOCHRONE_BENCHMARK_N_BUDGETS minutes of walking
+	const double minute_cost = 80.0;
+	uint32_t starts[BENCHMARK_N_QUERIES];
+	uint32_t random_state = 4242;
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++) starts[i] = next_benchmark_random(&random_state) % graph->n_nodes;
+	
+	size_t fresh_nodes = 0;
+	double start_time = get_benchmark_time();
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++){
+		for(size_t b = 1;b <= ISOCHRONE_BENCHMARK_N_BUDGETS;b++){
+			isochrone_t * isochrone = create_isochrone(graph,starts[i],ROUTE_PROFILE_WALKER);
+			grow_isochrone(isochrone,b*minute_cost);
+			fresh_nodes += isochrone->n_nodes;
+			delete_isochrone(isochrone);
+		}
+	}
+	double fresh_time = get_benchmark_time() - start_time;
+	
+	size_t grown_nodes = 0;
+	start_time = get_benchmark_time();
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++){
+		isochrone_t * isochrone = create_isochrone(graph,starts[i],ROUTE_PROFILE_WALKER);
+		for(size_t b = 1;b <= ISOCHRONE_BENCHMARK_N_BUDGETS;b++){
+			grow_isochrone(isochrone,b*minute_cost);
+			grown_nodes += isochrone->n_nodes;
+		}
+		delete_isochrone(isochrone);
+	}
+	double grown_time = get_benchmark_time() - start_time;
+	
+	fprintf(stdout,"Isochrones, %lu starts with %d growing budgets: new isochrone every budget %.4fs, grown isochrone %.4fs (%.1fx), %s nodes\n",
+		(size_t) BENCHMARK_N_QUERIES,ISOCHRONE_BENCHMARK_N_BUDGETS,fresh_time,grown_time,fresh_time/grown_time,fresh_nodes == grown_nodes ? "same" : "different");
+	
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+void schedules_benchmark(){
+	map_t map = init_map();
+	build_grid_map(&map,BENCHMARK_GRID_SIDE);
+	map_graph_t * graph = create_map_graph(&map);
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	
+	uint32_t starts[BENCHMARK_N_QUERIES];
+	uint32_t ends[BENCHMARK_N_QUERIES];
+	uint32_t random_state = 2024;
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++){
+		starts[i] = next_benchmark_random(&random_state) % graph->n_nodes;
+		ends[i] = next_benchmark_random(&random_state) % graph->n_nodes;
+	}
+	
+	//a Monday at noon
+	const int64_t departure_time = 1704067200 + 12*3600;
+	
+	double start_time = get_benchmark_time();
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++) search_map_graph_with_profile(graph,context,starts[i],ends[i],ROUTE_PROFILE_WALKER);
+	double untimed_time = get_benchmark_time() - start_time;
+	
+	start_time = get_benchmark_time();
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++) search_map_graph_at_time(graph,context,starts[i],ends[i],ROUTE_PROFILE_WALKER,departure_time,NULL);
+	double unscheduled_time = get_benchmark_time() - start_time;
+	
+	//every third edge is only open from 6:00 to 22:00
+	for(size_t i = 0;i < map.n_edges;i += 3){
+		schedule_t * schedule = create_schedule();
+		for(int32_t day = 0;day < 7;day++){
+			add_schedule_interval(schedule,day*SCHEDULE_DAY_SECONDS + 6*3600,day*SCHEDULE_DAY_SECONDS + 22*3600);
+		}
+		set_map_edge_schedule(map.all_edges[i],schedule);
+	}
+	start_time = get_benchmark_time();
+	map_graph_t * scheduled = create_map_graph_from_previous(&map,graph);
+	double compile_time = get_benchmark_time() - start_time;
+	
+	start_time = get_benchmark_time();
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++) search_map_graph_at_time(scheduled,context,starts[i],ends[i],ROUTE_PROFILE_WALKER,departure_time,NULL);
+	double scheduled_time = get_benchmark_time() - start_time;
+	
+	fprintf(stdout,"Timed routing, %lu queries: untimed %.4fs, timed without schedules %.4fs, timed with %lu scheduled edges %.4fs (%lu tables compiled in %.4fs)\n",
+		(size_t) BENCHMARK_N_QUERIES,untimed_time,unscheduled_time,(map.n_edges+2)/3,scheduled_time,scheduled->schedule_tables->n_tables,compile_time);
+	
+	release_map_graph(scheduled);
+	delete_route_search_context(context);
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+void projection_benchmark(){
+	map_t map = init_map();
+	build_grid_map(&map,BENCHMARK_GRID_SIDE);
+	map_graph_t * graph = create_map_graph(&map);
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	
+	//measure every edge a few times over so the timings are long enough to compare
+	const size_t n_passes = 20;
+	float * lengths = (float*) malloc(sizeof(float)*graph->n_edges);
+	double start_time = get_benchmark_time();
+	for(size_t pass = 0;pass < n_passes;pass++){
+		for(size_t i = 0;i < graph->n_edges;i++) lengths[i] = (float) get_map_edge_length(&(graph->edges[i]));
+	}
+	double haversine_time = get_benchmark_time() - start_time;
+	double checksum = 0;
+	for(size_t i = 0;i < graph->n_edges;i++) checksum += lengths[i];
+	
+	start_time = get_benchmark_time();
+	for(size_t pass = 0;pass < n_passes;pass++) compute_projected_edge_lengths(graph->projection,graph,lengths);
+	double projected_time = get_benchmark_time() - start_time;
+	double projected_checksum = 0;
+	for(size_t i = 0;i < graph->n_edges;i++) projected_checksum += lengths[i];
+	free(lengths);
+	
+	fprintf(stdout,"Edge lengths, %lu edges %lu times: haversine %.4fs, projected %.4fs (%.1fx), total lengths differ by %.5f%%\n",
+		graph->n_edges,n_passes,haversine_time,projected_time,haversine_time/projected_time,100.0*fabs(projected_checksum - checksum)/checksum);
+	
+	uint32_t starts[BENCHMARK_N_QUERIES];
+	uint32_t ends[BENCHMARK_N_QUERIES];
+	uint32_t random_state = 31337;
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++){
+		starts[i] = next_benchmark_random(&random_state) % graph->n_nodes;
+		ends[i] = next_benchmark_random(&random_state) % graph->n_nodes;
+	}
+	
+	double dijkstra_cost = 0;
+	start_time = get_benchmark_time();
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++){
+		if(search_map_graph_with_profile(graph,context,starts[i],ends[i],ROUTE_PROFILE_WALKER)) dijkstra_cost += context->cost[ends[i]];
+	}
+	double dijkstra_time = get_benchmark_time() - start_time;
+	
+	double a_star_cost = 0;
+	start_time = get_benchmark_time();
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++){
+		if(search_map_graph_with_heuristic(graph,context,starts[i],ends[i],ROUTE_PROFILE_WALKER)) a_star_cost += context->cost[ends[i]];
+	}
+	double a_star_time = get_benchmark_time() - start_time;
+	
+	fprintf(stdout,"Projected A*, %lu queries: Dijkstra %.4fs, A* %.4fs (%.1fx), %s costs\n",(size_t) BENCHMARK_N_QUERIES,dijkstra_time,a_star_time,
+		dijkstra_time/a_star_time,fabs(dijkstra_cost - a_star_cost) < 1e-3*dijkstra_cost ? "same" : "different");
+	
+	delete_route_search_context(context);
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+/*
+ * A hardware counter of the last level cache misses of this thread, -1 where perf events are not allowed.
+ * Read it with read_cache_miss_counter around the code to measure.
+ */
+static int open_cache_miss_counter(void){
+	struct perf_event_attr attr;
+	memset(&attr,0,sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = PERF_COUNT_HW_CACHE_MISSES;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return (int) syscall(SYS_perf_event_open,&attr,0,-1,-1,0);
+}
+
+static uint64_t read_cache_miss_counter(int counter){
+	uint64_t count = 0;
+	if(counter < 0 || read(counter,&count,sizeof(count)) != sizeof(count)) return 0;
+	return count;
+}
+
+//Shuffle the nodes and edges, the order an imported map comes in has nothing to do with where nodes are.
+static void shuffle_benchmark_map(map_t * map,uint32_t * random_state){
+	for(size_t i = map->n_nodes-1;i > 0;i--){
+		size_t j = next_benchmark_random(random_state) % (i+1);
+		map_node_t * node = map->all_nodes[i];
+		map->all_nodes[i] = map->all_nodes[j];
+		map->all_nodes[j] = node;
+		uint16_t flags = map->node_flags[i];
+		map->node_flags[i] = map->node_flags[j];
+		map->node_flags[j] = flags;
+	}
+	for(size_t i = map->n_edges-1;i > 0;i--){
+		size_t j = next_benchmark_random(random_state) % (i+1);
+		map_edge_t * edge = map->all_edges[i];
+		map->all_edges[i] = map->all_edges[j];
+		map->all_edges[j] = edge;
+	}
+}
+
+//Time the same queries, given as map nodes, on a fresh snapshot of the map in its current order.
+static void run_node_order_queries(map_t * map,map_node_t ** starts,map_node_t ** ends,int counter,const char * label){
+	map_graph_t * graph = create_map_graph(map);
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	
+	uint32_t start_indices[BENCHMARK_N_QUERIES];
+	uint32_t end_indices[BENCHMARK_N_QUERIES];
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++){
+		bool found = false;
+		start_indices[i] = get_map_graph_node_index(graph,starts[i],&found);
+		end_indices[i] = get_map_graph_node_index(graph,ends[i],&found);
+	}
+	
+	double cost = 0;
+	if(counter >= 0){
+		ioctl(counter,PERF_EVENT_IOC_RESET,0);
+		ioctl(counter,PERF_EVENT_IOC_ENABLE,0);
+	}
+	double start_time = get_benchmark_time();
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++){
+		if(search_map_graph_with_profile(graph,context,start_indices[i],end_indices[i],ROUTE_PROFILE_WALKER)) cost += context->cost[end_indices[i]];
+	}
+	double query_time = get_benchmark_time() - start_time;
+	if(counter >= 0) ioctl(counter,PERF_EVENT_IOC_DISABLE,0);
+	
+	if(counter >= 0){
+		fprintf(stdout,"\t%s: %.4fs, %lu cache misses, total cost %.0f\n",label,query_time,read_cache_miss_counter(counter),cost);
+	}else{
+		fprintf(stdout,"\t%s: %.4fs, cache misses not available, total cost %.0f\n",label,query_time,cost);
+	}
+	
+	delete_route_search_context(context);
+	release_map_graph(graph);
+}
+
+void node_order_benchmark(){
+	map_t map = init_map();
+	build_grid_map(&map,BENCHMARK_GRID_SIDE);
+	
+	map_node_t * starts[BENCHMARK_N_QUERIES];
+	map_node_t * ends[BENCHMARK_N_QUERIES];
+	uint32_t random_state = 8086;
+	for(size_t i = 0;i < BENCHMARK_N_QUERIES;i++){
+		starts[i] = map.all_nodes[next_benchmark_random(&random_state) % map.n_nodes];
+		ends[i] = map.all_nodes[next_benchmark_random(&random_state) % map.n_nodes];
+	}
+	
+	shuffle_benchmark_map(&map,&random_state);
+	
+	int counter = open_cache_miss_counter();
+	fprintf(stdout,"Node order, %lu queries on a %d by %d grid:\n",(size_t) BENCHMARK_N_QUERIES,BENCHMARK_GRID_SIDE,BENCHMARK_GRID_SIDE);
+	run_node_order_queries(&map,starts,ends,counter,"shuffled");
+	
+	double start_time = get_benchmark_time();
+	reorder_map_nodes(&map,MAP_NODE_ORDER_BFS);
+	double reorder_time = get_benchmark_time() - start_time;
+	run_node_order_queries(&map,starts,ends,counter,"breadth first");
+	fprintf(stdout,"\t\treordered in %.4fs\n",reorder_time);
+	
+	start_time = get_benchmark_time();
+	reorder_map_nodes(&map,MAP_NODE_ORDER_HILBERT);
+	reorder_time = get_benchmark_time() - start_time;
+	run_node_order_queries(&map,starts,ends,counter,"Hilbert curve");
+	fprintf(stdout,"\t\treordered in %.4fs\n",reorder_time);
+	
+	if(counter >= 0) close(counter);
+	clear_map(&map);
+}
+
+//How a search tree was walked back before snapshots kept edge_nodes, comparing against the full node copies.
+static uint32_t get_other_node_through_copies(const map_graph_t * graph,uint32_t edge_index,uint32_t node){
+	const map_edge_t * edge = &(graph->edges[edge_index]);
+	return (edge->a == &(graph->nodes[node])) ? (edge->b - graph->nodes) : (edge->a - graph->nodes);
+}
+
+void hot_nodes_benchmark(){
+	map_t map = init_map();
+	build_grid_map(&map,BENCHMARK_GRID_SIDE);
+	uint32_t random_state = 1979;
+	shuffle_benchmark_map(&map,&random_state);
+	map_graph_t * graph = create_map_graph(&map);
+	fprintf(stdout,"Hot node array, %lu edges of a shuffled %d by %d grid, %lu bytes per hot node and %lu per copy:\n",graph->n_edges,BENCHMARK_GRID_SIDE,BENCHMARK_GRID_SIDE,sizeof(map_graph_node_t),sizeof(map_node_t));
+	
+	//gather both ends of every edge, like measuring edge lengths does
+	double start_time = get_benchmark_time();
+	double copies_sum = 0;
+	for(size_t r = 0;r < BENCHMARK_N_QUERIES;r++){
+		for(size_t j = 0;j < graph->n_edges;j++){
+			const map_edge_t * edge = &(graph->edges[j]);
+			copies_sum += edge->b->coordinate.latitude - edge->a->coordinate.latitude + (edge->b->floor_number - edge->a->floor_number);
+		}
+	}
+	double copies_time = get_benchmark_time() - start_time;
+	
+	start_time = get_benchmark_time();
+	double hot_sum = 0;
+	for(size_t r = 0;r < BENCHMARK_N_QUERIES;r++){
+		for(size_t j = 0;j < graph->n_edges;j++){
+			const map_graph_node_t * a = &(graph->hot_nodes[graph->edge_nodes[2*j]]);
+			const map_graph_node_t * b = &(graph->hot_nodes[graph->edge_nodes[2*j+1]]);
+			hot_sum += b->coordinate.latitude - a->coordinate.latitude + (b->floor_number - a->floor_number);
+		}
+	}
+	double hot_time = get_benchmark_time() - start_time;
+	fprintf(stdout,"	edge ends %lu times through the node copies: %.4fs, through the hot nodes: %.4fs (%.1fx), sums differ by %g\n",(size_t) BENCHMARK_N_QUERIES,copies_time,hot_time,copies_time/hot_time,fabs(copies_sum - hot_sum));
+	
+	//walk the whole search tree back from nodes all over the grid, like extracting paths does
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	grow_route_search_tree(graph,context,0,NULL,0,INFINITY,ROUTE_PROFILE_WALKER);
+	start_time = get_benchmark_time();
+	size_t copies_steps = 0;
+	for(size_t i = 0;i < graph->n_nodes;i += 8){
+		for(uint32_t current = i;route_search_reached(context,current) && context->previous_edge[current] != UINT32_MAX;copies_steps++){
+			current = get_other_node_through_copies(graph,context->previous_edge[current],current);
+		}
+	}
+	copies_time = get_benchmark_time() - start_time;
+	
+	start_time = get_benchmark_time();
+	size_t hot_steps = 0;
+	for(size_t i = 0;i < graph->n_nodes;i += 8){
+		for(uint32_t current = i;route_search_reached(context,current) && context->previous_edge[current] != UINT32_MAX;hot_steps++){
+			current = get_map_graph_other_node(graph,context->previous_edge[current],current);
+		}
+	}
+	hot_time = get_benchmark_time() - start_time;
+	fprintf(stdout,"	%lu tree steps through the edge copies: %.4fs, through edge_nodes: %.4fs (%.1fx), %lu steps\n",copies_steps,copies_time,hot_time,copies_time/hot_time,hot_steps);
+	
+	delete_route_search_context(context);
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+void string_interner_benchmark(){
+	//rooms of a few hundred buildings, the photos of a building are in a handful of shared files
+	map_t map = init_map();
+	char text[96];
+	size_t copies_bytes = 0;
+	for(size_t i = 0;i < STRINGS_BENCHMARK_N_NODES;i++){
+		map_node_t * node = create_map_node(create_cord(-76.7130 + (i % 300)*0.0001,39.2550 + (i / 300)*0.0001));
+		snprintf(text,sizeof(text),"Building %lu Room %lu",i % 300,i / 300);
+		set_map_node_name(node,text);
+		snprintf(text,sizeof(text),"/usr/share/umbc-map/pictures/building_%lu/hallway_%lu.png",i % 300,i % 7);
+		set_map_node_picture(node,text);
+		copies_bytes += malloc_usable_size(node->name) + malloc_usable_size(node->picture_file_path);
+		add_node_to_map(&map,node);
+	}
+	size_t interned_bytes = get_string_interner_bytes(map.strings);
+	fprintf(stdout,"String interning, %d nodes with a name and a picture:\n",STRINGS_BENCHMARK_N_NODES);
+	fprintf(stdout,"\t%lu distinct strings, %lu bytes of copies, %lu bytes interned (%.1fx less)\n",map.strings->n_strings,copies_bytes,interned_bytes,(double) copies_bytes/interned_bytes);
+	
+	//look up rooms by name, comparing every name against the query or every id against the query's id
+	const char * queries[BENCHMARK_N_QUERIES];
+	uint32_t random_state = 2600;
+	for(size_t q = 0;q < BENCHMARK_N_QUERIES;q++) queries[q] = map.all_nodes[next_benchmark_random(&random_state) % map.n_nodes]->name;
+	
+	double start_time = get_benchmark_time();
+	size_t copies_found = 0;
+	for(size_t q = 0;q < BENCHMARK_N_QUERIES;q++){
+		for(size_t i = 0;i < map.n_nodes;i++) copies_found += strcmp(map.all_nodes[i]->name,queries[q]) == 0;
+	}
+	double copies_time = get_benchmark_time() - start_time;
+	
+	start_time = get_benchmark_time();
+	size_t ids_found = 0;
+	for(size_t q = 0;q < BENCHMARK_N_QUERIES;q++){
+		uint32_t id = find_interned_string(map.strings,queries[q]);
+		for(size_t i = 0;i < map.n_nodes;i++) ids_found += map.all_nodes[i]->name_id == id;
+	}
+	double ids_time = get_benchmark_time() - start_time;
+	fprintf(stdout,"\t%d name lookups by strcmp: %.4fs, by id: %.4fs (%.1fx), %lu and %lu found\n",BENCHMARK_N_QUERIES,copies_time,ids_time,copies_time/ids_time,copies_found,ids_found);
+	
+	clear_map(&map);
+}
+
+void image_cache_benchmark(){
+	//a walk past nodes with a picture each, the pictures are noisy so they do not compress to nothing
+	map_t map = init_map();
+	uint8_t * pixels = (uint8_t*) malloc((size_t) IMAGES_BENCHMARK_PICTURE_WIDTH*IMAGES_BENCHMARK_PICTURE_HEIGHT*3);
+	uint32_t random_state = 3033;
+	char path[64];
+	for(size_t i = 0;i < IMAGES_BENCHMARK_N_PICTURES;i++){
+		for(size_t p = 0;p < (size_t) IMAGES_BENCHMARK_PICTURE_WIDTH*IMAGES_BENCHMARK_PICTURE_HEIGHT*3;p++){
+			pixels[p] = (uint8_t) ((p/3 % IMAGES_BENCHMARK_PICTURE_WIDTH)/8 + i*10 + (next_benchmark_random(&random_state) & 15));
+		}
+		png_image image;
+		memset(&image,0,sizeof(png_image));
+		image.version = PNG_IMAGE_VERSION;
+		image.width = IMAGES_BENCHMARK_PICTURE_WIDTH;
+		image.height = IMAGES_BENCHMARK_PICTURE_HEIGHT;
+		image.format = PNG_FORMAT_RGB;
+		snprintf(path,sizeof(path),"/tmp/image_cache_benchmark_%lu.png",i);
+		png_image_write_to_file(&image,path,0,pixels,0,NULL);
+	
+		map_node_t * node = create_map_node(create_cord(-76.7130 + i*0.0001,39.2550));
+		set_map_node_picture(node,path);
+		add_node_to_map(&map,node);
+	}
+	free(pixels);
+	
+	//selecting every node in turn, decoding the picture when it is selected like the UI did
+	double start_time = get_benchmark_time();
+	double worst_time = 0;
+	for(size_t i = 0;i < map.n_nodes;i++){
+		double select_time = get_benchmark_time();
+		release_cached_image(decode_cached_image(map.all_nodes[i]->picture_file_path,IMAGE_SIZE_THUMBNAIL));
+		worst_time = fmax(worst_time,get_benchmark_time() - select_time);
+	}
+	double decode_time = get_benchmark_time() - start_time;
+	fprintf(stdout,"Image cache, %d pictures of %dx%d along a path:\n",IMAGES_BENCHMARK_N_PICTURES,IMAGES_BENCHMARK_PICTURE_WIDTH,IMAGES_BENCHMARK_PICTURE_HEIGHT);
+	fprintf(stdout,"\tdecoding on select: %.2fms a selection, worst %.2fms\n",1000*decode_time/map.n_nodes,1000*worst_time);
+	
+	//the same walk once the route came back and its pictures were prefetched, then walking back over it
+	image_cache_t * cache = create_image_cache(DEFAULT_IMAGE_CACHE_BYTES,NULL,NULL);
+	map_path_t route = {map.all_nodes,map.n_nodes,NULL};
+	start_time = get_benchmark_time();
+	prefetch_map_path_images(cache,&route,IMAGE_SIZE_THUMBNAIL);
+	wait_for_image_cache(cache);
+	double prefetch_time = get_benchmark_time() - start_time;
+	
+	start_time = get_benchmark_time();
+	worst_time = 0;
+	size_t n_shown = 0;
+	for(size_t k = 0;k < 2*map.n_nodes;k++){
+		size_t i = (k < map.n_nodes) ? k : 2*map.n_nodes-1 - k;
+		double select_time = get_benchmark_time();
+		cached_image_t * image = get_cached_image(cache,map.all_nodes[i]->picture_file_path,IMAGE_SIZE_THUMBNAIL);
+		worst_time = fmax(worst_time,get_benchmark_time() - select_time);
+		n_shown += image != NULL;
+		release_cached_image(image);
+	}
+	double cached_time = get_benchmark_time() - start_time;
+	image_cache_stats_t stats = get_image_cache_stats(cache);
+	fprintf(stdout,"\tprefetched in the background in %.2fms, then %.4fms a selection, worst %.4fms (%.0fx)\n",1000*prefetch_time,1000*cached_time/(2*map.n_nodes),1000*worst_time,(decode_time/map.n_nodes)/(cached_time/(2*map.n_nodes)));
+	fprintf(stdout,"\t%lu of %lu shown right away, hit rate %.2f (%lu from prefetches), %lu bytes cached\n",n_shown,2*map.n_nodes,get_image_cache_hit_rate(&stats),stats.n_prefetch_hits,stats.bytes);
+	delete_image_cache(cache);
+	
+	for(size_t i = 0;i < map.n_nodes;i++) remove(map.all_nodes[i]->picture_file_path);
+	clear_map(&map);
+}
+
+void raster_import_benchmark(){
+	//grass colored noise with a grid of brighter green paths 7 pixels wide on it
+	size_t n_pixels = (size_t) RASTER_BENCHMARK_SIDE*RASTER_BENCHMARK_SIDE;
+	uint8_t * rgba = (uint8_t*) malloc(n_pixels*4);
+	uint32_t random_state = 4096;
+	for(size_t i = 0;i < n_pixels;i++){
+		uint32_t random = next_benchmark_random(&random_state);
+		size_t x = i % RASTER_BENCHMARK_SIDE;
+		size_t y = i / RASTER_BENCHMARK_SIDE;
+		bool on_path = (x % RASTER_BENCHMARK_PATH_SPACING) < 7 || (y % RASTER_BENCHMARK_PATH_SPACING) < 7;
+		rgba[4*i] = (uint8_t) (60 + (random & 31));
+		rgba[4*i+1] = (uint8_t) ((on_path ? 170 : 90) + ((random >> 5) & 31));
+		rgba[4*i+2] = (uint8_t) (50 + ((random >> 10) & 31));
+		rgba[4*i+3] = 255;
+	}
+	
+	//find_green_pixel.py's walk, column by column collecting the coordinates of every green pixel
+	double start_time = get_benchmark_time();
+	size_t n_found = 0;
+	size_t found_capacity = 1024;
+	uint32_t * found = (uint32_t*) malloc(sizeof(uint32_t)*2*found_capacity);
+	for(uint32_t x = 0;x < RASTER_BENCHMARK_SIDE;x++){
+		for(uint32_t y = 0;y < RASTER_BENCHMARK_SIDE;y++){
+			const uint8_t * pixel = rgba + 4*((size_t) y*RASTER_BENCHMARK_SIDE + x);
+			if(!(pixel[1] > DEFAULT_RASTER_GREEN_THRESHOLD && pixel[1] > pixel[0] && pixel[1] > pixel[2])) continue;
+			if(n_found == found_capacity){
+				found_capacity *= 2;
+				found = (uint32_t*) realloc(found,sizeof(uint32_t)*2*found_capacity);
+			}
+			found[2*n_found] = x;
+			found[2*n_found+1] = y;
+			n_found++;
+		}
+	}
+	double scan_time = get_benchmark_time() - start_time;
+	free(found);
+	
+	start_time = get_benchmark_time();
+	size_t n_walkable = 0;
+	uint8_t * mask = classify_walkable_pixels(rgba,RASTER_BENCHMARK_SIDE,RASTER_BENCHMARK_SIDE,DEFAULT_RASTER_GREEN_THRESHOLD,&n_walkable);
+	double classify_time = get_benchmark_time() - start_time;
+	free(mask);
+	fprintf(stdout,"Raster import, %dx%d picture:\n",RASTER_BENCHMARK_SIDE,RASTER_BENCHMARK_SIDE);
+	fprintf(stdout,"\tgreen pixels by column walk: %.4fs, vectorized: %.4fs (%.1fx), %lu and %lu found\n",scan_time,classify_time,scan_time/classify_time,n_found,n_walkable);
+	
+	//the whole way from pixels to a routable map
+	map_t map = init_map();
+	raster_import_options_t options = default_raster_import_options(create_map_rect(create_cord(-76.7200,39.2500),create_cord(-76.7000,39.2700)));
+	raster_import_stats_t stats;
+	start_time = get_benchmark_time();
+	import_raster_pixels(&map,rgba,RASTER_BENCHMARK_SIDE,RASTER_BENCHMARK_SIDE,&options,&stats);
+	double import_time = get_benchmark_time() - start_time;
+	fprintf(stdout,"\tclassified, thinned and traced in %.4fs: %lu skeleton pixels, %lu nodes, %lu edges\n",import_time,stats.n_skeleton_pixels,stats.n_nodes,stats.n_edges);
+	
+	clear_map(&map);
+	free(rgba);
+}
+
+//Time one import of a file, printing its rate in nodes referenced by ways or features (<nd> or positions).
+static void run_map_import_benchmark(const char * format,const char * path,size_t n_references){
+	FILE * file = fopen(path,"rb");
+	fseek(file,0,SEEK_END);
+	double megabytes = ftell(file)/(1024.0*1024.0);
+	fclose(file);
+	
+	map_t map = init_map();
+	map_import_stats_t stats;
+	double start_time = get_benchmark_time();
+	import_map_file(&map,path,&stats);
+	double import_time = get_benchmark_time() - start_time;
+	fprintf(stdout,"\t%s, %.1fMiB: %.4fs, %lu elements, %.2f million node references/s, %.0fMiB/s, %lu nodes, %lu edges, %lu shared\n",
+		format,megabytes,import_time,stats.n_elements,n_references/import_time/1e6,megabytes/import_time,stats.n_nodes,stats.n_edges,stats.n_shared_nodes);
+	clear_map(&map);
+}
+
+void map_import_benchmark(){
+	//a grid of footways, a way or feature along every row and column of nodes
+	const size_t side = IMPORT_BENCHMARK_GRID_SIDE;
+	FILE * file = fopen("/tmp/map_import_benchmark.osm","w");
+	fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<osm version=\"0.6\" generator=\"benchmarks\">\n",file);
+	for(size_t i = 0;i < side*side;i++){
+		fprintf(file," <node id=\"%lu\" visible=\"true\" version=\"1\" lat=\"%.7f\" lon=\"%.7f\"/>\n",i+1,39.2500 + (i / side)*0.00002,-76.7200 + (i % side)*0.00002);
+	}
+	for(size_t line = 0;line < 2*side;line++){
+		fprintf(file," <way id=\"%lu\" visible=\"true\" version=\"1\">\n",line+1);
+		for(size_t k = 0;k < side;k++){
+			size_t node = (line < side) ? line*side + k : k*side + (line - side);
+			fprintf(file,"  <nd ref=\"%lu\"/>\n",node+1);
+		}
+		fputs("  <tag k=\"highway\" v=\"footway\"/>\n </way>\n",file);
+	}
+	fputs("</osm>\n",file);
+	fclose(file);
+	
+	file = fopen("/tmp/map_import_benchmark.geojson","w");
+	fputs("{\"type\": \"FeatureCollection\", \"features\": [\n",file);
+	for(size_t line = 0;line < 2*side;line++){
+		fprintf(file,"%s{\"type\": \"Feature\", \"properties\": {\"highway\": \"footway\"}, \"geometry\": {\"type\": \"LineString\", \"coordinates\": [",(line == 0) ? "" : ",\n");
+		for(size_t k = 0;k < side;k++){
+			size_t node = (line < side) ? line*side + k : k*side + (line - side);
+			fprintf(file,"%s[%.7f, %.7f]",(k == 0) ? "" : ", ",-76.7200 + (node % side)*0.00002,39.2500 + (node / side)*0.00002);
+		}
+		fputs("]}}",file);
+	}
+	fputs("\n]}\n",file);
+	fclose(file);
+	
+	fprintf(stdout,"Map import, a %dx%d grid of footways:\n",IMPORT_BENCHMARK_GRID_SIDE,IMPORT_BENCHMARK_GRID_SIDE);
+	run_map_import_benchmark("OSM XML","/tmp/map_import_benchmark.osm",2*side*side);
+	run_map_import_benchmark("GeoJSON","/tmp/map_import_benchmark.geojson",2*side*side);
+	remove("/tmp/map_import_benchmark.osm");
+	remove("/tmp/map_import_benchmark.geojson");
+}
+
+//Generate campuses of growing size and time a snapshot and walker and wheelchair searches on each.
+void campus_generator_benchmark(){
+	fputs("Campus generator:\n",stdout);
+	for(size_t n_nodes = CAMPUS_BENCHMARK_MIN_NODES;n_nodes <= CAMPUS_BENCHMARK_MAX_NODES;n_nodes *= 10){
+		campus_options_t options = campus_options_for_size(n_nodes,DEFAULT_CAMPUS_SEED);
+		campus_stats_t stats;
+		map_t map = init_map();
+		double start_time = get_benchmark_time();
+		generate_campus_map(&map,&options,&stats);
+		double generate_time = get_benchmark_time() - start_time;
+		
+		start_time = get_benchmark_time();
+		map_graph_t * graph = create_map_graph(&map);
+		double snapshot_time = get_benchmark_time() - start_time;
+		fprintf(stdout,"\t%lu nodes, %lu edges, %lu buildings: generated in %.4fs (%.2f million nodes/s), snapshot in %.4fs\n",
+			stats.n_nodes,stats.n_edges,stats.n_buildings,generate_time,stats.n_nodes/generate_time/1e6,snapshot_time);
+		
+		//searches on the biggest campuses take long, run fewer of them
+		size_t n_queries = (n_nodes <= CAMPUS_BENCHMARK_MIN_NODES*10) ? BENCHMARK_N_QUERIES : BENCHMARK_N_QUERIES/10;
+		route_search_context_t * context = create_route_search_context(graph->n_nodes);
+		const uint8_t profiles[2] = {ROUTE_PROFILE_WALKER,ROUTE_PROFILE_WHEELCHAIR};
+		for(size_t p = 0;p < 2;p++){
+			uint32_t random_state = 2025;
+			size_t n_found = 0;
+			start_time = get_benchmark_time();
+			for(size_t i = 0;i < n_queries;i++){
+				uint32_t start = next_benchmark_random(&random_state) % graph->n_nodes;
+				uint32_t end = next_benchmark_random(&random_state) % graph->n_nodes;
+				n_found += search_map_graph_with_profile(graph,context,start,end,profiles[p]);
+			}
+			double query_time = get_benchmark_time() - start_time;
+			fprintf(stdout,"\t\t%s: %lu queries, %.3fms each, %lu found\n",(p == 0) ? "walker" : "wheelchair",n_queries,query_time/n_queries*1e3,n_found);
+		}
+		
+		delete_route_search_context(context);
+		release_map_graph(graph);
+		clear_map(&map);
+	}
+}
@@ -0,0 +1,26 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+//Seconds on a monotonic clock, only differences between two calls mean anything.
+double get_benchmark_time(void);
+
+void cost_profile_benchmark();
+void edge_weights_benchmark();
+void route_repair_benchmark();
+void route_alternatives_benchmark();
+void pareto_routes_benchmark();
+void isochrone_benchmark();
+void schedules_benchmark();
+void projection_benchmark();
+void node_order_benchmark();
+void hot_nodes_benchmark();
+void string_interner_benchmark();
+void image_cache_benchmark();
+void raster_import_benchmark();
+void map_import_benchmark();
+void campus_generator_benchmark();
+
+#endif
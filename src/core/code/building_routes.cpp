@@ -0,0 +1,230 @@
+#include "building_routes.h"
+#include "edge_weights.h"
+#include <string.h>
+
+static uint64_t mix_checksum(uint64_t key){
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return key;
+}
+
+/*
+ * Number the buildings of a graph in the order they are first seen and give every node its building
+ */
+static size_t assign_node_buildings(const map_graph_t * graph,uint32_t * node_building,building_portals_t ** buildings_out){
+	size_t n_slots = 16;
+	while(n_slots < 2*graph->n_nodes) n_slots *= 2;
+	size_t mask = n_slots - 1;
+
+	uint32_t * slots = (uint32_t*) malloc(sizeof(uint32_t)*n_slots);
+	for(size_t i = 0;i < n_slots;i++) slots[i] = UINT32_MAX;
+
+	size_t buildings_capacity = 4;
+	building_portals_t * buildings = (building_portals_t*) malloc(sizeof(building_portals_t)*buildings_capacity);
+	size_t n_buildings = 0;
+
+	for(size_t i = 0;i < graph->n_nodes;i++){
+		const building_t * building = get_map_node_view_building(get_map_graph_node_view(graph,i));
+		if(building == NULL){
+			node_building[i] = NODE_OUTDOORS;
+			continue;
+		}
+
+		size_t slot = mix_checksum((uint64_t)(uintptr_t) building) & mask;
+		while(slots[slot] != UINT32_MAX && buildings[slots[slot]].building != building) slot = (slot+1) & mask;
+
+		if(slots[slot] == UINT32_MAX){
+			if(n_buildings == buildings_capacity){
+				buildings_capacity *= 2;
+				buildings = (building_portals_t*) realloc(buildings,sizeof(building_portals_t)*buildings_capacity);
+			}
+
+			building_portals_t * portals = &(buildings[n_buildings]);
+			portals->building = building;
+			portals->n_entrances = 0;
+			portals->entrances = NULL;
+			for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++) portals->entrance_costs[profile] = NULL;
+			portals->interior_checksum = 0;
+
+			slots[slot] = n_buildings;
+			n_buildings++;
+		}
+
+		node_building[i] = slots[slot];
+	}
+
+	free(slots);
+	*buildings_out = buildings;
+	return n_buildings;
+}
+
+/*
+ * Find the entrances of every building and checksum everything the tables depend on
+ */
+static void find_building_entrances(const map_graph_t * graph,building_routes_t * routes){
+	for(size_t i = 0;i < graph->n_nodes;i++) routes->node_entrance[i] = UINT32_MAX;
+
+	for(size_t j = 0;j < graph->n_edges;j++){
+		uint32_t a = graph->edge_nodes[2*j];
+		uint32_t b = graph->edge_nodes[2*j+1];
+		uint32_t building_a = routes->node_building[a];
+		uint32_t building_b = routes->node_building[b];
+
+		if(building_a == building_b){
+			if(building_a == NODE_OUTDOORS) continue;
+
+			//summed so the order the edges come in does not matter
+			uint64_t key = (uint64_t)(uintptr_t) graph->source_edges[j];
+			for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+				uint32_t weight_bits;
+				memcpy(&weight_bits,&(graph->weights->profile_weights[profile][j]),sizeof(uint32_t));
+				key = mix_checksum(key ^ weight_bits);
+			}
+			routes->buildings[building_a].interior_checksum += key;
+			continue;
+		}
+
+		//an edge leaving a building makes entrances of its ends
+		if(building_a != NODE_OUTDOORS && routes->node_entrance[a] == UINT32_MAX){
+			routes->node_entrance[a] = routes->buildings[building_a].n_entrances++;
+		}
+		if(building_b != NODE_OUTDOORS && routes->node_entrance[b] == UINT32_MAX){
+			routes->node_entrance[b] = routes->buildings[building_b].n_entrances++;
+		}
+	}
+
+	for(size_t k = 0;k < routes->n_buildings;k++){
+		routes->buildings[k].entrances = (uint32_t*) malloc(sizeof(uint32_t)*(routes->buildings[k].n_entrances+1));
+	}
+	for(size_t i = 0;i < graph->n_nodes;i++){
+		if(routes->node_entrance[i] == UINT32_MAX) continue;
+
+		building_portals_t * portals = &(routes->buildings[routes->node_building[i]]);
+		portals->entrances[routes->node_entrance[i]] = i;
+		portals->interior_checksum += mix_checksum((uint64_t)(uintptr_t) graph->source_nodes[i] + routes->node_entrance[i]);
+	}
+}
+
+/*
+ * Slots of a small hash from the building of every entry of previous->building_routes to its index, UINT32_MAX
+ * for an empty slot. NULL if there is no previous snapshot.
+ */
+static uint32_t * hash_previous_buildings(const map_graph_t * previous,size_t * mask_out){
+	if(previous == NULL || previous->building_routes == NULL) return NULL;
+
+	const building_routes_t * previous_routes = previous->building_routes;
+	size_t n_slots = 16;
+	while(n_slots < 2*previous_routes->n_buildings) n_slots *= 2;
+	size_t mask = n_slots - 1;
+
+	uint32_t * slots = (uint32_t*) malloc(sizeof(uint32_t)*n_slots);
+	for(size_t i = 0;i < n_slots;i++) slots[i] = UINT32_MAX;
+	for(size_t k = 0;k < previous_routes->n_buildings;k++){
+		size_t slot = ((uintptr_t) previous_routes->buildings[k].building >> 4) & mask;
+		while(slots[slot] != UINT32_MAX) slot = (slot+1) & mask;
+		slots[slot] = k;
+	}
+
+	*mask_out = mask;
+	return slots;
+}
+
+/*
+ * The same building in the previous snapshot if nothing it depends on has changed, slots and mask are from
+ * hash_previous_buildings
+ */
+static const building_portals_t * find_unchanged_building(const map_graph_t * graph,const building_portals_t * portals,const map_graph_t * previous,const uint32_t * slots,size_t mask){
+	if(slots == NULL) return NULL;
+
+	const building_routes_t * previous_routes = previous->building_routes;
+	size_t slot = ((uintptr_t) portals->building >> 4) & mask;
+	while(slots[slot] != UINT32_MAX){
+		const building_portals_t * old = &(previous_routes->buildings[slots[slot]]);
+		slot = (slot+1) & mask;
+		if(old->building != portals->building) continue;
+
+		if(old->interior_checksum != portals->interior_checksum || old->n_entrances != portals->n_entrances) return NULL;
+		for(uint32_t e = 0;e < portals->n_entrances;e++){
+			if(previous->source_nodes[old->entrances[e]] != graph->source_nodes[portals->entrances[e]]) return NULL;
+		}
+		return old;
+	}
+
+	return NULL;
+}
+
+static void fill_entrance_costs(const map_graph_t * graph,const building_routes_t * routes,route_search_context_t * context,uint32_t building_index,building_portals_t * portals){
+	uint32_t n = portals->n_entrances;
+
+	for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+		float * costs = portals->entrance_costs[profile];
+
+		for(uint32_t i = 0;i < n;i++){
+			grow_building_interior_tree(graph,routes,context,portals->entrances[i],building_index,profile);
+
+			for(uint32_t j = 0;j < n;j++){
+				uint32_t entrance = portals->entrances[j];
+				costs[i*n + j] = route_search_reached(context,entrance) ? (float) context->cost[entrance] : EDGE_COST_IMPASSABLE;
+			}
+		}
+	}
+}
+
+building_routes_t * create_building_routes(const map_graph_t * graph,const map_graph_t * previous){
+	if(graph == NULL || graph->weights == NULL) return NULL;
+
+	building_routes_t * routes = (building_routes_t*) malloc(sizeof(building_routes_t));
+	routes->node_building = (uint32_t*) malloc(sizeof(uint32_t)*(graph->n_nodes+1));
+	routes->node_entrance = (uint32_t*) malloc(sizeof(uint32_t)*(graph->n_nodes+1));
+	routes->n_buildings = assign_node_buildings(graph,routes->node_building,&(routes->buildings));
+	routes->n_rebuilt = 0;
+
+	find_building_entrances(graph,routes);
+
+	size_t mask = 0;
+	uint32_t * previous_slots = hash_previous_buildings(previous,&mask);
+
+	route_search_context_t * context = NULL;
+	for(size_t k = 0;k < routes->n_buildings;k++){
+		building_portals_t * portals = &(routes->buildings[k]);
+		size_t table_size = ((size_t) portals->n_entrances)*portals->n_entrances;
+		for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+			portals->entrance_costs[profile] = (float*) malloc(sizeof(float)*(table_size+1));
+		}
+
+		//only buildings whose inside changed are searched again
+		const building_portals_t * old = find_unchanged_building(graph,portals,previous,previous_slots,mask);
+		if(old != NULL){
+			for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+				memcpy(portals->entrance_costs[profile],old->entrance_costs[profile],sizeof(float)*table_size);
+			}
+			continue;
+		}
+
+		if(context == NULL) context = create_route_search_context(graph->n_nodes);
+		fill_entrance_costs(graph,routes,context,k,portals);
+		routes->n_rebuilt++;
+	}
+	delete_route_search_context(context);
+	free(previous_slots);
+
+	return routes;
+}
+
+void delete_building_routes(building_routes_t * routes){
+	if(routes == NULL) return;
+
+	for(size_t k = 0;k < routes->n_buildings;k++){
+		free(routes->buildings[k].entrances);
+		for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+			free(routes->buildings[k].entrance_costs[profile]);
+		}
+	}
+	free(routes->buildings);
+	free(routes->node_building);
+	free(routes->node_entrance);
+	free(routes);
+}
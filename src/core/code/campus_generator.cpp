@@ -0,0 +1,291 @@
+#include "campus_generator.h"
+#include "node_order.h"
+#include <string.h>
+#include <math.h>
+
+//what fills a block
+#define CAMPUS_BLOCK_BUILDING 0
+#define CAMPUS_BLOCK_POND 1
+#define CAMPUS_BLOCK_PARK 2
+
+//corners of the outline of a pond
+#define CAMPUS_POND_CORDS 8
+
+//how far a building stands back from the sidewalk and its hallways from its walls, as parts of a block side
+#define CAMPUS_BUILDING_INSET 0.15
+#define CAMPUS_HALLWAY_MARGIN 0.04
+
+typedef struct Campus_Generator{
+	map_t * map;
+	const campus_options_t * options;
+	campus_stats_t stats;
+	uint64_t random_state;
+} campus_generator_t;
+
+//splitmix64, small and fast with no state beyond one word so a seed fully decides the map
+static uint64_t next_campus_random(uint64_t * state){
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27))*0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+//uniform in [0,1)
+static inline double next_campus_unit(uint64_t * state){
+	return (next_campus_random(state) >> 11)*(1.0/9007199254740992.0);
+}
+
+campus_options_t default_campus_options(void){
+	campus_options_t options;
+	options.seed = DEFAULT_CAMPUS_SEED;
+	options.origin = create_cord(-76.7150,39.2530);
+	options.blocks_x = DEFAULT_CAMPUS_BLOCKS;
+	options.blocks_y = DEFAULT_CAMPUS_BLOCKS;
+	options.block_size = DEFAULT_CAMPUS_BLOCK_SIZE;
+	options.street_width = DEFAULT_CAMPUS_STREET_WIDTH;
+	options.block_nodes = DEFAULT_CAMPUS_BLOCK_NODES;
+	options.hallway_nodes = DEFAULT_CAMPUS_HALLWAY_NODES;
+	options.max_floors = DEFAULT_CAMPUS_MAX_FLOORS;
+	options.building_probability = 0.6;
+	options.pond_probability = 0.1;
+	options.elevator_probability = 0.8;
+	options.auto_door_probability = 0.5;
+	options.ramp_probability = 0.05;
+	options.reorder_nodes = true;
+	return options;
+}
+
+double get_expected_campus_nodes(const campus_options_t * options){
+	double park_probability = fmax(0.0,1.0 - options->building_probability - options->pond_probability);
+	double building_nodes = options->building_probability*options->hallway_nodes*(1.0 + options->max_floors)/2.0;
+	double park_nodes = park_probability*(options->block_nodes - 1.0);
+	return (double) options->blocks_x*options->blocks_y*(4.0*options->block_nodes + building_nodes + park_nodes);
+}
+
+campus_options_t campus_options_for_size(size_t n_nodes,uint64_t seed){
+	campus_options_t options = default_campus_options();
+	options.seed = seed;
+	options.blocks_x = 1;
+	options.blocks_y = 1;
+	double n_blocks = fmax(1.0,round(n_nodes/get_expected_campus_nodes(&options)));
+	options.blocks_x = (uint32_t) ceil(sqrt(n_blocks));
+	options.blocks_y = (uint32_t) fmax(1.0,round(n_blocks/options.blocks_x));
+	return options;
+}
+
+//Add an outdoor node, or one on a floor of a building when building is not NULL. Returns its index.
+static size_t add_campus_node(campus_generator_t * generator,cord_t cord,building_t * building,int8_t floor_number,const char * name){
+	map_node_t * node = create_map_node(cord);
+	if(building != NULL){
+		set_map_node_building(node,building);
+		set_map_node_floor_number(node,floor_number);
+	}
+	if(name != NULL){
+		set_map_node_name(node,name);
+		set_map_node_selectable(node,true);
+	}
+	add_node_to_map(generator->map,node);
+	return generator->map->n_nodes - 1;
+}
+
+static void connect_campus_nodes(campus_generator_t * generator,size_t a,size_t b,uint8_t edge_type){
+	connect_nodes_in_map_by_indices(generator->map,a,b,edge_type);
+	generator->stats.n_edges_by_type[edge_type]++;
+}
+
+//a sidewalk edge, now and then a ramp
+static void connect_campus_sidewalk(campus_generator_t * generator,size_t a,size_t b){
+	bool ramp = next_campus_unit(&(generator->random_state)) < generator->options->ramp_probability;
+	connect_campus_nodes(generator,a,b,ramp ? EDGE_TYPE_RAMP : EDGE_TYPE_SIDEWALK);
+}
+
+/*
+ * Where node k of the sidewalk around a block is. The sidewalk has block_nodes nodes a side starting at the
+ * south west corner, then the south east, north east and north west corners, counter clockwise.
+ */
+static cord_t get_campus_ring_cord(const campus_options_t * options,cord_t south_west,uint32_t k){
+	uint32_t n = options->block_nodes;
+	double size = options->block_size;
+	double t = (double)(k % n)/n*size;
+	switch(k / n){
+		case 0: return create_cord(south_west.longitude + t,south_west.latitude);
+		case 1: return create_cord(south_west.longitude + size,south_west.latitude + t);
+		case 2: return create_cord(south_west.longitude + size - t,south_west.latitude + size);
+		default: return create_cord(south_west.longitude,south_west.latitude + size - t);
+	}
+}
+
+//index along the sidewalk of a block of the corners and of the middle of the east and west sides
+#define CAMPUS_RING_SOUTH_WEST(n) 0
+#define CAMPUS_RING_SOUTH_EAST(n) (n)
+#define CAMPUS_RING_NORTH_EAST(n) (2*(n))
+#define CAMPUS_RING_NORTH_WEST(n) (3*(n))
+#define CAMPUS_RING_EAST_MIDDLE(n) ((n) + (n)/2)
+#define CAMPUS_RING_WEST_MIDDLE(n) (3*(n) + (n)/2)
+
+//Add the sidewalk around a block. Returns the index of its first node.
+static size_t add_campus_ring(campus_generator_t * generator,cord_t south_west){
+	uint32_t n_ring = 4*generator->options->block_nodes;
+	size_t first = generator->map->n_nodes;
+	for(uint32_t k = 0;k < n_ring;k++){
+		add_campus_node(generator,get_campus_ring_cord(generator->options,south_west,k),NULL,NODE_FLOOR_NUMBER_NONE,NULL);
+	}
+	for(uint32_t k = 0;k < n_ring;k++){
+		connect_campus_sidewalk(generator,first + k,first + (k+1) % n_ring);
+	}
+	return first;
+}
+
+//A building with a hallway on every floor, joined to the sidewalk around its block by a door at each end of the ground floor.
+static void add_campus_building(campus_generator_t * generator,cord_t south_west,size_t ring){
+	const campus_options_t * options = generator->options;
+	map_t * map = generator->map;
+	uint64_t * random_state = &(generator->random_state);
+	uint32_t n = options->block_nodes;
+	uint32_t n_hallway = options->hallway_nodes;
+	double inset = CAMPUS_BUILDING_INSET*options->block_size;
+
+	cord_t bottom_left = create_cord(south_west.longitude + inset,south_west.latitude + inset);
+	cord_t top_right = create_cord(south_west.longitude + options->block_size - inset,south_west.latitude + options->block_size - inset);
+	uint8_t n_floors = 1 + next_campus_random(random_state) % options->max_floors;
+	bool has_elevator = n_floors > 1 && next_campus_unit(random_state) < options->elevator_probability;
+
+	generator->stats.n_buildings++;
+	char name[32];
+	snprintf(name,sizeof(name),"Hall %lu",generator->stats.n_buildings);
+	building_t * building = create_building(name,create_map_rect(bottom_left,top_right),n_floors);
+	add_building_to_map(map,building);
+
+	cord_t outline[4] = {bottom_left,create_cord(top_right.longitude,bottom_left.latitude),top_right,create_cord(bottom_left.longitude,top_right.latitude)};
+	mpo_t * mpo = create_mpo(outline,4,MPO_TYPE_BUILDING);
+	set_mpo_name(mpo,name);
+	add_mpo_to_map(map,mpo);
+
+	double margin = CAMPUS_HALLWAY_MARGIN*options->block_size;
+	double west = bottom_left.longitude + margin;
+	double step = (top_right.longitude - margin - west)/(n_hallway - 1);
+	double latitude = (bottom_left.latitude + top_right.latitude)/2;
+	size_t ground = map->n_nodes;
+	char room[48];
+	for(uint8_t floor = 1;floor <= n_floors;floor++){
+		size_t first = map->n_nodes;
+		for(uint32_t i = 0;i < n_hallway;i++){
+			//rooms on the odd nodes so the ends, where stairs and doors are, stay hallway
+			if(i % 2 == 1) snprintf(room,sizeof(room),"%s %u%02u",name,floor,i/2 + 1);
+			add_campus_node(generator,create_cord(west + i*step,latitude),building,(int8_t) floor,(i % 2 == 1) ? room : NULL);
+		}
+		for(uint32_t i = 0;i+1 < n_hallway;i++) connect_campus_nodes(generator,first + i,first + i + 1,EDGE_TYPE_HALLWAY);
+
+		if(floor > 1){
+			size_t below = first - n_hallway;
+			connect_campus_nodes(generator,below,first,EDGE_TYPE_STAIRS);
+			connect_campus_nodes(generator,below + n_hallway - 1,first + n_hallway - 1,EDGE_TYPE_STAIRS);
+			if(has_elevator) connect_campus_nodes(generator,below + n_hallway/2,first + n_hallway/2,EDGE_TYPE_ELEVATOR_SHAFT);
+		}
+	}
+
+	for(uint32_t side = 0;side < 2;side++){
+		uint8_t door = (next_campus_unit(random_state) < options->auto_door_probability) ? EDGE_TYPE_AUTO_DOOR : EDGE_TYPE_DOOR;
+		if(side == 0) connect_campus_nodes(generator,ring + CAMPUS_RING_WEST_MIDDLE(n),ground,door);
+		else connect_campus_nodes(generator,ring + CAMPUS_RING_EAST_MIDDLE(n),ground + n_hallway - 1,door);
+	}
+}
+
+//A pond of uneven outline in the middle of a block.
+static void add_campus_pond(campus_generator_t * generator,cord_t south_west){
+	const campus_options_t * options = generator->options;
+	double half = options->block_size/2;
+	cord_t center = create_cord(south_west.longitude + half,south_west.latitude + half);
+	cord_t outline[CAMPUS_POND_CORDS];
+	for(size_t i = 0;i < CAMPUS_POND_CORDS;i++){
+		double angle = 2*M_PI*i/CAMPUS_POND_CORDS;
+		double radius = half*(0.5 + 0.3*next_campus_unit(&(generator->random_state)));
+		outline[i] = create_cord(center.longitude + radius*cos(angle),center.latitude + radius*sin(angle));
+	}
+	add_mpo_to_map(generator->map,create_mpo(outline,CAMPUS_POND_CORDS,MPO_TYPE_WATER));
+	generator->stats.n_ponds++;
+}
+
+//Trees over a block with a path across it from the middle of its west side to the middle of its east side.
+static void add_campus_park(campus_generator_t * generator,cord_t south_west,size_t ring){
+	const campus_options_t * options = generator->options;
+	uint32_t n = options->block_nodes;
+	double inset = 0.05*options->block_size;
+	double far = options->block_size - inset;
+	cord_t outline[4] = {
+		create_cord(south_west.longitude + inset,south_west.latitude + inset),
+		create_cord(south_west.longitude + far,south_west.latitude + inset),
+		create_cord(south_west.longitude + far,south_west.latitude + far),
+		create_cord(south_west.longitude + inset,south_west.latitude + far)
+	};
+	add_mpo_to_map(generator->map,create_mpo(outline,4,MPO_TYPE_TREE));
+
+	size_t west = ring + CAMPUS_RING_WEST_MIDDLE(n);
+	size_t east = ring + CAMPUS_RING_EAST_MIDDLE(n);
+	cord_t from = generator->map->all_nodes[west]->coordinate;
+	cord_t to = generator->map->all_nodes[east]->coordinate;
+	size_t previous = west;
+	for(uint32_t j = 1;j < n;j++){
+		double t = (double) j/n;
+		cord_t cord = create_cord(from.longitude + t*(to.longitude - from.longitude),from.latitude + t*(to.latitude - from.latitude));
+		size_t index = add_campus_node(generator,cord,NULL,NODE_FLOOR_NUMBER_NONE,NULL);
+		connect_campus_sidewalk(generator,previous,index);
+		previous = index;
+	}
+	connect_campus_sidewalk(generator,previous,east);
+	generator->stats.n_parks++;
+}
+
+bool generate_campus_map(map_t * map,const campus_options_t * options,campus_stats_t * stats){
+	if(options->blocks_x == 0 || options->blocks_y == 0 || options->block_nodes < 2 || options->hallway_nodes < 2) return false;
+	if(options->max_floors == 0 || options->max_floors > 127) return false;
+
+	campus_generator_t generator;
+	generator.map = map;
+	generator.options = options;
+	memset(&(generator.stats),0,sizeof(campus_stats_t));
+	generator.random_state = options->seed;
+
+	size_t first_node = map->n_nodes;
+	size_t first_edge = map->n_edges;
+	size_t first_mpo = map->n_mpos;
+	double expected_nodes = get_expected_campus_nodes(options);
+	reserve_map_capacity(map,(size_t) expected_nodes,(size_t)(1.25*expected_nodes));
+
+	//first sidewalk node of the blocks of the row below, to lay the crosswalks to
+	uint32_t n = options->block_nodes;
+	size_t * rings_below = (size_t*) malloc(sizeof(size_t)*options->blocks_x);
+	double pitch = options->block_size + options->street_width;
+	for(uint32_t y = 0;y < options->blocks_y;y++){
+		for(uint32_t x = 0;x < options->blocks_x;x++){
+			cord_t south_west = create_cord(options->origin.longitude + x*pitch,options->origin.latitude + y*pitch);
+			size_t ring = add_campus_ring(&generator,south_west);
+
+			if(x > 0){
+				size_t ring_west = rings_below[x-1];//already replaced by the block to the west in this row
+				connect_campus_nodes(&generator,ring_west + CAMPUS_RING_SOUTH_EAST(n),ring + CAMPUS_RING_SOUTH_WEST(n),EDGE_TYPE_CROSSWALK);
+				connect_campus_nodes(&generator,ring_west + CAMPUS_RING_NORTH_EAST(n),ring + CAMPUS_RING_NORTH_WEST(n),EDGE_TYPE_CROSSWALK);
+			}
+			if(y > 0){
+				size_t ring_south = rings_below[x];
+				connect_campus_nodes(&generator,ring_south + CAMPUS_RING_NORTH_WEST(n),ring + CAMPUS_RING_SOUTH_WEST(n),EDGE_TYPE_CROSSWALK);
+				connect_campus_nodes(&generator,ring_south + CAMPUS_RING_NORTH_EAST(n),ring + CAMPUS_RING_SOUTH_EAST(n),EDGE_TYPE_CROSSWALK);
+			}
+			rings_below[x] = ring;
+
+			double kind = next_campus_unit(&(generator.random_state));
+			if(kind < options->building_probability) add_campus_building(&generator,south_west,ring);
+			else if(kind < options->building_probability + options->pond_probability) add_campus_pond(&generator,south_west);
+			else add_campus_park(&generator,south_west,ring);
+			generator.stats.n_blocks++;
+		}
+	}
+	free(rings_below);
+
+	generator.stats.n_nodes = map->n_nodes - first_node;
+	generator.stats.n_edges = map->n_edges - first_edge;
+	generator.stats.n_mpos = map->n_mpos - first_mpo;
+	if(options->reorder_nodes) reorder_map_nodes(map,MAP_NODE_ORDER_HILBERT);
+	if(stats != NULL) *stats = generator.stats;
+	return true;
+}
@@ -0,0 +1,186 @@
+#include "distance_matrix.h"
+
+typedef struct Distance_Matrix_Job{
+	const map_graph_t * graph;
+	uint8_t profile;
+
+	//distinct nodes searched from
+	const uint32_t * roots;
+
+	//nodes every search has to settle, with duplicates, and a mark for each distinct one
+	const uint32_t * others;
+	size_t n_others;
+	const uint8_t * other_marks;
+	size_t n_distinct_others;
+
+	//one row of n_others costs per root
+	float * rows;
+
+	route_search_context_t ** contexts;
+} distance_matrix_job_t;
+
+static size_t fill_distance_row(const map_graph_t * graph,route_search_context_t * context,uint32_t source,const uint8_t * target_marks,size_t n_distinct_targets,const uint32_t * targets,size_t n_targets,uint8_t profile,float * row){
+	//the stamps would still be those of the last search
+	if(source >= graph->n_nodes || context->n_nodes < graph->n_nodes){
+		for(size_t j = 0;j < n_targets;j++) row[j] = INFINITY;
+		return 0;
+	}
+
+	grow_route_search_tree(graph,context,source,target_marks,n_distinct_targets,INFINITY,profile);
+
+	size_t n_reachable = 0;
+	for(size_t j = 0;j < n_targets;j++){
+		if(route_search_reached(context,targets[j])){
+			row[j] = (float) context->cost[targets[j]];
+			n_reachable++;
+		}else{
+			row[j] = INFINITY;
+		}
+	}
+
+	return n_reachable;
+}
+
+/*
+ * Mark every node in a list and count how many distinct nodes it holds
+ */
+static size_t mark_distinct_nodes(size_t n_graph_nodes,const uint32_t * nodes,size_t n_list_nodes,uint8_t * marks){
+	size_t n_distinct = 0;
+
+	for(size_t i = 0;i < n_graph_nodes;i++) marks[i] = 0;
+	for(size_t i = 0;i < n_list_nodes;i++){
+		uint32_t node = nodes[i];
+		if(marks[node]) continue;
+
+		marks[node] = 1;
+		n_distinct++;
+	}
+
+	return n_distinct;
+}
+
+size_t compute_distance_row(const map_graph_t * graph,route_search_context_t * context,uint32_t source,const uint32_t * targets,size_t n_targets,uint8_t profile,float * row){
+	if(n_targets == 0 || row == NULL) return 0;
+
+	//every way out before the search leaves a row of unreachable targets
+	for(size_t j = 0;j < n_targets;j++) row[j] = INFINITY;
+	if(graph == NULL || context == NULL || targets == NULL) return 0;
+	if(get_route_profile_cost_function(profile) == NULL) return 0;
+
+	for(size_t j = 0;j < n_targets;j++){
+		if(targets[j] >= graph->n_nodes) return 0;
+	}
+
+	uint8_t * marks = (uint8_t*) malloc(graph->n_nodes+1);
+	size_t n_distinct = mark_distinct_nodes(graph->n_nodes,targets,n_targets,marks);
+
+	size_t n_reachable = fill_distance_row(graph,context,source,marks,n_distinct,targets,n_targets,profile,row);
+
+	free(marks);
+	return n_reachable;
+}
+
+static void run_distance_matrix_row(size_t task_index,size_t worker_index,void * user_data){
+	distance_matrix_job_t * job = (distance_matrix_job_t*) user_data;
+
+	route_search_context_t * context = job->contexts[worker_index];
+	if(context == NULL){
+		context = create_route_search_context(job->graph->n_nodes);
+		job->contexts[worker_index] = context;
+	}
+
+	fill_distance_row(job->graph,context,job->roots[task_index],job->other_marks,job->n_distinct_others,
+		job->others,job->n_others,job->profile,job->rows + task_index*job->n_others);
+}
+
+float * compute_distance_matrix(thread_pool_t * pool,const map_graph_t * graph,const uint32_t * sources,size_t n_sources,const uint32_t * targets,size_t n_targets,uint8_t profile){
+	if(pool == NULL || graph == NULL || sources == NULL || targets == NULL) return NULL;
+	if(n_sources == 0 || n_targets == 0) return NULL;
+
+	if(get_route_profile_cost_function(profile) == NULL) return NULL;
+
+	for(size_t i = 0;i < n_sources;i++) if(sources[i] >= graph->n_nodes) return NULL;
+	for(size_t j = 0;j < n_targets;j++) if(targets[j] >= graph->n_nodes) return NULL;
+
+	uint8_t * source_marks = (uint8_t*) malloc(graph->n_nodes+1);
+	uint8_t * target_marks = (uint8_t*) malloc(graph->n_nodes+1);
+	uint32_t * first_index = (uint32_t*) malloc(sizeof(uint32_t)*(graph->n_nodes+1));
+
+	size_t n_distinct_sources = mark_distinct_nodes(graph->n_nodes,sources,n_sources,source_marks);
+	size_t n_distinct_targets = mark_distinct_nodes(graph->n_nodes,targets,n_targets,target_marks);
+
+	//costs are symmetric so search from whichever side has fewer distinct nodes
+	bool reversed = n_distinct_targets < n_distinct_sources;
+	const uint32_t * root_list = reversed ? targets : sources;
+	size_t n_root_list = reversed ? n_targets : n_sources;
+
+	distance_matrix_job_t job;
+	job.graph = graph;
+	job.profile = profile;
+	job.others = reversed ? sources : targets;
+	job.n_others = reversed ? n_sources : n_targets;
+	job.other_marks = reversed ? source_marks : target_marks;
+	job.n_distinct_others = reversed ? n_distinct_sources : n_distinct_targets;
+
+	//collect the distinct roots, first_index maps each root node to its row.
+	//the root side's marks are not needed by the searches so they are reused as a seen flag.
+	uint8_t * root_marks = reversed ? target_marks : source_marks;
+	size_t n_roots = reversed ? n_distinct_targets : n_distinct_sources;
+	uint32_t * roots = (uint32_t*) malloc(sizeof(uint32_t)*n_roots);
+	size_t at = 0;
+	for(size_t i = 0;i < n_root_list;i++){
+		uint32_t node = root_list[i];
+		if(root_marks[node] != 1) continue;
+
+		root_marks[node] = 2;//seen, skip the duplicates
+		first_index[node] = at;
+		roots[at] = node;
+		at++;
+	}
+	job.roots = roots;
+	job.rows = (float*) malloc(sizeof(float)*n_roots*job.n_others);
+	job.contexts = (route_search_context_t**) malloc(sizeof(route_search_context_t*)*pool->n_workers);
+	for(size_t i = 0;i < pool->n_workers;i++) job.contexts[i] = NULL;
+
+	run_thread_pool_tasks(pool,n_roots,run_distance_matrix_row,&job);
+
+	//spread the rows of the distinct roots out into the full matrix
+	float * matrix = (float*) malloc(sizeof(float)*n_sources*n_targets);
+	for(size_t i = 0;i < n_sources;i++){
+		for(size_t j = 0;j < n_targets;j++){
+			if(reversed){
+				matrix[i*n_targets + j] = job.rows[first_index[targets[j]]*job.n_others + i];
+			}else{
+				matrix[i*n_targets + j] = job.rows[first_index[sources[i]]*job.n_others + j];
+			}
+		}
+	}
+
+	for(size_t i = 0;i < pool->n_workers;i++) delete_route_search_context(job.contexts[i]);
+	free(job.contexts);
+	free(job.rows);
+	free(roots);
+	free(first_index);
+	free(target_marks);
+	free(source_marks);
+
+	return matrix;
+}
+
+void save_distance_matrix_csv(const float * matrix,size_t n_rows,size_t n_columns,FILE * file){
+	if(matrix == NULL || file == NULL) return;
+
+	for(size_t i = 0;i < n_rows;i++){
+		for(size_t j = 0;j < n_columns;j++){
+			if(j > 0) fputc(',',file);
+
+			float value = matrix[i*n_columns + j];
+			if(isinf(value)){
+				fputs("inf",file);
+			}else{
+				fprintf(file,"%.3f",value);
+			}
+		}
+		fputc('\n',file);
+	}
+}
@@ -0,0 +1,143 @@
+#include "edge_closures.h"
+#include "building_routes.h"
+
+edge_closures_t * create_edge_closures(map_graph_t * graph){
+	if(graph == NULL) return NULL;
+
+	retain_map_graph(graph);
+
+	edge_closures_t * closures = (edge_closures_t*) malloc(sizeof(edge_closures_t));
+	closures->graph = graph;
+
+	size_t n_words = (graph->n_edges + 63)/64 + 1;
+	closures->closed_edges = (uint64_t*) malloc(sizeof(uint64_t)*n_words);
+	for(size_t i = 0;i < n_words;i++) closures->closed_edges[i] = 0;
+
+	closures->window_start = (int64_t*) malloc(sizeof(int64_t)*(graph->n_edges+1));
+	closures->window_end = (int64_t*) malloc(sizeof(int64_t)*(graph->n_edges+1));
+	closures->window_sequence = (uint32_t*) malloc(sizeof(uint32_t)*(graph->n_edges+1));
+	for(size_t j = 0;j < graph->n_edges;j++) closures->window_sequence[j] = 0;
+
+	size_t n_buildings = graph->building_routes->n_buildings;
+	closures->building_closures = (uint32_t*) malloc(sizeof(uint32_t)*(n_buildings+1));
+	for(size_t k = 0;k < n_buildings;k++) closures->building_closures[k] = 0;
+
+	closures->n_closed = 0;
+
+	return closures;
+}
+
+edge_closures_t * carry_edge_closures(const edge_closures_t * previous,map_graph_t * graph){
+	edge_closures_t * closures = create_edge_closures(graph);
+	if(closures == NULL || previous == NULL || __atomic_load_n(&(previous->n_closed),__ATOMIC_RELAXED) == 0) return closures;
+
+	//the closed bits are copied first so closures changing meanwhile can not overfill the hash
+	const map_graph_t * old_graph = previous->graph;
+	size_t n_words = (old_graph->n_edges + 63)/64;
+	uint64_t * closed_edges = (uint64_t*) malloc(sizeof(uint64_t)*(n_words+1));
+	size_t n_closed = 0;
+	for(size_t i = 0;i < n_words;i++){
+		closed_edges[i] = __atomic_load_n(&(previous->closed_edges[i]),__ATOMIC_ACQUIRE);
+		n_closed += __builtin_popcountll(closed_edges[i]);
+	}
+
+	//closed source edges are looked up in a small hash, only the closures are visited from the old side
+	size_t n_slots = 16;
+	while(n_slots < 2*n_closed) n_slots *= 2;
+	size_t mask = n_slots - 1;
+
+	uint32_t * slots = (uint32_t*) malloc(sizeof(uint32_t)*n_slots);
+	for(size_t i = 0;i < n_slots;i++) slots[i] = UINT32_MAX;
+
+	for(size_t j = 0;j < old_graph->n_edges;j++){
+		if(!((closed_edges[j >> 6] >> (j & 63)) & 1)) continue;
+
+		size_t slot = ((uintptr_t) old_graph->source_edges[j] >> 4) & mask;
+		while(slots[slot] != UINT32_MAX) slot = (slot+1) & mask;
+		slots[slot] = j;
+	}
+
+	for(size_t j = 0;j < graph->n_edges;j++){
+		size_t slot = ((uintptr_t) graph->source_edges[j] >> 4) & mask;
+		while(slots[slot] != UINT32_MAX){
+			uint32_t old = slots[slot];
+			if(old_graph->source_edges[old] == graph->source_edges[j]){
+				int64_t start,end;
+				get_edge_closure_window(previous,old,&start,&end);
+				close_map_graph_edge(closures,j,start,end);
+				break;
+			}
+			slot = (slot+1) & mask;
+		}
+	}
+
+	free(slots);
+	free(closed_edges);
+	return closures;
+}
+
+void delete_edge_closures(edge_closures_t * closures){
+	if(closures == NULL) return;
+
+	release_map_graph(closures->graph);
+	free(closures->closed_edges);
+	free(closures->window_start);
+	free(closures->window_end);
+	free(closures->window_sequence);
+	free(closures->building_closures);
+	free(closures);
+}
+
+//the building both ends of an edge are in, NODE_OUTDOORS if the edge is not inside one building
+static uint32_t get_edge_building(const map_graph_t * graph,uint32_t edge_index){
+	const building_routes_t * routes = graph->building_routes;
+	uint32_t building_a = routes->node_building[graph->edge_nodes[2*edge_index]];
+	uint32_t building_b = routes->node_building[graph->edge_nodes[2*edge_index+1]];
+
+	return (building_a == building_b) ? building_a : NODE_OUTDOORS;
+}
+
+void close_map_graph_edge(edge_closures_t * closures,uint32_t edge_index,int64_t start_time,int64_t end_time){
+	if(closures == NULL || edge_index >= closures->graph->n_edges) return;
+
+	//take the sequence from even to odd, waiting out any other writer of the same edge
+	uint32_t * sequence = &(closures->window_sequence[edge_index]);
+	uint32_t even = __atomic_load_n(sequence,__ATOMIC_RELAXED);
+	while((even & 1) || !__atomic_compare_exchange_n(sequence,&even,even+1,false,__ATOMIC_ACQUIRE,__ATOMIC_RELAXED)){
+		even = __atomic_load_n(sequence,__ATOMIC_RELAXED);
+	}
+
+	//the odd sequence has to be visible before any of the window is, or a reader could pair a half written
+	//window with the old even sequence
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&(closures->window_start[edge_index]),start_time,__ATOMIC_RELAXED);
+	__atomic_store_n(&(closures->window_end[edge_index]),end_time,__ATOMIC_RELAXED);
+	__atomic_store_n(sequence,even+2,__ATOMIC_RELEASE);
+
+	//the window is written before the bit is published so a reader never sees a stale window
+	uint64_t bit = ((uint64_t) 1) << (edge_index & 63);
+	uint64_t old_word = __atomic_fetch_or(&(closures->closed_edges[edge_index >> 6]),bit,__ATOMIC_RELEASE);
+	if(old_word & bit) return;//only the window changed
+
+	__atomic_add_fetch(&(closures->n_closed),1,__ATOMIC_RELAXED);
+	uint32_t building = get_edge_building(closures->graph,edge_index);
+	if(building != NODE_OUTDOORS) __atomic_add_fetch(&(closures->building_closures[building]),1,__ATOMIC_RELEASE);
+}
+
+void reopen_map_graph_edge(edge_closures_t * closures,uint32_t edge_index){
+	if(closures == NULL || edge_index >= closures->graph->n_edges) return;
+
+	uint64_t bit = ((uint64_t) 1) << (edge_index & 63);
+	uint64_t old_word = __atomic_fetch_and(&(closures->closed_edges[edge_index >> 6]),~bit,__ATOMIC_RELEASE);
+	if(!(old_word & bit)) return;
+
+	__atomic_sub_fetch(&(closures->n_closed),1,__ATOMIC_RELAXED);
+	uint32_t building = get_edge_building(closures->graph,edge_index);
+	if(building != NODE_OUTDOORS) __atomic_sub_fetch(&(closures->building_closures[building]),1,__ATOMIC_RELEASE);
+}
+
+bool building_has_closures(const edge_closures_t * closures,uint32_t building_index){
+	if(closures == NULL) return false;
+
+	return __atomic_load_n(&(closures->building_closures[building_index]),__ATOMIC_ACQUIRE) != 0;
+}
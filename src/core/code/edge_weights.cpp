@@ -0,0 +1,127 @@
+#include "edge_weights.h"
+#include "cost_profiles.h"
+
+static bool map_edges_match(const map_edge_t * x,const map_edge_t * y){
+	if(x->type != y->type) return false;
+	if(x->a->floor_number != y->a->floor_number || x->b->floor_number != y->b->floor_number) return false;
+
+	return x->a->coordinate.latitude == y->a->coordinate.latitude && x->a->coordinate.longitude == y->a->coordinate.longitude
+		&& x->b->coordinate.latitude == y->b->coordinate.latitude && x->b->coordinate.longitude == y->b->coordinate.longitude;
+}
+
+static size_t hash_edge_pointer(const map_edge_t * edge,size_t mask){
+	uint64_t key = (uint64_t)(uintptr_t) edge;
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	return (size_t) key & mask;
+}
+
+/*
+ * For every edge of graph, the index of the same source edge in previous or UINT32_MAX.
+ * Edges are removed from the middle of map_t::all_edges so the indices do not line up.
+ */
+static uint32_t * match_previous_edges(const map_graph_t * graph,const map_graph_t * previous){
+	size_t n_slots = 16;
+	while(n_slots < 2*previous->n_edges) n_slots *= 2;
+	size_t mask = n_slots - 1;
+
+	uint32_t * slots = (uint32_t*) malloc(sizeof(uint32_t)*n_slots);
+	for(size_t i = 0;i < n_slots;i++) slots[i] = UINT32_MAX;
+
+	for(size_t j = 0;j < previous->n_edges;j++){
+		size_t slot = hash_edge_pointer(previous->source_edges[j],mask);
+		while(slots[slot] != UINT32_MAX) slot = (slot+1) & mask;
+		slots[slot] = j;
+	}
+
+	uint32_t * matches = (uint32_t*) malloc(sizeof(uint32_t)*(graph->n_edges+1));
+	for(size_t i = 0;i < graph->n_edges;i++){
+		matches[i] = UINT32_MAX;
+
+		size_t slot = hash_edge_pointer(graph->source_edges[i],mask);
+		while(slots[slot] != UINT32_MAX){
+			if(previous->source_edges[slots[slot]] == graph->source_edges[i]){
+				matches[i] = slots[slot];
+				break;
+			}
+			slot = (slot+1) & mask;
+		}
+	}
+
+	free(slots);
+	return matches;
+}
+
+/*
+ * Measure edge i of graph from its hot nodes and write its length and profile weights
+ */
+static void measure_edge_weights(edge_weights_t * weights,const map_graph_t * graph,size_t i){
+	const double degrees_to_radians = M_PI/180.0;
+	const map_graph_node_t * a = &(graph->hot_nodes[graph->edge_nodes[2*i]]);
+	const map_graph_node_t * b = &(graph->hot_nodes[graph->edge_nodes[2*i+1]]);
+
+	double half_d_lat = (b->coordinate.latitude - a->coordinate.latitude)*(degrees_to_radians/2.0);
+	double half_d_lon = (b->coordinate.longitude - a->coordinate.longitude)*(degrees_to_radians/2.0);
+	double sin_d_lat = sin(half_d_lat);
+	double sin_d_lon = sin(half_d_lon);
+	double h = sin_d_lat*sin_d_lat + cos(a->coordinate.latitude*degrees_to_radians)*cos(b->coordinate.latitude*degrees_to_radians)*sin_d_lon*sin_d_lon;
+	double ground = 2.0*EARTH_RADIUS_METERS*asin(fmin(1.0,sqrt(h)));
+
+	bool has_floors = a->floor_number != NODE_FLOOR_NUMBER_NONE && b->floor_number != NODE_FLOOR_NUMBER_NONE;
+	double climb = has_floors ? fabs((double)(a->floor_number - b->floor_number))*FLOOR_HEIGHT_METERS : 0.0;
+	double length = sqrt(ground*ground + climb*climb);
+	weights->lengths[i] = (float) length;
+
+	uint8_t type = (graph->edges[i].type < N_EDGE_TYPES) ? graph->edges[i].type : 0;
+	for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+		//a zero length edge times an impassable multiplier would be NaN
+		double multiplier = get_profile_type_multipliers(profile)[type];
+		weights->profile_weights[profile][i] = isinf(multiplier) ? EDGE_COST_IMPASSABLE : (float)(length*multiplier);
+	}
+}
+
+edge_weights_t * create_edge_weights(const map_graph_t * graph,const map_graph_t * previous){
+	if(graph == NULL) return NULL;
+
+	edge_weights_t * weights = (edge_weights_t*) malloc(sizeof(edge_weights_t));
+	weights->n_edges = graph->n_edges;
+	weights->lengths = (float*) malloc(sizeof(float)*(graph->n_edges+1));
+	for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+		weights->profile_weights[profile] = (float*) malloc(sizeof(float)*(graph->n_edges+1));
+	}
+	weights->n_refreshed = 0;
+
+	uint32_t * matches = NULL;
+	if(previous != NULL && previous->weights != NULL && previous->n_edges > 0){
+		matches = match_previous_edges(graph,previous);
+	}
+
+	for(size_t i = 0;i < graph->n_edges;i++){
+		//untouched edges keep the weights they had
+		if(matches != NULL && matches[i] != UINT32_MAX && map_edges_match(&(graph->edges[i]),&(previous->edges[matches[i]]))){
+			uint32_t j = matches[i];
+			weights->lengths[i] = previous->weights->lengths[j];
+			for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+				weights->profile_weights[profile][i] = previous->weights->profile_weights[profile][j];
+			}
+			continue;
+		}
+
+		measure_edge_weights(weights,graph,i);
+		weights->n_refreshed++;
+	}
+
+	free(matches);
+	return weights;
+}
+
+void delete_edge_weights(edge_weights_t * weights){
+	if(weights == NULL) return;
+
+	free(weights->lengths);
+	for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+		free(weights->profile_weights[profile]);
+	}
+	free(weights);
+}
@@ -0,0 +1,371 @@
+#include "floor_layers.h"
+#include "edge_weights.h"
+#include "routing.h"
+
+static size_t hash_floor_key(const building_t * building,int8_t floor_number,size_t mask){
+	uint64_t key = ((uint64_t)(uintptr_t) building) ^ (((uint64_t)(uint8_t) floor_number) << 56);
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	return (size_t) key & mask;
+}
+
+/*
+ * Give every node the index of its layer, numbering layers in the order they are first seen.
+ * Returns the number of layers.
+ */
+static size_t assign_node_layers(const map_graph_t * graph,uint32_t * node_layer,floor_layer_t ** layers_out){
+	size_t n_slots = 16;
+	while(n_slots < 2*graph->n_nodes) n_slots *= 2;
+	size_t mask = n_slots - 1;
+
+	uint32_t * slots = (uint32_t*) malloc(sizeof(uint32_t)*n_slots);
+	for(size_t i = 0;i < n_slots;i++) slots[i] = UINT32_MAX;
+
+	size_t layers_capacity = 8;
+	floor_layer_t * layers = (floor_layer_t*) malloc(sizeof(floor_layer_t)*layers_capacity);
+	size_t n_layers = 0;
+
+	for(size_t i = 0;i < graph->n_nodes;i++){
+		map_node_view_t node = get_map_graph_node_view(graph,i);
+		const building_t * building = get_map_node_view_building(node);
+		int8_t floor_number = get_map_node_view_floor_number(node);
+
+		size_t slot = hash_floor_key(building,floor_number,mask);
+		while(slots[slot] != UINT32_MAX){
+			floor_layer_t * layer = &(layers[slots[slot]]);
+			if(layer->building == building && layer->floor_number == floor_number) break;
+			slot = (slot+1) & mask;
+		}
+
+		if(slots[slot] == UINT32_MAX){
+			if(n_layers == layers_capacity){
+				layers_capacity *= 2;
+				layers = (floor_layer_t*) realloc(layers,sizeof(floor_layer_t)*layers_capacity);
+			}
+
+			floor_layer_t * layer = &(layers[n_layers]);
+			layer->building = building;
+			layer->floor_number = floor_number;
+			layer->n_nodes = 0;
+			layer->n_edges = 0;
+			layer->n_portals = 0;
+			layer->n_neighbours = 0;
+
+			slots[slot] = n_layers;
+			n_layers++;
+		}
+
+		node_layer[i] = slots[slot];
+		layers[slots[slot]].n_nodes++;
+	}
+
+	free(slots);
+	*layers_out = layers;
+	return n_layers;
+}
+
+static void set_floor_edge_bit(uint64_t * bits,uint32_t edge,bool value){
+	if(value){
+		bits[edge >> 6] |= ((uint64_t) 1) << (edge & 63);
+	}else{
+		bits[edge >> 6] &= ~(((uint64_t) 1) << (edge & 63));
+	}
+}
+
+//allow or forbid the edges of a layer, and the portals between it and other if other is not UINT32_MAX
+static void set_floor_layer_edge_bits(const map_graph_t * graph,const floor_layers_t * layers,uint32_t l,uint32_t other,uint64_t * bits,bool value){
+	const floor_layer_t * layer = &(layers->layers[l]);
+	for(uint32_t k = layer->first_edge;k < layer->first_edge + layer->n_edges;k++) set_floor_edge_bit(bits,layers->layer_edges[k],value);
+	if(other == UINT32_MAX) return;
+
+	for(uint32_t p = layer->first_portal;p < layer->first_portal + layer->n_portals;p++){
+		uint32_t portal = layers->layer_portals[p];
+		uint32_t layer_a = layers->node_layer[graph->edge_nodes[2*portal]];
+		uint32_t layer_b = layers->node_layer[graph->edge_nodes[2*portal+1]];
+		if(layer_a == other || layer_b == other) set_floor_edge_bit(bits,portal,value);
+	}
+}
+
+//cost from a to b with only the edges in bits, EDGE_COST_IMPASSABLE if there is no such path
+static double measure_floor_path(const map_graph_t * graph,route_search_context_t * context,uint32_t a,uint32_t b,uint8_t profile,const uint64_t * bits){
+	if(!search_map_graph_with_allowed_edges(graph,context,a,b,profile,bits,INFINITY,NULL)) return EDGE_COST_IMPASSABLE;
+	return context->cost[b];
+}
+
+/*
+ * For every profile, can a path between two of entries through layer l and back be shorter than the path between
+ * them on other? Returns the profiles that can as bits.
+ */
+static uint8_t find_floor_layer_shortcuts(const map_graph_t * graph,const floor_layers_t * layers,uint32_t l,uint32_t other,const uint32_t * entries,uint32_t n_entries,route_search_context_t * context,uint64_t * through_bits,uint64_t * around_bits){
+	set_floor_layer_edge_bits(graph,layers,l,other,through_bits,true);
+	set_floor_layer_edge_bits(graph,layers,other,UINT32_MAX,around_bits,true);
+
+	uint8_t shortcuts = 0;
+	for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+		for(uint32_t i = 0;i < n_entries && !((shortcuts >> profile) & 1);i++){
+			for(uint32_t j = i+1;j < n_entries;j++){
+				double through = measure_floor_path(graph,context,entries[i],entries[j],profile,through_bits);
+				if(isinf(through)) continue;
+				if(through < measure_floor_path(graph,context,entries[i],entries[j],profile,around_bits)){
+					shortcuts |= 1 << profile;
+					break;
+				}
+			}
+		}
+	}
+
+	set_floor_layer_edge_bits(graph,layers,l,other,through_bits,false);
+	set_floor_layer_edge_bits(graph,layers,other,UINT32_MAX,around_bits,false);
+	return shortcuts;
+}
+
+floor_layers_t * create_floor_layers(const map_graph_t * graph){
+	if(graph == NULL) return NULL;
+
+	floor_layers_t * layers = (floor_layers_t*) malloc(sizeof(floor_layers_t));
+	layers->node_layer = (uint32_t*) malloc(sizeof(uint32_t)*(graph->n_nodes+1));
+	layers->n_layers = assign_node_layers(graph,layers->node_layer,&(layers->layers));
+
+	//count the edges inside and between layers
+	layers->n_portal_edges = 0;
+	for(size_t j = 0;j < graph->n_edges;j++){
+		uint32_t layer_a = layers->node_layer[graph->edge_nodes[2*j]];
+		uint32_t layer_b = layers->node_layer[graph->edge_nodes[2*j+1]];
+
+		if(layer_a == layer_b){
+			layers->layers[layer_a].n_edges++;
+		}else{
+			layers->layers[layer_a].n_portals++;
+			layers->layers[layer_b].n_portals++;
+			layers->n_portal_edges++;
+		}
+	}
+
+	//prefix sums turn the counts into ranges
+	uint32_t next_node = 0;
+	uint32_t next_edge = 0;
+	uint32_t next_portal = 0;
+	for(size_t l = 0;l < layers->n_layers;l++){
+		floor_layer_t * layer = &(layers->layers[l]);
+		layer->first_node = next_node;
+		layer->first_edge = next_edge;
+		layer->first_portal = next_portal;
+		next_node += layer->n_nodes;
+		next_edge += layer->n_edges;
+		next_portal += layer->n_portals;
+		layer->n_nodes = 0;
+		layer->n_edges = 0;
+		layer->n_portals = 0;
+	}
+
+	layers->layer_nodes = (uint32_t*) malloc(sizeof(uint32_t)*(next_node+1));
+	layers->layer_edges = (uint32_t*) malloc(sizeof(uint32_t)*(next_edge+1));
+	layers->layer_portals = (uint32_t*) malloc(sizeof(uint32_t)*(next_portal+1));
+
+	for(size_t i = 0;i < graph->n_nodes;i++){
+		floor_layer_t * layer = &(layers->layers[layers->node_layer[i]]);
+		layers->layer_nodes[layer->first_node + layer->n_nodes] = i;
+		layer->n_nodes++;
+	}
+
+	for(size_t j = 0;j < graph->n_edges;j++){
+		floor_layer_t * layer_a = &(layers->layers[layers->node_layer[graph->edge_nodes[2*j]]]);
+		floor_layer_t * layer_b = &(layers->layers[layers->node_layer[graph->edge_nodes[2*j+1]]]);
+
+		if(layer_a == layer_b){
+			layers->layer_edges[layer_a->first_edge + layer_a->n_edges] = j;
+			layer_a->n_edges++;
+		}else{
+			layers->layer_portals[layer_a->first_portal + layer_a->n_portals] = j;
+			layer_a->n_portals++;
+			layers->layer_portals[layer_b->first_portal + layer_b->n_portals] = j;
+			layer_b->n_portals++;
+		}
+	}
+
+	//distinct neighbouring layers, a layer can have many portals to the same neighbour
+	layers->layer_neighbours = (uint32_t*) malloc(sizeof(uint32_t)*(next_portal+1));
+	layers->layer_neighbour_portals = (uint32_t*) malloc(sizeof(uint32_t)*(next_portal+1));
+	layers->layer_neighbour_entries = (uint32_t*) malloc(sizeof(uint32_t)*(next_portal+1));
+	layers->layer_neighbour_shortcuts = (uint8_t*) malloc(sizeof(uint8_t)*(next_portal+1));
+	uint32_t * last_seen = (uint32_t*) malloc(sizeof(uint32_t)*(layers->n_layers+1));
+	uint32_t * neighbour_slot = (uint32_t*) malloc(sizeof(uint32_t)*(layers->n_layers+1));
+	uint32_t * entry_seen = (uint32_t*) malloc(sizeof(uint32_t)*(graph->n_nodes+1));
+	for(size_t l = 0;l < layers->n_layers;l++) last_seen[l] = UINT32_MAX;
+	for(size_t i = 0;i < graph->n_nodes;i++) entry_seen[i] = UINT32_MAX;
+
+	uint32_t next_neighbour = 0;
+	for(size_t l = 0;l < layers->n_layers;l++){
+		floor_layer_t * layer = &(layers->layers[l]);
+		layer->first_neighbour = next_neighbour;
+
+		for(uint32_t p = layer->first_portal;p < layer->first_portal + layer->n_portals;p++){
+			uint32_t portal = layers->layer_portals[p];
+			uint32_t other_node = graph->edge_nodes[2*portal];
+			if(layers->node_layer[other_node] == l) other_node = graph->edge_nodes[2*portal+1];
+			uint32_t other = layers->node_layer[other_node];
+
+			if(last_seen[other] != l){
+				last_seen[other] = l;
+				neighbour_slot[other] = next_neighbour;
+				layers->layer_neighbours[next_neighbour] = other;
+				layers->layer_neighbour_portals[next_neighbour] = 0;
+				layers->layer_neighbour_entries[next_neighbour] = 0;
+				next_neighbour++;
+				layer->n_neighbours++;
+			}
+
+			//slots are never reused so they tell the entries seen from one layer apart from the rest
+			uint32_t slot = neighbour_slot[other];
+			layers->layer_neighbour_portals[slot]++;
+			if(entry_seen[other_node] != slot){
+				entry_seen[other_node] = slot;
+				layers->layer_neighbour_entries[slot]++;
+			}
+		}
+	}
+
+	//measure the detours through floors of the same building, the searches only ever visit the two floors
+	route_search_context_t * context = NULL;
+	uint64_t * through_bits = NULL;
+	uint64_t * around_bits = NULL;
+	uint32_t entries[FLOOR_LAYER_MAX_MEASURED_ENTRIES];
+	for(size_t l = 0;l < layers->n_layers;l++){
+		floor_layer_t * layer = &(layers->layers[l]);
+		for(uint32_t k = layer->first_neighbour;k < layer->first_neighbour + layer->n_neighbours;k++){
+			uint32_t other = layers->layer_neighbours[k];
+			uint32_t n_entries = layers->layer_neighbour_entries[k];
+			bool same_building = layer->building != NULL && layer->building == layers->layers[other].building;
+
+			if(n_entries <= 1){
+				layers->layer_neighbour_shortcuts[k] = 0;
+				continue;
+			}
+			if(!same_building || n_entries > FLOOR_LAYER_MAX_MEASURED_ENTRIES){
+				layers->layer_neighbour_shortcuts[k] = (1 << N_ROUTE_PROFILES) - 1;
+				continue;
+			}
+
+			//the entries again, marked with the slot count past the last real slot so they are not mistaken for it
+			n_entries = 0;
+			for(uint32_t p = layer->first_portal;p < layer->first_portal + layer->n_portals;p++){
+				uint32_t portal = layers->layer_portals[p];
+				uint32_t other_node = graph->edge_nodes[2*portal];
+				if(layers->node_layer[other_node] == l) other_node = graph->edge_nodes[2*portal+1];
+				if(layers->node_layer[other_node] != other || entry_seen[other_node] == next_neighbour + k) continue;
+
+				entry_seen[other_node] = next_neighbour + k;
+				entries[n_entries++] = other_node;
+			}
+
+			if(context == NULL){
+				size_t n_words = (graph->n_edges + 63)/64 + 1;
+				context = create_route_search_context(graph->n_nodes);
+				through_bits = (uint64_t*) calloc(n_words,sizeof(uint64_t));
+				around_bits = (uint64_t*) calloc(n_words,sizeof(uint64_t));
+			}
+			layers->layer_neighbour_shortcuts[k] = find_floor_layer_shortcuts(graph,layers,l,other,entries,n_entries,context,through_bits,around_bits);
+		}
+	}
+	delete_route_search_context(context);
+	free(through_bits);
+	free(around_bits);
+	free(entry_seen);
+	free(neighbour_slot);
+	free(last_seen);
+
+	return layers;
+}
+
+void delete_floor_layers(floor_layers_t * layers){
+	if(layers == NULL) return;
+
+	free(layers->layers);
+	free(layers->layer_nodes);
+	free(layers->node_layer);
+	free(layers->layer_edges);
+	free(layers->layer_portals);
+	free(layers->layer_neighbours);
+	free(layers->layer_neighbour_portals);
+	free(layers->layer_neighbour_entries);
+	free(layers->layer_neighbour_shortcuts);
+	free(layers);
+}
+
+uint32_t find_floor_layer(const floor_layers_t * layers,const building_t * building,int8_t floor_number,bool * found){
+	*found = false;
+	if(layers == NULL) return 0;
+
+	for(size_t l = 0;l < layers->n_layers;l++){
+		if(layers->layers[l].building == building && layers->layers[l].floor_number == floor_number){
+			*found = true;
+			return l;
+		}
+	}
+
+	return 0;
+}
+
+//true if a layer can only be left back into the layer it came from and is not worth entering
+static bool is_floor_layer_dead_end(const floor_layers_t * layers,uint32_t l,const uint32_t * degree,const uint8_t * allowed_layers,uint8_t profile){
+	if(degree[l] == 0) return true;
+	if(degree[l] > 1) return false;
+
+	const floor_layer_t * layer = &(layers->layers[l]);
+	for(uint32_t k = layer->first_neighbour;k < layer->first_neighbour + layer->n_neighbours;k++){
+		if(!allowed_layers[layers->layer_neighbours[k]]) continue;
+
+		if(layers->layer_neighbour_entries[k] <= 1) return true;
+		return profile < N_ROUTE_PROFILES && !((layers->layer_neighbour_shortcuts[k] >> profile) & 1);
+	}
+	return true;
+}
+
+size_t mark_floor_layers_for_route(const floor_layers_t * layers,uint32_t start,uint32_t end,uint8_t profile,uint8_t * allowed_layers){
+	if(layers == NULL || allowed_layers == NULL) return 0;
+
+	uint32_t start_layer = layers->node_layer[start];
+	uint32_t end_layer = layers->node_layer[end];
+
+	//peel off dead end layers until none remain, degree is the number of neighbouring layers still allowed
+	uint32_t * degree = (uint32_t*) malloc(sizeof(uint32_t)*(layers->n_layers+1));
+	uint32_t * dead_ends = (uint32_t*) malloc(sizeof(uint32_t)*(layers->n_layers+1));
+	uint8_t * pushed = (uint8_t*) calloc(layers->n_layers+1,1);
+	size_t n_dead_ends = 0;
+	size_t n_allowed = layers->n_layers;
+
+	for(size_t l = 0;l < layers->n_layers;l++){
+		allowed_layers[l] = 1;
+		degree[l] = layers->layers[l].n_neighbours;
+	}
+	for(size_t l = 0;l < layers->n_layers;l++){
+		if(l != start_layer && l != end_layer && is_floor_layer_dead_end(layers,l,degree,allowed_layers,profile)){
+			dead_ends[n_dead_ends++] = l;
+			pushed[l] = 1;
+		}
+	}
+
+	while(n_dead_ends > 0){
+		uint32_t l = dead_ends[--n_dead_ends];
+		allowed_layers[l] = 0;
+		n_allowed--;
+
+		const floor_layer_t * layer = &(layers->layers[l]);
+		for(uint32_t k = layer->first_neighbour;k < layer->first_neighbour + layer->n_neighbours;k++){
+			uint32_t other = layers->layer_neighbours[k];
+			if(!allowed_layers[other]) continue;
+
+			if(degree[other] > 0) degree[other]--;
+			if(!pushed[other] && other != start_layer && other != end_layer && is_floor_layer_dead_end(layers,other,degree,allowed_layers,profile)){
+				dead_ends[n_dead_ends++] = other;
+				pushed[other] = 1;
+			}
+		}
+	}
+
+	free(pushed);
+	free(dead_ends);
+	free(degree);
+	return n_allowed;
+}
@@ -0,0 +1,563 @@
+#include "image_cache.h"
+#include <string.h>
+#include <setjmp.h>
+#include <png.h>
+#include <jpeglib.h>
+
+#define DEFAULT_IMAGE_CACHE_BUCKETS 64
+
+uint32_t get_image_size_side(uint8_t size){
+	switch(size){
+		case IMAGE_SIZE_ICON: return IMAGE_ICON_SIDE;
+		case IMAGE_SIZE_THUMBNAIL: return IMAGE_THUMBNAIL_SIDE;
+		default: return IMAGE_PREVIEW_SIDE;
+	}
+}
+
+//Read a PNG file into 8 bit RGBA. NULL if it can not be read.
+static uint8_t * read_png_pixels(const char * path,uint32_t * width_out,uint32_t * height_out){
+	png_image image;
+	memset(&image,0,sizeof(png_image));
+	image.version = PNG_IMAGE_VERSION;
+	if(!png_image_begin_read_from_file(&image,path)) return NULL;
+
+	image.format = PNG_FORMAT_RGBA;
+	uint8_t * pixels = (uint8_t*) malloc(PNG_IMAGE_SIZE(image));
+	if(!png_image_finish_read(&image,NULL,pixels,0,NULL)){
+		free(pixels);
+		png_image_free(&image);
+		return NULL;
+	}
+
+	*width_out = image.width;
+	*height_out = image.height;
+	return pixels;
+}
+
+//libjpeg reports errors by calling error_exit, which must not return
+typedef struct Jpeg_Error_Handler{
+	struct jpeg_error_mgr manager;
+	jmp_buf escape;
+} jpeg_error_handler_t;
+
+static void exit_jpeg_error(j_common_ptr info){
+	longjmp(((jpeg_error_handler_t*) info->err)->escape,1);
+}
+
+/*
+ * Read a JPEG file into 8 bit RGBA. libjpeg scales by 1/2, 1/4 or 1/8 while decoding for almost nothing,
+ * so the picture is decoded at the smallest of those that is still at least side pixels on its longest side.
+ */
+static uint8_t * read_jpeg_pixels(FILE * file,uint32_t side,uint32_t * width_out,uint32_t * height_out){
+	struct jpeg_decompress_struct info;
+	jpeg_error_handler_t handler;
+	info.err = jpeg_std_error(&(handler.manager));
+	handler.manager.error_exit = exit_jpeg_error;
+
+	//volatile so the buffers are still known after a longjmp
+	uint8_t * volatile pixels = NULL;
+	uint8_t * volatile row = NULL;
+	if(setjmp(handler.escape)){
+		jpeg_destroy_decompress(&info);
+		free(pixels);
+		free(row);
+		return NULL;
+	}
+
+	jpeg_create_decompress(&info);
+	jpeg_stdio_src(&info,file);
+	jpeg_read_header(&info,TRUE);
+
+	uint32_t longest = (info.image_width > info.image_height) ? info.image_width : info.image_height;
+	info.scale_num = 1;
+	info.scale_denom = 1;
+	while(info.scale_denom < 8 && longest/(2*info.scale_denom) >= side) info.scale_denom *= 2;
+	info.out_color_space = JCS_RGB;
+	jpeg_start_decompress(&info);
+
+	uint32_t width = info.output_width;
+	uint32_t height = info.output_height;
+	pixels = (uint8_t*) malloc((size_t) width*height*4);
+	row = (uint8_t*) malloc((size_t) width*3);
+	while(info.output_scanline < height){
+		uint8_t * rgba = &(pixels[(size_t) info.output_scanline*width*4]);
+		JSAMPROW rows[1] = {row};
+		jpeg_read_scanlines(&info,rows,1);
+		for(uint32_t x = 0;x < width;x++){
+			rgba[4*x] = row[3*x];
+			rgba[4*x+1] = row[3*x+1];
+			rgba[4*x+2] = row[3*x+2];
+			rgba[4*x+3] = 255;
+		}
+	}
+	jpeg_finish_decompress(&info);
+	jpeg_destroy_decompress(&info);
+	free(row);
+
+	*width_out = width;
+	*height_out = height;
+	return pixels;
+}
+
+/*
+ * Scale 8 bit RGBA down to fit side by side, averaging every source pixel under a target pixel, into
+ * premultiplied ARGB32. Pictures that already fit keep their size.
+ */
+static uint32_t * downscale_pixels(const uint8_t * rgba,uint32_t width,uint32_t height,uint32_t side,uint32_t * width_out,uint32_t * height_out){
+	uint32_t longest = (width > height) ? width : height;
+	uint32_t target_width = width;
+	uint32_t target_height = height;
+	if(longest > side){
+		target_width = (uint32_t) (((uint64_t) width*side + longest/2)/longest);
+		target_height = (uint32_t) (((uint64_t) height*side + longest/2)/longest);
+		if(target_width == 0) target_width = 1;
+		if(target_height == 0) target_height = 1;
+	}
+
+	uint32_t * pixels = (uint32_t*) malloc(sizeof(uint32_t)*target_width*target_height);
+	for(uint32_t ty = 0;ty < target_height;ty++){
+		uint32_t y0 = (uint32_t) ((uint64_t) ty*height/target_height);
+		uint32_t y1 = (uint32_t) ((uint64_t) (ty+1)*height/target_height);
+		if(y1 == y0) y1 = y0+1;
+
+		for(uint32_t tx = 0;tx < target_width;tx++){
+			uint32_t x0 = (uint32_t) ((uint64_t) tx*width/target_width);
+			uint32_t x1 = (uint32_t) ((uint64_t) (tx+1)*width/target_width);
+			if(x1 == x0) x1 = x0+1;
+
+			uint64_t red = 0,green = 0,blue = 0,alpha = 0;
+			for(uint32_t y = y0;y < y1;y++){
+				const uint8_t * source = &(rgba[((size_t) y*width + x0)*4]);
+				for(uint32_t x = x0;x < x1;x++){
+					uint32_t a = source[3];
+					red += source[0]*a;
+					green += source[1]*a;
+					blue += source[2]*a;
+					alpha += a;
+					source += 4;
+				}
+			}
+
+			uint64_t n = (uint64_t) (x1-x0)*(y1-y0);
+			uint32_t a = (uint32_t) ((alpha + n/2)/n);
+			uint32_t r = (uint32_t) ((red + 255*n/2)/(255*n));
+			uint32_t g = (uint32_t) ((green + 255*n/2)/(255*n));
+			uint32_t b = (uint32_t) ((blue + 255*n/2)/(255*n));
+			pixels[(size_t) ty*target_width + tx] = (a << 24) | (r << 16) | (g << 8) | b;
+		}
+	}
+
+	*width_out = target_width;
+	*height_out = target_height;
+	return pixels;
+}
+
+static cached_image_t * create_cached_image(const char * path,uint8_t size){
+	cached_image_t * image = (cached_image_t*) malloc(sizeof(cached_image_t));
+	image->reference_count = 1;
+	image->path = (char*) malloc(strlen(path)+1);
+	strcpy(image->path,path);
+	image->size = size;
+	image->state = CACHED_IMAGE_PENDING;
+	image->width = 0;
+	image->height = 0;
+	image->pixels = NULL;
+	image->prefetched = false;
+	image->next_in_bucket = NULL;
+	image->newer = NULL;
+	image->older = NULL;
+	image->in_recent = false;
+	image->in_flight = false;
+	return image;
+}
+
+cached_image_t * decode_cached_image(const char * path,uint8_t size){
+	if(path == NULL) return NULL;
+
+	cached_image_t * image = create_cached_image(path,size);
+	image->state = CACHED_IMAGE_FAILED;
+
+	FILE * file = fopen(path,"rb");
+	if(file == NULL) return image;
+
+	//tell the formats apart by their first bytes, not by the file name
+	uint8_t signature[8];
+	size_t n_read = fread(signature,1,sizeof(signature),file);
+	uint32_t width = 0,height = 0;
+	uint8_t * rgba = NULL;
+	if(n_read == sizeof(signature) && png_sig_cmp(signature,0,sizeof(signature)) == 0){
+		fclose(file);
+		rgba = read_png_pixels(path,&width,&height);
+	}else if(n_read >= 3 && signature[0] == 0xFF && signature[1] == 0xD8 && signature[2] == 0xFF){
+		rewind(file);
+		rgba = read_jpeg_pixels(file,get_image_size_side(size),&width,&height);
+		fclose(file);
+	}else{
+		fclose(file);
+	}
+	if(rgba == NULL) return image;
+
+	image->pixels = downscale_pixels(rgba,width,height,get_image_size_side(size),&(image->width),&(image->height));
+	image->state = CACHED_IMAGE_READY;
+	free(rgba);
+	return image;
+}
+
+void retain_cached_image(cached_image_t * image){
+	if(image == NULL) return;
+
+	__atomic_add_fetch(&(image->reference_count),1,__ATOMIC_RELAXED);
+}
+
+void release_cached_image(cached_image_t * image){
+	if(image == NULL) return;
+
+	if(__atomic_sub_fetch(&(image->reference_count),1,__ATOMIC_ACQ_REL) != 0) return;
+
+	free(image->path);
+	free(image->pixels);
+	free(image);
+}
+
+//Memory a cached image is charged for.
+static size_t get_cached_image_bytes(const cached_image_t * image){
+	return sizeof(cached_image_t) + strlen(image->path)+1 + (size_t) image->width*image->height*sizeof(uint32_t);
+}
+
+static size_t hash_image_key(const char * path,uint8_t size,size_t mask){
+	uint64_t hash = 14695981039346656037ULL;
+	for(const char * c = path;*c != '\0';c++){
+		hash ^= (uint8_t) *c;
+		hash *= 1099511628211ULL;
+	}
+	hash ^= size;
+	hash *= 1099511628211ULL;
+	return (size_t) (hash ^ (hash >> 32)) & mask;
+}
+
+static cached_image_t * find_cached_image(const image_cache_t * cache,const char * path,uint8_t size){
+	cached_image_t * image = cache->buckets[hash_image_key(path,size,cache->n_buckets-1)];
+	while(image != NULL && (image->size != size || strcmp(image->path,path) != 0)) image = image->next_in_bucket;
+	return image;
+}
+
+static void insert_cached_image(image_cache_t * cache,cached_image_t * image){
+	//keep about one image a bucket
+	if(cache->n_images == cache->n_buckets){
+		size_t n_buckets = 2*cache->n_buckets;
+		cached_image_t ** buckets = (cached_image_t**) calloc(n_buckets,sizeof(cached_image_t*));
+		for(size_t i = 0;i < cache->n_buckets;i++){
+			cached_image_t * current = cache->buckets[i];
+			while(current != NULL){
+				cached_image_t * next = current->next_in_bucket;
+				size_t bucket = hash_image_key(current->path,current->size,n_buckets-1);
+				current->next_in_bucket = buckets[bucket];
+				buckets[bucket] = current;
+				current = next;
+			}
+		}
+		free(cache->buckets);
+		cache->buckets = buckets;
+		cache->n_buckets = n_buckets;
+	}
+
+	size_t bucket = hash_image_key(image->path,image->size,cache->n_buckets-1);
+	image->next_in_bucket = cache->buckets[bucket];
+	cache->buckets[bucket] = image;
+	cache->n_images++;
+}
+
+static void remove_cached_image(image_cache_t * cache,cached_image_t * image){
+	cached_image_t ** link = &(cache->buckets[hash_image_key(image->path,image->size,cache->n_buckets-1)]);
+	while(*link != image) link = &((*link)->next_in_bucket);
+	*link = image->next_in_bucket;
+	image->next_in_bucket = NULL;
+	cache->n_images--;
+}
+
+static void unlink_recent_image(image_cache_t * cache,cached_image_t * image){
+	if(!image->in_recent) return;
+
+	if(image->newer != NULL) image->newer->older = image->older;
+	else cache->newest = image->older;
+	if(image->older != NULL) image->older->newer = image->newer;
+	else cache->oldest = image->newer;
+	image->newer = NULL;
+	image->older = NULL;
+	image->in_recent = false;
+}
+
+//Make an image the newest, moving it if it is already in the list.
+static void push_recent_image(image_cache_t * cache,cached_image_t * image){
+	unlink_recent_image(cache,image);
+	image->in_recent = true;
+	image->newer = NULL;
+	image->older = cache->newest;
+	if(cache->newest != NULL) cache->newest->newer = image;
+	cache->newest = image;
+	if(cache->oldest == NULL) cache->oldest = image;
+}
+
+//Drop the least recently used images until the cache is within its budget.
+static void evict_cached_images(image_cache_t * cache){
+	while(cache->stats.bytes > cache->max_bytes && cache->oldest != NULL){
+		cached_image_t * image = cache->oldest;
+		unlink_recent_image(cache,image);
+		remove_cached_image(cache,image);
+		cache->stats.bytes -= get_cached_image_bytes(image);
+		cache->stats.n_evicted++;
+		release_cached_image(image);
+	}
+}
+
+static cached_image_t * get_queued_image(const image_cache_t * cache,size_t position){
+	return cache->queue[(cache->queue_first + position) % IMAGE_CACHE_MAX_QUEUED];
+}
+
+//Take a pending image out of the queue if it is in it. Returns false if it was not queued.
+static bool unqueue_image(image_cache_t * cache,const cached_image_t * image){
+	for(size_t i = 0;i < cache->n_queued;i++){
+		if(get_queued_image(cache,i) != image) continue;
+
+		for(size_t j = i;j+1 < cache->n_queued;j++){
+			cache->queue[(cache->queue_first + j) % IMAGE_CACHE_MAX_QUEUED] = get_queued_image(cache,j+1);
+		}
+		cache->n_queued--;
+		return true;
+	}
+	return false;
+}
+
+//Forget a pending image that will not be decoded after all.
+static void drop_pending_image(image_cache_t * cache,cached_image_t * image){
+	if(image->prefetched) cache->stats.n_prefetches_dropped++;
+	remove_cached_image(cache,image);
+	release_cached_image(image);
+}
+
+static void * image_cache_main(void * argument){
+	image_cache_t * cache = (image_cache_t*) argument;
+
+	pthread_mutex_lock(&(cache->lock));
+	while(true){
+		while(cache->n_queued == 0 && !cache->shutting_down){
+			pthread_cond_broadcast(&(cache->idle));
+			pthread_cond_wait(&(cache->wake),&(cache->lock));
+		}
+		if(cache->shutting_down) break;
+
+		cached_image_t * image = cache->queue[cache->queue_first];
+		cache->queue_first = (cache->queue_first+1) % IMAGE_CACHE_MAX_QUEUED;
+		cache->n_queued--;
+		cache->decoding = true;
+		image->in_flight = true;
+
+		//decode without holding the lock, nobody else touches a pending image
+		pthread_mutex_unlock(&(cache->lock));
+		cached_image_t * decoded = decode_cached_image(image->path,image->size);
+		pthread_mutex_lock(&(cache->lock));
+
+		image->state = decoded->state;
+		image->width = decoded->width;
+		image->height = decoded->height;
+		image->pixels = decoded->pixels;
+		image->in_flight = false;
+		decoded->pixels = NULL;
+		release_cached_image(decoded);
+
+		if(image->state == CACHED_IMAGE_READY) cache->stats.n_decoded++;
+		else cache->stats.n_failed++;
+		cache->stats.bytes += get_cached_image_bytes(image);
+		push_recent_image(cache,image);
+
+		//hold on to the image while telling about it, a tight budget could evict it right away
+		retain_cached_image(image);
+		evict_cached_images(cache);
+
+		if(cache->on_ready != NULL){
+			pthread_mutex_unlock(&(cache->lock));
+			cache->on_ready(image->path,image->size,cache->user_data);
+			pthread_mutex_lock(&(cache->lock));
+		}
+		release_cached_image(image);
+		cache->decoding = false;
+	}
+	pthread_mutex_unlock(&(cache->lock));
+
+	return NULL;
+}
+
+image_cache_t * create_image_cache(size_t max_bytes,void (*on_ready)(const char * path,uint8_t size,void * user_data),void * user_data){
+	image_cache_t * cache = (image_cache_t*) malloc(sizeof(image_cache_t));
+
+	pthread_mutex_init(&(cache->lock),NULL);
+	pthread_cond_init(&(cache->wake),NULL);
+	pthread_cond_init(&(cache->idle),NULL);
+	cache->shutting_down = false;
+
+	cache->n_buckets = DEFAULT_IMAGE_CACHE_BUCKETS;
+	cache->buckets = (cached_image_t**) calloc(cache->n_buckets,sizeof(cached_image_t*));
+	cache->n_images = 0;
+	cache->newest = NULL;
+	cache->oldest = NULL;
+	cache->max_bytes = max_bytes;
+
+	cache->queue = (cached_image_t**) malloc(sizeof(cached_image_t*)*IMAGE_CACHE_MAX_QUEUED);
+	cache->queue_first = 0;
+	cache->n_queued = 0;
+	cache->decoding = false;
+
+	cache->on_ready = on_ready;
+	cache->user_data = user_data;
+	memset(&(cache->stats),0,sizeof(image_cache_stats_t));
+
+	pthread_create(&(cache->thread),NULL,image_cache_main,cache);
+
+	return cache;
+}
+
+void delete_image_cache(image_cache_t * cache){
+	if(cache == NULL) return;
+
+	pthread_mutex_lock(&(cache->lock));
+	cache->shutting_down = true;
+	pthread_cond_signal(&(cache->wake));
+	pthread_mutex_unlock(&(cache->lock));
+
+	pthread_join(cache->thread,NULL);
+
+	//pending images are in the table too
+	for(size_t i = 0;i < cache->n_buckets;i++){
+		cached_image_t * image = cache->buckets[i];
+		while(image != NULL){
+			cached_image_t * next = image->next_in_bucket;
+			release_cached_image(image);
+			image = next;
+		}
+	}
+	free(cache->buckets);
+	free(cache->queue);
+	pthread_cond_destroy(&(cache->idle));
+	pthread_cond_destroy(&(cache->wake));
+	pthread_mutex_destroy(&(cache->lock));
+	free(cache);
+}
+
+cached_image_t * get_cached_image(image_cache_t * cache,const char * path,uint8_t size){
+	if(cache == NULL || path == NULL || size >= N_IMAGE_SIZES) return NULL;
+
+	pthread_mutex_lock(&(cache->lock));
+	cache->stats.n_requests++;
+
+	cached_image_t * image = find_cached_image(cache,path,size);
+	if(image != NULL && image->state != CACHED_IMAGE_PENDING){
+		push_recent_image(cache,image);
+		if(image->state == CACHED_IMAGE_FAILED){
+			pthread_mutex_unlock(&(cache->lock));
+			return NULL;
+		}
+
+		cache->stats.n_hits++;
+		if(image->prefetched) cache->stats.n_prefetch_hits++;
+		image->prefetched = false;
+		retain_cached_image(image);
+		pthread_mutex_unlock(&(cache->lock));
+		return image;
+	}
+
+	//already being decoded, on_ready comes soon
+	if(image != NULL && image->in_flight){
+		image->prefetched = false;
+		pthread_mutex_unlock(&(cache->lock));
+		return NULL;
+	}
+
+	//the picture someone is waiting for goes to the front, a full queue loses its last prefetch
+	if(image == NULL){
+		image = create_cached_image(path,size);
+		insert_cached_image(cache,image);
+	}else{
+		unqueue_image(cache,image);
+	}
+	image->prefetched = false;
+	if(cache->n_queued == IMAGE_CACHE_MAX_QUEUED){
+		drop_pending_image(cache,get_queued_image(cache,cache->n_queued-1));
+		cache->n_queued--;
+	}
+	cache->queue_first = (cache->queue_first + IMAGE_CACHE_MAX_QUEUED-1) % IMAGE_CACHE_MAX_QUEUED;
+	cache->queue[cache->queue_first] = image;
+	cache->n_queued++;
+
+	pthread_cond_signal(&(cache->wake));
+	pthread_mutex_unlock(&(cache->lock));
+	return NULL;
+}
+
+bool prefetch_cached_image(image_cache_t * cache,const char * path,uint8_t size){
+	if(cache == NULL || path == NULL || size >= N_IMAGE_SIZES) return false;
+
+	pthread_mutex_lock(&(cache->lock));
+	if(find_cached_image(cache,path,size) != NULL){
+		pthread_mutex_unlock(&(cache->lock));
+		return true;
+	}
+	if(cache->n_queued == IMAGE_CACHE_MAX_QUEUED){
+		cache->stats.n_prefetches_dropped++;
+		pthread_mutex_unlock(&(cache->lock));
+		return false;
+	}
+
+	cached_image_t * image = create_cached_image(path,size);
+	image->prefetched = true;
+	insert_cached_image(cache,image);
+	cache->queue[(cache->queue_first + cache->n_queued) % IMAGE_CACHE_MAX_QUEUED] = image;
+	cache->n_queued++;
+
+	pthread_cond_signal(&(cache->wake));
+	pthread_mutex_unlock(&(cache->lock));
+	return true;
+}
+
+void prefetch_map_path_images(image_cache_t * cache,const map_path_t * path,uint8_t size){
+	if(cache == NULL || path == NULL) return;
+
+	for(size_t i = 0;i < path->n_nodes;i++){
+		const char * picture = path->nodes[i]->picture_file_path;
+		if(picture != NULL && !prefetch_cached_image(cache,picture,size)) return;
+	}
+}
+
+void prefetch_map_rect_images(image_cache_t * cache,const map_t * map,map_rect_t rect,uint8_t size){
+	if(cache == NULL || map == NULL) return;
+
+	for(size_t i = 0;i < map->n_nodes;i++){
+		const map_node_t * node = map->all_nodes[i];
+		if(node->picture_file_path == NULL) continue;
+
+		cord_t cord = node->coordinate;
+		if(cord.longitude < rect.bottom_left.longitude || cord.longitude > rect.top_right.longitude) continue;
+		if(cord.latitude < rect.bottom_left.latitude || cord.latitude > rect.top_right.latitude) continue;
+		if(!prefetch_cached_image(cache,node->picture_file_path,size)) return;
+	}
+}
+
+void wait_for_image_cache(image_cache_t * cache){
+	if(cache == NULL) return;
+
+	pthread_mutex_lock(&(cache->lock));
+	while(cache->n_queued > 0 || cache->decoding) pthread_cond_wait(&(cache->idle),&(cache->lock));
+	pthread_mutex_unlock(&(cache->lock));
+}
+
+image_cache_stats_t get_image_cache_stats(image_cache_t * cache){
+	pthread_mutex_lock(&(cache->lock));
+	image_cache_stats_t stats = cache->stats;
+	pthread_mutex_unlock(&(cache->lock));
+	return stats;
+}
+
+double get_image_cache_hit_rate(const image_cache_stats_t * stats){
+	if(stats == NULL || stats->n_requests == 0) return 0.0;
+
+	return (double) stats->n_hits/stats->n_requests;
+}
@@ -0,0 +1,226 @@
+#include "isochrone.h"
+#include "edge_weights.h"
+#include "building_routes.h"
+
+#define DEFAULT_ISOCHRONE_NODES_CAPACITY 64
+
+isochrone_t * create_isochrone(map_graph_t * graph,uint32_t start,uint8_t profile){
+	if(graph == NULL || start >= graph->n_nodes || profile >= N_ROUTE_PROFILES) return NULL;
+
+	retain_map_graph(graph);
+
+	isochrone_t * isochrone = (isochrone_t*) malloc(sizeof(isochrone_t));
+	isochrone->graph = graph;
+	isochrone->start = start;
+	isochrone->profile = profile;
+	isochrone->context = create_route_search_context(graph->n_nodes);
+	record_settled_nodes(isochrone->context);
+	isochrone->cost_limit = -1.0;
+
+	isochrone->nodes_capacity = DEFAULT_ISOCHRONE_NODES_CAPACITY;
+	isochrone->nodes = (uint32_t*) malloc(sizeof(uint32_t)*isochrone->nodes_capacity);
+	isochrone->n_nodes = 0;
+
+	size_t n_buildings = graph->building_routes->n_buildings;
+	isochrone->buildings = (const building_t**) malloc(sizeof(building_t*)*(n_buildings+1));
+	isochrone->n_buildings = 0;
+	isochrone->building_reached = (uint8_t*) calloc(n_buildings+1,sizeof(uint8_t));
+
+	isochrone->entrances = (uint32_t*) malloc(sizeof(uint32_t)*(graph->n_nodes+1));
+	isochrone->n_entrances = 0;
+
+	isochrone->outline = NULL;
+	isochrone->n_outline = 0;
+
+	isochrone->frontier = (uint32_t*) malloc(sizeof(uint32_t)*(graph->n_nodes+1));
+	isochrone->n_frontier = 0;
+
+	grow_isochrone(isochrone,0.0);
+
+	return isochrone;
+}
+
+void delete_isochrone(isochrone_t * isochrone){
+	if(isochrone == NULL) return;
+
+	delete_route_search_context(isochrone->context);
+	release_map_graph(isochrone->graph);
+	free(isochrone->nodes);
+	free(isochrone->buildings);
+	free(isochrone->building_reached);
+	free(isochrone->entrances);
+	free(isochrone->outline);
+	free(isochrone->frontier);
+	free(isochrone);
+}
+
+static bool isochrone_node_reachable(const isochrone_t * isochrone,uint32_t node){
+	return route_search_reached(isochrone->context,node) && isochrone->context->cost[node] <= isochrone->cost_limit;
+}
+
+static void add_isochrone_node(isochrone_t * isochrone,uint32_t node){
+	if(isochrone->n_nodes == isochrone->nodes_capacity){
+		isochrone->nodes_capacity *= 2;
+		isochrone->nodes = (uint32_t*) realloc(isochrone->nodes,sizeof(uint32_t)*isochrone->nodes_capacity);
+	}
+	isochrone->nodes[isochrone->n_nodes] = node;
+	isochrone->n_nodes++;
+
+	const building_routes_t * routes = isochrone->graph->building_routes;
+	uint32_t building = routes->node_building[node];
+	if(building != NODE_OUTDOORS && !isochrone->building_reached[building]){
+		isochrone->building_reached[building] = 1;
+		isochrone->buildings[isochrone->n_buildings] = routes->buildings[building].building;
+		isochrone->n_buildings++;
+	}
+
+	if(routes->node_entrance[node] != UINT32_MAX){
+		isochrone->entrances[isochrone->n_entrances] = node;
+		isochrone->n_entrances++;
+	}
+}
+
+//Cross product of b-a and c-a, positive when a, b, c turn counter-clockwise.
+static double cross_cords(cord_t a,cord_t b,cord_t c){
+	return (b.longitude - a.longitude)*(c.latitude - a.latitude) - (b.latitude - a.latitude)*(c.longitude - a.longitude);
+}
+
+static int compare_cords(const void * a,const void * b){
+	const cord_t * cord_a = (const cord_t*) a;
+	const cord_t * cord_b = (const cord_t*) b;
+	if(cord_a->longitude != cord_b->longitude) return (cord_a->longitude > cord_b->longitude) - (cord_a->longitude < cord_b->longitude);
+	return (cord_a->latitude > cord_b->latitude) - (cord_a->latitude < cord_b->latitude);
+}
+
+/*
+ * Andrew's monotone chain, writes the hull of points into hull counter-clockwise and returns its size.
+ * points is sorted in place, hull needs room for n_points+1 cords.
+ */
+static size_t find_convex_hull(cord_t * points,size_t n_points,cord_t * hull){
+	qsort(points,n_points,sizeof(cord_t),compare_cords);
+	if(n_points < 3){
+		size_t n_hull = 0;
+		for(size_t i = 0;i < n_points;i++){
+			if(n_hull > 0 && compare_cords(&hull[n_hull-1],&points[i]) == 0) continue;
+			hull[n_hull] = points[i];
+			n_hull++;
+		}
+		return n_hull;
+	}
+
+	size_t n_hull = 0;
+	for(size_t i = 0;i < n_points;i++){
+		while(n_hull >= 2 && cross_cords(hull[n_hull-2],hull[n_hull-1],points[i]) <= 0) n_hull--;
+		hull[n_hull] = points[i];
+		n_hull++;
+	}
+	size_t lower_size = n_hull + 1;
+	for(size_t i = n_points-1;i > 0;i--){
+		while(n_hull >= lower_size && cross_cords(hull[n_hull-2],hull[n_hull-1],points[i-1]) <= 0) n_hull--;
+		hull[n_hull] = points[i-1];
+		n_hull++;
+	}
+
+	//the last point is the first one again
+	return n_hull - 1;
+}
+
+/*
+ * Add the point along every usable edge out of a reachable node where the budget runs out. Returns false if all
+ * of its neighbours are reachable, the node then never adds a point again.
+ */
+static bool add_frontier_points(const isochrone_t * isochrone,uint32_t node,cord_t * points,size_t * n_points){
+	const map_graph_t * graph = isochrone->graph;
+	const float * weights = graph->weights->profile_weights[isochrone->profile];
+	double cost = isochrone->context->cost[node];
+
+	bool on_frontier = false;
+	for(size_t j = graph->adjacency_offsets[node];j < graph->adjacency_offsets[node+1];j++){
+		uint32_t neighbour = graph->adjacency_nodes[j];
+		float weight = weights[graph->adjacency_edges[j]];
+		if(isinf(weight) || weight <= 0 || isochrone_node_reachable(isochrone,neighbour)) continue;
+
+		double t = (isochrone->cost_limit - cost)/weight;
+		cord_t a = graph->hot_nodes[node].coordinate;
+		cord_t b = graph->hot_nodes[neighbour].coordinate;
+		points[*n_points] = create_cord(a.longitude + t*(b.longitude - a.longitude),a.latitude + t*(b.latitude - a.latitude));
+		(*n_points)++;
+		on_frontier = true;
+	}
+
+	return on_frontier;
+}
+
+/*
+ * Outline the reachable nodes plus the point along every edge out of them where the budget runs out. The old
+ * outline, the nodes from first_new on and the old frontier are enough: an old node's points are inside the old
+ * outline, and an old point on an edge lies between its node and the new point on that edge or the neighbour.
+ */
+static void outline_isochrone(isochrone_t * isochrone,size_t first_new){
+	const map_graph_t * graph = isochrone->graph;
+
+	//every candidate node gives itself and at most one point per edge
+	size_t n_edges = 0;
+	for(size_t i = 0;i < isochrone->n_frontier;i++){
+		uint32_t node = isochrone->frontier[i];
+		n_edges += graph->adjacency_offsets[node+1] - graph->adjacency_offsets[node];
+	}
+	for(size_t i = first_new;i < isochrone->n_nodes;i++){
+		uint32_t node = isochrone->nodes[i];
+		n_edges += graph->adjacency_offsets[node+1] - graph->adjacency_offsets[node];
+	}
+	size_t n_points = 0;
+	cord_t * points = (cord_t*) malloc(sizeof(cord_t)*(isochrone->n_outline + (isochrone->n_nodes - first_new) + n_edges + 1));
+	for(size_t i = 0;i < isochrone->n_outline;i++){
+		points[n_points] = isochrone->outline[i];
+		n_points++;
+	}
+
+	//the old frontier first, its nodes are already in the old outline
+	size_t n_frontier = 0;
+	for(size_t i = 0;i < isochrone->n_frontier;i++){
+		uint32_t node = isochrone->frontier[i];
+		if(add_frontier_points(isochrone,node,points,&n_points)) isochrone->frontier[n_frontier++] = node;
+	}
+	for(size_t i = first_new;i < isochrone->n_nodes;i++){
+		uint32_t node = isochrone->nodes[i];
+		points[n_points] = graph->hot_nodes[node].coordinate;
+		n_points++;
+		if(add_frontier_points(isochrone,node,points,&n_points)) isochrone->frontier[n_frontier++] = node;
+	}
+	isochrone->n_frontier = n_frontier;
+
+	free(isochrone->outline);
+	isochrone->outline = (cord_t*) malloc(sizeof(cord_t)*(n_points+1));
+	isochrone->n_outline = find_convex_hull(points,n_points,isochrone->outline);
+
+	free(points);
+}
+
+void grow_isochrone(isochrone_t * isochrone,double cost_limit){
+	if(isochrone == NULL || cost_limit < 0) return;
+
+	const map_graph_t * graph = isochrone->graph;
+	double old_limit = isochrone->cost_limit;
+
+	if(cost_limit < old_limit || old_limit < 0){
+		//shrinking, or the first budget: start the tree, the lists and the outline over
+		grow_route_search_tree(graph,isochrone->context,isochrone->start,NULL,0,cost_limit,isochrone->profile);
+		isochrone->n_nodes = 0;
+		isochrone->n_buildings = 0;
+		isochrone->n_entrances = 0;
+		isochrone->n_outline = 0;
+		isochrone->n_frontier = 0;
+		for(size_t k = 0;k < graph->building_routes->n_buildings;k++) isochrone->building_reached[k] = 0;
+	}else{
+		extend_route_search_tree(graph,isochrone->context,cost_limit,isochrone->profile);
+	}
+	isochrone->cost_limit = cost_limit;
+
+	//every settled node is reachable, the ones this budget settled come after the ones already listed
+	size_t first_new = isochrone->n_nodes;
+	const route_search_context_t * context = isochrone->context;
+	for(size_t i = first_new;i < context->n_settled;i++) add_isochrone_node(isochrone,context->settled[i]);
+
+	outline_isochrone(isochrone,first_new);
+}
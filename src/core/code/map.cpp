@@ -1,4 +1,7 @@
 #include "map.h"
+#include "route_repair.h"
+#include "schedules.h"
+#include "string_interner.h"
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
@@ -68,7 +71,9 @@ building_t * create_building(const char * primary_name,map_rect_t building_bound
 	out->possible_names_capacity = 0;
 	out->n_possible_names = 0;
 	out->possible_names = NULL;
+	out->possible_name_ids = NULL;
 	out->building_bounding_box = building_bounding_box;
+	out->opening_hours = NULL;
 	
 	add_building_alias_name(out,primary_name);
 	
@@ -80,10 +85,12 @@ void delete_building(building_t * building){
 	
 	if(building->possible_names != NULL){
 		for(size_t i = 0;i < building->n_possible_names;i++){
-			free(building->possible_names[i]);
+			if(building->possible_name_ids[i] == STRING_ID_NONE) free(building->possible_names[i]);
 		}
 		free(building->possible_names);
+		free(building->possible_name_ids);
 	}
+	delete_schedule(building->opening_hours);
 	
 	free(building);
 }
@@ -95,12 +102,14 @@ void add_building_alias_name(building_t * building,const char * alias_name){
 	if(building->possible_names == NULL){
 		building->possible_names_capacity = DEFAULT_POSSIBLE_NAMES_CAPACITY;
 		building->possible_names = (char**) malloc(sizeof(char*)*building->possible_names_capacity);
+		building->possible_name_ids = (uint32_t*) malloc(sizeof(uint32_t)*building->possible_names_capacity);
 	}
 	
 	//resize strings array buffer if full
 	if(building->n_possible_names == building->possible_names_capacity){
 		building->possible_names_capacity *= 2;
 		building->possible_names = (char**) realloc(building->possible_names,sizeof(char*)*building->possible_names_capacity);
+		building->possible_name_ids = (uint32_t*) realloc(building->possible_name_ids,sizeof(uint32_t)*building->possible_names_capacity);
 	}
 	
 	size_t alias_length = strlen(alias_name);
@@ -109,6 +118,7 @@ void add_building_alias_name(building_t * building,const char * alias_name){
 	
 	//add new element to the strings array
 	building->possible_names[building->n_possible_names] = alias_string_cpy;
+	building->possible_name_ids[building->n_possible_names] = STRING_ID_NONE;
 	building->n_possible_names++;
 }
 
@@ -132,12 +142,13 @@ void remove_building_alias_name(building_t * building,const char * alias_name){
 	
 	if(!found) return;
 	
-	//delete the string
-	free(building->possible_names[matching_index]);
+	//delete the string, interned ones belong to the map
+	if(building->possible_name_ids[matching_index] == STRING_ID_NONE) free(building->possible_names[matching_index]);
 	
 	//shift over data
 	for(size_t i = matching_index;i < building->n_possible_names-1;i++){
 		building->possible_names[i] = building->possible_names[i+1];
+		building->possible_name_ids[i] = building->possible_name_ids[i+1];
 	}
 	building->n_possible_names--;//shrink array
 }
@@ -165,6 +176,10 @@ void change_primary_building_name(building_t * building,const char * primary_nam
 	char * temp = building->possible_names[0];
 	building->possible_names[0] = building->possible_names[matching_index];
 	building->possible_names[matching_index] = temp;
+	
+	uint32_t temp_id = building->possible_name_ids[0];
+	building->possible_name_ids[0] = building->possible_name_ids[matching_index];
+	building->possible_name_ids[matching_index] = temp_id;
 }
 
 void set_building_floor_count(building_t * building,size_t new_floor_count){
@@ -178,6 +193,13 @@ void set_building_bounding_box(building_t * building,map_rect_t building_boundin
 	building->building_bounding_box = building_bounding_box;
 }
 
+void set_building_opening_hours(building_t * building,schedule_t * opening_hours){
+	if(building == NULL) return;
+	
+	if(building->opening_hours != opening_hours) delete_schedule(building->opening_hours);
+	building->opening_hours = opening_hours;
+}
+
 const char * get_primary_building_name(const building_t * building){
 	if(building == NULL) return NULL;
 	if(building->n_possible_names == 0) return NULL;
@@ -227,6 +249,8 @@ map_node_t * create_map_node(cord_t coordinate) {
 	output->coordinate = coordinate;
 	output->picture_file_path = NULL;
 	output->name = NULL;
+	output->name_id = STRING_ID_NONE;
+	output->picture_id = STRING_ID_NONE;
 	output->outgoing_edges = NULL;
 	output->n_outgoing_edges = 0;
 	output->outgoing_edges_capacity = 0;
@@ -242,10 +266,10 @@ map_node_t * create_map_node(cord_t coordinate) {
 
 void delete_map_node(map_node_t * node){
 	if(node == NULL) return;
-	if(node->picture_file_path != NULL) {
+	if(node->picture_file_path != NULL && node->picture_id == STRING_ID_NONE) {
 		free(node->picture_file_path);
 	}
-	if(node->name != NULL){
+	if(node->name != NULL && node->name_id == STRING_ID_NONE){
 		free(node->name);
 	}
 	free(node->outgoing_edges);
@@ -261,41 +285,68 @@ void set_map_node_cord(map_node_t * node,cord_t new_cord){
 void set_map_node_name(map_node_t * node,const char * name){
 	if(node == NULL) return;
 	
-	if(node->name != NULL) free(node->name);
+	if(node->name != NULL && node->name_id == STRING_ID_NONE) free(node->name);
 	
 	size_t name_length = strlen(name);
 	char * name_cpy = (char*) malloc(name_length+1);
 	strcpy(name_cpy,name);
 	
 	node->name = name_cpy;
+	node->name_id = STRING_ID_NONE;
 }
 
 void clear_map_node_name(map_node_t * node){
 	if(node == NULL) return;
 	if(node->name == NULL) return;
 	
-	free(node->name);
+	if(node->name_id == STRING_ID_NONE) free(node->name);
 	node->name = NULL;
+	node->name_id = STRING_ID_NONE;
 }
 
 void set_map_node_picture(map_node_t * node,const char * file_path){
 	if(node == NULL) return;
 	
-	if(node->picture_file_path != NULL) free(node->picture_file_path);
+	if(node->picture_file_path != NULL && node->picture_id == STRING_ID_NONE) free(node->picture_file_path);
 	
 	size_t path_length = strlen(file_path);
 	char * path_cpy = (char*) malloc(path_length+1);
 	strcpy(path_cpy,file_path);
 	
 	node->picture_file_path = path_cpy;
+	node->picture_id = STRING_ID_NONE;
 }
 
 void clear_map_node_picture(map_node_t * node){
 	if(node == NULL) return;
 	if(node->picture_file_path == NULL) return;
 	
-	free(node->picture_file_path);
+	if(node->picture_id == STRING_ID_NONE) free(node->picture_file_path);
 	node->picture_file_path = NULL;
+	node->picture_id = STRING_ID_NONE;
+}
+
+uint16_t compute_map_node_flags(const map_node_t * node){
+	if(node == NULL) return 0;
+	
+	uint16_t flags = ((uint16_t)(uint8_t) node->floor_number) << 8;
+	if(node->associated_building != NULL) flags |= NODE_FLAG_INTERIOR;
+	if(node->selectable) flags |= NODE_FLAG_SELECTABLE;
+	
+	for(size_t i = 0;i < node->n_outgoing_edges;i++){
+		uint8_t type = node->outgoing_edges[i]->type;
+		if(type == EDGE_TYPE_AUTO_DOOR) flags |= NODE_FLAG_ADJACENT_TO_AUTO_DOOR;
+		if(type == EDGE_TYPE_ELEVATOR_SHAFT) flags |= NODE_FLAG_HAS_ELEVATOR;
+	}
+	
+	return flags;
+}
+
+//the flags an edge of some type gives both of its nodes
+static uint16_t get_edge_type_node_flags(uint8_t type){
+	if(type == EDGE_TYPE_AUTO_DOOR) return NODE_FLAG_ADJACENT_TO_AUTO_DOOR;
+	if(type == EDGE_TYPE_ELEVATOR_SHAFT) return NODE_FLAG_HAS_ELEVATOR;
+	return 0;
 }
 
 bool node_adjacent_to_auto_door(map_node_t * node){
@@ -453,6 +504,7 @@ map_edge_t * create_map_edge(uint8_t type,map_node_t * a,map_node_t * b) {
 	output->a = a;
 	output->b = b;
 	output->type = type;
+	output->schedule = NULL;
 	
 	add_outgoing_edge_to_node(a,output);
 	add_outgoing_edge_to_node(b,output);
@@ -462,6 +514,7 @@ map_edge_t * create_map_edge(uint8_t type,map_node_t * a,map_node_t * b) {
 
 void delete_map_edge(map_edge_t * edge){
 	if(edge == NULL) return;
+	delete_schedule(edge->schedule);
 	free(edge);
 }
 
@@ -471,6 +524,13 @@ void set_map_edge_type(map_edge_t * edge,uint8_t type){
 	edge->type = type;
 }
 
+void set_map_edge_schedule(map_edge_t * edge,schedule_t * schedule){
+	if(edge == NULL) return;
+	
+	if(edge->schedule != schedule) delete_schedule(edge->schedule);
+	edge->schedule = schedule;
+}
+
 void map_edge_to_output_stream(const map_edge_t * edge,size_t tabs,FILE * stream){
 	if(edge == NULL || stream == NULL) return;
 	
@@ -524,6 +584,7 @@ mpo_t * create_mpo(const cord_t * cord_arry, size_t n_cords, uint8_t type){
 	}
 	output->type = type;
 	output->name = NULL;
+	output->name_id = STRING_ID_NONE;
 	
 	return output;
 }
@@ -531,25 +592,28 @@ mpo_t * create_mpo(const cord_t * cord_arry, size_t n_cords, uint8_t type){
 void set_mpo_name(mpo_t * mpo,const char * name){
 	if(mpo == NULL || name == NULL) return;
 	
-	if(mpo->name != NULL) free(mpo->name);
+	if(mpo->name != NULL && mpo->name_id == STRING_ID_NONE) free(mpo->name);
 	
 	size_t name_length = strlen(name);
 	char * name_cpy = (char*) malloc(name_length+1);
 	strcpy(name_cpy,name);
 	
 	mpo->name = name_cpy;
+	mpo->name_id = STRING_ID_NONE;
 }
 
 void clear_mpo_name(mpo_t * mpo){
 	if(mpo == NULL) return;
 	if(mpo->name == NULL) return;
 	
-	free(mpo->name);
+	if(mpo->name_id == STRING_ID_NONE) free(mpo->name);
 	mpo->name = NULL;
+	mpo->name_id = STRING_ID_NONE;
 }
 
 void delete_map_mpo(mpo_t * mpo_ref){
 	if(mpo_ref == NULL) return;
+	if(mpo_ref->name != NULL && mpo_ref->name_id == STRING_ID_NONE) free(mpo_ref->name);
 	free(mpo_ref->cords);
 	free(mpo_ref);
 }
@@ -605,6 +669,7 @@ map_t init_map(void){
 	map.all_nodes= NULL;
 	map.n_nodes = 0;
 	map.node_capacity = 0;
+	map.node_flags = NULL;
 	
 	map.all_edges = NULL;
 	map.n_edges = 0;
@@ -623,6 +688,12 @@ map_t init_map(void){
 	map.active_path = NULL;
 	
 	map.active_edge_cost_function = NULL;
+	map.active_route_repair = NULL;
+	map.changed_edges = NULL;
+	map.n_changed_edges = 0;
+	map.changed_edges_capacity = 0;
+	
+	map.strings = NULL;
 	
 	return map;
 }
@@ -636,6 +707,7 @@ void clear_map(map_t * map){
 		}
 		free(map->all_nodes);
 	}
+	free(map->node_flags);
 
 	if(map->all_edges != NULL) {
 		for(size_t i = 0; i < map->n_edges;i++) {
@@ -661,6 +733,76 @@ void clear_map(map_t * map){
 	if(map->active_path != NULL) {
 		delete_map_path(map->active_path);
 	}
+	delete_route_repair(map->active_route_repair);
+	free(map->changed_edges);
+	
+	//last, the nodes, buildings and mpos above point into it
+	delete_string_interner(map->strings);
+}
+
+/*
+ * Swap a string someone owns a copy of for the interned one, freeing the copy.
+ * Strings that are already interned are left alone.
+ */
+static void intern_owned_string(map_t * map,char ** string,uint32_t * id){
+	if(*string == NULL || *id != STRING_ID_NONE) return;
+	
+	if(map->strings == NULL) map->strings = create_string_interner();
+	*id = intern_string(map->strings,*string);
+	free(*string);
+	*string = (char*) get_interned_string(map->strings,*id);
+}
+
+//Remember an edge whose cost may have changed so find_best_path can repair the active route.
+static void note_changed_map_edge(map_t * map,map_edge_t * edge){
+	if(map->active_route_repair == NULL) return;
+	
+	if(map->changed_edges_capacity == map->n_changed_edges){
+		map->changed_edges_capacity = (map->changed_edges_capacity == 0) ? 16 : 2*map->changed_edges_capacity;
+		map->changed_edges = (map_edge_t**) realloc(map->changed_edges,sizeof(map_edge_t*)*map->changed_edges_capacity);
+	}
+	map->changed_edges[map->n_changed_edges] = edge;
+	map->n_changed_edges++;
+}
+
+//Nodes or edges were added or removed, the active route has to be searched again on a new snapshot.
+static void drop_active_route_repair(map_t * map){
+	delete_route_repair(map->active_route_repair);
+	map->active_route_repair = NULL;
+	map->n_changed_edges = 0;
+}
+
+static void intern_building_strings(map_t * map,building_t * building){
+	for(size_t i = 0;i < building->n_possible_names;i++){
+		intern_owned_string(map,&(building->possible_names[i]),&(building->possible_name_ids[i]));
+	}
+}
+
+static void intern_node_strings(map_t * map,map_node_t * node){
+	intern_owned_string(map,&(node->name),&(node->name_id));
+	intern_owned_string(map,&(node->picture_file_path),&(node->picture_id));
+}
+
+static void intern_mpo_strings(map_t * map,mpo_t * mpo){
+	intern_owned_string(map,&(mpo->name),&(mpo->name_id));
+}
+
+void intern_map_strings(map_t * map){
+	if(map == NULL) return;
+	
+	for(size_t i = 0;i < map->n_buildings;i++) intern_building_strings(map,map->all_buildings[i]);
+	for(size_t i = 0;i < map->n_nodes;i++) intern_node_strings(map,map->all_nodes[i]);
+	for(size_t i = 0;i < map->n_mpos;i++) intern_mpo_strings(map,map->all_mpos[i]);
+}
+
+/*
+ * Does a name match the text of name_id, the interned id of some text or STRING_ID_NONE if that text
+ * was never interned. Interned names are compared by id, only copies need a strcmp.
+ */
+static bool map_name_matches(const char * name,uint32_t id,const char * text,uint32_t text_id){
+	if(name == NULL) return false;
+	if(id != STRING_ID_NONE) return id == text_id;
+	return strcmp(name,text) == 0;
 }
 
 void add_building_to_map(map_t * map,building_t * building){
@@ -676,6 +818,7 @@ void add_building_to_map(map_t * map,building_t * building){
 		map->all_buildings = (building_t**) realloc(map->all_buildings,sizeof(building_t*)*map->buildings_capacity);
 	}
 	
+	intern_building_strings(map,building);
 	map->all_buildings[map->n_buildings] = building;
 	map->n_buildings++;
 }
@@ -691,6 +834,7 @@ void remove_building_from_map_by_index(map_t * map,size_t index){
 		map_node_t * current_node = map->all_nodes[i];
 		if(current_node->associated_building == building_in_question){
 			clear_map_node_building(current_node);
+			map->node_flags[i] = compute_map_node_flags(current_node);
 		}
 	}
 	
@@ -733,6 +877,7 @@ void remove_building_by_name_from_map(map_t * map,const char * name){
 	
 	bool found = false;
 	size_t matching_index = 0;
+	uint32_t name_id = find_interned_string(map->strings,name);
 	
 	//find it in the array
 	for(size_t i = 0;i < map->n_buildings;i++){
@@ -741,7 +886,7 @@ void remove_building_by_name_from_map(map_t * map,const char * name){
 		for(size_t j = 0;j < current_building->n_possible_names;j++){
 			const char * possible_name = current_building->possible_names[j];
 			
-			if(strcmp(possible_name,name) == 0){
+			if(map_name_matches(possible_name,current_building->possible_name_ids[j],name,name_id)){
 				found = true;
 				matching_index = i;
 				break;
@@ -762,21 +907,46 @@ void add_node_to_map(map_t * map,map_node_t * node){
 	if(map->all_nodes == NULL){
 		map->node_capacity = DEFAULT_NODES_CAPACITY;
 		map->all_nodes = (map_node_t**) malloc(sizeof(map_node_t*)*map->node_capacity);
+		map->node_flags = (uint16_t*) malloc(sizeof(uint16_t)*map->node_capacity);
 	}
 	
 	if(map->node_capacity == map->n_nodes){
 		map->node_capacity *= 2;
 		map->all_nodes = (map_node_t**) realloc(map->all_nodes,sizeof(map_node_t*)*map->node_capacity);
+		map->node_flags = (uint16_t*) realloc(map->node_flags,sizeof(uint16_t)*map->node_capacity);
 	}
 	
+	drop_active_route_repair(map);
+	intern_node_strings(map,node);
 	map->all_nodes[map->n_nodes] = node;
+	map->node_flags[map->n_nodes] = compute_map_node_flags(node);
 	map->n_nodes++;
 }
 
+void reserve_map_capacity(map_t * map,size_t n_nodes,size_t n_edges){
+	if(map == NULL) return;
+	
+	size_t node_capacity = map->n_nodes + n_nodes;
+	if(map->all_nodes == NULL || map->node_capacity < node_capacity){
+		if(node_capacity < DEFAULT_NODES_CAPACITY) node_capacity = DEFAULT_NODES_CAPACITY;
+		map->node_capacity = node_capacity;
+		map->all_nodes = (map_node_t**) realloc(map->all_nodes,sizeof(map_node_t*)*map->node_capacity);
+		map->node_flags = (uint16_t*) realloc(map->node_flags,sizeof(uint16_t)*map->node_capacity);
+	}
+	
+	size_t edge_capacity = map->n_edges + n_edges;
+	if(map->all_edges == NULL || map->edge_capacity < edge_capacity){
+		if(edge_capacity < DEFAULT_EDGES_CAPACITY) edge_capacity = DEFAULT_EDGES_CAPACITY;
+		map->edge_capacity = edge_capacity;
+		map->all_edges = (map_edge_t**) realloc(map->all_edges,sizeof(map_edge_t*)*map->edge_capacity);
+	}
+}
+
 static void remove_edge_from_map_by_index(map_t * map,size_t index){
 	if(map == NULL) return;
 	if(!(index < map->n_edges)) return;
 	
+	drop_active_route_repair(map);
 	delete_map_edge(map->all_edges[index]);
 	
 	//shift over data
@@ -799,6 +969,7 @@ static void add_edge_to_map(map_t * map,map_edge_t * edge){
 		map->all_edges = (map_edge_t**) realloc(map->all_edges,sizeof(map_edge_t*)*map->edge_capacity);
 	}
 	
+	drop_active_route_repair(map);
 	map->all_edges[map->n_edges] = edge;
 	map->n_edges++;
 }
@@ -831,15 +1002,22 @@ void remove_node_from_map_by_index(map_t * map,size_t index){
 	if(!(index < map->n_nodes)) return;//out of bounds
 	
 	map_node_t * node_in_question = map->all_nodes[index];
+	drop_active_route_repair(map);
 	
 	//remove all connections to the node
 	for(size_t i = 0;i < node_in_question->n_outgoing_edges;i++){
 		map_edge_t * outgoing_edge = node_in_question->outgoing_edges[i];
+		map_node_t * neighbour = NULL;
 		
 		if(outgoing_edge->a == node_in_question){
-			remove_outgoing_edge_from_node(outgoing_edge->b,outgoing_edge);
+			neighbour = outgoing_edge->b;
 		}else if(outgoing_edge->b == node_in_question){
-			remove_outgoing_edge_from_node(outgoing_edge->a,outgoing_edge);
+			neighbour = outgoing_edge->a;
+		}
+		
+		if(neighbour != NULL){
+			remove_outgoing_edge_from_node(neighbour,outgoing_edge);
+			refresh_map_node_flags(map,neighbour);
 		}
 		
 		remove_edge_from_map(map,outgoing_edge);
@@ -851,6 +1029,7 @@ void remove_node_from_map_by_index(map_t * map,size_t index){
 	//shift over data
 	for(size_t i = index;i < map->n_nodes-1;i++){
 		map->all_nodes[i] = map->all_nodes[i+1];
+		map->node_flags[i] = map->node_flags[i+1];
 	}
 	map->n_nodes--;//shrink array
 }
@@ -877,6 +1056,60 @@ static size_t find_node_in_map_by_pointer(map_t * map,map_node_t * node,bool * f
 	return matching_index;
 }
 
+uint16_t get_map_node_flags(const map_t * map,size_t index){
+	if(map == NULL) return 0;
+	if(!(index < map->n_nodes)) return 0;//out of bounds
+	
+	return map->node_flags[index];
+}
+
+void refresh_map_node_flags(map_t * map,map_node_t * node){
+	if(map == NULL || node == NULL) return;
+	
+	//index_temp is usually still right, otherwise look the node up
+	size_t index = node->index_temp;
+	if(!(index < map->n_nodes) || map->all_nodes[index] != node){
+		bool found = false;
+		index = find_node_in_map_by_pointer(map,node,&found);
+		if(!found) return;
+	}
+	
+	map->node_flags[index] = compute_map_node_flags(node);
+}
+
+void set_map_node_building_in_map(map_t * map,map_node_t * node,building_t * building){
+	if(map == NULL || node == NULL) return;
+	
+	node->associated_building = building;
+	refresh_map_node_flags(map,node);
+}
+
+void set_map_node_floor_number_in_map(map_t * map,map_node_t * node,int8_t floor_number){
+	if(map == NULL || node == NULL) return;
+	
+	node->floor_number = floor_number;
+	refresh_map_node_flags(map,node);
+	
+	//the climb of every edge of the node changes with it
+	for(size_t i = 0;i < node->n_outgoing_edges;i++) note_changed_map_edge(map,node->outgoing_edges[i]);
+}
+
+void set_map_node_selectable_in_map(map_t * map,map_node_t * node,bool selectable){
+	if(map == NULL || node == NULL) return;
+	
+	node->selectable = selectable;
+	refresh_map_node_flags(map,node);
+}
+
+void set_map_edge_type_in_map(map_t * map,map_edge_t * edge,uint8_t type){
+	if(map == NULL || edge == NULL) return;
+	
+	edge->type = type;
+	note_changed_map_edge(map,edge);
+	refresh_map_node_flags(map,edge->a);
+	refresh_map_node_flags(map,edge->b);
+}
+
 void remove_node_from_map(map_t * map,map_node_t * node){
 	if(map == NULL || node == NULL) return;
 	
@@ -892,13 +1125,13 @@ static size_t find_node_in_map_by_name(map_t * map,const char * node_name,bool *
 	
 	*found = false;
 	size_t matching_index = 0;
+	uint32_t name_id = find_interned_string(map->strings,node_name);
 	
 	//find it in the array
 	for(size_t i = 0;i < map->n_nodes;i++){
 		map_node_t * current_node = map->all_nodes[i];
-		if(current_node->name == NULL) continue;
 		
-		if(strcmp(node_name,current_node->name) == 0){
+		if(map_name_matches(current_node->name,current_node->name_id,node_name,name_id)){
 			*found = true;
 			matching_index = i;
 			break;
@@ -932,6 +1165,10 @@ void connect_nodes_in_map_by_indices(map_t * map,size_t index_a,size_t index_b,u
 	map_edge_t * new_edge = create_map_edge(edge_type,node_a,node_b);
 	
 	add_edge_to_map(map,new_edge);
+	
+	//a new edge can only add flags
+	map->node_flags[index_a] |= get_edge_type_node_flags(edge_type);
+	map->node_flags[index_b] |= get_edge_type_node_flags(edge_type);
 }
 
 void connect_nodes_in_map(map_t * map,map_node_t * node_a,map_node_t * node_b,uint8_t edge_type){
@@ -975,6 +1212,10 @@ void disconnect_nodes_in_map_by_indices(map_t * map,size_t index_a,size_t index_
 			remove_outgoing_edge_from_node_by_index(node_a,i);
 			remove_outgoing_edge_from_node(node_b,current_edge);
 			remove_edge_from_map(map,current_edge);
+			
+			//another edge may still give the same flag so only these two nodes are checked again
+			map->node_flags[index_a] = compute_map_node_flags(node_a);
+			map->node_flags[index_b] = compute_map_node_flags(node_b);
 			return;
 		}
 	}
@@ -1019,6 +1260,10 @@ void set_connection_type_for_nodes_by_indices(map_t * map,size_t index_a,size_t
 		
 		if(current_edge->a == node_b || current_edge->b == node_b){
 			current_edge->type = new_edge_type;
+			note_changed_map_edge(map,current_edge);
+			
+			map->node_flags[index_a] = compute_map_node_flags(node_a);
+			map->node_flags[index_b] = compute_map_node_flags(node_b);
 			return;
 		}
 	}
@@ -1063,6 +1308,7 @@ void add_mpo_to_map(map_t * map,mpo_t * mpo){
 		map->all_mpos = (mpo_t**) realloc(map->all_mpos,sizeof(mpo_t*)*map->mpo_capacity);
 	}
 	
+	intern_mpo_strings(map,mpo);
 	map->all_mpos[map->n_mpos] = mpo;
 	map->n_mpos++;
 }
@@ -1088,13 +1334,13 @@ void remove_mpo_from_map_by_name(map_t * map,const char * mpo_name){
 	
 	bool found = false;
 	size_t matching_index = 0;
+	uint32_t name_id = find_interned_string(map->strings,mpo_name);
 	
 	//find it in the array
 	for(size_t i = 0;i < map->n_mpos;i++){
 		mpo_t * current_mpo = map->all_mpos[i];
-		if(current_mpo->name == NULL) continue;
 		
-		if(strcmp(mpo_name,current_mpo->name) == 0){
+		if(map_name_matches(current_mpo->name,current_mpo->name_id,mpo_name,name_id)){
 			found = true;
 			matching_index = i;
 			break;
@@ -1203,6 +1449,7 @@ void delete_map_path(map_path_t * map_path_ref) {
 	if(map_path_ref == NULL) return;
 	free(map_path_ref->nodes);
 	free(map_path_ref->name);
+	free(map_path_ref);
 }
 
 map_path_t * copy_map_path(const map_path_t * map_path_ref){
@@ -1239,6 +1486,24 @@ map_path_t * copy_map_path(const map_path_t * map_path_ref){
 	return out;
 }
 
+map_rect_t get_map_bounding_rect(const map_t * map_ref){
+	if(map_ref == NULL || map_ref->n_nodes == 0) return create_map_rect(create_cord(0,0),create_cord(0,0));
+
+	cord_t first = map_ref->all_nodes[0]->coordinate;
+	map_rect_t out = create_map_rect(first,first);
+
+	for(size_t i = 1;i < map_ref->n_nodes;i++){
+		cord_t current = map_ref->all_nodes[i]->coordinate;
+
+		if(current.longitude < out.bottom_left.longitude) out.bottom_left.longitude = current.longitude;
+		if(current.latitude < out.bottom_left.latitude) out.bottom_left.latitude = current.latitude;
+		if(current.longitude > out.top_right.longitude) out.top_right.longitude = current.longitude;
+		if(current.latitude > out.top_right.latitude) out.top_right.latitude = current.latitude;
+	}
+
+	return out;
+}
+
 saved_paths_t init_saved_paths(){
 	saved_paths_t out;
 
@@ -1511,6 +1776,7 @@ static map_edge_t * convert_binary_to_map_edge(const uint8_t * buffer,map_node_t
 	
 	memcpy(&(index),buffer+current_offset,sizeof(size_t));
 	out->b = all_nodes[index];
+	out->schedule = NULL;
 	
 	return out;
 }
@@ -0,0 +1,173 @@
+#include "map_graph.h"
+#include "edge_weights.h"
+#include "floor_layers.h"
+#include "building_routes.h"
+#include "schedules.h"
+#include "projection.h"
+
+static uint64_t last_map_graph_version = 0;
+
+map_graph_t * create_map_graph(map_t * map_ref){
+	return create_map_graph_from_previous(map_ref,NULL);
+}
+
+map_graph_t * create_map_graph_from_previous(map_t * map_ref,const map_graph_t * previous){
+	if(map_ref == NULL) return NULL;
+
+	map_graph_t * graph = (map_graph_t*) malloc(sizeof(map_graph_t));
+	graph->reference_count = 1;
+	graph->version = __atomic_add_fetch(&last_map_graph_version,1,__ATOMIC_RELAXED);
+
+	graph->n_nodes = map_ref->n_nodes;
+	graph->hot_nodes = (map_graph_node_t*) malloc(sizeof(map_graph_node_t)*(graph->n_nodes+1));
+	graph->nodes = (map_node_t*) malloc(sizeof(map_node_t)*(graph->n_nodes+1));
+	graph->source_nodes = (map_node_t**) malloc(sizeof(map_node_t*)*(graph->n_nodes+1));
+	graph->node_flags = (uint16_t*) malloc(sizeof(uint16_t)*(graph->n_nodes+1));
+
+	for(size_t i = 0;i < graph->n_nodes;i++){
+		map_node_t * source = map_ref->all_nodes[i];
+		source->index_temp = i;
+
+		graph->hot_nodes[i].coordinate = source->coordinate;
+		graph->hot_nodes[i].floor_number = source->floor_number;
+
+		map_node_t * copy = &(graph->nodes[i]);
+		*copy = *source;
+		copy->name = NULL;
+		copy->picture_file_path = NULL;
+		copy->outgoing_edges = NULL;
+		copy->n_outgoing_edges = 0;
+		copy->outgoing_edges_capacity = 0;
+		copy->previous = NULL;
+
+		graph->source_nodes[i] = source;
+		graph->node_flags[i] = map_ref->node_flags[i];
+	}
+
+	graph->n_edges = map_ref->n_edges;
+	graph->edges = (map_edge_t*) malloc(sizeof(map_edge_t)*(graph->n_edges+1));
+	graph->source_edges = (map_edge_t**) malloc(sizeof(map_edge_t*)*(graph->n_edges+1));
+	graph->edge_nodes = (uint32_t*) malloc(sizeof(uint32_t)*(2*graph->n_edges+1));
+	graph->adjacency_offsets = (size_t*) malloc(sizeof(size_t)*(graph->n_nodes+1));
+	graph->adjacency_nodes = (uint32_t*) malloc(sizeof(uint32_t)*(2*graph->n_edges+1));
+	graph->adjacency_edges = (uint32_t*) malloc(sizeof(uint32_t)*(2*graph->n_edges+1));
+
+	//count the degree of every node
+	for(size_t i = 0;i <= graph->n_nodes;i++) graph->adjacency_offsets[i] = 0;
+	for(size_t i = 0;i < graph->n_edges;i++){
+		map_edge_t * source = map_ref->all_edges[i];
+		size_t a = source->a->index_temp;
+		size_t b = source->b->index_temp;
+
+		graph->edges[i] = *source;
+		graph->edges[i].a = &(graph->nodes[a]);
+		graph->edges[i].b = &(graph->nodes[b]);
+		graph->edges[i].schedule = NULL;
+		graph->source_edges[i] = source;
+		graph->edge_nodes[2*i] = a;
+		graph->edge_nodes[2*i+1] = b;
+
+		graph->adjacency_offsets[a+1]++;
+		graph->adjacency_offsets[b+1]++;
+	}
+
+	//prefix sum turns degrees into offsets
+	for(size_t i = 0;i < graph->n_nodes;i++){
+		graph->adjacency_offsets[i+1] += graph->adjacency_offsets[i];
+	}
+
+	//fill in neighbours, every edge is walkable in both directions
+	size_t * fill = (size_t*) malloc(sizeof(size_t)*(graph->n_nodes+1));
+	for(size_t i = 0;i < graph->n_nodes;i++) fill[i] = graph->adjacency_offsets[i];
+	for(size_t i = 0;i < graph->n_edges;i++){
+		uint32_t a = graph->edge_nodes[2*i];
+		uint32_t b = graph->edge_nodes[2*i+1];
+
+		graph->adjacency_nodes[fill[a]] = b;
+		graph->adjacency_edges[fill[a]] = i;
+		fill[a]++;
+
+		graph->adjacency_nodes[fill[b]] = a;
+		graph->adjacency_edges[fill[b]] = i;
+		fill[b]++;
+	}
+	free(fill);
+
+	graph->projection = create_map_projection(graph);
+	graph->weights = create_edge_weights(graph,previous);
+	for(size_t i = 0;i < N_SEARCH_FILTERS;i++) graph->filter_bitsets[i] = NULL;
+	graph->floor_layers = create_floor_layers(graph);
+	graph->building_routes = create_building_routes(graph,previous);
+	graph->schedule_tables = create_schedule_tables(graph);
+
+	return graph;
+}
+
+void retain_map_graph(map_graph_t * graph){
+	if(graph == NULL) return;
+
+	__atomic_add_fetch(&(graph->reference_count),1,__ATOMIC_RELAXED);
+}
+
+void release_map_graph(map_graph_t * graph){
+	if(graph == NULL) return;
+
+	if(__atomic_sub_fetch(&(graph->reference_count),1,__ATOMIC_ACQ_REL) != 0) return;
+
+	free(graph->hot_nodes);
+	free(graph->nodes);
+	free(graph->source_nodes);
+	free(graph->node_flags);
+	free(graph->edges);
+	free(graph->source_edges);
+	free(graph->edge_nodes);
+	free(graph->adjacency_offsets);
+	free(graph->adjacency_nodes);
+	free(graph->adjacency_edges);
+	delete_map_projection(graph->projection);
+	delete_edge_weights(graph->weights);
+	for(size_t i = 0;i < N_SEARCH_FILTERS;i++) free(graph->filter_bitsets[i]);
+	delete_floor_layers(graph->floor_layers);
+	delete_building_routes(graph->building_routes);
+	delete_schedule_tables(graph->schedule_tables);
+	free(graph);
+}
+
+uint32_t get_map_graph_node_index(const map_graph_t * graph,const map_node_t * node,bool * found){
+	*found = false;
+	if(graph == NULL || node == NULL) return 0;
+
+	//index_temp is usually still the index from when the snapshot was taken
+	if(node->index_temp < graph->n_nodes && graph->source_nodes[node->index_temp] == node){
+		*found = true;
+		return node->index_temp;
+	}
+
+	for(size_t i = 0;i < graph->n_nodes;i++){
+		if(graph->source_nodes[i] == node){
+			*found = true;
+			return i;
+		}
+	}
+
+	return 0;
+}
+
+uint32_t get_map_graph_edge_index(const map_graph_t * graph,const map_edge_t * edge,bool * found){
+	*found = false;
+	if(graph == NULL || edge == NULL) return 0;
+
+	bool node_found = false;
+	uint32_t a = get_map_graph_node_index(graph,edge->a,&node_found);
+	if(!node_found) return 0;
+
+	for(size_t i = graph->adjacency_offsets[a];i < graph->adjacency_offsets[a+1];i++){
+		uint32_t edge_index = graph->adjacency_edges[i];
+		if(graph->source_edges[edge_index] == edge){
+			*found = true;
+			return edge_index;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,1231 @@
+#include "map_import.h"
+#include "node_order.h"
+#include "string_interner.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <expat.h>
+
+#define DEFAULT_IMPORT_NODE_SLOTS 1024
+#define DEFAULT_IMPORT_BUFFER_CAPACITY 64
+
+//no map node or no array, in the uint32_t indices below
+#define IMPORT_INDEX_NONE UINT32_MAX
+
+//deepest nesting of GeoJSON coordinates read, a MultiPolygon needs 4
+#define MAX_GEOJSON_COORDINATE_DEPTH 8
+
+//what the tags of a way or feature make it
+#define IMPORT_SHAPE_NONE 0
+#define IMPORT_SHAPE_LINE 1//a chain of edges through its nodes
+#define IMPORT_SHAPE_AREA 2//a building or an mpo outlined by it
+
+//the OSM element being read
+#define OSM_ELEMENT_NONE 0
+#define OSM_ELEMENT_NODE 1
+#define OSM_ELEMENT_WAY 2
+#define OSM_ELEMENT_RELATION 3
+
+//GeoJSON geometry types read
+#define GEOJSON_GEOMETRY_NONE 0
+#define GEOJSON_GEOMETRY_POINT 1
+#define GEOJSON_GEOMETRY_LINE_STRING 2
+#define GEOJSON_GEOMETRY_MULTI_LINE_STRING 3
+#define GEOJSON_GEOMETRY_POLYGON 4
+#define GEOJSON_GEOMETRY_MULTI_POLYGON 5
+
+/*
+ * A node of the file by its key: the OSM id, or for GeoJSON the coordinate to 7 decimals with the level in
+ * key_floor so stacked floors stay apart. map_index is IMPORT_INDEX_NONE until a way or feature uses the node.
+ */
+typedef struct Import_Node{
+	uint64_t key;
+	int8_t key_floor;
+	bool used;
+
+	//a GeoJSON node without a level standing in for a node on a level at the same coordinate
+	bool alias;
+	cord_t coordinate;
+	uint32_t map_index;
+	uint32_t name_id;
+} import_node_t;
+
+//The tags of the way or feature being read that say what it becomes.
+typedef struct Import_Tags{
+	uint8_t highway_edge_type;
+	uint8_t mpo_type;
+	bool building;
+	bool corridor;
+	bool crossing;
+	bool bridge;
+	bool ramp;
+	bool door;
+	bool automatic_door;
+	uint8_t n_floors;
+	bool has_level;
+	int8_t level;
+	char name[MAP_IMPORT_MAX_NAME];
+} import_tags_t;
+
+//An array of positions of a GeoJSON geometry, parts with the same group are the rings of one polygon.
+typedef struct Geojson_Part{
+	size_t first_cord;
+	size_t n_cords;
+	uint32_t group;
+} geojson_part_t;
+
+/*
+ * The building bounding boxes of a map bucketed into a grid of cells over all of them, the buildings of cell c are
+ * buildings[offsets[c]] up to buildings[offsets[c+1]], in map order.
+ */
+typedef struct Building_Grid{
+	map_rect_t bounds;
+	size_t side;
+	double cell_width;
+	double cell_height;
+	uint32_t * offsets;
+	uint32_t * buildings;
+} building_grid_t;
+
+typedef struct Map_Importer{
+	map_t * map;
+	map_import_stats_t stats;
+	size_t first_node;
+	size_t first_edge;
+	size_t first_building;
+	size_t first_mpo;
+
+	//open addressing table of every node read, the number of slots is a power of two
+	import_node_t * nodes;
+	size_t n_slots;
+	size_t n_used;
+
+	//names of nodes not in the map yet
+	string_interner_t * names;
+
+	import_tags_t tags;
+
+	//OSM node ids of the way being read
+	uint64_t * refs;
+	size_t n_refs;
+	size_t refs_capacity;
+
+	//positions of the way or geometry being read and the arrays they are split into
+	cord_t * cords;
+	size_t n_cords;
+	size_t cords_capacity;
+	geojson_part_t * parts;
+	size_t n_parts;
+	size_t parts_capacity;
+
+	//1 for every added map node that belongs inside a building, by map index from first_node
+	uint8_t * indoor;
+	size_t indoor_capacity;
+
+	//the OSM element being read
+	uint8_t element;
+	uint64_t element_id;
+	cord_t element_cord;
+} map_importer_t;
+
+static const double powers_of_ten[23] = {1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+
+/*
+ * A decimal number at the start of text, like 39.2554213 or -7.6e1. Returns the bytes read, 0 if there is no number.
+ * Up to 19 significant digits are kept, enough for coordinates to be exact to the last bit.
+ */
+static size_t parse_import_number(const char * text,size_t length,double * value){
+	size_t i = 0;
+	bool negative = false;
+	if(i < length && (text[i] == '-' || text[i] == '+')){
+		negative = text[i] == '-';
+		i++;
+	}
+
+	uint64_t mantissa = 0;
+	int exponent = 0;
+	size_t n_significant = 0;
+	size_t n_digits = 0;
+	for(;i < length && text[i] >= '0' && text[i] <= '9';i++){
+		n_digits++;
+		if(n_significant < 19){
+			mantissa = mantissa*10 + (text[i] - '0');
+			n_significant += mantissa != 0;
+		}else{
+			exponent++;
+		}
+	}
+	if(i < length && text[i] == '.'){
+		for(i++;i < length && text[i] >= '0' && text[i] <= '9';i++){
+			n_digits++;
+			if(n_significant < 19){
+				mantissa = mantissa*10 + (text[i] - '0');
+				n_significant += mantissa != 0;
+				exponent--;
+			}
+		}
+	}
+	if(n_digits == 0) return 0;
+
+	if(i < length && (text[i] == 'e' || text[i] == 'E')){
+		size_t j = i+1;
+		bool negative_exponent = false;
+		if(j < length && (text[j] == '-' || text[j] == '+')){
+			negative_exponent = text[j] == '-';
+			j++;
+		}
+		int written_exponent = 0;
+		size_t n_exponent_digits = 0;
+		for(;j < length && text[j] >= '0' && text[j] <= '9';j++){
+			if(written_exponent < 10000) written_exponent = written_exponent*10 + (text[j] - '0');
+			n_exponent_digits++;
+		}
+		if(n_exponent_digits > 0){
+			exponent += negative_exponent ? -written_exponent : written_exponent;
+			i = j;
+		}
+	}
+
+	double result = (double) mantissa;
+	if(exponent < 0){
+		result = (exponent >= -22) ? result/powers_of_ten[-exponent] : result/pow(10.0,-exponent);
+	}else if(exponent > 0){
+		result = (exponent <= 22) ? result*powers_of_ten[exponent] : result*pow(10.0,exponent);
+	}
+	*value = negative ? -result : result;
+	return i;
+}
+
+static void reset_import_tags(import_tags_t * tags){
+	tags->highway_edge_type = 0;
+	tags->mpo_type = 0;
+	tags->building = false;
+	tags->corridor = false;
+	tags->crossing = false;
+	tags->bridge = false;
+	tags->ramp = false;
+	tags->door = false;
+	tags->automatic_door = false;
+	tags->n_floors = 1;
+	tags->has_level = false;
+	tags->level = NODE_FLOOR_NUMBER_NONE;
+	tags->name[0] = '\0';
+}
+
+//true unless a tag value says the thing is not there
+static inline bool is_import_tag_set(const char * value){
+	return strcmp(value,"no") != 0 && strcmp(value,"0") != 0 && strcmp(value,"0%") != 0;
+}
+
+static bool is_import_value_in(const char * value,const char * const * values,size_t n_values){
+	for(size_t i = 0;i < n_values;i++){
+		if(strcmp(value,values[i]) == 0) return true;
+	}
+	return false;
+}
+
+//Record one key=value tag of the way or feature being read.
+static void apply_import_tag(import_tags_t * tags,const char * key,const char * value){
+	static const char * const walkways[] = {"footway","path","pedestrian","living_street","cycleway","track","bridleway"};
+	static const char * const not_ways[] = {"proposed","construction","abandoned","platform","bus_stop","street_lamp","traffic_signals","crossing"};
+	static const char * const water[] = {"reservoir","basin"};
+	static const char * const trees[] = {"forest","grass","meadow"};
+
+	switch(key[0]){
+		case 'a':
+			if(strcmp(key,"automatic_door") == 0) tags->automatic_door = is_import_tag_set(value);
+			else if(strcmp(key,"area:highway") == 0) tags->highway_edge_type = EDGE_TYPE_SIDEWALK;
+			break;
+		case 'b':
+			if(strcmp(key,"building") == 0) tags->building = is_import_tag_set(value);
+			else if(strcmp(key,"bridge") == 0) tags->bridge = is_import_tag_set(value);
+			else if(strcmp(key,"building:levels") == 0){
+				double levels = 0;
+				if(parse_import_number(value,strlen(value),&levels) > 0 && levels >= 1) tags->n_floors = (levels > 255) ? 255 : (uint8_t) levels;
+			}
+			break;
+		case 'd':
+			if(strcmp(key,"door") == 0){
+				tags->door = is_import_tag_set(value);
+				if(strcmp(value,"automatic") == 0) tags->automatic_door = true;
+			}
+			break;
+		case 'f':
+			if(strcmp(key,"footway") == 0 && strcmp(value,"crossing") == 0) tags->crossing = true;
+			break;
+		case 'h':
+			if(strcmp(key,"highway") != 0) break;
+			if(is_import_value_in(value,walkways,sizeof(walkways)/sizeof(walkways[0]))) tags->highway_edge_type = EDGE_TYPE_SIDEWALK;
+			else if(strcmp(value,"steps") == 0) tags->highway_edge_type = EDGE_TYPE_STAIRS;
+			else if(strcmp(value,"corridor") == 0) tags->highway_edge_type = EDGE_TYPE_HALLWAY;
+			else if(strcmp(value,"elevator") == 0) tags->highway_edge_type = EDGE_TYPE_ELEVATOR_SHAFT;
+			else if(!is_import_value_in(value,not_ways,sizeof(not_ways)/sizeof(not_ways[0]))) tags->highway_edge_type = EDGE_TYPE_ROAD;
+			if(strcmp(value,"crossing") == 0) tags->crossing = true;
+			break;
+		case 'i':
+			if(strcmp(key,"indoor") == 0 && strcmp(value,"corridor") == 0) tags->corridor = true;
+			else if(strcmp(key,"incline") == 0) tags->ramp = is_import_tag_set(value);
+			break;
+		case 'l':
+			if(strcmp(key,"landuse") == 0){
+				if(is_import_value_in(value,water,sizeof(water)/sizeof(water[0]))) tags->mpo_type = MPO_TYPE_WATER;
+				else if(is_import_value_in(value,trees,sizeof(trees)/sizeof(trees[0]))) tags->mpo_type = MPO_TYPE_TREE;
+			}else if(strcmp(key,"level") == 0){
+				double level = 0;
+				if(parse_import_number(value,strlen(value),&level) > 0 && level > -128 && level < 128){
+					tags->has_level = true;
+					tags->level = (int8_t) level;
+				}
+			}
+			break;
+		case 'n':
+			if(strcmp(key,"name") == 0){
+				strncpy(tags->name,value,MAP_IMPORT_MAX_NAME-1);
+				tags->name[MAP_IMPORT_MAX_NAME-1] = '\0';
+			}else if(strcmp(key,"natural") == 0){
+				if(strcmp(value,"water") == 0) tags->mpo_type = MPO_TYPE_WATER;
+				else if(strcmp(value,"wood") == 0 || strcmp(value,"scrub") == 0) tags->mpo_type = MPO_TYPE_TREE;
+			}
+			break;
+		case 'r':
+			if(strcmp(key,"ramp") == 0) tags->ramp = is_import_tag_set(value);
+			break;
+		case 'w':
+			if(strcmp(key,"water") == 0) tags->mpo_type = MPO_TYPE_WATER;
+			else if(strcmp(key,"waterway") == 0 && strcmp(value,"riverbank") == 0) tags->mpo_type = MPO_TYPE_WATER;
+			break;
+	}
+}
+
+//IMPORT_SHAPE_* of the tags read, with the edge type of a line.
+static uint8_t classify_import_tags(const import_tags_t * tags,uint8_t * edge_type){
+	if(tags->building || tags->mpo_type != 0) return IMPORT_SHAPE_AREA;
+
+	uint8_t type = tags->highway_edge_type;
+	if(type == 0 && tags->corridor) type = EDGE_TYPE_HALLWAY;
+	if(tags->door){
+		type = tags->automatic_door ? EDGE_TYPE_AUTO_DOOR : EDGE_TYPE_DOOR;
+	}else if(type == EDGE_TYPE_SIDEWALK){
+		if(tags->crossing) type = EDGE_TYPE_CROSSWALK;
+		else if(tags->bridge) type = EDGE_TYPE_OVERPASS;
+		else if(tags->ramp) type = EDGE_TYPE_RAMP;
+	}
+	if(type == 0) return IMPORT_SHAPE_NONE;
+
+	*edge_type = type;
+	return IMPORT_SHAPE_LINE;
+}
+
+//true for edges only found inside buildings, their nodes are put in the building around them
+static inline bool is_indoor_edge_type(uint8_t edge_type){
+	return edge_type == EDGE_TYPE_HALLWAY || edge_type == EDGE_TYPE_STAIRS || edge_type == EDGE_TYPE_ELEVATOR_SHAFT
+		|| edge_type == EDGE_TYPE_DOOR || edge_type == EDGE_TYPE_AUTO_DOOR;
+}
+
+//splitmix64 finalizer, spreads OSM ids that count up and coordinates that differ in the low bits alike
+static inline uint64_t hash_import_key(uint64_t key,int8_t key_floor){
+	key ^= (uint64_t)(uint8_t) key_floor << 56;
+	key = (key ^ (key >> 30))*0xbf58476d1ce4e5b9ull;
+	key = (key ^ (key >> 27))*0x94d049bb133111ebull;
+	return key ^ (key >> 31);
+}
+
+static size_t find_import_slot(const map_importer_t * importer,uint64_t key,int8_t key_floor){
+	size_t mask = importer->n_slots - 1;
+	size_t slot = hash_import_key(key,key_floor) & mask;
+	while(importer->nodes[slot].used && (importer->nodes[slot].key != key || importer->nodes[slot].key_floor != key_floor)){
+		slot = (slot+1) & mask;
+	}
+	return slot;
+}
+
+//Double the table once it is half full.
+static void grow_import_nodes(map_importer_t * importer){
+	import_node_t * old_nodes = importer->nodes;
+	size_t old_n_slots = importer->n_slots;
+	importer->n_slots *= 2;
+	importer->nodes = (import_node_t*) calloc(importer->n_slots,sizeof(import_node_t));
+	for(size_t i = 0;i < old_n_slots;i++){
+		if(!old_nodes[i].used) continue;
+		importer->nodes[find_import_slot(importer,old_nodes[i].key,old_nodes[i].key_floor)] = old_nodes[i];
+	}
+	free(old_nodes);
+}
+
+//The node with a key, NULL if the file has not had it.
+static import_node_t * find_import_node(map_importer_t * importer,uint64_t key,int8_t key_floor){
+	size_t slot = find_import_slot(importer,key,key_floor);
+	return importer->nodes[slot].used ? &(importer->nodes[slot]) : NULL;
+}
+
+//The node with a key, added at a coordinate if it is new. Valid until the next node is added.
+static import_node_t * add_import_node(map_importer_t * importer,uint64_t key,int8_t key_floor,cord_t coordinate){
+	if(2*(importer->n_used+1) > importer->n_slots) grow_import_nodes(importer);
+
+	import_node_t * node = &(importer->nodes[find_import_slot(importer,key,key_floor)]);
+	if(node->used) return node;
+
+	node->used = true;
+	node->alias = false;
+	node->key = key;
+	node->key_floor = key_floor;
+	node->coordinate = coordinate;
+	node->map_index = IMPORT_INDEX_NONE;
+	node->name_id = STRING_ID_NONE;
+	importer->n_used++;
+	return node;
+}
+
+static void init_map_importer(map_importer_t * importer,map_t * map){
+	importer->map = map;
+	memset(&(importer->stats),0,sizeof(map_import_stats_t));
+	importer->first_node = map->n_nodes;
+	importer->first_edge = map->n_edges;
+	importer->first_building = map->n_buildings;
+	importer->first_mpo = map->n_mpos;
+
+	importer->n_slots = DEFAULT_IMPORT_NODE_SLOTS;
+	importer->nodes = (import_node_t*) calloc(importer->n_slots,sizeof(import_node_t));
+	importer->n_used = 0;
+	importer->names = create_string_interner();
+	reset_import_tags(&(importer->tags));
+
+	importer->refs_capacity = DEFAULT_IMPORT_BUFFER_CAPACITY;
+	importer->refs = (uint64_t*) malloc(sizeof(uint64_t)*importer->refs_capacity);
+	importer->n_refs = 0;
+	importer->cords_capacity = DEFAULT_IMPORT_BUFFER_CAPACITY;
+	importer->cords = (cord_t*) malloc(sizeof(cord_t)*importer->cords_capacity);
+	importer->n_cords = 0;
+	importer->parts_capacity = DEFAULT_IMPORT_BUFFER_CAPACITY;
+	importer->parts = (geojson_part_t*) malloc(sizeof(geojson_part_t)*importer->parts_capacity);
+	importer->n_parts = 0;
+	importer->indoor_capacity = DEFAULT_IMPORT_BUFFER_CAPACITY;
+	importer->indoor = (uint8_t*) calloc(importer->indoor_capacity,sizeof(uint8_t));
+
+	importer->element = OSM_ELEMENT_NONE;
+	importer->element_id = 0;
+	importer->element_cord = create_cord(0,0);
+}
+
+static void delete_map_importer_buffers(map_importer_t * importer){
+	free(importer->nodes);
+	delete_string_interner(importer->names);
+	free(importer->refs);
+	free(importer->cords);
+	free(importer->parts);
+	free(importer->indoor);
+}
+
+static void add_import_cord(map_importer_t * importer,cord_t cord){
+	if(importer->n_cords == importer->cords_capacity){
+		importer->cords_capacity *= 2;
+		importer->cords = (cord_t*) realloc(importer->cords,sizeof(cord_t)*importer->cords_capacity);
+	}
+	importer->cords[importer->n_cords] = cord;
+	importer->n_cords++;
+}
+
+/*
+ * The map index of a node, adding it to the map the first time a way or feature uses it.
+ * The first way to use a node gives it its floor.
+ */
+static uint32_t get_import_map_node(map_importer_t * importer,import_node_t * node,int8_t floor_number,bool indoor){
+	map_t * map = importer->map;
+	if(node->map_index != IMPORT_INDEX_NONE){
+		importer->stats.n_shared_nodes++;
+	}else{
+		map_node_t * map_node = create_map_node(node->coordinate);
+		if(floor_number != NODE_FLOOR_NUMBER_NONE) set_map_node_floor_number(map_node,floor_number);
+		if(node->name_id != STRING_ID_NONE){
+			set_map_node_name(map_node,get_interned_string(importer->names,node->name_id));
+			set_map_node_selectable(map_node,true);
+		}
+		node->map_index = map->n_nodes;
+		add_node_to_map(map,map_node);
+	}
+
+	size_t offset = node->map_index - importer->first_node;
+	if(indoor){
+		if(offset >= importer->indoor_capacity){
+			size_t old_capacity = importer->indoor_capacity;
+			while(importer->indoor_capacity <= offset) importer->indoor_capacity *= 2;
+			importer->indoor = (uint8_t*) realloc(importer->indoor,importer->indoor_capacity);
+			memset(importer->indoor+old_capacity,0,importer->indoor_capacity-old_capacity);
+		}
+		importer->indoor[offset] = 1;
+	}
+	return node->map_index;
+}
+
+//Join the node before along a line to the next one.
+static void link_import_map_node(map_importer_t * importer,uint32_t * previous,uint32_t index,uint8_t edge_type){
+	if(*previous != IMPORT_INDEX_NONE && *previous != index){
+		connect_nodes_in_map_by_indices(importer->map,*previous,index,edge_type);
+	}
+	*previous = index;
+}
+
+//Add a closed outline as a building or an mpo by the tags read. The outline does not repeat its first cord.
+static void add_import_area(map_importer_t * importer,const cord_t * cords,size_t n_cords){
+	if(n_cords >= 2 && cords[0].longitude == cords[n_cords-1].longitude && cords[0].latitude == cords[n_cords-1].latitude) n_cords--;
+	if(n_cords < 3){
+		importer->stats.n_skipped++;
+		return;
+	}
+
+	const import_tags_t * tags = &(importer->tags);
+	const char * name = (tags->name[0] != '\0') ? tags->name : NULL;
+	mpo_t * mpo = create_mpo(cords,n_cords,tags->building ? MPO_TYPE_BUILDING : tags->mpo_type);
+	if(name != NULL) set_mpo_name(mpo,name);
+	add_mpo_to_map(importer->map,mpo);
+
+	if(tags->building){
+		cord_t bottom_left = cords[0];
+		cord_t top_right = cords[0];
+		for(size_t i = 1;i < n_cords;i++){
+			bottom_left.longitude = fmin(bottom_left.longitude,cords[i].longitude);
+			bottom_left.latitude = fmin(bottom_left.latitude,cords[i].latitude);
+			top_right.longitude = fmax(top_right.longitude,cords[i].longitude);
+			top_right.latitude = fmax(top_right.latitude,cords[i].latitude);
+		}
+		add_building_to_map(importer->map,create_building(name,create_map_rect(bottom_left,top_right),tags->n_floors));
+	}
+}
+
+//The cells of a grid a rect covers along one axis, clamped to the grid.
+static void get_building_grid_span(double low,double high,double grid_low,double cell_size,size_t side,size_t * first,size_t * last){
+	double first_cell = floor((low - grid_low)/cell_size);
+	double last_cell = floor((high - grid_low)/cell_size);
+	*first = (size_t) fmin(fmax(first_cell,0.0),(double) (side-1));
+	*last = (size_t) fmin(fmax(last_cell,0.0),(double) (side-1));
+}
+
+//About one building per cell, so a node is tested against the few buildings near it.
+static building_grid_t create_building_grid(const map_t * map){
+	building_grid_t grid;
+	grid.side = 1;
+	while(grid.side*grid.side < map->n_buildings) grid.side *= 2;
+
+	grid.bounds = create_map_rect(create_cord(0,0),create_cord(0,0));
+	for(size_t b = 0;b < map->n_buildings;b++){
+		map_rect_t box = map->all_buildings[b]->building_bounding_box;
+		if(b == 0){
+			grid.bounds = box;
+			continue;
+		}
+		grid.bounds.bottom_left.longitude = fmin(grid.bounds.bottom_left.longitude,box.bottom_left.longitude);
+		grid.bounds.bottom_left.latitude = fmin(grid.bounds.bottom_left.latitude,box.bottom_left.latitude);
+		grid.bounds.top_right.longitude = fmax(grid.bounds.top_right.longitude,box.top_right.longitude);
+		grid.bounds.top_right.latitude = fmax(grid.bounds.top_right.latitude,box.top_right.latitude);
+	}
+	grid.cell_width = fmax((grid.bounds.top_right.longitude - grid.bounds.bottom_left.longitude)/grid.side,1e-9);
+	grid.cell_height = fmax((grid.bounds.top_right.latitude - grid.bounds.bottom_left.latitude)/grid.side,1e-9);
+
+	//count the buildings of every cell, then place them
+	size_t n_cells = grid.side*grid.side;
+	grid.offsets = (uint32_t*) calloc(n_cells+1,sizeof(uint32_t));
+	for(int pass = 0;pass < 2;pass++){
+		if(pass == 1){
+			for(size_t c = 0;c < n_cells;c++) grid.offsets[c+1] += grid.offsets[c];
+			grid.buildings = (uint32_t*) malloc(sizeof(uint32_t)*(grid.offsets[n_cells]+1));
+		}
+
+		for(size_t b = 0;b < map->n_buildings;b++){
+			map_rect_t box = map->all_buildings[b]->building_bounding_box;
+			size_t first_x,last_x,first_y,last_y;
+			get_building_grid_span(box.bottom_left.longitude,box.top_right.longitude,grid.bounds.bottom_left.longitude,grid.cell_width,grid.side,&first_x,&last_x);
+			get_building_grid_span(box.bottom_left.latitude,box.top_right.latitude,grid.bounds.bottom_left.latitude,grid.cell_height,grid.side,&first_y,&last_y);
+			for(size_t y = first_y;y <= last_y;y++){
+				for(size_t x = first_x;x <= last_x;x++){
+					size_t cell = y*grid.side + x;
+					if(pass == 0){
+						grid.offsets[cell+1]++;
+					}else{
+						grid.buildings[grid.offsets[cell]++] = b;
+					}
+				}
+			}
+		}
+	}
+
+	//placing moved every offset to the start of the next cell
+	for(size_t c = n_cells;c > 0;c--) grid.offsets[c] = grid.offsets[c-1];
+	grid.offsets[0] = 0;
+
+	return grid;
+}
+
+//The first building of the map whose bounding box holds a coordinate, NULL if there is none.
+static building_t * find_building_in_grid(const map_t * map,const building_grid_t * grid,cord_t cord){
+	if(cord.longitude < grid->bounds.bottom_left.longitude || cord.longitude > grid->bounds.top_right.longitude) return NULL;
+	if(cord.latitude < grid->bounds.bottom_left.latitude || cord.latitude > grid->bounds.top_right.latitude) return NULL;
+
+	size_t x,y;
+	get_building_grid_span(cord.longitude,cord.longitude,grid->bounds.bottom_left.longitude,grid->cell_width,grid->side,&x,&x);
+	get_building_grid_span(cord.latitude,cord.latitude,grid->bounds.bottom_left.latitude,grid->cell_height,grid->side,&y,&y);
+
+	size_t cell = y*grid->side + x;
+	for(size_t i = grid->offsets[cell];i < grid->offsets[cell+1];i++){
+		building_t * building = map->all_buildings[grid->buildings[i]];
+		map_rect_t box = building->building_bounding_box;
+		if(cord.longitude < box.bottom_left.longitude || cord.longitude > box.top_right.longitude) continue;
+		if(cord.latitude < box.bottom_left.latitude || cord.latitude > box.top_right.latitude) continue;
+		return building;
+	}
+	return NULL;
+}
+
+/*
+ * Put the nodes on indoor ways in the first building whose box holds them, take the strings of renamed nodes into
+ * the map, count what was added and reorder the nodes.
+ */
+static void finish_map_import(map_importer_t * importer){
+	map_t * map = importer->map;
+	building_grid_t grid = create_building_grid(map);
+	for(size_t offset = 0;importer->first_node + offset < map->n_nodes && offset < importer->indoor_capacity;offset++){
+		if(!importer->indoor[offset]) continue;
+
+		size_t index = importer->first_node + offset;
+		map_node_t * node = map->all_nodes[index];
+		building_t * building = find_building_in_grid(map,&grid,node->coordinate);
+		if(building == NULL) continue;
+
+		set_map_node_building(node,building);
+		map->node_flags[index] = compute_map_node_flags(node);
+	}
+	free(grid.offsets);
+	free(grid.buildings);
+	intern_map_strings(map);
+
+	importer->stats.n_nodes = map->n_nodes - importer->first_node;
+	importer->stats.n_edges = map->n_edges - importer->first_edge;
+	importer->stats.n_buildings = map->n_buildings - importer->first_building;
+	importer->stats.n_mpos = map->n_mpos - importer->first_mpo;
+	reorder_map_nodes(map,MAP_NODE_ORDER_HILBERT);
+}
+
+//---------------------------------------------------------- OSM XML ----------------------------------------------------------------
+
+static const char * get_osm_attribute(const XML_Char ** attributes,const char * name){
+	for(size_t i = 0;attributes[i] != NULL;i += 2){
+		if(strcmp(attributes[i],name) == 0) return attributes[i+1];
+	}
+	return NULL;
+}
+
+static double get_osm_number_attribute(const XML_Char ** attributes,const char * name){
+	const char * text = get_osm_attribute(attributes,name);
+	double value = 0;
+	if(text != NULL) parse_import_number(text,strlen(text),&value);
+	return value;
+}
+
+static void XMLCALL start_osm_element(void * user_data,const XML_Char * name,const XML_Char ** attributes){
+	map_importer_t * importer = (map_importer_t*) user_data;
+
+	if(strcmp(name,"nd") == 0){
+		const char * ref = get_osm_attribute(attributes,"ref");
+		if(importer->element != OSM_ELEMENT_WAY || ref == NULL) return;
+		if(importer->n_refs == importer->refs_capacity){
+			importer->refs_capacity *= 2;
+			importer->refs = (uint64_t*) realloc(importer->refs,sizeof(uint64_t)*importer->refs_capacity);
+		}
+		importer->refs[importer->n_refs] = (uint64_t) strtoll(ref,NULL,10);
+		importer->n_refs++;
+	}else if(strcmp(name,"tag") == 0){
+		const char * key = get_osm_attribute(attributes,"k");
+		const char * value = get_osm_attribute(attributes,"v");
+		if(importer->element == OSM_ELEMENT_RELATION || key == NULL || value == NULL) return;
+		apply_import_tag(&(importer->tags),key,value);
+	}else if(strcmp(name,"node") == 0 || strcmp(name,"way") == 0 || strcmp(name,"relation") == 0){
+		importer->stats.n_elements++;
+		importer->element = (name[0] == 'n') ? OSM_ELEMENT_NODE : (name[0] == 'w') ? OSM_ELEMENT_WAY : OSM_ELEMENT_RELATION;
+		const char * id = get_osm_attribute(attributes,"id");
+		importer->element_id = (id != NULL) ? (uint64_t) strtoll(id,NULL,10) : 0;
+		importer->element_cord = create_cord(get_osm_number_attribute(attributes,"lon"),get_osm_number_attribute(attributes,"lat"));
+		importer->n_refs = 0;
+		reset_import_tags(&(importer->tags));
+	}
+}
+
+static void add_osm_way(map_importer_t * importer){
+	uint8_t edge_type = 0;
+	uint8_t shape = classify_import_tags(&(importer->tags),&edge_type);
+	if(shape == IMPORT_SHAPE_NONE || importer->n_refs < 2){
+		importer->stats.n_skipped++;
+		return;
+	}
+
+	if(shape == IMPORT_SHAPE_AREA){
+		if(importer->refs[0] != importer->refs[importer->n_refs-1]){
+			importer->stats.n_skipped++;
+			return;
+		}
+		importer->n_cords = 0;
+		for(size_t r = 0;r < importer->n_refs;r++){
+			import_node_t * node = find_import_node(importer,importer->refs[r],NODE_FLOOR_NUMBER_NONE);
+			if(node == NULL){
+				importer->stats.n_missing_nodes++;
+				continue;
+			}
+			add_import_cord(importer,node->coordinate);
+		}
+		add_import_area(importer,importer->cords,importer->n_cords);
+		return;
+	}
+
+	int8_t floor_number = importer->tags.has_level ? importer->tags.level : NODE_FLOOR_NUMBER_NONE;
+	bool indoor = importer->tags.has_level || is_indoor_edge_type(edge_type);
+	uint32_t previous = IMPORT_INDEX_NONE;
+	for(size_t r = 0;r < importer->n_refs;r++){
+		import_node_t * node = find_import_node(importer,importer->refs[r],NODE_FLOOR_NUMBER_NONE);
+		if(node == NULL){
+			importer->stats.n_missing_nodes++;
+			previous = IMPORT_INDEX_NONE;
+			continue;
+		}
+		link_import_map_node(importer,&previous,get_import_map_node(importer,node,floor_number,indoor),edge_type);
+	}
+}
+
+static void XMLCALL end_osm_element(void * user_data,const XML_Char * name){
+	map_importer_t * importer = (map_importer_t*) user_data;
+
+	if(importer->element == OSM_ELEMENT_NODE && strcmp(name,"node") == 0){
+		//OSM ids are the keys, the floor comes from the ways
+		import_node_t * node = add_import_node(importer,importer->element_id,NODE_FLOOR_NUMBER_NONE,importer->element_cord);
+		node->coordinate = importer->element_cord;
+		if(importer->tags.name[0] != '\0') node->name_id = intern_string(importer->names,importer->tags.name);
+		importer->element = OSM_ELEMENT_NONE;
+	}else if(importer->element == OSM_ELEMENT_WAY && strcmp(name,"way") == 0){
+		add_osm_way(importer);
+		importer->element = OSM_ELEMENT_NONE;
+	}else if(importer->element == OSM_ELEMENT_RELATION && strcmp(name,"relation") == 0){
+		importer->element = OSM_ELEMENT_NONE;
+	}
+}
+
+bool import_osm_xml_map(map_t * map,const char * path,map_import_stats_t * stats){
+	if(map == NULL || path == NULL) return false;
+
+	FILE * file = fopen(path,"rb");
+	if(file == NULL) return false;
+
+	XML_Parser parser = XML_ParserCreate(NULL);
+	map_importer_t importer;
+	init_map_importer(&importer,map);
+	XML_SetUserData(parser,&importer);
+	XML_SetElementHandler(parser,start_osm_element,end_osm_element);
+
+	bool well_formed = true;
+	bool done = false;
+	while(!done && well_formed){
+		void * buffer = XML_GetBuffer(parser,MAP_IMPORT_CHUNK_SIZE);
+		size_t n_read = fread(buffer,1,MAP_IMPORT_CHUNK_SIZE,file);
+		done = n_read < MAP_IMPORT_CHUNK_SIZE;
+		well_formed = XML_ParseBuffer(parser,(int) n_read,done) != XML_STATUS_ERROR;
+	}
+	XML_ParserFree(parser);
+	fclose(file);
+
+	finish_map_import(&importer);
+	if(stats != NULL) *stats = importer.stats;
+	delete_map_importer_buffers(&importer);
+	return well_formed;
+}
+
+//---------------------------------------------------------- GEOJSON ----------------------------------------------------------------
+
+/*
+ * Reads a JSON file MAP_IMPORT_CHUNK_SIZE bytes at a time. The last string, number or literal read is in text.
+ * Any syntax error sets failed and makes every read after it fail too.
+ */
+typedef struct Json_Reader{
+	FILE * file;
+	char buffer[MAP_IMPORT_CHUNK_SIZE];
+	size_t position;
+	size_t size;
+	bool failed;
+
+	char * text;
+	size_t text_length;
+	size_t text_capacity;
+} json_reader_t;
+
+//The next byte without taking it, EOF at the end of the file.
+static inline int peek_json_byte(json_reader_t * reader){
+	if(reader->position == reader->size){
+		reader->size = fread(reader->buffer,1,MAP_IMPORT_CHUNK_SIZE,reader->file);
+		reader->position = 0;
+		if(reader->size == 0) return EOF;
+	}
+	return (uint8_t) reader->buffer[reader->position];
+}
+
+static inline int skip_json_space(json_reader_t * reader){
+	int c = peek_json_byte(reader);
+	while(c == ' ' || c == '\n' || c == '\r' || c == '\t'){
+		reader->position++;
+		c = peek_json_byte(reader);
+	}
+	return c;
+}
+
+static bool expect_json_byte(json_reader_t * reader,char expected){
+	if(reader->failed || skip_json_space(reader) != expected){
+		reader->failed = true;
+		return false;
+	}
+	reader->position++;
+	return true;
+}
+
+static inline void add_json_text_byte(json_reader_t * reader,char c){
+	if(reader->text_length+1 >= reader->text_capacity){
+		reader->text_capacity *= 2;
+		reader->text = (char*) realloc(reader->text,reader->text_capacity);
+	}
+	reader->text[reader->text_length] = c;
+	reader->text_length++;
+}
+
+//Four hex digits of a \u escape, -1 if they are not hex digits.
+static int read_json_hex(json_reader_t * reader){
+	int value = 0;
+	for(size_t i = 0;i < 4;i++){
+		int c = peek_json_byte(reader);
+		int digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+		if(digit < 0) return -1;
+		reader->position++;
+		value = value*16 + digit;
+	}
+	return value;
+}
+
+//Read a string into text without its quotes, escapes decoded and \u escapes written as UTF-8.
+static bool read_json_string(json_reader_t * reader){
+	if(!expect_json_byte(reader,'"')) return false;
+
+	reader->text_length = 0;
+	while(true){
+		int c = peek_json_byte(reader);
+		if(c == EOF) break;
+		reader->position++;
+		if(c == '"'){
+			reader->text[reader->text_length] = '\0';
+			return true;
+		}
+		if(c != '\\'){
+			add_json_text_byte(reader,(char) c);
+			continue;
+		}
+
+		c = peek_json_byte(reader);
+		if(c == EOF) break;
+		reader->position++;
+		switch(c){
+			case 'n': add_json_text_byte(reader,'\n'); break;
+			case 't': add_json_text_byte(reader,'\t'); break;
+			case 'r': add_json_text_byte(reader,'\r'); break;
+			case 'b': add_json_text_byte(reader,'\b'); break;
+			case 'f': add_json_text_byte(reader,'\f'); break;
+			case 'u':{
+				int code_point = read_json_hex(reader);
+				if(code_point < 0){
+					reader->failed = true;
+					return false;
+				}
+				//a surrogate pair makes one code point above the basic plane
+				if(code_point >= 0xD800 && code_point < 0xDC00 && peek_json_byte(reader) == '\\'){
+					reader->position++;
+					if(peek_json_byte(reader) != 'u'){
+						reader->failed = true;
+						return false;
+					}
+					reader->position++;
+					int low = read_json_hex(reader);
+					if(low < 0xDC00 || low > 0xDFFF){
+						reader->failed = true;
+						return false;
+					}
+					code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+				}
+				if(code_point < 0x80){
+					add_json_text_byte(reader,(char) code_point);
+				}else if(code_point < 0x800){
+					add_json_text_byte(reader,(char) (0xC0 | (code_point >> 6)));
+					add_json_text_byte(reader,(char) (0x80 | (code_point & 0x3F)));
+				}else if(code_point < 0x10000){
+					add_json_text_byte(reader,(char) (0xE0 | (code_point >> 12)));
+					add_json_text_byte(reader,(char) (0x80 | ((code_point >> 6) & 0x3F)));
+					add_json_text_byte(reader,(char) (0x80 | (code_point & 0x3F)));
+				}else{
+					add_json_text_byte(reader,(char) (0xF0 | (code_point >> 18)));
+					add_json_text_byte(reader,(char) (0x80 | ((code_point >> 12) & 0x3F)));
+					add_json_text_byte(reader,(char) (0x80 | ((code_point >> 6) & 0x3F)));
+					add_json_text_byte(reader,(char) (0x80 | (code_point & 0x3F)));
+				}
+				break;
+			}
+			default: add_json_text_byte(reader,(char) c); break;
+		}
+	}
+	reader->failed = true;
+	return false;
+}
+
+//Read a number or a true, false or null literal into text as it is written.
+static bool read_json_scalar(json_reader_t * reader){
+	if(reader->failed) return false;
+
+	skip_json_space(reader);
+	reader->text_length = 0;
+	while(true){
+		int c = peek_json_byte(reader);
+		bool number_byte = (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+		bool literal_byte = c >= 'a' && c <= 'z';
+		if(!number_byte && !literal_byte) break;
+		add_json_text_byte(reader,(char) c);
+		reader->position++;
+	}
+	reader->text[reader->text_length] = '\0';
+	if(reader->text_length == 0) reader->failed = true;
+	return !reader->failed;
+}
+
+static bool read_json_number(json_reader_t * reader,double * value){
+	if(!read_json_scalar(reader)) return false;
+	if(parse_import_number(reader->text,reader->text_length,value) != reader->text_length) reader->failed = true;
+	return !reader->failed;
+}
+
+/*
+ * Step to the next member of an object whose { was read: true with the key in text and the : read, false at the }.
+ * first is true until the first member is read.
+ */
+static bool next_json_member(json_reader_t * reader,bool * first){
+	if(reader->failed) return false;
+
+	int c = skip_json_space(reader);
+	if(c == '}'){
+		reader->position++;
+		return false;
+	}
+	if(!*first && !expect_json_byte(reader,',')) return false;
+	*first = false;
+	return read_json_string(reader) && expect_json_byte(reader,':');
+}
+
+//Step to the next element of an array whose [ was read: true before an element, false at the ].
+static bool next_json_element(json_reader_t * reader,bool * first){
+	if(reader->failed) return false;
+
+	int c = skip_json_space(reader);
+	if(c == ']'){
+		reader->position++;
+		return false;
+	}
+	if(!*first && !expect_json_byte(reader,',')) return false;
+	*first = false;
+	return true;
+}
+
+//Read past a value of any kind. Nesting is counted instead of recursed into, so any depth takes no stack.
+static bool skip_json_value(json_reader_t * reader){
+	size_t depth = 0;
+	do{
+		int c = skip_json_space(reader);
+		if(c == '"'){
+			if(!read_json_string(reader)) return false;
+		}else if(c == '{' || c == '['){
+			reader->position++;
+			depth++;
+		}else if(c == '}' || c == ']'){
+			if(depth == 0){
+				reader->failed = true;
+				return false;
+			}
+			reader->position++;
+			depth--;
+		}else if(c == ',' || c == ':'){
+			if(depth == 0){
+				reader->failed = true;
+				return false;
+			}
+			reader->position++;
+		}else if(!read_json_scalar(reader)){
+			return false;
+		}
+	}while(depth > 0);
+	return true;
+}
+
+/*
+ * Read the properties of a feature as tags. Values that are numbers or literals are taken as written, nested
+ * objects called tags (the way some converters write OSM tags) are read as more tags.
+ */
+static bool read_geojson_properties(map_importer_t * importer,json_reader_t * reader){
+	if(skip_json_space(reader) == 'n') return read_json_scalar(reader);
+	if(!expect_json_byte(reader,'{')) return false;
+
+	char key[64];
+	bool first = true;
+	while(next_json_member(reader,&first)){
+		strncpy(key,reader->text,sizeof(key)-1);
+		key[sizeof(key)-1] = '\0';
+
+		int c = skip_json_space(reader);
+		if(c == '"'){
+			if(read_json_string(reader)) apply_import_tag(&(importer->tags),key,reader->text);
+		}else if(c == '{' && strcmp(key,"tags") == 0){
+			read_geojson_properties(importer,reader);
+		}else if(c == '{' || c == '['){
+			skip_json_value(reader);
+		}else if(read_json_scalar(reader)){
+			apply_import_tag(&(importer->tags),key,reader->text);
+		}
+	}
+	return !reader->failed;
+}
+
+/*
+ * Read a coordinates array of any nesting into cords, returning how deep it is: 0 for a position, 1 for an array of
+ * positions and so on. Every array of positions becomes a part of the group of the array holding it.
+ */
+static int read_geojson_coordinates(map_importer_t * importer,json_reader_t * reader,uint32_t parent_group,uint32_t * n_groups,int depth){
+	if(depth > MAX_GEOJSON_COORDINATE_DEPTH || !expect_json_byte(reader,'[')) return -1;
+
+	int c = skip_json_space(reader);
+	if(c == '-' || (c >= '0' && c <= '9')){
+		//a position, anything after the longitude and latitude like an altitude is skipped
+		double longitude = 0,latitude = 0;
+		if(!read_json_number(reader,&longitude) || !expect_json_byte(reader,',') || !read_json_number(reader,&latitude)) return -1;
+		while(skip_json_space(reader) == ','){
+			reader->position++;
+			double ignored;
+			if(!read_json_number(reader,&ignored)) return -1;
+		}
+		if(!expect_json_byte(reader,']')) return -1;
+		add_import_cord(importer,create_cord(longitude,latitude));
+		return 0;
+	}
+
+	uint32_t group = *n_groups;
+	(*n_groups)++;
+	size_t first_cord = importer->n_cords;
+	int level = 1;
+	bool first = true;
+	while(next_json_element(reader,&first)){
+		int child_level = read_geojson_coordinates(importer,reader,group,n_groups,depth+1);
+		if(child_level < 0) return -1;
+		level = child_level+1;
+	}
+	if(reader->failed) return -1;
+
+	if(level == 1){
+		if(importer->n_parts == importer->parts_capacity){
+			importer->parts_capacity *= 2;
+			importer->parts = (geojson_part_t*) realloc(importer->parts,sizeof(geojson_part_t)*importer->parts_capacity);
+		}
+		geojson_part_t * part = &(importer->parts[importer->n_parts]);
+		part->first_cord = first_cord;
+		part->n_cords = importer->n_cords - first_cord;
+		part->group = parent_group;
+		importer->n_parts++;
+	}
+	return level;
+}
+
+static bool read_geojson_geometry(map_importer_t * importer,json_reader_t * reader,uint8_t * geometry_type){
+	if(skip_json_space(reader) == 'n') return read_json_scalar(reader);
+	if(!expect_json_byte(reader,'{')) return false;
+
+	bool first = true;
+	while(next_json_member(reader,&first)){
+		if(strcmp(reader->text,"type") == 0){
+			if(!read_json_string(reader)) return false;
+			const char * type = reader->text;
+			*geometry_type = (strcmp(type,"Point") == 0) ? GEOJSON_GEOMETRY_POINT
+				: (strcmp(type,"LineString") == 0) ? GEOJSON_GEOMETRY_LINE_STRING
+				: (strcmp(type,"MultiLineString") == 0) ? GEOJSON_GEOMETRY_MULTI_LINE_STRING
+				: (strcmp(type,"Polygon") == 0) ? GEOJSON_GEOMETRY_POLYGON
+				: (strcmp(type,"MultiPolygon") == 0) ? GEOJSON_GEOMETRY_MULTI_POLYGON : GEOJSON_GEOMETRY_NONE;
+		}else if(strcmp(reader->text,"coordinates") == 0){
+			uint32_t n_groups = 0;
+			if(read_geojson_coordinates(importer,reader,UINT32_MAX,&n_groups,0) < 0) return false;
+		}else{
+			skip_json_value(reader);
+		}
+	}
+	return !reader->failed;
+}
+
+//The key of a GeoJSON position, the coordinate to 7 decimals like OSM stores them.
+static inline uint64_t get_geojson_key(cord_t cord){
+	uint32_t longitude = (uint32_t) (int32_t) llround(cord.longitude*1e7);
+	uint32_t latitude = (uint32_t) (int32_t) llround(cord.latitude*1e7);
+	return (uint64_t) longitude << 32 | latitude;
+}
+
+/*
+ * The map index of the node at a GeoJSON position. A node on a level is shared with the same level, or else with a
+ * node put there by a feature without a level. A new node on a level is also entered without a level as an alias,
+ * so features without a level reach it too, but other levels do not.
+ */
+static uint32_t get_geojson_map_node(map_importer_t * importer,cord_t cord,int8_t level,bool indoor){
+	uint64_t key = get_geojson_key(cord);
+	if(level != NODE_FLOOR_NUMBER_NONE && find_import_node(importer,key,level) == NULL){
+		import_node_t * unleveled = find_import_node(importer,key,NODE_FLOOR_NUMBER_NONE);
+		if(unleveled != NULL && !unleveled->alias) return get_import_map_node(importer,unleveled,level,indoor);
+	}
+
+	uint32_t index = get_import_map_node(importer,add_import_node(importer,key,level,cord),level,indoor);
+	if(level != NODE_FLOOR_NUMBER_NONE){
+		import_node_t * unleveled = add_import_node(importer,key,NODE_FLOOR_NUMBER_NONE,cord);
+		if(unleveled->map_index == IMPORT_INDEX_NONE){
+			unleveled->map_index = index;
+			unleveled->alias = true;
+		}
+	}
+	return index;
+}
+
+static void add_geojson_line(map_importer_t * importer,const geojson_part_t * part,uint8_t edge_type){
+	int8_t floor_number = importer->tags.has_level ? importer->tags.level : NODE_FLOOR_NUMBER_NONE;
+	bool indoor = importer->tags.has_level || is_indoor_edge_type(edge_type);
+	uint32_t previous = IMPORT_INDEX_NONE;
+	for(size_t i = 0;i < part->n_cords;i++){
+		link_import_map_node(importer,&previous,get_geojson_map_node(importer,importer->cords[part->first_cord + i],floor_number,indoor),edge_type);
+	}
+}
+
+//Turn the geometry and tags of a feature read into nodes, edges, buildings or mpos.
+static void add_geojson_feature(map_importer_t * importer,uint8_t geometry_type){
+	if(geometry_type == GEOJSON_GEOMETRY_POINT){
+		//a named point names the node there, now or when a line reaches it
+		if(importer->n_cords != 1 || importer->tags.name[0] == '\0'){
+			importer->stats.n_skipped++;
+			return;
+		}
+		int8_t floor_number = importer->tags.has_level ? importer->tags.level : NODE_FLOOR_NUMBER_NONE;
+		import_node_t * node = add_import_node(importer,get_geojson_key(importer->cords[0]),floor_number,importer->cords[0]);
+		node->name_id = intern_string(importer->names,importer->tags.name);
+		if(node->map_index != IMPORT_INDEX_NONE){
+			map_node_t * map_node = importer->map->all_nodes[node->map_index];
+			set_map_node_name(map_node,importer->tags.name);
+			set_map_node_selectable(map_node,true);
+			importer->map->node_flags[node->map_index] = compute_map_node_flags(map_node);
+		}
+		return;
+	}
+
+	uint8_t edge_type = 0;
+	uint8_t shape = classify_import_tags(&(importer->tags),&edge_type);
+	if(shape == IMPORT_SHAPE_NONE || geometry_type == GEOJSON_GEOMETRY_NONE){
+		importer->stats.n_skipped++;
+		return;
+	}
+
+	bool polygon = geometry_type == GEOJSON_GEOMETRY_POLYGON || geometry_type == GEOJSON_GEOMETRY_MULTI_POLYGON;
+	for(size_t p = 0;p < importer->n_parts;p++){
+		const geojson_part_t * part = &(importer->parts[p]);
+		//the rings of a polygon after its first are holes
+		if(polygon && p > 0 && importer->parts[p-1].group == part->group) continue;
+
+		if(shape == IMPORT_SHAPE_LINE){
+			add_geojson_line(importer,part,edge_type);
+		}else if(polygon || part->n_cords >= 4){
+			add_import_area(importer,importer->cords + part->first_cord,part->n_cords);
+		}else{
+			importer->stats.n_skipped++;
+		}
+	}
+}
+
+static bool read_geojson_feature(map_importer_t * importer,json_reader_t * reader){
+	if(!expect_json_byte(reader,'{')) return false;
+
+	importer->stats.n_elements++;
+	reset_import_tags(&(importer->tags));
+	importer->n_cords = 0;
+	importer->n_parts = 0;
+	uint8_t geometry_type = GEOJSON_GEOMETRY_NONE;
+
+	bool first = true;
+	while(next_json_member(reader,&first)){
+		if(strcmp(reader->text,"properties") == 0) read_geojson_properties(importer,reader);
+		else if(strcmp(reader->text,"geometry") == 0) read_geojson_geometry(importer,reader,&geometry_type);
+		else skip_json_value(reader);
+	}
+	if(reader->failed) return false;
+
+	add_geojson_feature(importer,geometry_type);
+	return true;
+}
+
+bool import_geojson_map(map_t * map,const char * path,map_import_stats_t * stats){
+	if(map == NULL || path == NULL) return false;
+
+	json_reader_t * reader = (json_reader_t*) malloc(sizeof(json_reader_t));
+	reader->file = fopen(path,"rb");
+	if(reader->file == NULL){
+		free(reader);
+		return false;
+	}
+	reader->position = 0;
+	reader->size = 0;
+	reader->failed = false;
+	reader->text_capacity = DEFAULT_IMPORT_BUFFER_CAPACITY;
+	reader->text = (char*) malloc(reader->text_capacity);
+	reader->text_length = 0;
+
+	map_importer_t importer;
+	init_map_importer(&importer,map);
+
+	//a FeatureCollection, the features are read one at a time as they come
+	bool first = true;
+	if(expect_json_byte(reader,'{')){
+		while(next_json_member(reader,&first)){
+			if(strcmp(reader->text,"features") != 0){
+				skip_json_value(reader);
+				continue;
+			}
+			if(!expect_json_byte(reader,'[')) break;
+			bool first_feature = true;
+			while(next_json_element(reader,&first_feature)){
+				if(!read_geojson_feature(&importer,reader)) break;
+			}
+		}
+	}
+	bool read = !reader->failed;
+
+	fclose(reader->file);
+	free(reader->text);
+	free(reader);
+
+	finish_map_import(&importer);
+	if(stats != NULL) *stats = importer.stats;
+	delete_map_importer_buffers(&importer);
+	return read;
+}
+
+//---------------------------------------------------------- EITHER ----------------------------------------------------------------
+
+uint8_t get_map_import_format(const char * path){
+	if(path == NULL) return N_MAP_IMPORT_FORMATS;
+
+	const char * extension = strrchr(path,'.');
+	if(extension == NULL) return N_MAP_IMPORT_FORMATS;
+	if(strcasecmp(extension,".osm") == 0 || strcasecmp(extension,".xml") == 0) return MAP_IMPORT_FORMAT_OSM_XML;
+	if(strcasecmp(extension,".geojson") == 0 || strcasecmp(extension,".json") == 0) return MAP_IMPORT_FORMAT_GEOJSON;
+	return N_MAP_IMPORT_FORMATS;
+}
+
+bool import_map_file(map_t * map,const char * path,map_import_stats_t * stats){
+	switch(get_map_import_format(path)){
+		case MAP_IMPORT_FORMAT_OSM_XML: return import_osm_xml_map(map,path,stats);
+		case MAP_IMPORT_FORMAT_GEOJSON: return import_geojson_map(map,path,stats);
+		default: return false;
+	}
+}
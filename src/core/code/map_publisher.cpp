@@ -0,0 +1,151 @@
+#include "map_publisher.h"
+
+map_publisher_t * create_map_publisher(map_t * map_ref){
+	if(map_ref == NULL) return NULL;
+
+	map_publisher_t * publisher = (map_publisher_t*) malloc(sizeof(map_publisher_t));
+
+	publisher->map = map_ref;
+	publisher->current = create_map_graph(map_ref);
+	publisher->global_epoch = 1;
+
+	for(size_t i = 0;i < MAX_MAP_READERS;i++){
+		publisher->reader_slots[i].epoch = MAP_READER_IDLE;
+		publisher->reader_slots[i].in_use = false;
+	}
+
+	pthread_mutex_init(&(publisher->editor_lock),NULL);
+
+	publisher->retired = NULL;
+	publisher->n_retired = 0;
+	publisher->retired_capacity = 0;
+
+	return publisher;
+}
+
+void delete_map_publisher(map_publisher_t * publisher){
+	if(publisher == NULL) return;
+
+	for(size_t i = 0;i < publisher->n_retired;i++){
+		release_map_graph(publisher->retired[i].graph);
+	}
+	free(publisher->retired);
+
+	release_map_graph(publisher->current);
+	pthread_mutex_destroy(&(publisher->editor_lock));
+	free(publisher);
+}
+
+size_t register_map_reader(map_publisher_t * publisher){
+	if(publisher == NULL) return MAX_MAP_READERS;
+
+	for(size_t i = 0;i < MAX_MAP_READERS;i++){
+		bool expected = false;
+		if(__atomic_compare_exchange_n(&(publisher->reader_slots[i].in_use),&expected,true,false,__ATOMIC_ACQ_REL,__ATOMIC_RELAXED)){
+			return i;
+		}
+	}
+
+	return MAX_MAP_READERS;
+}
+
+void unregister_map_reader(map_publisher_t * publisher,size_t reader){
+	if(publisher == NULL || reader >= MAX_MAP_READERS) return;
+
+	__atomic_store_n(&(publisher->reader_slots[reader].epoch),MAP_READER_IDLE,__ATOMIC_RELEASE);
+	__atomic_store_n(&(publisher->reader_slots[reader].in_use),false,__ATOMIC_RELEASE);
+}
+
+const map_graph_t * acquire_map_snapshot(map_publisher_t * publisher,size_t reader){
+	if(publisher == NULL || reader >= MAX_MAP_READERS) return NULL;
+
+	//announce the epoch before loading the pointer. Any snapshot retired at or after this
+	//epoch will not be released until this slot goes idle again.
+	uint64_t epoch = __atomic_load_n(&(publisher->global_epoch),__ATOMIC_SEQ_CST);
+	__atomic_store_n(&(publisher->reader_slots[reader].epoch),epoch,__ATOMIC_SEQ_CST);
+
+	return __atomic_load_n(&(publisher->current),__ATOMIC_SEQ_CST);
+}
+
+void release_map_snapshot(map_publisher_t * publisher,size_t reader){
+	if(publisher == NULL || reader >= MAX_MAP_READERS) return;
+
+	__atomic_store_n(&(publisher->reader_slots[reader].epoch),MAP_READER_IDLE,__ATOMIC_RELEASE);
+}
+
+map_t * begin_map_edit(map_publisher_t * publisher){
+	if(publisher == NULL) return NULL;
+
+	pthread_mutex_lock(&(publisher->editor_lock));
+	return publisher->map;
+}
+
+static void retire_map_graph(map_publisher_t * publisher,map_graph_t * graph,uint64_t retire_epoch){
+	if(publisher->retired == NULL){
+		publisher->retired_capacity = DEFAULT_RETIRED_GRAPHS_CAPACITY;
+		publisher->retired = (retired_map_graph_t*) malloc(sizeof(retired_map_graph_t)*publisher->retired_capacity);
+	}
+
+	if(publisher->n_retired == publisher->retired_capacity){
+		publisher->retired_capacity *= 2;
+		publisher->retired = (retired_map_graph_t*) realloc(publisher->retired,sizeof(retired_map_graph_t)*publisher->retired_capacity);
+	}
+
+	publisher->retired[publisher->n_retired].graph = graph;
+	publisher->retired[publisher->n_retired].retire_epoch = retire_epoch;
+	publisher->n_retired++;
+}
+
+/*
+ * dev-note: caller must hold the editor lock
+ */
+static size_t reclaim_map_snapshots_locked(map_publisher_t * publisher){
+	//the oldest epoch any active reader may have started in
+	uint64_t oldest_reader_epoch = UINT64_MAX;
+	for(size_t i = 0;i < MAX_MAP_READERS;i++){
+		uint64_t epoch = __atomic_load_n(&(publisher->reader_slots[i].epoch),__ATOMIC_SEQ_CST);
+		if(epoch != MAP_READER_IDLE && epoch < oldest_reader_epoch) oldest_reader_epoch = epoch;
+	}
+
+	//release every snapshot retired before the oldest reader started, keep the rest in order
+	size_t kept = 0;
+	for(size_t i = 0;i < publisher->n_retired;i++){
+		retired_map_graph_t retired = publisher->retired[i];
+
+		if(retired.retire_epoch < oldest_reader_epoch){
+			release_map_graph(retired.graph);
+		}else{
+			publisher->retired[kept] = retired;
+			kept++;
+		}
+	}
+	publisher->n_retired = kept;
+
+	return kept;
+}
+
+void end_map_edit(map_publisher_t * publisher){
+	if(publisher == NULL) return;
+
+	//only the edges changed by this edit are measured again
+	map_graph_t * new_graph = create_map_graph_from_previous(publisher->map,publisher->current);
+
+	//swap the pointer first, then close the epoch the old snapshot could be seen in
+	map_graph_t * old_graph = __atomic_exchange_n(&(publisher->current),new_graph,__ATOMIC_SEQ_CST);
+	uint64_t retire_epoch = __atomic_fetch_add(&(publisher->global_epoch),1,__ATOMIC_SEQ_CST);
+
+	retire_map_graph(publisher,old_graph,retire_epoch);
+	reclaim_map_snapshots_locked(publisher);
+
+	pthread_mutex_unlock(&(publisher->editor_lock));
+}
+
+size_t reclaim_map_snapshots(map_publisher_t * publisher){
+	if(publisher == NULL) return 0;
+
+	pthread_mutex_lock(&(publisher->editor_lock));
+	size_t n_left = reclaim_map_snapshots_locked(publisher);
+	pthread_mutex_unlock(&(publisher->editor_lock));
+
+	return n_left;
+}
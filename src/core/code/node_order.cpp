@@ -0,0 +1,140 @@
+#include "node_order.h"
+#include <string.h>
+#include <math.h>
+
+typedef struct Node_Order_Key{
+	uint64_t key;
+	uint32_t index;
+} node_order_key_t;
+
+static int compare_node_order_keys(const void * a,const void * b){
+	const node_order_key_t * key_a = (const node_order_key_t*) a;
+	const node_order_key_t * key_b = (const node_order_key_t*) b;
+	if(key_a->key != key_b->key) return (key_a->key > key_b->key) - (key_a->key < key_b->key);
+	return (key_a->index > key_b->index) - (key_a->index < key_b->index);
+}
+
+//Distance along a Hilbert curve filling a 2^HILBERT_ORDER_BITS square of a cell x, y.
+static uint64_t get_hilbert_index(uint32_t x,uint32_t y){
+	uint64_t d = 0;
+	for(uint32_t s = 1u << (HILBERT_ORDER_BITS-1);s > 0;s >>= 1){
+		uint32_t rx = (x & s) ? 1 : 0;
+		uint32_t ry = (y & s) ? 1 : 0;
+		d += (uint64_t) s*s*((3*rx) ^ ry);
+
+		//rotate the quadrant so the curve stays connected
+		if(ry == 0){
+			if(rx == 1){
+				x = s-1 - (x & (s-1));
+				y = s-1 - (y & (s-1));
+			}
+			uint32_t t = x;
+			x = y;
+			y = t;
+		}
+	}
+	return d;
+}
+
+static uint32_t * compute_hilbert_order(const map_t * map){
+	map_rect_t bounds = get_map_bounding_rect(map);
+	double width = bounds.top_right.longitude - bounds.bottom_left.longitude;
+	double height = bounds.top_right.latitude - bounds.bottom_left.latitude;
+	double side = fmax(width,height);
+	double cells = (double) ((1u << HILBERT_ORDER_BITS) - 1);
+
+	node_order_key_t * keys = (node_order_key_t*) malloc(sizeof(node_order_key_t)*(map->n_nodes+1));
+	for(size_t i = 0;i < map->n_nodes;i++){
+		cord_t cord = map->all_nodes[i]->coordinate;
+		uint32_t x = 0,y = 0;
+		if(side > 0){
+			x = (uint32_t) ((cord.longitude - bounds.bottom_left.longitude)/side*cells);
+			y = (uint32_t) ((cord.latitude - bounds.bottom_left.latitude)/side*cells);
+		}
+		keys[i].key = get_hilbert_index(x,y);
+		keys[i].index = i;
+	}
+	qsort(keys,map->n_nodes,sizeof(node_order_key_t),compare_node_order_keys);
+
+	uint32_t * order = (uint32_t*) malloc(sizeof(uint32_t)*(map->n_nodes+1));
+	for(size_t k = 0;k < map->n_nodes;k++) order[k] = keys[k].index;
+	free(keys);
+	return order;
+}
+
+static uint32_t * compute_bfs_order(const map_t * map){
+	for(size_t i = 0;i < map->n_nodes;i++) map->all_nodes[i]->index_temp = i;
+
+	uint32_t * order = (uint32_t*) malloc(sizeof(uint32_t)*(map->n_nodes+1));
+	uint8_t * visited = (uint8_t*) calloc(map->n_nodes+1,sizeof(uint8_t));
+
+	//order doubles as the queue, every node is placed once
+	size_t n_placed = 0;
+	for(size_t root = 0;root < map->n_nodes;root++){
+		if(visited[root]) continue;
+		visited[root] = 1;
+		order[n_placed] = root;
+		n_placed++;
+
+		for(size_t head = n_placed-1;head < n_placed;head++){
+			const map_node_t * node = map->all_nodes[order[head]];
+			for(size_t j = 0;j < node->n_outgoing_edges;j++){
+				const map_edge_t * edge = node->outgoing_edges[j];
+				size_t neighbour = (edge->a == node) ? edge->b->index_temp : edge->a->index_temp;
+				if(visited[neighbour]) continue;
+				visited[neighbour] = 1;
+				order[n_placed] = neighbour;
+				n_placed++;
+			}
+		}
+	}
+
+	free(visited);
+	return order;
+}
+
+uint32_t * compute_map_node_order(const map_t * map,uint8_t order){
+	if(map == NULL) return NULL;
+
+	switch(order){
+		case MAP_NODE_ORDER_HILBERT: return compute_hilbert_order(map);
+		case MAP_NODE_ORDER_BFS: return compute_bfs_order(map);
+		default: return NULL;
+	}
+}
+
+bool reorder_map_nodes(map_t * map,uint8_t order){
+	uint32_t * node_order = compute_map_node_order(map,order);
+	if(node_order == NULL) return false;
+
+	map_node_t ** nodes = (map_node_t**) malloc(sizeof(map_node_t*)*(map->n_nodes+1));
+	uint16_t * flags = (uint16_t*) malloc(sizeof(uint16_t)*(map->n_nodes+1));
+	for(size_t k = 0;k < map->n_nodes;k++){
+		nodes[k] = map->all_nodes[node_order[k]];
+		flags[k] = map->node_flags[node_order[k]];
+	}
+	memcpy(map->all_nodes,nodes,sizeof(map_node_t*)*map->n_nodes);
+	memcpy(map->node_flags,flags,sizeof(uint16_t)*map->n_nodes);
+	for(size_t k = 0;k < map->n_nodes;k++) map->all_nodes[k]->index_temp = k;
+	free(flags);
+	free(nodes);
+	free(node_order);
+
+	//edges by their lower then higher node, so the edges of a node are together and follow the nodes
+	node_order_key_t * keys = (node_order_key_t*) malloc(sizeof(node_order_key_t)*(map->n_edges+1));
+	for(size_t j = 0;j < map->n_edges;j++){
+		uint64_t a = map->all_edges[j]->a->index_temp;
+		uint64_t b = map->all_edges[j]->b->index_temp;
+		keys[j].key = (a < b) ? (a << 32 | b) : (b << 32 | a);
+		keys[j].index = j;
+	}
+	qsort(keys,map->n_edges,sizeof(node_order_key_t),compare_node_order_keys);
+
+	map_edge_t ** edges = (map_edge_t**) malloc(sizeof(map_edge_t*)*(map->n_edges+1));
+	for(size_t j = 0;j < map->n_edges;j++) edges[j] = map->all_edges[keys[j].index];
+	memcpy(map->all_edges,edges,sizeof(map_edge_t*)*map->n_edges);
+	free(edges);
+	free(keys);
+
+	return true;
+}
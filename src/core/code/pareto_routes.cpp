@@ -0,0 +1,367 @@
+#include "pareto_routes.h"
+#include "edge_weights.h"
+
+#define DEFAULT_PARETO_LABELS_CAPACITY 256
+
+//values closer than this count as equal, so routes that only differ by rounding do not all get a label
+#define PARETO_EQUAL_TOLERANCE 1e-3
+
+/*
+ * One route to a node, as the values of every criterion and the label it was reached from
+ */
+typedef struct Pareto_Label{
+	double values[N_ROUTE_CRITERIA];
+	uint32_t node;
+
+	//label of the node before, UINT32_MAX for the start
+	uint32_t parent;
+
+	//false once a better label took its place, it may still be the parent of living labels
+	bool alive;
+} pareto_label_t;
+
+typedef struct Pareto_Search{
+	const map_graph_t * graph;
+	const float * weights;
+	uint8_t criteria;
+	uint8_t primary;
+	uint32_t end;
+	size_t max_labels;
+
+	//every label ever made, labels are referred to by index since the array grows
+	pareto_label_t * labels;
+	size_t n_labels;
+	size_t labels_capacity;
+
+	//the living labels of node i are bag_labels[i*max_labels] up to bag_labels[i*max_labels + bag_sizes[i] - 1]
+	uint32_t * bag_labels;
+	uint32_t * bag_sizes;
+
+	//copy of the values of the labels at the end, every label is checked against them so they are kept together
+	double * end_values;
+	size_t n_end_values;
+
+	//labels waiting to be expanded, smallest primary criterion first
+	uint32_t * heap;
+	size_t heap_size;
+	size_t heap_capacity;
+
+	//one tree grown from the end per chosen criterion, lower_bounds[c][i] is the least criterion c can still grow by from node i
+	route_search_context_t * end_trees[N_ROUTE_CRITERIA];
+	const double * lower_bounds[N_ROUTE_CRITERIA];
+
+	bool truncated;
+} pareto_search_t;
+
+static double sum_pareto_values(const double * values){
+	double sum = 0;
+	for(size_t c = 0;c < N_ROUTE_CRITERIA;c++) sum += values[c];
+	return sum;
+}
+
+/*
+ * Is a expanded before b? Ordered by the primary criterion with its lower bound added so routes to the end are
+ * found early, then by the sum of all of them. Two labels at the same node keep the order of their values so a
+ * label is never expanded after one it dominates.
+ */
+static bool pareto_label_before(const pareto_search_t * search,uint32_t a,uint32_t b){
+	const pareto_label_t * label_a = &(search->labels[a]);
+	const pareto_label_t * label_b = &(search->labels[b]);
+	const double * lower_bounds = search->lower_bounds[search->primary];
+
+	double key_a = label_a->values[search->primary] + lower_bounds[label_a->node];
+	double key_b = label_b->values[search->primary] + lower_bounds[label_b->node];
+
+	if(key_a != key_b) return key_a < key_b;
+	return sum_pareto_values(label_a->values) < sum_pareto_values(label_b->values);
+}
+
+//Is a at least as good as b on every chosen criterion?
+static bool pareto_values_dominate(const double * a,const double * b,uint8_t criteria){
+	for(size_t c = 0;c < N_ROUTE_CRITERIA;c++){
+		if(((criteria >> c) & 1) && a[c] > b[c] + PARETO_EQUAL_TOLERANCE) return false;
+	}
+	return true;
+}
+
+static void pareto_heap_push(pareto_search_t * search,uint32_t label){
+	if(search->heap_size == search->heap_capacity){
+		search->heap_capacity *= 2;
+		search->heap = (uint32_t*) realloc(search->heap,sizeof(uint32_t)*search->heap_capacity);
+	}
+
+	size_t i = search->heap_size;
+	search->heap_size++;
+	while(i > 0){
+		size_t parent = (i-1)/2;
+		if(!pareto_label_before(search,label,search->heap[parent])) break;
+		search->heap[i] = search->heap[parent];
+		i = parent;
+	}
+	search->heap[i] = label;
+}
+
+static uint32_t pareto_heap_pop(pareto_search_t * search){
+	uint32_t top = search->heap[0];
+	search->heap_size--;
+	uint32_t last = search->heap[search->heap_size];
+
+	size_t i = 0;
+	while(true){
+		size_t child = 2*i + 1;
+		if(child >= search->heap_size) break;
+		if(child+1 < search->heap_size && pareto_label_before(search,search->heap[child+1],search->heap[child])) child++;
+		if(!pareto_label_before(search,search->heap[child],last)) break;
+		search->heap[i] = search->heap[child];
+		i = child;
+	}
+	search->heap[i] = last;
+
+	return top;
+}
+
+/*
+ * The value of every criterion along one edge, 0 for criteria that were not chosen
+ */
+static void get_edge_criteria_values(const map_graph_t * graph,const float * weights,uint8_t criteria,uint32_t edge_index,double * values){
+	const map_edge_t * edge_ref = &(graph->edges[edge_index]);
+	double length = graph->weights->lengths[edge_index];
+
+	uint16_t flags_a = graph->node_flags[graph->edge_nodes[2*edge_index]];
+	uint16_t flags_b = graph->node_flags[graph->edge_nodes[2*edge_index+1]];
+	bool interior = (flags_a & flags_b & NODE_FLAG_INTERIOR) != 0;
+
+	values[0] = weights[edge_index];
+	values[1] = (edge_ref->type == EDGE_TYPE_DOOR) ? 1.0 : 0.0;
+	values[2] = interior ? 0.0 : length;
+	values[3] = (edge_ref->type == EDGE_TYPE_STAIRS) ? length : 0.0;
+
+	for(size_t c = 0;c < N_ROUTE_CRITERIA;c++){
+		if(!((criteria >> c) & 1)) values[c] = 0.0;
+	}
+}
+
+/*
+ * Is a route with these values at node beaten by a route already found to the end, even at its best?
+ */
+static bool pareto_values_beaten_at_end(const pareto_search_t * search,uint32_t node,const double * values){
+	double best_case[N_ROUTE_CRITERIA];
+	for(size_t c = 0;c < N_ROUTE_CRITERIA;c++) best_case[c] = values[c] + search->lower_bounds[c][node];
+
+	for(size_t i = 0;i < search->n_end_values;i++){
+		if(pareto_values_dominate(&(search->end_values[i*N_ROUTE_CRITERIA]),best_case,search->criteria)) return true;
+	}
+	return false;
+}
+
+static void copy_pareto_end_values(pareto_search_t * search){
+	const uint32_t * end_bag = &(search->bag_labels[search->end*search->max_labels]);
+	search->n_end_values = search->bag_sizes[search->end];
+	for(size_t i = 0;i < search->n_end_values;i++){
+		for(size_t c = 0;c < N_ROUTE_CRITERIA;c++) search->end_values[i*N_ROUTE_CRITERIA + c] = search->labels[end_bag[i]].values[c];
+	}
+}
+
+/*
+ * Add a label to a node unless a label there dominates it, dropping the labels there it dominates
+ */
+static void add_pareto_label(pareto_search_t * search,uint32_t node,const double * values,uint32_t parent){
+	if(pareto_values_beaten_at_end(search,node,values)) return;
+
+	uint32_t * bag = &(search->bag_labels[node*search->max_labels]);
+	for(size_t i = 0;i < search->bag_sizes[node];i++){
+		if(pareto_values_dominate(search->labels[bag[i]].values,values,search->criteria)) return;
+	}
+
+	size_t kept = 0;
+	for(size_t i = 0;i < search->bag_sizes[node];i++){
+		if(pareto_values_dominate(values,search->labels[bag[i]].values,search->criteria)){
+			search->labels[bag[i]].alive = false;
+		}else{
+			bag[kept] = bag[i];
+			kept++;
+		}
+	}
+	search->bag_sizes[node] = kept;
+
+	if(search->labels_capacity == search->n_labels){
+		search->labels_capacity *= 2;
+		search->labels = (pareto_label_t*) realloc(search->labels,sizeof(pareto_label_t)*search->labels_capacity);
+	}
+	uint32_t label = search->n_labels;
+	search->n_labels++;
+	pareto_label_t * label_ref = &(search->labels[label]);
+	for(size_t c = 0;c < N_ROUTE_CRITERIA;c++) label_ref->values[c] = values[c];
+	label_ref->node = node;
+	label_ref->parent = parent;
+	label_ref->alive = true;
+
+	//a full set gives up its worst label, if the new one is better than that
+	if(search->bag_sizes[node] == search->max_labels){
+		search->truncated = true;
+
+		size_t worst = 0;
+		for(size_t i = 1;i < search->bag_sizes[node];i++){
+			if(pareto_label_before(search,bag[worst],bag[i])) worst = i;
+		}
+		if(!pareto_label_before(search,label,bag[worst])){
+			label_ref->alive = false;
+			return;
+		}
+
+		search->labels[bag[worst]].alive = false;
+		bag[worst] = bag[search->bag_sizes[node]-1];
+		search->bag_sizes[node]--;
+	}
+
+	bag[search->bag_sizes[node]] = label;
+	search->bag_sizes[node]++;
+	if(node == search->end) copy_pareto_end_values(search);
+	pareto_heap_push(search,label);
+}
+
+static map_path_t * pareto_label_to_map_path(const pareto_search_t * search,uint32_t label){
+	size_t n_path_nodes = 0;
+	for(uint32_t at = label;at != UINT32_MAX;at = search->labels[at].parent) n_path_nodes++;
+
+	map_path_t * path = (map_path_t*) malloc(sizeof(map_path_t));
+	path->nodes = (map_node_t**) malloc(sizeof(map_node_t*)*n_path_nodes);
+	path->n_nodes = n_path_nodes;
+	path->name = NULL;
+
+	size_t i = n_path_nodes;
+	for(uint32_t at = label;at != UINT32_MAX;at = search->labels[at].parent){
+		i--;
+		path->nodes[i] = search->graph->source_nodes[search->labels[at].node];
+	}
+
+	return path;
+}
+
+pareto_routes_t * find_pareto_routes(const map_graph_t * graph,uint32_t start,uint32_t end,uint8_t profile,uint8_t criteria,size_t max_labels){
+	if(graph == NULL || profile >= N_ROUTE_PROFILES || max_labels == 0) return NULL;
+	if(start >= graph->n_nodes || end >= graph->n_nodes) return NULL;
+
+	criteria &= (1 << N_ROUTE_CRITERIA) - 1;
+	if(criteria == 0) return NULL;
+
+	const float * weights = graph->weights->profile_weights[profile];
+
+	//a tree from the end for every chosen criterion, over the edges the profile can use
+	pareto_search_t search;
+	double * no_bounds = (double*) calloc(graph->n_nodes,sizeof(double));
+	float * criterion_weights = (float*) malloc(sizeof(float)*(graph->n_edges+1));
+	route_search_context_t * reachable = NULL;
+	for(size_t c = 0;c < N_ROUTE_CRITERIA;c++){
+		search.end_trees[c] = NULL;
+		search.lower_bounds[c] = no_bounds;
+		if(!((criteria >> c) & 1)) continue;
+
+		for(uint32_t j = 0;j < graph->n_edges;j++){
+			double values[N_ROUTE_CRITERIA];
+			get_edge_criteria_values(graph,weights,criteria,j,values);
+			criterion_weights[j] = isinf(weights[j]) ? EDGE_COST_IMPASSABLE : (float) values[c];
+		}
+
+		search.end_trees[c] = create_route_search_context(graph->n_nodes);
+		grow_route_search_tree_with_weights(graph,search.end_trees[c],end,INFINITY,criterion_weights);
+		search.lower_bounds[c] = search.end_trees[c]->cost;
+		reachable = search.end_trees[c];
+	}
+	free(criterion_weights);
+
+	//every tree reaches the same nodes, those it never reaches can not lead to the end
+	if(!route_search_reached(reachable,start)){
+		for(size_t c = 0;c < N_ROUTE_CRITERIA;c++) delete_route_search_context(search.end_trees[c]);
+		free(no_bounds);
+		return NULL;
+	}
+
+	search.graph = graph;
+	search.weights = weights;
+	search.criteria = criteria;
+	search.primary = 0;
+	while(!((criteria >> search.primary) & 1)) search.primary++;
+	search.end = end;
+	search.max_labels = max_labels;
+	search.labels_capacity = DEFAULT_PARETO_LABELS_CAPACITY;
+	search.labels = (pareto_label_t*) malloc(sizeof(pareto_label_t)*search.labels_capacity);
+	search.n_labels = 0;
+	search.bag_labels = (uint32_t*) malloc(sizeof(uint32_t)*graph->n_nodes*max_labels);
+	search.bag_sizes = (uint32_t*) calloc(graph->n_nodes,sizeof(uint32_t));
+	search.heap_capacity = DEFAULT_PARETO_LABELS_CAPACITY;
+	search.heap = (uint32_t*) malloc(sizeof(uint32_t)*search.heap_capacity);
+	search.heap_size = 0;
+	search.end_values = (double*) malloc(sizeof(double)*N_ROUTE_CRITERIA*max_labels);
+	search.n_end_values = 0;
+	search.truncated = false;
+
+	double zero[N_ROUTE_CRITERIA] = {0};
+	add_pareto_label(&search,start,zero,UINT32_MAX);
+
+	while(search.heap_size > 0){
+		uint32_t label = pareto_heap_pop(&search);
+		if(!search.labels[label].alive) continue;
+
+		//routes go no further than the end, and routes found since this label was made may beat it
+		uint32_t node = search.labels[label].node;
+		if(node == end) continue;
+		if(pareto_values_beaten_at_end(&search,node,search.labels[label].values)) continue;
+
+		for(size_t i = graph->adjacency_offsets[node];i < graph->adjacency_offsets[node+1];i++){
+			uint32_t neighbour = graph->adjacency_nodes[i];
+			uint32_t edge_index = graph->adjacency_edges[i];
+			if(isinf(search.weights[edge_index]) || !route_search_reached(reachable,neighbour)) continue;
+
+			double values[N_ROUTE_CRITERIA];
+			get_edge_criteria_values(graph,search.weights,criteria,edge_index,values);
+			for(size_t c = 0;c < N_ROUTE_CRITERIA;c++) values[c] += search.labels[label].values[c];
+
+			add_pareto_label(&search,neighbour,values,label);
+		}
+	}
+
+	//the living labels at the end are the routes, in the order they would be expanded
+	uint32_t * end_bag = &(search.bag_labels[end*max_labels]);
+	size_t n_paths = search.bag_sizes[end];
+	for(size_t i = 1;i < n_paths;i++){
+		uint32_t label = end_bag[i];
+		size_t j = i;
+		while(j > 0 && pareto_label_before(&search,label,end_bag[j-1])){
+			end_bag[j] = end_bag[j-1];
+			j--;
+		}
+		end_bag[j] = label;
+	}
+
+	pareto_routes_t * routes = (pareto_routes_t*) malloc(sizeof(pareto_routes_t));
+	routes->criteria = criteria;
+	routes->n_paths = n_paths;
+	routes->paths = (map_path_t**) malloc(sizeof(map_path_t*)*(n_paths+1));
+	routes->values = (double*) malloc(sizeof(double)*N_ROUTE_CRITERIA*(n_paths+1));
+	routes->n_labels = search.n_labels;
+	routes->truncated = search.truncated;
+	for(size_t k = 0;k < n_paths;k++){
+		routes->paths[k] = pareto_label_to_map_path(&search,end_bag[k]);
+		for(size_t c = 0;c < N_ROUTE_CRITERIA;c++) routes->values[k*N_ROUTE_CRITERIA + c] = search.labels[end_bag[k]].values[c];
+	}
+
+	free(search.end_values);
+	free(search.heap);
+	free(search.bag_sizes);
+	free(search.bag_labels);
+	free(search.labels);
+	for(size_t c = 0;c < N_ROUTE_CRITERIA;c++) delete_route_search_context(search.end_trees[c]);
+	free(no_bounds);
+
+	return routes;
+}
+
+void delete_pareto_routes(pareto_routes_t * routes){
+	if(routes == NULL) return;
+
+	for(size_t k = 0;k < routes->n_paths;k++) delete_map_path(routes->paths[k]);
+	free(routes->paths);
+	free(routes->values);
+	free(routes);
+}
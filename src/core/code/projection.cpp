@@ -0,0 +1,110 @@
+#include "projection.h"
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+/*
+ * Scratch arrays for one block of edges, gathered from the node arrays so the math is a straight
+ * loop over plain arrays that measures four edges a register. dz is 0 for edges that do not climb.
+ */
+typedef struct Projection_Block{
+	float dx[PROJECTION_BLOCK_SIZE];
+	float dy[PROJECTION_BLOCK_SIZE];
+	float dz[PROJECTION_BLOCK_SIZE];
+} projection_block_t;
+
+map_projection_t * create_map_projection(const map_graph_t * graph){
+	if(graph == NULL) return NULL;
+
+	map_projection_t * projection = (map_projection_t*) malloc(sizeof(map_projection_t));
+	projection->n_nodes = graph->n_nodes;
+	projection->x = (float*) malloc(sizeof(float)*(graph->n_nodes+1));
+	projection->y = (float*) malloc(sizeof(float)*(graph->n_nodes+1));
+	projection->z = (float*) malloc(sizeof(float)*(graph->n_nodes+1));
+
+	//anchor at the middle of the bounding rect so no node is far from the origin
+	double min_lon = 0,max_lon = 0,min_lat = 0,max_lat = 0;
+	for(size_t i = 0;i < graph->n_nodes;i++){
+		cord_t cord = graph->hot_nodes[i].coordinate;
+		if(i == 0 || cord.longitude < min_lon) min_lon = cord.longitude;
+		if(i == 0 || cord.longitude > max_lon) max_lon = cord.longitude;
+		if(i == 0 || cord.latitude < min_lat) min_lat = cord.latitude;
+		if(i == 0 || cord.latitude > max_lat) max_lat = cord.latitude;
+	}
+	projection->origin = create_cord((min_lon + max_lon)/2.0,(min_lat + max_lat)/2.0);
+	projection->meters_per_degree_latitude = EARTH_RADIUS_METERS*(M_PI/180.0);
+	projection->meters_per_degree_longitude = projection->meters_per_degree_latitude*cos(projection->origin.latitude*(M_PI/180.0));
+
+	//east-west distances are stretched the most at the latitude farthest from the equator
+	double farthest = fmax(fabs(min_lat),fabs(max_lat));
+	if(farthest > PROJECTION_MAX_LATITUDE){
+		projection->lower_bound_scale = 0.0f;
+	}else{
+		double stretch = cos(farthest*(M_PI/180.0))/cos(projection->origin.latitude*(M_PI/180.0));
+		projection->lower_bound_scale = (float) (fmin(stretch,1.0)*PROJECTION_LOWER_BOUND_MARGIN);
+	}
+
+	for(size_t i = 0;i < graph->n_nodes;i++){
+		project_cord(projection,graph->hot_nodes[i].coordinate,&(projection->x[i]),&(projection->y[i]));
+
+		int8_t floor_number = graph->hot_nodes[i].floor_number;
+		projection->z[i] = (floor_number == NODE_FLOOR_NUMBER_NONE) ? 0.0f : (float)(floor_number*FLOOR_HEIGHT_METERS);
+	}
+
+	return projection;
+}
+
+void delete_map_projection(map_projection_t * projection){
+	if(projection == NULL) return;
+
+	free(projection->x);
+	free(projection->y);
+	free(projection->z);
+	free(projection);
+}
+
+void project_cord(const map_projection_t * projection,cord_t cord,float * x_out,float * y_out){
+	*x_out = (float) ((cord.longitude - projection->origin.longitude)*projection->meters_per_degree_longitude);
+	*y_out = (float) ((cord.latitude - projection->origin.latitude)*projection->meters_per_degree_latitude);
+}
+
+//Lengths of one gathered block. sqrtf sets errno on negative input, which keeps the compiler from vectorizing it.
+static void measure_projection_block(const projection_block_t * block,size_t n,float * lengths){
+	size_t k = 0;
+
+#ifdef __SSE__
+	for(;k+4 <= n;k += 4){
+		__m128 dx = _mm_loadu_ps(block->dx + k);
+		__m128 dy = _mm_loadu_ps(block->dy + k);
+		__m128 dz = _mm_loadu_ps(block->dz + k);
+		__m128 squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx,dx),_mm_mul_ps(dy,dy)),_mm_mul_ps(dz,dz));
+		_mm_storeu_ps(lengths + k,_mm_sqrt_ps(squared));
+	}
+#endif
+
+	for(;k < n;k++){
+		lengths[k] = sqrtf(block->dx[k]*block->dx[k] + block->dy[k]*block->dy[k] + block->dz[k]*block->dz[k]);
+	}
+}
+
+void compute_projected_edge_lengths(const map_projection_t * projection,const map_graph_t * graph,float * lengths){
+	if(projection == NULL || graph == NULL || lengths == NULL) return;
+
+	projection_block_t * block = (projection_block_t*) malloc(sizeof(projection_block_t));
+	for(size_t first = 0;first < graph->n_edges;first += PROJECTION_BLOCK_SIZE){
+		size_t n = graph->n_edges - first;
+		if(n > PROJECTION_BLOCK_SIZE) n = PROJECTION_BLOCK_SIZE;
+
+		for(size_t k = 0;k < n;k++){
+			uint32_t a = graph->edge_nodes[2*(first+k)];
+			uint32_t b = graph->edge_nodes[2*(first+k)+1];
+			block->dx[k] = projection->x[b] - projection->x[a];
+			block->dy[k] = projection->y[b] - projection->y[a];
+			//nodes without a floor are at height 0, an edge only climbs if both of its ends have floors
+			bool climbs = graph->hot_nodes[a].floor_number != NODE_FLOOR_NUMBER_NONE && graph->hot_nodes[b].floor_number != NODE_FLOOR_NUMBER_NONE;
+			block->dz[k] = climbs ? projection->z[b] - projection->z[a] : 0.0f;
+		}
+		measure_projection_block(block,n,&(lengths[first]));
+	}
+	free(block);
+}
@@ -0,0 +1,529 @@
+#include "raster_import.h"
+#include "node_order.h"
+#include <string.h>
+#include <math.h>
+#include <png.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//what a pixel of the padded skeleton is while it is traced, 0 is not walkable
+#define SKELETON_LINE 1//on a line, not traced yet
+#define SKELETON_NODE 2//a dead end or junction, or a pixel made a node to start a loop from
+#define SKELETON_TRACED 3//on a line already traced
+
+//neighbours of a pixel, see get_neighbour_offsets
+#define N_NEIGHBOURS 8
+
+typedef struct Raster_Point{
+	double x;
+	double y;
+} raster_point_t;
+
+//A traced line of the skeleton, from one node cluster to another through its pixels.
+typedef struct Raster_Chain{
+	uint32_t start_cluster;
+	uint32_t end_cluster;
+	raster_point_t * points;
+	size_t n_points;
+	bool pruned;
+} raster_chain_t;
+
+raster_import_options_t default_raster_import_options(map_rect_t bounds){
+	raster_import_options_t options;
+	options.bounds = bounds;
+	options.green_threshold = DEFAULT_RASTER_GREEN_THRESHOLD;
+	options.simplify_tolerance = DEFAULT_RASTER_SIMPLIFY_TOLERANCE;
+	options.min_spur_pixels = DEFAULT_RASTER_MIN_SPUR_PIXELS;
+	options.reorder_nodes = true;
+	return options;
+}
+
+static inline uint8_t is_walkable_pixel(const uint8_t * pixel,uint8_t green_threshold){
+	uint8_t red = pixel[0];
+	uint8_t green = pixel[1];
+	uint8_t blue = pixel[2];
+	uint8_t alpha = pixel[3];
+	return green > green_threshold && green > red && green > blue && alpha > 127;
+}
+
+uint8_t * classify_walkable_pixels(const uint8_t * rgba,uint32_t width,uint32_t height,uint8_t green_threshold,size_t * n_walkable){
+	size_t n_pixels = (size_t) width*height;
+	uint8_t * mask = (uint8_t*) malloc(n_pixels+1);
+	size_t i = 0;
+	size_t count = 0;
+
+#ifdef __SSE2__
+	//four pixels a register with every channel in its own 32 bit lane, so the compares need no unpacking.
+	//Channels are below 256 so the signed compares are exact.
+	const __m128i byte_mask = _mm_set1_epi32(0xFF);
+	const __m128i threshold = _mm_set1_epi32(green_threshold);
+	const __m128i half_alpha = _mm_set1_epi32(127);
+	const __m128i one = _mm_set1_epi8(1);
+	for(;i+16 <= n_pixels;i += 16){
+		__m128i walkable[4];
+		for(size_t k = 0;k < 4;k++){
+			__m128i pixels = _mm_loadu_si128((const __m128i*) (rgba + 4*(i+4*k)));
+			__m128i red = _mm_and_si128(pixels,byte_mask);
+			__m128i green = _mm_and_si128(_mm_srli_epi32(pixels,8),byte_mask);
+			__m128i blue = _mm_and_si128(_mm_srli_epi32(pixels,16),byte_mask);
+			__m128i alpha = _mm_srli_epi32(pixels,24);
+			__m128i result = _mm_cmpgt_epi32(green,threshold);
+			result = _mm_and_si128(result,_mm_cmpgt_epi32(green,red));
+			result = _mm_and_si128(result,_mm_cmpgt_epi32(green,blue));
+			walkable[k] = _mm_and_si128(result,_mm_cmpgt_epi32(alpha,half_alpha));
+		}
+
+		//all ones lanes pack down to 0xFF bytes, one byte a pixel in pixel order
+		__m128i packed = _mm_packs_epi16(_mm_packs_epi32(walkable[0],walkable[1]),_mm_packs_epi32(walkable[2],walkable[3]));
+		__m128i bytes = _mm_and_si128(packed,one);
+		_mm_storeu_si128((__m128i*) (mask+i),bytes);
+		count += __builtin_popcount(_mm_movemask_epi8(packed));
+	}
+#endif
+
+	for(;i < n_pixels;i++){
+		mask[i] = is_walkable_pixel(rgba + 4*i,green_threshold);
+		count += mask[i];
+	}
+
+	if(n_walkable != NULL) *n_walkable = count;
+	return mask;
+}
+
+//A copy of a mask with a border of 0 pixels all around, so every pixel of the image has 8 neighbours to look at.
+static uint8_t * pad_mask(const uint8_t * mask,uint32_t width,uint32_t height){
+	size_t padded_width = (size_t) width+2;
+	uint8_t * padded = (uint8_t*) calloc(padded_width*(height+2),sizeof(uint8_t));
+	for(uint32_t y = 0;y < height;y++) memcpy(padded + (y+1)*padded_width + 1,mask + (size_t) y*width,width);
+	return padded;
+}
+
+//Offsets of the neighbours of a padded pixel clockwise from north: N, NE, E, SE, S, SW, W, NW.
+static void get_neighbour_offsets(size_t padded_width,ptrdiff_t offsets[N_NEIGHBOURS]){
+	ptrdiff_t row = (ptrdiff_t) padded_width;
+	offsets[0] = -row;
+	offsets[1] = -row+1;
+	offsets[2] = 1;
+	offsets[3] = row+1;
+	offsets[4] = row;
+	offsets[5] = row-1;
+	offsets[6] = -1;
+	offsets[7] = -row-1;
+}
+
+//Bit i of the result is set if neighbour i (see get_neighbour_offsets) is set.
+static inline uint8_t get_neighbour_bits(const uint8_t * padded,size_t index,const ptrdiff_t offsets[N_NEIGHBOURS]){
+	uint8_t bits = 0;
+	for(size_t k = 0;k < N_NEIGHBOURS;k++) bits |= (padded[index+offsets[k]] != 0) << k;
+	return bits;
+}
+
+//Number of separate runs of set neighbours around a pixel: 1 at a dead end, 2 along a line, 3 or more at a junction.
+static inline uint8_t count_neighbour_runs(uint8_t bits){
+	uint8_t rotated = (uint8_t) ((bits >> 1) | (bits << 7));
+	return __builtin_popcount((uint8_t) (~bits & rotated));
+}
+
+//Zhang-Suen thinning of a padded mask, only visiting the pixels still set.
+static size_t thin_padded_mask(uint8_t * padded,uint32_t width,uint32_t height){
+	size_t padded_width = (size_t) width+2;
+	ptrdiff_t offsets[N_NEIGHBOURS];
+	get_neighbour_offsets(padded_width,offsets);
+
+	size_t n_set = 0;
+	size_t set_capacity = 64;
+	size_t * set = (size_t*) malloc(sizeof(size_t)*set_capacity);
+	for(uint32_t y = 1;y <= height;y++){
+		for(uint32_t x = 1;x <= width;x++){
+			size_t index = y*padded_width + x;
+			if(padded[index] == 0) continue;
+			if(n_set == set_capacity){
+				set_capacity *= 2;
+				set = (size_t*) realloc(set,sizeof(size_t)*set_capacity);
+			}
+			set[n_set] = index;
+			n_set++;
+		}
+	}
+
+	size_t * removed = (size_t*) malloc(sizeof(size_t)*(n_set+1));
+	bool changed = true;
+	while(changed){
+		changed = false;
+		for(uint8_t pass = 0;pass < 2;pass++){
+			size_t n_removed = 0;
+			for(size_t i = 0;i < n_set;i++){
+				uint8_t bits = get_neighbour_bits(padded,set[i],offsets);
+				int n_neighbours = __builtin_popcount(bits);
+				if(n_neighbours < 2 || n_neighbours > 6 || count_neighbour_runs(bits) != 1) continue;
+
+				bool north = bits & 0x01;
+				bool east = bits & 0x04;
+				bool south = bits & 0x10;
+				bool west = bits & 0x40;
+				//the first pass takes pixels off south east edges and north west corners, the second the opposite
+				bool removable = (pass == 0) ? (!(north && east && south) && !(east && south && west)) : (!(north && east && west) && !(north && south && west));
+				if(!removable) continue;
+				removed[n_removed] = set[i];
+				n_removed++;
+			}
+			if(n_removed == 0) continue;
+
+			changed = true;
+			for(size_t i = 0;i < n_removed;i++) padded[removed[i]] = 0;
+			size_t n_kept = 0;
+			for(size_t i = 0;i < n_set;i++){
+				if(padded[set[i]] == 0) continue;
+				set[n_kept] = set[i];
+				n_kept++;
+			}
+			n_set = n_kept;
+		}
+	}
+
+	free(removed);
+	free(set);
+	return n_set;
+}
+
+size_t skeletonize_walkable_mask(uint8_t * mask,uint32_t width,uint32_t height){
+	if(mask == NULL) return 0;
+
+	uint8_t * padded = pad_mask(mask,width,height);
+	size_t n_left = thin_padded_mask(padded,width,height);
+	size_t padded_width = (size_t) width+2;
+	for(uint32_t y = 0;y < height;y++) memcpy(mask + (size_t) y*width,padded + (y+1)*padded_width + 1,width);
+	free(padded);
+	return n_left;
+}
+
+//Distance of a point from the segment between two others, or from the point when both are the same.
+static double get_segment_distance(raster_point_t point,raster_point_t a,raster_point_t b){
+	double dx = b.x - a.x;
+	double dy = b.y - a.y;
+	double length_squared = dx*dx + dy*dy;
+	double t = 0;
+	if(length_squared > 0) t = fmin(1.0,fmax(0.0,((point.x - a.x)*dx + (point.y - a.y)*dy)/length_squared));
+	return hypot(point.x - (a.x + t*dx),point.y - (a.y + t*dy));
+}
+
+//Douglas-Peucker: mark the points of a line between first and last that are needed to stay within tolerance.
+static void simplify_raster_chain(const raster_point_t * points,size_t first,size_t last,double tolerance,uint8_t * keep){
+	while(last > first+1){
+		size_t farthest = first;
+		double farthest_distance = 0;
+		for(size_t i = first+1;i < last;i++){
+			double distance = get_segment_distance(points[i],points[first],points[last]);
+			if(distance > farthest_distance){
+				farthest_distance = distance;
+				farthest = i;
+			}
+		}
+		if(farthest_distance <= tolerance) return;
+
+		keep[farthest] = 1;
+		simplify_raster_chain(points,first,farthest,tolerance,keep);
+		first = farthest;
+	}
+}
+
+static void add_raster_point(raster_chain_t * chain,size_t * capacity,raster_point_t point){
+	if(chain->n_points == *capacity){
+		*capacity *= 2;
+		chain->points = (raster_point_t*) realloc(chain->points,sizeof(raster_point_t)*(*capacity));
+	}
+	chain->points[chain->n_points] = point;
+	chain->n_points++;
+}
+
+static inline raster_point_t get_padded_point(size_t index,size_t padded_width){
+	raster_point_t point = {(double) (index % padded_width) - 1,(double) (index / padded_width) - 1};
+	return point;
+}
+
+/*
+ * Follow a line of the skeleton from a node pixel through the line pixel next to it until it reaches a node pixel,
+ * marking the pixels passed as traced. A step prefers a node sharing a side, then a line pixel sharing a side,
+ * then the same two diagonally, so a line running past a junction stops at it instead of cutting the corner.
+ * The cluster a line started from only counts as its end once the line has left it.
+ */
+static raster_chain_t trace_raster_chain(uint8_t * skeleton,const uint32_t * clusters,size_t padded_width,const ptrdiff_t offsets[N_NEIGHBOURS],size_t start,size_t next,const raster_point_t * cluster_centers){
+	raster_chain_t chain;
+	size_t capacity = 16;
+	chain.points = (raster_point_t*) malloc(sizeof(raster_point_t)*capacity);
+	chain.n_points = 0;
+	chain.start_cluster = clusters[start];
+	chain.pruned = false;
+	add_raster_point(&chain,&capacity,cluster_centers[chain.start_cluster]);
+
+	size_t current = next;
+	skeleton[current] = SKELETON_TRACED;
+	size_t n_steps = 1;
+	while(true){
+		add_raster_point(&chain,&capacity,get_padded_point(current,padded_width));
+
+		size_t found = 0;
+		bool found_node = false;
+		for(size_t pass = 0;pass < 4 && found == 0;pass++){
+			//pass 0 and 2 look for nodes, 1 and 3 for line pixels, the first two on the sides and the last two diagonally
+			bool look_for_node = (pass % 2) == 0;
+			for(size_t k = (pass < 2) ? 0 : 1;k < N_NEIGHBOURS;k += 2){
+				size_t neighbour = current + offsets[k];
+				if(look_for_node){
+					if(skeleton[neighbour] != SKELETON_NODE) continue;
+					if(clusters[neighbour] == chain.start_cluster && n_steps < 2) continue;
+				}else if(skeleton[neighbour] != SKELETON_LINE){
+					continue;
+				}
+				found = neighbour;
+				found_node = look_for_node;
+				break;
+			}
+		}
+
+		if(found_node){
+			chain.end_cluster = clusters[found];
+			break;
+		}
+		if(found == 0){
+			//ran into pixels traced before, end where the line stopped
+			chain.end_cluster = UINT32_MAX;
+			break;
+		}
+		skeleton[found] = SKELETON_TRACED;
+		current = found;
+		n_steps++;
+	}
+
+	if(chain.end_cluster != UINT32_MAX) add_raster_point(&chain,&capacity,cluster_centers[chain.end_cluster]);
+	return chain;
+}
+
+//Cord of a point in pixels, pixel centers spread evenly over the bounds with y growing south.
+static cord_t get_raster_point_cord(raster_point_t point,uint32_t width,uint32_t height,map_rect_t bounds){
+	double longitude_span = bounds.top_right.longitude - bounds.bottom_left.longitude;
+	double latitude_span = bounds.top_right.latitude - bounds.bottom_left.latitude;
+	return create_cord(bounds.bottom_left.longitude + (point.x + 0.5)/width*longitude_span,bounds.top_right.latitude - (point.y + 0.5)/height*latitude_span);
+}
+
+bool import_raster_pixels(map_t * map,const uint8_t * rgba,uint32_t width,uint32_t height,const raster_import_options_t * options,raster_import_stats_t * stats){
+	if(map == NULL || rgba == NULL || options == NULL || width == 0 || height == 0) return false;
+
+	raster_import_stats_t import_stats;
+	import_stats.width = width;
+	import_stats.height = height;
+	import_stats.n_nodes = 0;
+	import_stats.n_edges = 0;
+
+	uint8_t * mask = classify_walkable_pixels(rgba,width,height,options->green_threshold,&(import_stats.n_walkable_pixels));
+	uint8_t * skeleton = pad_mask(mask,width,height);
+	free(mask);
+	import_stats.n_skeleton_pixels = thin_padded_mask(skeleton,width,height);
+
+	size_t padded_width = (size_t) width+2;
+	size_t n_padded = padded_width*(height+2);
+	ptrdiff_t offsets[N_NEIGHBOURS];
+	get_neighbour_offsets(padded_width,offsets);
+
+	//dead ends and junctions are node pixels, touching node pixels are one cluster placed at their center
+	size_t n_node_pixels = 0;
+	for(size_t index = padded_width;index < n_padded-padded_width;index++){
+		if(skeleton[index] == 0) continue;
+		uint8_t n_runs = count_neighbour_runs(get_neighbour_bits(skeleton,index,offsets));
+		skeleton[index] = (n_runs == 2) ? SKELETON_LINE : SKELETON_NODE;
+		n_node_pixels += n_runs != 2;
+	}
+
+	uint32_t * clusters = (uint32_t*) malloc(sizeof(uint32_t)*n_padded);
+	size_t * stack = (size_t*) malloc(sizeof(size_t)*(import_stats.n_skeleton_pixels+1));
+	size_t cluster_capacity = n_node_pixels + 16;
+	raster_point_t * cluster_centers = (raster_point_t*) malloc(sizeof(raster_point_t)*cluster_capacity);
+	size_t n_clusters = 0;
+	for(size_t index = 0;index < n_padded;index++){
+		if(skeleton[index] != SKELETON_NODE) continue;
+		clusters[index] = UINT32_MAX;
+	}
+	for(size_t index = 0;index < n_padded;index++){
+		if(skeleton[index] != SKELETON_NODE || clusters[index] != UINT32_MAX) continue;
+
+		double sum_x = 0,sum_y = 0;
+		size_t n_pixels = 0;
+		size_t n_stacked = 1;
+		stack[0] = index;
+		clusters[index] = n_clusters;
+		while(n_stacked > 0){
+			n_stacked--;
+			size_t pixel = stack[n_stacked];
+			raster_point_t point = get_padded_point(pixel,padded_width);
+			sum_x += point.x;
+			sum_y += point.y;
+			n_pixels++;
+			for(size_t k = 0;k < N_NEIGHBOURS;k++){
+				size_t neighbour = pixel + offsets[k];
+				if(skeleton[neighbour] != SKELETON_NODE || clusters[neighbour] != UINT32_MAX) continue;
+				clusters[neighbour] = n_clusters;
+				stack[n_stacked] = neighbour;
+				n_stacked++;
+			}
+		}
+		cluster_centers[n_clusters].x = sum_x/n_pixels;
+		cluster_centers[n_clusters].y = sum_y/n_pixels;
+		n_clusters++;
+	}
+	free(stack);
+
+	//every line leaving a node pixel, then loops with no node on them started from a pixel made a node
+	size_t n_chains = 0;
+	size_t chain_capacity = 64;
+	raster_chain_t * chains = (raster_chain_t*) malloc(sizeof(raster_chain_t)*chain_capacity);
+	for(uint8_t round = 0;round < 2;round++){
+		for(size_t index = padded_width;index < n_padded-padded_width;index++){
+			if(round == 1 && skeleton[index] == SKELETON_LINE){
+				if(n_clusters == cluster_capacity){
+					cluster_capacity *= 2;
+					cluster_centers = (raster_point_t*) realloc(cluster_centers,sizeof(raster_point_t)*cluster_capacity);
+				}
+				skeleton[index] = SKELETON_NODE;
+				clusters[index] = n_clusters;
+				cluster_centers[n_clusters] = get_padded_point(index,padded_width);
+				n_clusters++;
+			}else if(skeleton[index] != SKELETON_NODE){
+				continue;
+			}
+
+			for(size_t k = 0;k < N_NEIGHBOURS;k++){
+				size_t neighbour = index + offsets[k];
+				if(skeleton[neighbour] != SKELETON_LINE) continue;
+				if(n_chains == chain_capacity){
+					chain_capacity *= 2;
+					chains = (raster_chain_t*) realloc(chains,sizeof(raster_chain_t)*chain_capacity);
+				}
+				chains[n_chains] = trace_raster_chain(skeleton,clusters,padded_width,offsets,index,neighbour,cluster_centers);
+				n_chains++;
+			}
+		}
+	}
+	free(skeleton);
+	free(clusters);
+
+	//short lines ending nowhere are stubs of thinning or specks of noise
+	uint32_t * cluster_degrees = (uint32_t*) calloc(n_clusters+1,sizeof(uint32_t));
+	for(size_t c = 0;c < n_chains;c++){
+		if(chains[c].end_cluster == UINT32_MAX) continue;
+		cluster_degrees[chains[c].start_cluster]++;
+		cluster_degrees[chains[c].end_cluster]++;
+	}
+	for(size_t c = 0;c < n_chains;c++){
+		raster_chain_t * chain = &(chains[c]);
+		if(chain->end_cluster == UINT32_MAX || chain->n_points >= options->min_spur_pixels+2) continue;
+		if(cluster_degrees[chain->start_cluster] != 1 && cluster_degrees[chain->end_cluster] != 1) continue;
+		chain->pruned = true;
+	}
+
+	//the lines simplified, then nodes and edges all added in one go
+	uint8_t ** keeps = (uint8_t**) malloc(sizeof(uint8_t*)*(n_chains+1));
+	size_t n_new_nodes = 0;
+	size_t n_new_edges = 0;
+	for(size_t c = 0;c < n_chains;c++){
+		raster_chain_t * chain = &(chains[c]);
+		keeps[c] = NULL;
+		if(chain->pruned) continue;
+		if(chain->end_cluster == UINT32_MAX){
+			//nothing to end on, the last pixel becomes a node of its own
+			if(n_clusters == cluster_capacity){
+				cluster_capacity *= 2;
+				cluster_centers = (raster_point_t*) realloc(cluster_centers,sizeof(raster_point_t)*cluster_capacity);
+			}
+			cluster_centers[n_clusters] = chain->points[chain->n_points-1];
+			chain->end_cluster = n_clusters;
+			n_clusters++;
+		}
+
+		if(chain->start_cluster == chain->end_cluster && chain->n_points < 4){
+			//a loop too small to be anything but a speck
+			chain->pruned = true;
+			continue;
+		}
+
+		keeps[c] = (uint8_t*) calloc(chain->n_points,sizeof(uint8_t));
+		size_t last = chain->n_points-1;
+		if(chain->start_cluster == chain->end_cluster){
+			//a loop keeps two points besides its node so it does not fold into one edge walked twice
+			size_t third = last/3;
+			size_t two_thirds = 2*last/3;
+			keeps[c][third] = 1;
+			keeps[c][two_thirds] = 1;
+			simplify_raster_chain(chain->points,0,third,options->simplify_tolerance,keeps[c]);
+			simplify_raster_chain(chain->points,third,two_thirds,options->simplify_tolerance,keeps[c]);
+			simplify_raster_chain(chain->points,two_thirds,last,options->simplify_tolerance,keeps[c]);
+		}else{
+			simplify_raster_chain(chain->points,0,last,options->simplify_tolerance,keeps[c]);
+		}
+		size_t n_kept = 0;
+		for(size_t i = 1;i < last;i++) n_kept += keeps[c][i];
+		n_new_nodes += n_kept;
+		n_new_edges += n_kept+1;
+	}
+
+	uint32_t * cluster_nodes = (uint32_t*) malloc(sizeof(uint32_t)*(n_clusters+1));
+	for(size_t cluster = 0;cluster < n_clusters;cluster++) cluster_nodes[cluster] = UINT32_MAX;
+	reserve_map_capacity(map,n_new_nodes + n_clusters,n_new_edges);
+	size_t first_node = map->n_nodes;
+	size_t first_edge = map->n_edges;
+	for(size_t c = 0;c < n_chains;c++){
+		raster_chain_t * chain = &(chains[c]);
+		if(!chain->pruned){
+			uint32_t ends[2] = {chain->start_cluster,chain->end_cluster};
+			for(size_t e = 0;e < 2;e++){
+				if(cluster_nodes[ends[e]] != UINT32_MAX) continue;
+				cluster_nodes[ends[e]] = map->n_nodes;
+				add_node_to_map(map,create_map_node(get_raster_point_cord(cluster_centers[ends[e]],width,height,options->bounds)));
+			}
+
+			size_t previous = cluster_nodes[chain->start_cluster];
+			for(size_t i = 1;i+1 < chain->n_points;i++){
+				if(!keeps[c][i]) continue;
+				add_node_to_map(map,create_map_node(get_raster_point_cord(chain->points[i],width,height,options->bounds)));
+				connect_nodes_in_map_by_indices(map,previous,map->n_nodes-1,EDGE_TYPE_SIDEWALK);
+				previous = map->n_nodes-1;
+			}
+			connect_nodes_in_map_by_indices(map,previous,cluster_nodes[chain->end_cluster],EDGE_TYPE_SIDEWALK);
+		}
+		free(keeps[c]);
+		free(chain->points);
+	}
+	import_stats.n_nodes = map->n_nodes - first_node;
+	import_stats.n_edges = map->n_edges - first_edge;
+
+	free(cluster_nodes);
+	free(keeps);
+	free(cluster_degrees);
+	free(cluster_centers);
+	free(chains);
+
+	if(options->reorder_nodes) reorder_map_nodes(map,MAP_NODE_ORDER_HILBERT);
+	if(stats != NULL) *stats = import_stats;
+	return true;
+}
+
+bool import_raster_map(map_t * map,const char * png_path,const raster_import_options_t * options,raster_import_stats_t * stats){
+	if(map == NULL || png_path == NULL || options == NULL) return false;
+
+	png_image image;
+	memset(&image,0,sizeof(png_image));
+	image.version = PNG_IMAGE_VERSION;
+	if(!png_image_begin_read_from_file(&image,png_path)) return false;
+
+	image.format = PNG_FORMAT_RGBA;
+	uint8_t * rgba = (uint8_t*) malloc(PNG_IMAGE_SIZE(image));
+	if(!png_image_finish_read(&image,NULL,rgba,0,NULL)){
+		png_image_free(&image);
+		free(rgba);
+		return false;
+	}
+
+	bool imported = import_raster_pixels(map,rgba,image.width,image.height,options,stats);
+	free(rgba);
+	return imported;
+}
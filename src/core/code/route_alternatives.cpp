@@ -0,0 +1,296 @@
+#include "route_alternatives.h"
+#include "edge_weights.h"
+#include "search_filter.h"
+#include <string.h>
+
+/*
+ * A route as graph indices while the search is running, edges[i] joins nodes[i] and nodes[i+1]
+ */
+typedef struct Route_Candidate{
+	uint32_t * nodes;
+	uint32_t * edges;
+	size_t n_nodes;
+	double cost;
+
+	//index of the node this route left its parent at, spur searches start there
+	size_t deviation;
+} route_candidate_t;
+
+static uint32_t get_other_end_of_edge(const map_graph_t * graph,uint32_t edge_index,uint32_t node){
+	return get_map_graph_other_node(graph,edge_index,node);
+}
+
+static void delete_route_candidate(route_candidate_t * candidate){
+	free(candidate->nodes);
+	free(candidate->edges);
+}
+
+static bool route_candidates_equal(const route_candidate_t * a,const route_candidate_t * b){
+	if(a->n_nodes != b->n_nodes) return false;
+	return memcmp(a->nodes,b->nodes,sizeof(uint32_t)*a->n_nodes) == 0;
+}
+
+static void clear_allowed_edge(uint64_t * allowed_edges,uint32_t edge_index){
+	allowed_edges[edge_index >> 6] &= ~(((uint64_t) 1) << (edge_index & 63));
+}
+
+static void set_allowed_edge(uint64_t * allowed_edges,uint32_t edge_index){
+	allowed_edges[edge_index >> 6] |= ((uint64_t) 1) << (edge_index & 63);
+}
+
+/*
+ * Join the first n_root_nodes nodes of a route to a spur path given back to front, spur_nodes[0] is the end
+ */
+static route_candidate_t join_route_candidate(const route_candidate_t * root,size_t n_root_nodes,const uint32_t * spur_nodes,const uint32_t * spur_edges,size_t n_spur_nodes,double cost){
+	route_candidate_t candidate;
+	candidate.n_nodes = n_root_nodes + n_spur_nodes - 1;
+	candidate.nodes = (uint32_t*) malloc(sizeof(uint32_t)*candidate.n_nodes);
+	candidate.edges = (uint32_t*) malloc(sizeof(uint32_t)*candidate.n_nodes);
+	candidate.cost = cost;
+	candidate.deviation = n_root_nodes - 1;
+
+	memcpy(candidate.nodes,root->nodes,sizeof(uint32_t)*n_root_nodes);
+	memcpy(candidate.edges,root->edges,sizeof(uint32_t)*(n_root_nodes-1));
+	for(size_t i = 1;i < n_spur_nodes;i++){
+		candidate.nodes[n_root_nodes - 1 + i] = spur_nodes[n_spur_nodes - 1 - i];
+		candidate.edges[n_root_nodes - 2 + i] = spur_edges[n_spur_nodes - 1 - i];
+	}
+
+	return candidate;
+}
+
+/*
+ * Keep the candidates sorted by cost and at most max_candidates long, dropping duplicates of a kept route
+ */
+static void add_route_candidate(route_candidate_t * candidates,size_t * n_candidates,size_t max_candidates,route_candidate_t candidate){
+	for(size_t i = 0;i < *n_candidates;i++){
+		if(route_candidates_equal(&(candidates[i]),&candidate)){
+			delete_route_candidate(&candidate);
+			return;
+		}
+	}
+
+	size_t at = *n_candidates;
+	while(at > 0 && candidates[at-1].cost > candidate.cost) at--;
+	if(at >= max_candidates){
+		delete_route_candidate(&candidate);
+		return;
+	}
+
+	if(*n_candidates == max_candidates){
+		delete_route_candidate(&(candidates[max_candidates-1]));
+		(*n_candidates)--;
+	}
+	memmove(&(candidates[at+1]),&(candidates[at]),sizeof(route_candidate_t)*(*n_candidates - at));
+	candidates[at] = candidate;
+	(*n_candidates)++;
+}
+
+static map_path_t * route_candidate_to_map_path(const map_graph_t * graph,const route_candidate_t * candidate){
+	map_path_t * path = (map_path_t*) malloc(sizeof(map_path_t));
+	path->nodes = (map_node_t**) malloc(sizeof(map_node_t*)*candidate->n_nodes);
+	path->n_nodes = candidate->n_nodes;
+	path->name = NULL;
+
+	for(size_t i = 0;i < candidate->n_nodes;i++) path->nodes[i] = graph->source_nodes[candidate->nodes[i]];
+
+	return path;
+}
+
+route_alternatives_t * find_route_alternatives(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,uint8_t profile,size_t max_paths){
+	if(graph == NULL || context == NULL || max_paths == 0) return NULL;
+	if(start >= graph->n_nodes || end >= graph->n_nodes || profile >= N_ROUTE_PROFILES) return NULL;
+	if(context->n_nodes < graph->n_nodes) return NULL;
+
+	const float * weights = graph->weights->profile_weights[profile];
+
+	//costs are symmetric, so the tree grown from the end holds the cost from every node to the end
+	route_search_context_t * tree = create_route_search_context(graph->n_nodes);
+	grow_route_search_tree(graph,tree,end,NULL,0,INFINITY,profile);
+	if(!route_search_reached(tree,start)){
+		delete_route_search_context(tree);
+		return NULL;
+	}
+
+	size_t n_words = (graph->n_edges + 63)/64 + 1;
+	uint64_t * allowed_edges = (uint64_t*) malloc(sizeof(uint64_t)*n_words);
+	for(size_t i = 0;i < n_words;i++) allowed_edges[i] = UINT64_MAX;
+
+	//edges cleared for one spur node, set again once it is done
+	uint32_t * cleared_edges = (uint32_t*) malloc(sizeof(uint32_t)*(graph->n_edges+1));
+	size_t n_cleared = 0;
+
+	//scratch for a spur path, back to front
+	uint32_t * spur_nodes = (uint32_t*) malloc(sizeof(uint32_t)*(graph->n_nodes+1));
+	uint32_t * spur_edges = (uint32_t*) malloc(sizeof(uint32_t)*(graph->n_nodes+1));
+
+	route_candidate_t * found = (route_candidate_t*) malloc(sizeof(route_candidate_t)*max_paths);
+	size_t n_found = 0;
+	route_candidate_t * candidates = (route_candidate_t*) malloc(sizeof(route_candidate_t)*max_paths);
+	size_t n_candidates = 0;
+	size_t n_spur_searches = 0;
+
+	//the best route is the tree path from the start
+	size_t n_tree_nodes = 1;
+	spur_nodes[0] = start;
+	while(spur_nodes[n_tree_nodes-1] != end){
+		uint32_t edge_index = tree->previous_edge[spur_nodes[n_tree_nodes-1]];
+		spur_edges[n_tree_nodes-1] = edge_index;
+		spur_nodes[n_tree_nodes] = get_other_end_of_edge(graph,edge_index,spur_nodes[n_tree_nodes-1]);
+		n_tree_nodes++;
+	}
+	found[0].n_nodes = n_tree_nodes;
+	found[0].nodes = (uint32_t*) malloc(sizeof(uint32_t)*n_tree_nodes);
+	found[0].edges = (uint32_t*) malloc(sizeof(uint32_t)*n_tree_nodes);
+	memcpy(found[0].nodes,spur_nodes,sizeof(uint32_t)*n_tree_nodes);
+	memcpy(found[0].edges,spur_edges,sizeof(uint32_t)*(n_tree_nodes-1));
+	found[0].cost = tree->cost[start];
+	found[0].deviation = 0;
+	n_found = 1;
+
+	while(n_found < max_paths){
+		const route_candidate_t * last = &(found[n_found-1]);
+		size_t n_wanted = max_paths - n_found;
+
+		//the nodes before the spur node may not be used again, clear the edges of those before the deviation at once
+		double root_cost = 0;
+		for(size_t j = 0;j < last->deviation;j++){
+			uint32_t node = last->nodes[j];
+			for(size_t i = graph->adjacency_offsets[node];i < graph->adjacency_offsets[node+1];i++){
+				clear_allowed_edge(allowed_edges,graph->adjacency_edges[i]);
+			}
+			root_cost += weights[last->edges[j]];
+		}
+
+		for(size_t j = last->deviation;j+1 < last->n_nodes;j++){
+			uint32_t spur = last->nodes[j];
+
+			//leave every route with the same root a different way than it did
+			n_cleared = 0;
+			for(size_t k = 0;k < n_found;k++){
+				const route_candidate_t * other = &(found[k]);
+				if(other->n_nodes <= j+1 || memcmp(other->nodes,last->nodes,sizeof(uint32_t)*(j+1)) != 0) continue;
+
+				uint32_t next = other->nodes[j+1];
+				for(size_t i = graph->adjacency_offsets[spur];i < graph->adjacency_offsets[spur+1];i++){
+					if(graph->adjacency_nodes[i] != next || !search_filter_allows(allowed_edges,graph->adjacency_edges[i])) continue;
+					clear_allowed_edge(allowed_edges,graph->adjacency_edges[i]);
+					cleared_edges[n_cleared] = graph->adjacency_edges[i];
+					n_cleared++;
+				}
+			}
+
+			//no spur path can cost less than the unrestricted tree path
+			double limit = (n_candidates == n_wanted) ? candidates[n_wanted-1].cost : INFINITY;
+			if(route_search_reached(tree,spur) && root_cost + tree->cost[spur] < limit){
+				//the tree path is the best spur path whenever none of its edges are cleared
+				size_t n_spur_nodes = 1;
+				spur_nodes[0] = spur;
+				bool blocked = false;
+				while(spur_nodes[n_spur_nodes-1] != end){
+					uint32_t edge_index = tree->previous_edge[spur_nodes[n_spur_nodes-1]];
+					if(!search_filter_allows(allowed_edges,edge_index)){
+						blocked = true;
+						break;
+					}
+					spur_edges[n_spur_nodes-1] = edge_index;
+					spur_nodes[n_spur_nodes] = get_other_end_of_edge(graph,edge_index,spur_nodes[n_spur_nodes-1]);
+					n_spur_nodes++;
+				}
+
+				double spur_cost = tree->cost[spur];
+				bool spur_found = !blocked;
+				if(blocked){
+					n_spur_searches++;
+					spur_found = search_map_graph_with_allowed_edges(graph,context,spur,end,profile,allowed_edges,limit - root_cost,tree);
+					if(spur_found){
+						spur_cost = context->cost[end];
+
+						//walk the search tree back from the end, giving the spur path back to front
+						n_spur_nodes = 1;
+						spur_nodes[0] = end;
+						while(spur_nodes[n_spur_nodes-1] != spur){
+							uint32_t edge_index = context->previous_edge[spur_nodes[n_spur_nodes-1]];
+							spur_edges[n_spur_nodes-1] = edge_index;
+							spur_nodes[n_spur_nodes] = get_other_end_of_edge(graph,edge_index,spur_nodes[n_spur_nodes-1]);
+							n_spur_nodes++;
+						}
+					}
+				}else{
+					//the tree path was walked front to back, turn it around
+					for(size_t i = 0;i < n_spur_nodes/2;i++){
+						uint32_t node = spur_nodes[i];
+						spur_nodes[i] = spur_nodes[n_spur_nodes-1-i];
+						spur_nodes[n_spur_nodes-1-i] = node;
+					}
+					for(size_t i = 0;i < (n_spur_nodes-1)/2;i++){
+						uint32_t edge_index = spur_edges[i];
+						spur_edges[i] = spur_edges[n_spur_nodes-2-i];
+						spur_edges[n_spur_nodes-2-i] = edge_index;
+					}
+				}
+
+				if(spur_found && root_cost + spur_cost < limit){
+					route_candidate_t candidate = join_route_candidate(last,j+1,spur_nodes,spur_edges,n_spur_nodes,root_cost + spur_cost);
+
+					bool duplicate = false;
+					for(size_t k = 0;k < n_found && !duplicate;k++) duplicate = route_candidates_equal(&(found[k]),&candidate);
+					if(duplicate){
+						delete_route_candidate(&candidate);
+					}else{
+						add_route_candidate(candidates,&n_candidates,n_wanted,candidate);
+					}
+				}
+			}
+
+			for(size_t i = 0;i < n_cleared;i++) set_allowed_edge(allowed_edges,cleared_edges[i]);
+
+			//the spur node becomes part of the root for the next one
+			for(size_t i = graph->adjacency_offsets[spur];i < graph->adjacency_offsets[spur+1];i++){
+				clear_allowed_edge(allowed_edges,graph->adjacency_edges[i]);
+			}
+			root_cost += weights[last->edges[j]];
+		}
+
+		for(size_t i = 0;i < n_words;i++) allowed_edges[i] = UINT64_MAX;
+
+		if(n_candidates == 0) break;
+
+		//the cheapest candidate is the next route
+		found[n_found] = candidates[0];
+		n_found++;
+		n_candidates--;
+		memmove(&(candidates[0]),&(candidates[1]),sizeof(route_candidate_t)*n_candidates);
+	}
+
+	route_alternatives_t * alternatives = (route_alternatives_t*) malloc(sizeof(route_alternatives_t));
+	alternatives->n_paths = n_found;
+	alternatives->paths = (map_path_t**) malloc(sizeof(map_path_t*)*n_found);
+	alternatives->costs = (double*) malloc(sizeof(double)*n_found);
+	alternatives->n_spur_searches = n_spur_searches;
+	for(size_t k = 0;k < n_found;k++){
+		alternatives->paths[k] = route_candidate_to_map_path(graph,&(found[k]));
+		alternatives->costs[k] = found[k].cost;
+		delete_route_candidate(&(found[k]));
+	}
+	for(size_t k = 0;k < n_candidates;k++) delete_route_candidate(&(candidates[k]));
+
+	free(candidates);
+	free(found);
+	free(spur_edges);
+	free(spur_nodes);
+	free(cleared_edges);
+	free(allowed_edges);
+	delete_route_search_context(tree);
+
+	return alternatives;
+}
+
+void delete_route_alternatives(route_alternatives_t * alternatives){
+	if(alternatives == NULL) return;
+
+	for(size_t k = 0;k < alternatives->n_paths;k++) delete_map_path(alternatives->paths[k]);
+	free(alternatives->paths);
+	free(alternatives->costs);
+	free(alternatives);
+}
@@ -0,0 +1,72 @@
+#include "route_batch.h"
+
+typedef struct Route_Batch_Job{
+	const map_graph_t * graph;
+	const route_query_t * queries;
+	route_result_t * results;
+	bool want_paths;
+
+	//one search context per worker thread
+	route_search_context_t ** contexts;
+} route_batch_job_t;
+
+static void run_route_batch_query(size_t task_index,size_t worker_index,void * user_data){
+	route_batch_job_t * job = (route_batch_job_t*) user_data;
+	const route_query_t * query = &(job->queries[task_index]);
+	route_result_t * result = &(job->results[task_index]);
+
+	//contexts are made lazily so idle workers never allocate one
+	route_search_context_t * context = job->contexts[worker_index];
+	if(context == NULL){
+		context = create_route_search_context(job->graph->n_nodes);
+		job->contexts[worker_index] = context;
+	}
+
+	result->generation = 0;
+	result->query_index = task_index;
+	result->found = false;
+	result->cost = EDGE_COST_IMPASSABLE;
+	result->path = NULL;
+
+	bool found;
+	if(query->filter == SEARCH_FILTER_NONE){
+		found = search_map_graph_with_profile(job->graph,context,query->start,query->end,query->profile);
+	}else{
+		edge_cost_function_t edge_cost_function = get_route_profile_cost_function(query->profile);
+		found = edge_cost_function != NULL && search_map_graph_with_filter(job->graph,context,query->start,query->end,edge_cost_function,query->filter);
+	}
+
+	if(found){
+		result->found = true;
+		result->cost = context->cost[query->end];
+		if(job->want_paths) result->path = extract_route_path(job->graph,context,query->end);
+	}
+}
+
+route_result_t * run_route_batch(thread_pool_t * pool,const map_graph_t * graph,const route_query_t * queries,size_t n_queries,bool want_paths){
+	if(pool == NULL || graph == NULL || queries == NULL || n_queries == 0) return NULL;
+
+	route_batch_job_t job;
+	job.graph = graph;
+	job.queries = queries;
+	job.results = (route_result_t*) malloc(sizeof(route_result_t)*n_queries);
+	job.want_paths = want_paths;
+	job.contexts = (route_search_context_t**) malloc(sizeof(route_search_context_t*)*pool->n_workers);
+	for(size_t i = 0;i < pool->n_workers;i++) job.contexts[i] = NULL;
+
+	run_thread_pool_tasks(pool,n_queries,run_route_batch_query,&job);
+
+	for(size_t i = 0;i < pool->n_workers;i++) delete_route_search_context(job.contexts[i]);
+	free(job.contexts);
+
+	return job.results;
+}
+
+void delete_route_batch_results(route_result_t * results,size_t n_results){
+	if(results == NULL) return;
+
+	for(size_t i = 0;i < n_results;i++){
+		delete_map_path(results[i].path);
+	}
+	free(results);
+}
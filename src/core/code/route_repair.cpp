@@ -0,0 +1,292 @@
+#include "route_repair.h"
+#include "edge_weights.h"
+
+static double get_route_repair_edge_cost(const route_repair_t * repair,uint32_t edge_index){
+	if(repair->closures != NULL && map_graph_edge_closed(repair->closures,edge_index,repair->time)) return EDGE_COST_IMPASSABLE;
+
+	if(repair->costed_from_source != NULL && repair->costed_from_source[edge_index]){
+		double cost = repair->edge_cost_function(repair->graph->source_edges[edge_index]);
+
+		//rounded like the edge weights the rest of the edges are costed with
+		return repair->has_profile ? (double)(float) cost : cost;
+	}
+
+	if(repair->has_profile) return repair->graph->weights->profile_weights[repair->profile][edge_index];
+	return repair->edge_cost_function(&(repair->graph->edges[edge_index]));
+}
+
+static void swap_route_repair_heap_entries(route_repair_t * repair,size_t i,size_t j){
+	uint32_t node_i = repair->heap[i];
+	uint32_t node_j = repair->heap[j];
+	repair->heap[i] = node_j;
+	repair->heap[j] = node_i;
+	repair->heap_position[node_j] = i;
+	repair->heap_position[node_i] = j;
+}
+
+static void sift_route_repair_heap_up(route_repair_t * repair,size_t i){
+	while(i > 0){
+		size_t parent = (i-1)/2;
+		if(repair->key[repair->heap[parent]] <= repair->key[repair->heap[i]]) break;
+		swap_route_repair_heap_entries(repair,i,parent);
+		i = parent;
+	}
+}
+
+static void sift_route_repair_heap_down(route_repair_t * repair,size_t i){
+	while(true){
+		size_t smallest = i;
+		size_t left = 2*i + 1;
+		size_t right = left + 1;
+		if(left < repair->heap_size && repair->key[repair->heap[left]] < repair->key[repair->heap[smallest]]) smallest = left;
+		if(right < repair->heap_size && repair->key[repair->heap[right]] < repair->key[repair->heap[smallest]]) smallest = right;
+		if(smallest == i) break;
+
+		swap_route_repair_heap_entries(repair,i,smallest);
+		i = smallest;
+	}
+}
+
+//Put a node in the queue with a key, or move it if it is already there.
+static void set_route_repair_heap_key(route_repair_t * repair,uint32_t node,double key){
+	size_t i = repair->heap_position[node];
+	if(i == UINT32_MAX){
+		i = repair->heap_size;
+		repair->heap_size++;
+		repair->heap[i] = node;
+		repair->heap_position[node] = i;
+		repair->key[node] = key;
+		sift_route_repair_heap_up(repair,i);
+		return;
+	}
+
+	double old_key = repair->key[node];
+	repair->key[node] = key;
+	if(key < old_key){
+		sift_route_repair_heap_up(repair,i);
+	}else{
+		sift_route_repair_heap_down(repair,i);
+	}
+}
+
+static void remove_route_repair_heap_node(route_repair_t * repair,uint32_t node){
+	size_t i = repair->heap_position[node];
+	if(i == UINT32_MAX) return;
+
+	repair->heap_size--;
+	if(i != repair->heap_size){
+		swap_route_repair_heap_entries(repair,i,repair->heap_size);
+		sift_route_repair_heap_up(repair,i);
+		sift_route_repair_heap_down(repair,repair->heap_position[repair->heap[i]]);
+	}
+	repair->heap_position[node] = UINT32_MAX;
+}
+
+/*
+ * Work out rhs of a node again from its neighbours, and queue it if that leaves it inconsistent
+ */
+static void update_route_repair_node(route_repair_t * repair,uint32_t node){
+	const map_graph_t * graph = repair->graph;
+
+	if(node != repair->start){
+		double best = EDGE_COST_IMPASSABLE;
+		uint32_t best_edge = UINT32_MAX;
+		for(size_t i = graph->adjacency_offsets[node];i < graph->adjacency_offsets[node+1];i++){
+			uint32_t edge_index = graph->adjacency_edges[i];
+			double cost = repair->g[graph->adjacency_nodes[i]] + repair->edge_costs[edge_index];
+			if(cost < best){
+				best = cost;
+				best_edge = edge_index;
+			}
+		}
+		repair->rhs[node] = best;
+		repair->previous_edge[node] = best_edge;
+	}
+
+	if(repair->g[node] != repair->rhs[node]){
+		set_route_repair_heap_key(repair,node,fmin(repair->g[node],repair->rhs[node]));
+	}else{
+		remove_route_repair_heap_node(repair,node);
+	}
+}
+
+static void update_route_repair_neighbours(route_repair_t * repair,uint32_t node){
+	const map_graph_t * graph = repair->graph;
+	for(size_t i = graph->adjacency_offsets[node];i < graph->adjacency_offsets[node+1];i++){
+		update_route_repair_node(repair,graph->adjacency_nodes[i]);
+	}
+}
+
+route_repair_t * create_route_repair(map_graph_t * graph,const edge_closures_t * closures,int64_t time,uint32_t start,uint32_t end,edge_cost_function_t edge_cost_function){
+	if(graph == NULL || edge_cost_function == NULL) return NULL;
+	if(start >= graph->n_nodes || end >= graph->n_nodes) return NULL;
+	if(closures != NULL && closures->graph != graph) return NULL;
+
+	retain_map_graph(graph);
+
+	route_repair_t * repair = (route_repair_t*) malloc(sizeof(route_repair_t));
+	repair->graph = graph;
+	repair->edge_cost_function = edge_cost_function;
+	repair->has_profile = get_route_profile_of_cost_function(edge_cost_function,&(repair->profile));
+	repair->closures = closures;
+	repair->time = time;
+	repair->start = start;
+	repair->end = end;
+
+	repair->costed_from_source = NULL;
+	repair->edge_costs = (double*) malloc(sizeof(double)*(graph->n_edges+1));
+	for(uint32_t j = 0;j < graph->n_edges;j++) repair->edge_costs[j] = get_route_repair_edge_cost(repair,j);
+
+	size_t n_nodes = graph->n_nodes;
+	repair->g = (double*) malloc(sizeof(double)*n_nodes);
+	repair->rhs = (double*) malloc(sizeof(double)*n_nodes);
+	repair->previous_edge = (uint32_t*) malloc(sizeof(uint32_t)*n_nodes);
+	repair->heap = (uint32_t*) malloc(sizeof(uint32_t)*n_nodes);
+	repair->key = (double*) malloc(sizeof(double)*n_nodes);
+	repair->heap_position = (uint32_t*) malloc(sizeof(uint32_t)*n_nodes);
+	repair->heap_size = 0;
+	repair->n_updated = 0;
+
+	for(size_t i = 0;i < n_nodes;i++){
+		repair->g[i] = EDGE_COST_IMPASSABLE;
+		repair->rhs[i] = EDGE_COST_IMPASSABLE;
+		repair->previous_edge[i] = UINT32_MAX;
+		repair->heap_position[i] = UINT32_MAX;
+	}
+
+	//the start is the only inconsistent node, everything else is found from it
+	repair->rhs[start] = 0;
+	set_route_repair_heap_key(repair,start,0);
+
+	return repair;
+}
+
+void delete_route_repair(route_repair_t * repair){
+	if(repair == NULL) return;
+
+	release_map_graph(repair->graph);
+	free(repair->edge_costs);
+	free(repair->costed_from_source);
+	free(repair->g);
+	free(repair->rhs);
+	free(repair->previous_edge);
+	free(repair->heap);
+	free(repair->key);
+	free(repair->heap_position);
+	free(repair);
+}
+
+bool repair_route(route_repair_t * repair){
+	if(repair == NULL) return false;
+
+	uint32_t end = repair->end;
+	repair->n_updated = 0;
+
+	//stop once the end is consistent and nothing cheaper than it is left to fix
+	while(repair->heap_size > 0){
+		uint32_t node = repair->heap[0];
+		double end_key = fmin(repair->g[end],repair->rhs[end]);
+		if(repair->key[node] >= end_key && repair->g[end] == repair->rhs[end]) break;
+
+		remove_route_repair_heap_node(repair,node);
+		repair->n_updated++;
+
+		if(repair->g[node] > repair->rhs[node]){
+			//got cheaper, settle it like Dijkstra would
+			repair->g[node] = repair->rhs[node];
+			update_route_repair_neighbours(repair,node);
+		}else{
+			//got more expensive, forget its cost and let it and its neighbours find a new one
+			repair->g[node] = EDGE_COST_IMPASSABLE;
+			update_route_repair_node(repair,node);
+			update_route_repair_neighbours(repair,node);
+		}
+	}
+
+	return !isinf(repair->g[end]);
+}
+
+bool update_route_repair_edge(route_repair_t * repair,uint32_t edge_index){
+	if(repair == NULL || edge_index >= repair->graph->n_edges) return false;
+
+	double cost = get_route_repair_edge_cost(repair,edge_index);
+	if(cost == repair->edge_costs[edge_index]) return false;
+	repair->edge_costs[edge_index] = cost;
+
+	const map_graph_t * graph = repair->graph;
+	update_route_repair_node(repair,graph->edge_nodes[2*edge_index]);
+	update_route_repair_node(repair,graph->edge_nodes[2*edge_index+1]);
+
+	return true;
+}
+
+bool update_route_repair_source_edge(route_repair_t * repair,uint32_t edge_index){
+	if(repair == NULL || edge_index >= repair->graph->n_edges) return false;
+
+	if(repair->costed_from_source == NULL) repair->costed_from_source = (uint8_t*) calloc(repair->graph->n_edges+1,1);
+	repair->costed_from_source[edge_index] = 1;
+
+	return update_route_repair_edge(repair,edge_index);
+}
+
+bool move_route_repair_to_graph(route_repair_t * repair,map_graph_t * graph,const edge_closures_t * closures){
+	if(repair == NULL || graph == NULL) return false;
+	if(closures != NULL && closures->graph != graph) return false;
+
+	//node and edge j have to be the same ones in both snapshots
+	const map_graph_t * old_graph = repair->graph;
+	if(graph->n_nodes != old_graph->n_nodes || graph->n_edges != old_graph->n_edges) return false;
+	for(size_t i = 0;i < graph->n_nodes;i++){
+		if(graph->source_nodes[i] != old_graph->source_nodes[i]) return false;
+	}
+	for(size_t j = 0;j < graph->n_edges;j++){
+		if(graph->source_edges[j] != old_graph->source_edges[j]) return false;
+		if(graph->edge_nodes[2*j] != old_graph->edge_nodes[2*j]) return false;
+		if(graph->edge_nodes[2*j+1] != old_graph->edge_nodes[2*j+1]) return false;
+	}
+
+	retain_map_graph(graph);
+	release_map_graph(repair->graph);
+	repair->graph = graph;
+	repair->closures = closures;
+
+	//the new graph has the edges as they are now
+	free(repair->costed_from_source);
+	repair->costed_from_source = NULL;
+
+	for(uint32_t j = 0;j < graph->n_edges;j++) update_route_repair_edge(repair,j);
+
+	return true;
+}
+
+map_path_t * extract_repaired_route_path(const route_repair_t * repair){
+	if(repair == NULL || isinf(repair->g[repair->end])) return NULL;
+
+	const map_graph_t * graph = repair->graph;
+
+	//count the nodes first, a path can never visit more nodes than the graph has
+	size_t n_path_nodes = 1;
+	uint32_t current = repair->end;
+	while(current != repair->start){
+		uint32_t edge_index = repair->previous_edge[current];
+		if(edge_index == UINT32_MAX || n_path_nodes > graph->n_nodes) return NULL;
+
+		current = get_map_graph_other_node(graph,edge_index,current);
+		n_path_nodes++;
+	}
+
+	map_path_t * path = (map_path_t*) malloc(sizeof(map_path_t));
+	path->nodes = (map_node_t**) malloc(sizeof(map_node_t*)*n_path_nodes);
+	path->n_nodes = n_path_nodes;
+	path->name = NULL;
+
+	current = repair->end;
+	for(size_t i = n_path_nodes;i > 0;i--){
+		path->nodes[i-1] = graph->source_nodes[current];
+		if(current == repair->start) break;
+
+		current = get_map_graph_other_node(graph,repair->previous_edge[current],current);
+	}
+
+	return path;
+}
@@ -0,0 +1,144 @@
+#include "route_worker.h"
+
+static bool route_query_is_current(route_worker_t * worker,uint64_t generation){
+	return __atomic_load_n(&(worker->generation),__ATOMIC_ACQUIRE) == generation;
+}
+
+static void run_route_request(route_worker_t * worker,route_request_t * request){
+	map_graph_t * graph = request->graph;
+
+	//grow the scratch memory if the map grew
+	if(worker->context == NULL || worker->context->n_nodes < graph->n_nodes){
+		delete_route_search_context(worker->context);
+		worker->context = create_route_search_context(graph->n_nodes);
+	}
+
+	worker->context->cancel_counter = &(worker->generation);
+	worker->context->cancel_ticket = request->generation;
+
+	route_result_t * result = (route_result_t*) malloc(sizeof(route_result_t));
+	result->generation = request->generation;
+	result->query_index = 0;
+	result->found = search_map_graph_with_filter(graph,worker->context,request->start,request->end,request->edge_cost_function,request->filter);
+	result->cost = result->found ? worker->context->cost[request->end] : EDGE_COST_IMPASSABLE;
+	result->path = result->found ? extract_route_path(graph,worker->context,request->end) : NULL;
+
+	release_map_graph(graph);
+
+	//nobody wants a result for a query that was replaced while it ran
+	if(!route_query_is_current(worker,result->generation)){
+		delete_route_result(result);
+		return;
+	}
+
+	worker->on_result(result,worker->user_data);
+}
+
+static void * route_worker_main(void * argument){
+	route_worker_t * worker = (route_worker_t*) argument;
+
+	pthread_mutex_lock(&(worker->lock));
+	while(true){
+		while(!worker->has_pending && !worker->shutting_down){
+			pthread_cond_wait(&(worker->wake),&(worker->lock));
+		}
+		if(worker->shutting_down) break;
+
+		route_request_t request = worker->pending;
+		worker->has_pending = false;
+
+		//search without holding the lock so new queries can be submitted meanwhile
+		pthread_mutex_unlock(&(worker->lock));
+		run_route_request(worker,&request);
+		pthread_mutex_lock(&(worker->lock));
+	}
+	pthread_mutex_unlock(&(worker->lock));
+
+	return NULL;
+}
+
+route_worker_t * create_route_worker(void (*on_result)(route_result_t * result,void * user_data),void * user_data){
+	route_worker_t * worker = (route_worker_t*) malloc(sizeof(route_worker_t));
+
+	pthread_mutex_init(&(worker->lock),NULL);
+	pthread_cond_init(&(worker->wake),NULL);
+	worker->has_pending = false;
+	worker->shutting_down = false;
+	worker->generation = 0;
+	worker->on_result = on_result;
+	worker->user_data = user_data;
+	worker->context = NULL;
+
+	pthread_create(&(worker->thread),NULL,route_worker_main,worker);
+
+	return worker;
+}
+
+void delete_route_worker(route_worker_t * worker){
+	if(worker == NULL) return;
+
+	pthread_mutex_lock(&(worker->lock));
+	__atomic_add_fetch(&(worker->generation),1,__ATOMIC_ACQ_REL);
+	worker->shutting_down = true;
+	pthread_cond_signal(&(worker->wake));
+	pthread_mutex_unlock(&(worker->lock));
+
+	pthread_join(worker->thread,NULL);
+
+	//a query that never started still holds its graph
+	if(worker->has_pending) release_map_graph(worker->pending.graph);
+
+	delete_route_search_context(worker->context);
+	pthread_cond_destroy(&(worker->wake));
+	pthread_mutex_destroy(&(worker->lock));
+	free(worker);
+}
+
+uint64_t submit_route_query(route_worker_t * worker,map_graph_t * graph,const map_node_t * start,const map_node_t * end,double (*edge_cost_function)(const map_edge_t * edge_ref),uint8_t filter){
+	if(worker == NULL || graph == NULL || edge_cost_function == NULL) return 0;
+
+	bool start_found = false;
+	bool end_found = false;
+	uint32_t start_index = get_map_graph_node_index(graph,start,&start_found);
+	uint32_t end_index = get_map_graph_node_index(graph,end,&end_found);
+	if(!start_found || !end_found) return 0;
+
+	retain_map_graph(graph);
+
+	pthread_mutex_lock(&(worker->lock));
+
+	//replace a query that has not started yet
+	if(worker->has_pending) release_map_graph(worker->pending.graph);
+
+	//cancels the running search
+	uint64_t generation = __atomic_add_fetch(&(worker->generation),1,__ATOMIC_ACQ_REL);
+
+	worker->pending.graph = graph;
+	worker->pending.start = start_index;
+	worker->pending.end = end_index;
+	worker->pending.edge_cost_function = edge_cost_function;
+	worker->pending.filter = filter;
+	worker->pending.generation = generation;
+	worker->has_pending = true;
+
+	pthread_cond_signal(&(worker->wake));
+	pthread_mutex_unlock(&(worker->lock));
+
+	return generation;
+}
+
+void cancel_route_queries(route_worker_t * worker){
+	if(worker == NULL) return;
+
+	pthread_mutex_lock(&(worker->lock));
+	if(worker->has_pending){
+		release_map_graph(worker->pending.graph);
+		worker->has_pending = false;
+	}
+	__atomic_add_fetch(&(worker->generation),1,__ATOMIC_ACQ_REL);
+	pthread_mutex_unlock(&(worker->lock));
+}
+
+uint64_t get_route_worker_generation(route_worker_t * worker){
+	return __atomic_load_n(&(worker->generation),__ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,794 @@
+#include "routing.h"
+#include "cost_profiles.h"
+#include "route_repair.h"
+#include "projection.h"
+#include <string.h>
+
+#define DEFAULT_ROUTE_HEAP_CAPACITY 64
+
+static double degrees_to_radians(double degrees){
+	return degrees*(M_PI/180.0);
+}
+
+double get_map_edge_length(const map_edge_t * edge_ref){
+	cord_t a = edge_ref->a->coordinate;
+	cord_t b = edge_ref->b->coordinate;
+
+	//haversine distance along the ground
+	double lat_a = degrees_to_radians(a.latitude);
+	double lat_b = degrees_to_radians(b.latitude);
+	double half_d_lat = (lat_b - lat_a)/2.0;
+	double half_d_lon = degrees_to_radians(b.longitude - a.longitude)/2.0;
+	double h = sin(half_d_lat)*sin(half_d_lat) + cos(lat_a)*cos(lat_b)*sin(half_d_lon)*sin(half_d_lon);
+	double ground = 2.0*EARTH_RADIUS_METERS*asin(fmin(1.0,sqrt(h)));
+
+	//stairs and elevators mostly go up and down
+	double climb = 0.0;
+	int8_t floor_a = edge_ref->a->floor_number;
+	int8_t floor_b = edge_ref->b->floor_number;
+	if(floor_a != NODE_FLOOR_NUMBER_NONE && floor_b != NODE_FLOOR_NUMBER_NONE){
+		climb = fabs((double)(floor_a - floor_b))*FLOOR_HEIGHT_METERS;
+	}
+
+	return sqrt(ground*ground + climb*climb);
+}
+
+double calculate_wheelchair_edge_cost(const map_edge_t * edge_ref){
+	return Wheelchair_Cost_Profile::edge_cost(edge_ref);
+}
+
+double calculate_walker_edge_cost(const map_edge_t * edge_ref){
+	return Walker_Cost_Profile::edge_cost(edge_ref);
+}
+
+double calculate_deliverer_edge_cost(const map_edge_t * edge_ref){
+	return Deliverer_Cost_Profile::edge_cost(edge_ref);
+}
+
+double calculate_driver_edge_cost(const map_edge_t * edge_ref){
+	return Driver_Cost_Profile::edge_cost(edge_ref);
+}
+
+edge_cost_function_t get_route_profile_cost_function(uint8_t profile){
+	switch(profile){
+		case ROUTE_PROFILE_WHEELCHAIR: return calculate_wheelchair_edge_cost;
+		case ROUTE_PROFILE_WALKER: return calculate_walker_edge_cost;
+		case ROUTE_PROFILE_DELIVERER: return calculate_deliverer_edge_cost;
+		case ROUTE_PROFILE_DRIVER: return calculate_driver_edge_cost;
+		default: return NULL;
+	}
+}
+
+bool get_route_profile_of_cost_function(edge_cost_function_t edge_cost_function,uint8_t * profile_out){
+	for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+		if(get_route_profile_cost_function(profile) == edge_cost_function){
+			*profile_out = profile;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+route_search_context_t * create_route_search_context(size_t n_nodes){
+	route_search_context_t * context = (route_search_context_t*) malloc(sizeof(route_search_context_t));
+
+	context->n_nodes = n_nodes;
+	context->cost = (double*) malloc(sizeof(double)*(n_nodes+1));
+	context->previous_edge = (uint32_t*) malloc(sizeof(uint32_t)*(n_nodes+1));
+	context->stamp = (uint32_t*) calloc(n_nodes+1,sizeof(uint32_t));
+	context->current_stamp = 0;
+
+	context->heap_capacity = DEFAULT_ROUTE_HEAP_CAPACITY;
+	context->heap = (route_heap_entry_t*) malloc(sizeof(route_heap_entry_t)*context->heap_capacity);
+	context->heap_size = 0;
+
+	context->cancel_counter = NULL;
+	context->cancel_ticket = 0;
+
+	context->settled = NULL;
+	context->n_settled = 0;
+
+	return context;
+}
+
+void delete_route_search_context(route_search_context_t * context){
+	if(context == NULL) return;
+
+	free(context->cost);
+	free(context->previous_edge);
+	free(context->stamp);
+	free(context->heap);
+	free(context->settled);
+	free(context);
+}
+
+void record_settled_nodes(route_search_context_t * context){
+	if(context == NULL || context->settled != NULL) return;
+
+	//a node is settled at most once per search
+	context->settled = (uint32_t*) malloc(sizeof(uint32_t)*(context->n_nodes+1));
+	context->n_settled = 0;
+}
+
+/*
+ * Forget the previous search in O(1) by moving on to a new stamp
+ */
+static void reset_route_search_context(route_search_context_t * context){
+	context->heap_size = 0;
+	context->n_settled = 0;
+	context->current_stamp++;
+
+	//the stamp wrapped around, old stamps could be mistaken for current ones
+	if(context->current_stamp == 0){
+		memset(context->stamp,0,sizeof(uint32_t)*(context->n_nodes+1));
+		context->current_stamp = 1;
+	}
+}
+
+static void route_heap_push(route_search_context_t * context,double cost,uint32_t node){
+	if(context->heap_size == context->heap_capacity){
+		context->heap_capacity *= 2;
+		context->heap = (route_heap_entry_t*) realloc(context->heap,sizeof(route_heap_entry_t)*context->heap_capacity);
+	}
+
+	//sift up
+	size_t i = context->heap_size;
+	context->heap_size++;
+	while(i > 0){
+		size_t parent = (i-1)/2;
+		if(context->heap[parent].cost <= cost) break;
+		context->heap[i] = context->heap[parent];
+		i = parent;
+	}
+	context->heap[i].cost = cost;
+	context->heap[i].node = node;
+}
+
+static route_heap_entry_t route_heap_pop(route_search_context_t * context){
+	route_heap_entry_t top = context->heap[0];
+	context->heap_size--;
+	route_heap_entry_t last = context->heap[context->heap_size];
+
+	//sift down
+	size_t i = 0;
+	while(true){
+		size_t child = 2*i+1;
+		if(child >= context->heap_size) break;
+		if(child+1 < context->heap_size && context->heap[child+1].cost < context->heap[child].cost) child++;
+		if(last.cost <= context->heap[child].cost) break;
+		context->heap[i] = context->heap[child];
+		i = child;
+	}
+	context->heap[i] = last;
+
+	return top;
+}
+
+static bool route_search_cancelled(const route_search_context_t * context){
+	if(context->cancel_counter == NULL) return false;
+
+	return __atomic_load_n(context->cancel_counter,__ATOMIC_ACQUIRE) != context->cancel_ticket;
+}
+
+/*
+ * Dijkstra's Algorithm on from whatever is in the context's queue. Stops with true once end is settled or, if
+ * targets is not NULL, once n_targets marked nodes are settled. Stops with false when the queue runs dry, the
+ * next node costs more than cost_limit or the search is cancelled. A node over the cost limit is left in the
+ * queue so the search can go on with a higher limit later.
+ * Instantiated once per cost profile so the edge cost is inlined into the loop.
+ */
+template<typename Cost_Profile>
+static bool settle_route_search(const map_graph_t * graph,route_search_context_t * context,uint32_t end,const uint8_t * targets,size_t n_targets,double cost_limit,const Cost_Profile & cost_profile){
+	size_t n_settled = 0;
+	size_t n_targets_left = n_targets;
+	while(context->heap_size > 0){
+		if(context->heap[0].cost > cost_limit) return false;
+		route_heap_entry_t current = route_heap_pop(context);
+
+		//skip entries made outdated by a cheaper path
+		if(current.cost > context->cost[current.node]) continue;
+		if(context->settled != NULL) context->settled[context->n_settled++] = current.node;
+		if(current.node == end) return true;
+		if(targets != NULL && targets[current.node]){
+			n_targets_left--;
+			if(n_targets_left == 0) return true;
+		}
+
+		n_settled++;
+		if(n_settled % ROUTE_CANCEL_CHECK_INTERVAL == 0 && route_search_cancelled(context)) return false;
+
+		for(size_t i = graph->adjacency_offsets[current.node];i < graph->adjacency_offsets[current.node+1];i++){
+			uint32_t neighbour = graph->adjacency_nodes[i];
+			uint32_t edge_index = graph->adjacency_edges[i];
+
+			double edge_cost = cost_profile.edge_cost(graph,edge_index);
+			if(isinf(edge_cost)) continue;
+
+			double new_cost = current.cost + edge_cost;
+			if(context->stamp[neighbour] == context->current_stamp && context->cost[neighbour] <= new_cost) continue;
+
+			context->stamp[neighbour] = context->current_stamp;
+			context->cost[neighbour] = new_cost;
+			context->previous_edge[neighbour] = edge_index;
+			route_heap_push(context,new_cost,neighbour);
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Dijkstra's Algorithm from start, see settle_route_search
+ */
+template<typename Cost_Profile>
+static bool run_route_search(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,const uint8_t * targets,size_t n_targets,double cost_limit,const Cost_Profile & cost_profile){
+	reset_route_search_context(context);
+
+	context->cost[start] = 0.0;
+	context->previous_edge[start] = UINT32_MAX;
+	context->stamp[start] = context->current_stamp;
+	route_heap_push(context,0.0,start);
+
+	return settle_route_search(graph,context,end,targets,n_targets,cost_limit,cost_profile);
+}
+
+/*
+ * Heuristic of a shortest path tree grown from end over costs that are never higher than the cost profile's.
+ * Its costs are consistent, and nodes the tree never reached can not lead to end.
+ */
+struct End_Tree_Heuristic{
+	const route_search_context_t * end_tree;
+
+	double estimate(uint32_t node) const {
+		return route_search_reached(end_tree,node) ? end_tree->cost[node] : EDGE_COST_IMPASSABLE;
+	}
+};
+
+/*
+ * Heuristic of the straight line to end on the graph's projection, times the cheapest multiplier of the
+ * profile. Every edge is at least as long as the straight line between its nodes, so it never overestimates.
+ */
+struct Projected_Heuristic{
+	const map_projection_t * projection;
+	uint32_t end;
+	float scale;
+
+	double estimate(uint32_t node) const {
+		return get_projected_distance(projection,node,end)*scale;
+	}
+};
+
+/*
+ * A* from start to end, guided by the estimates of a heuristic that never overestimates the cost still to go.
+ * Nodes estimated at EDGE_COST_IMPASSABLE can not lead to end and are skipped. Heap entries hold the cost so far
+ * plus the estimate.
+ */
+template<typename Cost_Profile,typename Heuristic>
+static bool run_guided_route_search(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,double cost_limit,const Cost_Profile & cost_profile,const Heuristic & heuristic){
+	reset_route_search_context(context);
+	double start_estimate = heuristic.estimate(start);
+	if(isinf(start_estimate)) return false;
+
+	context->cost[start] = 0.0;
+	context->previous_edge[start] = UINT32_MAX;
+	context->stamp[start] = context->current_stamp;
+	route_heap_push(context,start_estimate,start);
+
+	size_t n_settled = 0;
+	while(context->heap_size > 0){
+		route_heap_entry_t current = route_heap_pop(context);
+
+		double current_cost = context->cost[current.node];
+		if(current.cost > current_cost + heuristic.estimate(current.node)) continue;
+		if(current.cost > cost_limit) return false;//no way through this node or any later one can be cheap enough
+		if(current.node == end) return true;
+
+		n_settled++;
+		if(n_settled % ROUTE_CANCEL_CHECK_INTERVAL == 0 && route_search_cancelled(context)) return false;
+
+		for(size_t i = graph->adjacency_offsets[current.node];i < graph->adjacency_offsets[current.node+1];i++){
+			uint32_t neighbour = graph->adjacency_nodes[i];
+			uint32_t edge_index = graph->adjacency_edges[i];
+
+			double edge_cost = cost_profile.edge_cost(graph,edge_index);
+			if(isinf(edge_cost)) continue;
+
+			double new_cost = current_cost + edge_cost;
+			if(context->stamp[neighbour] == context->current_stamp && context->cost[neighbour] <= new_cost) continue;
+
+			double estimate = heuristic.estimate(neighbour);
+			if(isinf(estimate)) continue;
+
+			context->stamp[neighbour] = context->current_stamp;
+			context->cost[neighbour] = new_cost;
+			context->previous_edge[neighbour] = edge_index;
+			route_heap_push(context,new_cost + estimate,neighbour);
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Dijkstra's Algorithm from start where the cost of an edge depends on the cost of the route up to it.
+ * Waiting for an edge to open never makes a route that gets there later leave earlier, so settled nodes
+ * are still final.
+ */
+template<typename Cost_Profile>
+static bool run_timed_route_search(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,const Schedules_Cost_Profile<Cost_Profile> & cost_profile){
+	reset_route_search_context(context);
+
+	context->cost[start] = 0.0;
+	context->previous_edge[start] = UINT32_MAX;
+	context->stamp[start] = context->current_stamp;
+	route_heap_push(context,0.0,start);
+
+	size_t n_settled = 0;
+	while(context->heap_size > 0){
+		route_heap_entry_t current = route_heap_pop(context);
+
+		if(current.cost > context->cost[current.node]) continue;
+		if(context->settled != NULL) context->settled[context->n_settled++] = current.node;
+		if(current.node == end) return true;
+
+		n_settled++;
+		if(n_settled % ROUTE_CANCEL_CHECK_INTERVAL == 0 && route_search_cancelled(context)) return false;
+
+		for(size_t i = graph->adjacency_offsets[current.node];i < graph->adjacency_offsets[current.node+1];i++){
+			uint32_t neighbour = graph->adjacency_nodes[i];
+			uint32_t edge_index = graph->adjacency_edges[i];
+
+			double edge_cost = cost_profile.edge_cost_at(graph,edge_index,current.cost);
+			if(isinf(edge_cost)) continue;
+
+			double new_cost = current.cost + edge_cost;
+			if(context->stamp[neighbour] == context->current_stamp && context->cost[neighbour] <= new_cost) continue;
+
+			context->stamp[neighbour] = context->current_stamp;
+			context->cost[neighbour] = new_cost;
+			context->previous_edge[neighbour] = edge_index;
+			route_heap_push(context,new_cost,neighbour);
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Search with the weights of a profile that were measured when the snapshot was taken
+ */
+static bool run_route_search_with_profile(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,const uint8_t * targets,size_t n_targets,double cost_limit,uint8_t profile){
+	if(profile >= N_ROUTE_PROFILES) return false;
+
+	Edge_Weights_Cost_Profile cost_profile;
+	cost_profile.weights = graph->weights->profile_weights[profile];
+
+	return run_route_search(graph,context,start,end,targets,n_targets,cost_limit,cost_profile);
+}
+
+static bool route_search_arguments_valid(const map_graph_t * graph,const route_search_context_t * context,uint32_t start){
+	if(graph == NULL || context == NULL) return false;
+	if(start >= graph->n_nodes) return false;
+	if(context->n_nodes < graph->n_nodes) return false;//context is too small for this graph
+
+	return true;
+}
+
+bool search_map_graph(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,double (*edge_cost_function)(const map_edge_t * edge_ref)){
+	//built in cost functions get the inlined search, anything else goes through the pointer
+	uint8_t profile;
+	if(get_route_profile_of_cost_function(edge_cost_function,&profile)){
+		return search_map_graph_with_profile(graph,context,start,end,profile);
+	}
+
+	return search_map_graph_through_pointer(graph,context,start,end,edge_cost_function);
+}
+
+bool search_map_graph_through_pointer(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,double (*edge_cost_function)(const map_edge_t * edge_ref)){
+	if(!route_search_arguments_valid(graph,context,start) || end >= graph->n_nodes) return false;
+	if(edge_cost_function == NULL) return false;
+
+	Function_Pointer_Cost_Profile cost_profile;
+	cost_profile.edge_cost_function = edge_cost_function;
+
+	return run_route_search(graph,context,start,end,NULL,0,INFINITY,cost_profile);
+}
+
+bool search_map_graph_with_profile(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,uint8_t profile){
+	if(!route_search_arguments_valid(graph,context,start) || end >= graph->n_nodes) return false;
+
+	return run_route_search_with_profile(graph,context,start,end,NULL,0,INFINITY,profile);
+}
+
+bool search_map_graph_with_heuristic(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,uint8_t profile){
+	if(!route_search_arguments_valid(graph,context,start) || end >= graph->n_nodes) return false;
+	if(profile >= N_ROUTE_PROFILES) return false;
+
+	//the cheapest a meter of any edge can be for the profile
+	const double * type_multipliers = get_profile_type_multipliers(profile);
+	double cheapest = INFINITY;
+	for(size_t i = 0;i < N_EDGE_TYPES;i++) cheapest = fmin(cheapest,type_multipliers[i]);
+	if(isinf(cheapest)) return false;
+
+	Edge_Weights_Cost_Profile cost_profile;
+	cost_profile.weights = graph->weights->profile_weights[profile];
+	Projected_Heuristic heuristic;
+	heuristic.projection = graph->projection;
+	heuristic.end = end;
+	heuristic.scale = (float) cheapest*graph->projection->lower_bound_scale;
+	return run_guided_route_search(graph,context,start,end,INFINITY,cost_profile,heuristic);
+}
+
+bool search_map_graph_with_filter(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,double (*edge_cost_function)(const map_edge_t * edge_ref),uint8_t filter){
+	if(filter == SEARCH_FILTER_NONE) return search_map_graph(graph,context,start,end,edge_cost_function);
+
+	if(!route_search_arguments_valid(graph,context,start) || end >= graph->n_nodes) return false;
+	if(edge_cost_function == NULL || filter >= N_SEARCH_FILTERS) return false;
+
+	const uint64_t * allowed_edges = get_search_filter_bitset(graph,filter);
+
+	uint8_t profile;
+	if(get_route_profile_of_cost_function(edge_cost_function,&profile)){
+		Filtered_Cost_Profile<Edge_Weights_Cost_Profile> cost_profile;
+		cost_profile.cost_profile.weights = graph->weights->profile_weights[profile];
+		cost_profile.allowed_edges = allowed_edges;
+
+		return run_route_search(graph,context,start,end,NULL,0,INFINITY,cost_profile);
+	}
+
+	Filtered_Cost_Profile<Function_Pointer_Cost_Profile> cost_profile;
+	cost_profile.cost_profile.edge_cost_function = edge_cost_function;
+	cost_profile.allowed_edges = allowed_edges;
+
+	return run_route_search(graph,context,start,end,NULL,0,INFINITY,cost_profile);
+}
+
+bool search_map_graph_with_allowed_edges(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,uint8_t profile,const uint64_t * allowed_edges,double cost_limit,const route_search_context_t * end_tree){
+	if(!route_search_arguments_valid(graph,context,start) || end >= graph->n_nodes) return false;
+	if(profile >= N_ROUTE_PROFILES || allowed_edges == NULL) return false;
+
+	Filtered_Cost_Profile<Edge_Weights_Cost_Profile> cost_profile;
+	cost_profile.cost_profile.weights = graph->weights->profile_weights[profile];
+	cost_profile.allowed_edges = allowed_edges;
+
+	if(end_tree != NULL){
+		End_Tree_Heuristic heuristic;
+		heuristic.end_tree = end_tree;
+		return run_guided_route_search(graph,context,start,end,cost_limit,cost_profile,heuristic);
+	}
+	return run_route_search(graph,context,start,end,NULL,0,cost_limit,cost_profile);
+}
+
+bool search_map_graph_at_time(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,uint8_t profile,int64_t departure_time,const edge_closures_t * closures){
+	if(graph == NULL || context == NULL || context->n_nodes < graph->n_nodes) return false;
+	if(start >= graph->n_nodes || end >= graph->n_nodes || profile >= N_ROUTE_PROFILES) return false;
+	if(closures != NULL && closures->graph != graph) return false;
+
+	Schedules_Cost_Profile<Edge_Weights_Cost_Profile> cost_profile;
+	cost_profile.cost_profile.weights = graph->weights->profile_weights[profile];
+	cost_profile.tables = graph->schedule_tables;
+	cost_profile.departure_time = departure_time;
+	cost_profile.meters_per_second = route_profile_meters_per_second[profile];
+	cost_profile.closures = closures;
+	return run_timed_route_search(graph,context,start,end,cost_profile);
+}
+
+bool search_map_graph_with_closures(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,double (*edge_cost_function)(const map_edge_t * edge_ref),const edge_closures_t * closures,int64_t time){
+	if(closures == NULL) return search_map_graph(graph,context,start,end,edge_cost_function);
+
+	if(!route_search_arguments_valid(graph,context,start) || end >= graph->n_nodes) return false;
+	if(edge_cost_function == NULL || closures->graph != graph) return false;
+
+	uint8_t profile;
+	if(get_route_profile_of_cost_function(edge_cost_function,&profile)){
+		Closures_Cost_Profile<Edge_Weights_Cost_Profile> cost_profile;
+		cost_profile.cost_profile.weights = graph->weights->profile_weights[profile];
+		cost_profile.closures = closures;
+		cost_profile.time = time;
+
+		return run_route_search(graph,context,start,end,NULL,0,INFINITY,cost_profile);
+	}
+
+	Closures_Cost_Profile<Function_Pointer_Cost_Profile> cost_profile;
+	cost_profile.cost_profile.edge_cost_function = edge_cost_function;
+	cost_profile.closures = closures;
+	cost_profile.time = time;
+
+	return run_route_search(graph,context,start,end,NULL,0,INFINITY,cost_profile);
+}
+
+bool search_map_graph_by_floor_layers(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,double (*edge_cost_function)(const map_edge_t * edge_ref)){
+	if(!route_search_arguments_valid(graph,context,start) || end >= graph->n_nodes) return false;
+	if(edge_cost_function == NULL) return false;
+
+	const floor_layers_t * layers = graph->floor_layers;
+	uint8_t * allowed_layers = (uint8_t*) malloc(layers->n_layers+1);
+	uint8_t profile = N_ROUTE_PROFILES;
+	bool known_profile = get_route_profile_of_cost_function(edge_cost_function,&profile);
+	mark_floor_layers_for_route(layers,start,end,known_profile ? profile : N_ROUTE_PROFILES,allowed_layers);
+
+	bool found;
+	if(known_profile){
+		Floor_Layers_Cost_Profile<Edge_Weights_Cost_Profile> cost_profile;
+		cost_profile.cost_profile.weights = graph->weights->profile_weights[profile];
+		cost_profile.node_layer = layers->node_layer;
+		cost_profile.allowed_layers = allowed_layers;
+
+		found = run_route_search(graph,context,start,end,NULL,0,INFINITY,cost_profile);
+	}else{
+		Floor_Layers_Cost_Profile<Function_Pointer_Cost_Profile> cost_profile;
+		cost_profile.cost_profile.edge_cost_function = edge_cost_function;
+		cost_profile.node_layer = layers->node_layer;
+		cost_profile.allowed_layers = allowed_layers;
+
+		found = run_route_search(graph,context,start,end,NULL,0,INFINITY,cost_profile);
+	}
+
+	free(allowed_layers);
+	return found;
+}
+
+bool grow_route_search_tree(const map_graph_t * graph,route_search_context_t * context,uint32_t start,const uint8_t * targets,size_t n_targets,double cost_limit,uint8_t profile){
+	if(!route_search_arguments_valid(graph,context,start)) return false;
+
+	//with no targets the whole tree up to the cost limit is wanted
+	if(targets == NULL || n_targets == 0){
+		run_route_search_with_profile(graph,context,start,UINT32_MAX,NULL,0,cost_limit,profile);
+		return true;
+	}
+
+	return run_route_search_with_profile(graph,context,start,UINT32_MAX,targets,n_targets,cost_limit,profile);
+}
+
+bool extend_route_search_tree(const map_graph_t * graph,route_search_context_t * context,double cost_limit,uint8_t profile){
+	if(graph == NULL || context == NULL || context->n_nodes < graph->n_nodes) return false;
+	if(profile >= N_ROUTE_PROFILES) return false;
+
+	Edge_Weights_Cost_Profile cost_profile;
+	cost_profile.weights = graph->weights->profile_weights[profile];
+
+	settle_route_search(graph,context,UINT32_MAX,NULL,0,cost_limit,cost_profile);
+	return true;
+}
+
+bool grow_route_search_tree_with_weights(const map_graph_t * graph,route_search_context_t * context,uint32_t start,double cost_limit,const float * weights){
+	if(!route_search_arguments_valid(graph,context,start) || weights == NULL) return false;
+
+	Edge_Weights_Cost_Profile cost_profile;
+	cost_profile.weights = weights;
+
+	run_route_search(graph,context,start,UINT32_MAX,NULL,0,cost_limit,cost_profile);
+	return true;
+}
+
+bool grow_building_interior_tree(const map_graph_t * graph,const building_routes_t * routes,route_search_context_t * context,uint32_t start,uint32_t building_index,uint8_t profile){
+	if(!route_search_arguments_valid(graph,context,start) || routes == NULL || profile >= N_ROUTE_PROFILES) return false;
+
+	Building_Interior_Cost_Profile cost_profile;
+	cost_profile.weights = graph->weights->profile_weights[profile];
+	cost_profile.node_building = routes->node_building;
+	cost_profile.building_index = building_index;
+
+	run_route_search(graph,context,start,UINT32_MAX,NULL,0,INFINITY,cost_profile);
+	return true;
+}
+
+static void relax_route_node(route_search_context_t * context,uint32_t node,double new_cost,uint32_t previous_edge){
+	if(context->stamp[node] == context->current_stamp && context->cost[node] <= new_cost) return;
+
+	context->stamp[node] = context->current_stamp;
+	context->cost[node] = new_cost;
+	context->previous_edge[node] = previous_edge;
+	route_heap_push(context,new_cost,node);
+}
+
+bool search_map_graph_by_buildings(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,uint8_t profile,const edge_closures_t * closures,int64_t time){
+	if(!route_search_arguments_valid(graph,context,start) || end >= graph->n_nodes) return false;
+	if(profile >= N_ROUTE_PROFILES) return false;
+	if(closures != NULL && closures->graph != graph) return false;
+
+	const building_routes_t * routes = graph->building_routes;
+	const float * weights = graph->weights->profile_weights[profile];
+	uint32_t start_building = routes->node_building[start];
+	uint32_t end_building = routes->node_building[end];
+
+	reset_route_search_context(context);
+	relax_route_node(context,start,0.0,UINT32_MAX);
+
+	size_t n_settled = 0;
+	while(context->heap_size > 0){
+		route_heap_entry_t current = route_heap_pop(context);
+		if(current.cost > context->cost[current.node]) continue;
+		if(context->settled != NULL) context->settled[context->n_settled++] = current.node;
+		if(current.node == end) return true;
+
+		n_settled++;
+		if(n_settled % ROUTE_CANCEL_CHECK_INTERVAL == 0 && route_search_cancelled(context)) return false;
+
+		uint32_t building = routes->node_building[current.node];
+		bool passing_through = building != NODE_OUTDOORS && building != start_building && building != end_building;
+		if(passing_through && building_has_closures(closures,building)) passing_through = false;//its table is out of date
+
+		for(size_t i = graph->adjacency_offsets[current.node];i < graph->adjacency_offsets[current.node+1];i++){
+			uint32_t neighbour = graph->adjacency_nodes[i];
+			uint32_t edge_index = graph->adjacency_edges[i];
+
+			//the inside of a building that is only passed through is covered by its entrance table
+			if(passing_through && routes->node_building[neighbour] == building) continue;
+
+			float edge_cost = weights[edge_index];
+			if(isinf(edge_cost)) continue;
+			if(closures != NULL && map_graph_edge_closed(closures,edge_index,time)) continue;
+
+			relax_route_node(context,neighbour,current.cost + edge_cost,edge_index);
+		}
+
+		if(!passing_through || routes->node_entrance[current.node] == UINT32_MAX) continue;
+
+		//jump straight to the building's other entrances
+		const building_portals_t * portals = &(routes->buildings[building]);
+		const float * entrance_costs = portals->entrance_costs[profile] + routes->node_entrance[current.node]*portals->n_entrances;
+		for(uint32_t j = 0;j < portals->n_entrances;j++){
+			if(isinf(entrance_costs[j]) || portals->entrances[j] == current.node) continue;
+
+			relax_route_node(context,portals->entrances[j],current.cost + entrance_costs[j],ROUTE_SHORTCUT_BIT | current.node);
+		}
+	}
+
+	return false;
+}
+
+/*
+ * The node before a node on the path in a search tree
+ */
+static uint32_t get_route_previous_node(const map_graph_t * graph,const route_search_context_t * context,uint32_t node){
+	uint32_t previous_edge = context->previous_edge[node];
+	if(previous_edge & ROUTE_SHORTCUT_BIT) return previous_edge & ~ROUTE_SHORTCUT_BIT;
+
+	return get_map_graph_other_node(graph,previous_edge,node);
+}
+
+map_path_t * extract_building_route_path(const map_graph_t * graph,const route_search_context_t * context,uint32_t end,uint8_t profile){
+	if(graph == NULL || context == NULL || profile >= N_ROUTE_PROFILES) return NULL;
+	if(end >= graph->n_nodes || context->stamp[end] != context->current_stamp) return NULL;
+
+	size_t nodes_capacity = 16;
+	size_t n_path_nodes = 0;
+	uint32_t * reversed_nodes = (uint32_t*) malloc(sizeof(uint32_t)*nodes_capacity);
+	route_search_context_t * interior_context = NULL;
+
+	//walk backwards, searching across the buildings that were jumped over
+	uint32_t current = end;
+	while(true){
+		if(n_path_nodes == nodes_capacity){
+			nodes_capacity *= 2;
+			reversed_nodes = (uint32_t*) realloc(reversed_nodes,sizeof(uint32_t)*nodes_capacity);
+		}
+		reversed_nodes[n_path_nodes++] = current;
+
+		uint32_t previous_edge = context->previous_edge[current];
+		if(previous_edge == UINT32_MAX) break;
+
+		uint32_t previous = get_route_previous_node(graph,context,current);
+		if(previous_edge & ROUTE_SHORTCUT_BIT){
+			if(interior_context == NULL) interior_context = create_route_search_context(graph->n_nodes);
+			grow_building_interior_tree(graph,graph->building_routes,interior_context,previous,graph->building_routes->node_building[previous],profile);
+
+			//the nodes strictly between the two entrances
+			uint32_t inside = get_route_previous_node(graph,interior_context,current);
+			while(inside != previous){
+				if(n_path_nodes == nodes_capacity){
+					nodes_capacity *= 2;
+					reversed_nodes = (uint32_t*) realloc(reversed_nodes,sizeof(uint32_t)*nodes_capacity);
+				}
+				reversed_nodes[n_path_nodes++] = inside;
+				inside = get_route_previous_node(graph,interior_context,inside);
+			}
+		}
+		current = previous;
+	}
+	delete_route_search_context(interior_context);
+
+	map_path_t * path = (map_path_t*) malloc(sizeof(map_path_t));
+	path->nodes = (map_node_t**) malloc(sizeof(map_node_t*)*n_path_nodes);
+	path->n_nodes = n_path_nodes;
+	path->name = NULL;
+	for(size_t i = 0;i < n_path_nodes;i++){
+		path->nodes[i] = graph->source_nodes[reversed_nodes[n_path_nodes-1-i]];
+	}
+
+	free(reversed_nodes);
+	return path;
+}
+
+bool route_search_reached(const route_search_context_t * context,uint32_t node){
+	return node < context->n_nodes && context->stamp[node] == context->current_stamp;
+}
+
+map_path_t * extract_route_path(const map_graph_t * graph,const route_search_context_t * context,uint32_t end){
+	if(graph == NULL || context == NULL) return NULL;
+	if(end >= graph->n_nodes || context->stamp[end] != context->current_stamp) return NULL;
+
+	//count the nodes along the path by walking it backwards
+	size_t n_path_nodes = 1;
+	uint32_t current = end;
+	while(context->previous_edge[current] != UINT32_MAX){
+		current = get_map_graph_other_node(graph,context->previous_edge[current],current);
+		n_path_nodes++;
+	}
+
+	map_path_t * path = (map_path_t*) malloc(sizeof(map_path_t));
+	path->nodes = (map_node_t**) malloc(sizeof(map_node_t*)*n_path_nodes);
+	path->n_nodes = n_path_nodes;
+	path->name = NULL;
+
+	//fill in the path from back to front
+	current = end;
+	for(size_t i = n_path_nodes;i > 0;i--){
+		path->nodes[i-1] = graph->source_nodes[current];
+		if(context->previous_edge[current] == UINT32_MAX) break;
+
+		current = get_map_graph_other_node(graph,context->previous_edge[current],current);
+	}
+
+	return path;
+}
+
+void delete_route_result(route_result_t * result){
+	if(result == NULL) return;
+
+	delete_map_path(result->path);
+	free(result);
+}
+
+void find_best_path(map_t * map_ref){
+	if(map_ref == NULL) return;
+
+	if(map_ref->active_path != NULL){
+		delete_map_path(map_ref->active_path);
+		map_ref->active_path = NULL;
+	}
+
+	route_repair_t * repair = map_ref->active_route_repair;
+	if(map_ref->active_start == NULL || map_ref->active_end == NULL || map_ref->active_edge_cost_function == NULL){
+		map_ref->n_changed_edges = 0;
+		return;
+	}
+
+	//keep the repair's snapshot and only look again at the edges changed in place since the last call
+	bool start_found = false;
+	bool end_found = false;
+	bool reusable = repair != NULL && repair->edge_cost_function == map_ref->active_edge_cost_function;
+	if(reusable){
+		uint32_t start = get_map_graph_node_index(repair->graph,map_ref->active_start,&start_found);
+		uint32_t end = get_map_graph_node_index(repair->graph,map_ref->active_end,&end_found);
+		reusable = start_found && end_found && repair->start == start && repair->end == end;
+	}
+	for(size_t k = 0;reusable && k < map_ref->n_changed_edges;k++){
+		bool edge_found = false;
+		uint32_t edge_index = get_map_graph_edge_index(repair->graph,map_ref->changed_edges[k],&edge_found);
+		if(edge_found){
+			update_route_repair_source_edge(repair,edge_index);
+		}else{
+			reusable = false;
+		}
+	}
+	map_ref->n_changed_edges = 0;
+
+	if(!reusable){
+		map_graph_t * graph = create_map_graph_from_previous(map_ref,(repair != NULL) ? repair->graph : NULL);
+		delete_route_repair(repair);
+		repair = NULL;
+
+		uint32_t start = get_map_graph_node_index(graph,map_ref->active_start,&start_found);
+		uint32_t end = get_map_graph_node_index(graph,map_ref->active_end,&end_found);
+		if(start_found && end_found) repair = create_route_repair(graph,NULL,0,start,end,map_ref->active_edge_cost_function);
+		map_ref->active_route_repair = repair;
+		release_map_graph(graph);
+	}
+
+	if(repair != NULL && repair_route(repair)){
+		map_ref->active_path = extract_repaired_route_path(repair);
+	}
+}
@@ -0,0 +1,191 @@
+#include "schedules.h"
+
+#define DEFAULT_SCHEDULE_INTERVALS_CAPACITY 8
+
+//at most the edge's own schedule and the opening hours of the buildings of its two nodes apply
+#define MAX_EDGE_SCHEDULES 3
+
+schedule_t * create_schedule(void){
+	schedule_t * schedule = (schedule_t*) malloc(sizeof(schedule_t));
+	schedule->intervals_capacity = DEFAULT_SCHEDULE_INTERVALS_CAPACITY;
+	schedule->open = (int32_t*) malloc(sizeof(int32_t)*schedule->intervals_capacity);
+	schedule->close = (int32_t*) malloc(sizeof(int32_t)*schedule->intervals_capacity);
+	schedule->n_intervals = 0;
+	return schedule;
+}
+
+void delete_schedule(schedule_t * schedule){
+	if(schedule == NULL) return;
+
+	free(schedule->open);
+	free(schedule->close);
+	free(schedule);
+}
+
+//A number of seconds wrapped into one week.
+static int64_t wrap_week_seconds(int64_t seconds){
+	int64_t wrapped = seconds % SCHEDULE_WEEK_SECONDS;
+	return (wrapped < 0) ? wrapped + SCHEDULE_WEEK_SECONDS : wrapped;
+}
+
+void add_schedule_interval(schedule_t * schedule,int32_t open_time,int32_t close_time){
+	if(schedule == NULL) return;
+
+	//move both into the week open_time is in, then down to whole minutes
+	int64_t open = wrap_week_seconds(open_time);
+	int64_t close = (int64_t) close_time - (open_time - open);
+	open -= open % SCHEDULE_SLOT_SECONDS;
+	close -= wrap_week_seconds(close) % SCHEDULE_SLOT_SECONDS;
+
+	//keep close after open, at most a week later
+	int64_t length = wrap_week_seconds(close - open);
+	if(length == 0 && close != open) length = SCHEDULE_WEEK_SECONDS;
+	if(length == 0) return;
+
+	if(schedule->n_intervals == schedule->intervals_capacity){
+		schedule->intervals_capacity *= 2;
+		schedule->open = (int32_t*) realloc(schedule->open,sizeof(int32_t)*schedule->intervals_capacity);
+		schedule->close = (int32_t*) realloc(schedule->close,sizeof(int32_t)*schedule->intervals_capacity);
+	}
+	schedule->open[schedule->n_intervals] = (int32_t) open;
+	schedule->close[schedule->n_intervals] = (int32_t) (open + length);
+	schedule->n_intervals++;
+}
+
+static bool schedule_open_at_week_time(const schedule_t * schedule,int64_t week_time){
+	for(size_t i = 0;i < schedule->n_intervals;i++){
+		//intervals may run past the end of the week into the next one
+		if(schedule->open[i] <= week_time && week_time < schedule->close[i]) return true;
+		if(schedule->open[i] <= week_time + SCHEDULE_WEEK_SECONDS && week_time + SCHEDULE_WEEK_SECONDS < schedule->close[i]) return true;
+	}
+	return false;
+}
+
+bool schedule_open_at(const schedule_t * schedule,int64_t time){
+	if(schedule == NULL) return true;
+
+	return schedule_open_at_week_time(schedule,get_schedule_week_time(time));
+}
+
+//Order schedules by their intervals, 0 if they are open at the same times in the same way.
+static int compare_schedules(const schedule_t * a,const schedule_t * b){
+	if(a == b) return 0;
+	if(a == NULL || b == NULL) return (a == NULL) ? -1 : 1;
+	if(a->n_intervals != b->n_intervals) return (a->n_intervals < b->n_intervals) ? -1 : 1;
+
+	for(size_t i = 0;i < a->n_intervals;i++){
+		if(a->open[i] != b->open[i]) return (a->open[i] < b->open[i]) ? -1 : 1;
+		if(a->close[i] != b->close[i]) return (a->close[i] < b->close[i]) ? -1 : 1;
+	}
+	return 0;
+}
+
+/*
+ * Gather the schedules that apply to an edge into key, sorted and without repeats, unused entries NULL.
+ * Sorting by content lets every door with the same hours share one table. Returns false if none apply.
+ */
+static bool get_edge_schedules(const map_graph_t * graph,size_t edge_index,const schedule_t ** key){
+	const building_t * building_a = get_map_node_view_building(get_map_graph_node_view(graph,graph->edge_nodes[2*edge_index]));
+	const building_t * building_b = get_map_node_view_building(get_map_graph_node_view(graph,graph->edge_nodes[2*edge_index+1]));
+	const schedule_t * schedules[MAX_EDGE_SCHEDULES] = {
+		graph->source_edges[edge_index]->schedule,
+		(building_a != NULL) ? building_a->opening_hours : NULL,
+		(building_b != NULL) ? building_b->opening_hours : NULL
+	};
+
+	size_t n_key = 0;
+	for(size_t i = 0;i < MAX_EDGE_SCHEDULES;i++){
+		if(schedules[i] == NULL) continue;
+
+		bool repeat = false;
+		for(size_t k = 0;k < n_key;k++) repeat = repeat || compare_schedules(key[k],schedules[i]) == 0;
+		if(repeat) continue;
+
+		size_t j = n_key;
+		while(j > 0 && compare_schedules(key[j-1],schedules[i]) > 0){
+			key[j] = key[j-1];
+			j--;
+		}
+		key[j] = schedules[i];
+		n_key++;
+	}
+	for(size_t i = n_key;i < MAX_EDGE_SCHEDULES;i++) key[i] = NULL;
+
+	return n_key > 0;
+}
+
+//Fill in the wait of every slot of a week for the slots open in every schedule of key.
+static void compile_schedule_table(const schedule_t * const * key,uint8_t * open,uint16_t * wait_slots){
+	for(size_t s = 0;s < SCHEDULE_WEEK_SLOTS;s++) open[s] = 1;
+	for(size_t k = 0;k < MAX_EDGE_SCHEDULES && key[k] != NULL;k++){
+		for(size_t s = 0;s < SCHEDULE_WEEK_SLOTS;s++){
+			if(open[s] && !schedule_open_at_week_time(key[k],s*SCHEDULE_SLOT_SECONDS)) open[s] = 0;
+		}
+	}
+
+	//walk backwards around the week twice so slots near the end see openings early in the next week
+	uint32_t wait = SCHEDULE_NEVER_OPEN;
+	for(size_t s = 2*SCHEDULE_WEEK_SLOTS;s > 0;s--){
+		size_t slot = (s-1) % SCHEDULE_WEEK_SLOTS;
+		if(open[slot]) wait = 0;
+		else if(wait != SCHEDULE_NEVER_OPEN) wait++;
+		if(s-1 < SCHEDULE_WEEK_SLOTS) wait_slots[slot] = (uint16_t) wait;
+	}
+}
+
+schedule_tables_t * create_schedule_tables(const map_graph_t * graph){
+	schedule_tables_t * tables = (schedule_tables_t*) malloc(sizeof(schedule_tables_t));
+	tables->n_tables = 0;
+	tables->wait_slots = NULL;
+	tables->edge_table = (uint32_t*) malloc(sizeof(uint32_t)*(graph->n_edges+1));
+
+	//the keys of the tables made so far, there are only a few per map
+	size_t keys_capacity = 0;
+	const schedule_t ** keys = NULL;
+	uint8_t * open = NULL;
+
+	for(size_t i = 0;i < graph->n_edges;i++){
+		const schedule_t * key[MAX_EDGE_SCHEDULES];
+		if(!get_edge_schedules(graph,i,key)){
+			tables->edge_table[i] = SCHEDULE_ALWAYS_OPEN;
+			continue;
+		}
+
+		size_t table = 0;
+		while(table < tables->n_tables){
+			const schedule_t ** table_key = &(keys[table*MAX_EDGE_SCHEDULES]);
+			bool same = true;
+			for(size_t k = 0;k < MAX_EDGE_SCHEDULES && same;k++) same = compare_schedules(table_key[k],key[k]) == 0;
+			if(same) break;
+			table++;
+		}
+
+		if(table == tables->n_tables){
+			if(tables->n_tables == keys_capacity){
+				keys_capacity = (keys_capacity == 0) ? 4 : 2*keys_capacity;
+				keys = (const schedule_t**) realloc(keys,sizeof(schedule_t*)*MAX_EDGE_SCHEDULES*keys_capacity);
+				tables->wait_slots = (uint16_t*) realloc(tables->wait_slots,sizeof(uint16_t)*SCHEDULE_WEEK_SLOTS*keys_capacity);
+			}
+			if(open == NULL) open = (uint8_t*) malloc(sizeof(uint8_t)*SCHEDULE_WEEK_SLOTS);
+
+			for(size_t k = 0;k < MAX_EDGE_SCHEDULES;k++) keys[table*MAX_EDGE_SCHEDULES + k] = key[k];
+			compile_schedule_table(key,open,&(tables->wait_slots[table*SCHEDULE_WEEK_SLOTS]));
+			tables->n_tables++;
+		}
+
+		tables->edge_table[i] = (uint32_t) table;
+	}
+
+	free(keys);
+	free(open);
+
+	return tables;
+}
+
+void delete_schedule_tables(schedule_tables_t * tables){
+	if(tables == NULL) return;
+
+	free(tables->wait_slots);
+	free(tables->edge_table);
+	free(tables);
+}
@@ -0,0 +1,55 @@
+#include "search_filter.h"
+
+uint8_t compile_search_filter(const search_filter_options_t * options){
+	if(options == NULL) return SEARCH_FILTER_NONE;
+
+	uint8_t filter = SEARCH_FILTER_NONE;
+	if(options->exclude_stairs) filter |= SEARCH_FILTER_EXCLUDE_STAIRS;
+	if(options->exclude_non_auto_doors) filter |= SEARCH_FILTER_EXCLUDE_NON_AUTO_DOORS;
+	if(options->exclude_interiors) filter |= SEARCH_FILTER_EXCLUDE_INTERIORS;
+
+	return filter;
+}
+
+bool map_graph_edge_excluded_by_filter(const map_graph_t * graph,uint32_t edge_index,uint8_t filter){
+	const map_edge_t * edge_ref = &(graph->edges[edge_index]);
+
+	if((filter & SEARCH_FILTER_EXCLUDE_STAIRS) && edge_ref->type == EDGE_TYPE_STAIRS) return true;
+	if((filter & SEARCH_FILTER_EXCLUDE_NON_AUTO_DOORS) && edge_ref->type == EDGE_TYPE_DOOR) return true;
+
+	//indoors is anything only found in buildings, or an edge with both ends in a building
+	if(filter & SEARCH_FILTER_EXCLUDE_INTERIORS){
+		if(edge_ref->type == EDGE_TYPE_HALLWAY || edge_ref->type == EDGE_TYPE_ELEVATOR_SHAFT) return true;
+		uint16_t flags_a = graph->node_flags[graph->edge_nodes[2*edge_index]];
+		uint16_t flags_b = graph->node_flags[graph->edge_nodes[2*edge_index+1]];
+		if(flags_a & flags_b & NODE_FLAG_INTERIOR) return true;
+	}
+
+	return false;
+}
+
+const uint64_t * get_search_filter_bitset(const map_graph_t * graph,uint8_t filter){
+	if(graph == NULL || filter == SEARCH_FILTER_NONE || filter >= N_SEARCH_FILTERS) return NULL;
+
+	//the graph is shared between threads, only the slot for the cache is ever written
+	uint64_t ** slot = (uint64_t**) &(graph->filter_bitsets[filter]);
+	uint64_t * bitset = __atomic_load_n(slot,__ATOMIC_ACQUIRE);
+	if(bitset != NULL) return bitset;
+
+	size_t n_words = (graph->n_edges + 63)/64 + 1;
+	bitset = (uint64_t*) malloc(sizeof(uint64_t)*n_words);
+	for(size_t i = 0;i < n_words;i++) bitset[i] = 0;
+
+	for(size_t j = 0;j < graph->n_edges;j++){
+		if(!map_graph_edge_excluded_by_filter(graph,j,filter)) bitset[j >> 6] |= ((uint64_t) 1) << (j & 63);
+	}
+
+	//two threads may build the same bitset at once, the loser frees its copy
+	uint64_t * expected = NULL;
+	if(!__atomic_compare_exchange_n(slot,&expected,bitset,false,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE)){
+		free(bitset);
+		return expected;
+	}
+
+	return bitset;
+}
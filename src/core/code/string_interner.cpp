@@ -0,0 +1,179 @@
+#include "string_interner.h"
+#include <string.h>
+
+#define DEFAULT_STRINGS_CAPACITY 64
+#define DEFAULT_STRING_SLOTS 128
+
+//FNV-1a over the bytes of a string.
+static uint32_t hash_string(const char * string,size_t length){
+	uint32_t hash = 2166136261u;
+	for(size_t i = 0;i < length;i++){
+		hash ^= (uint8_t) string[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+string_interner_t * create_string_interner(void){
+	string_interner_t * interner = (string_interner_t*) malloc(sizeof(string_interner_t));
+	interner->strings_capacity = DEFAULT_STRINGS_CAPACITY;
+	interner->strings = (const char**) malloc(sizeof(char*)*interner->strings_capacity);
+	interner->lengths = (uint32_t*) malloc(sizeof(uint32_t)*interner->strings_capacity);
+	interner->hashes = (uint32_t*) malloc(sizeof(uint32_t)*interner->strings_capacity);
+	interner->n_strings = 0;
+
+	interner->n_slots = DEFAULT_STRING_SLOTS;
+	interner->slots = (uint32_t*) malloc(sizeof(uint32_t)*interner->n_slots);
+	for(size_t i = 0;i < interner->n_slots;i++) interner->slots[i] = STRING_ID_NONE;
+
+	interner->blocks = NULL;
+	interner->arena_bytes = 0;
+	return interner;
+}
+
+void delete_string_interner(string_interner_t * interner){
+	if(interner == NULL) return;
+
+	string_arena_block_t * block = interner->blocks;
+	while(block != NULL){
+		string_arena_block_t * next = block->next;
+		free(block->bytes);
+		free(block);
+		block = next;
+	}
+	free(interner->strings);
+	free(interner->lengths);
+	free(interner->hashes);
+	free(interner->slots);
+	free(interner);
+}
+
+//The slot holding a string, or the empty slot it would go in.
+static size_t find_string_slot(const string_interner_t * interner,const char * string,size_t length,uint32_t hash){
+	size_t mask = interner->n_slots - 1;
+	size_t slot = hash & mask;
+	while(interner->slots[slot] != STRING_ID_NONE){
+		uint32_t id = interner->slots[slot];
+		if(interner->hashes[id] == hash && interner->lengths[id] == length && memcmp(interner->strings[id],string,length) == 0) break;
+		slot = (slot+1) & mask;
+	}
+	return slot;
+}
+
+//Copy a string into the arena, starting a new block when the current one is full.
+static const char * store_string(string_interner_t * interner,const char * string,size_t length){
+	string_arena_block_t * block = interner->blocks;
+	if(block == NULL || block->capacity - block->size < length+1){
+		size_t capacity = (length+1 > STRING_ARENA_BLOCK_SIZE) ? length+1 : STRING_ARENA_BLOCK_SIZE;
+		block = (string_arena_block_t*) malloc(sizeof(string_arena_block_t));
+		block->bytes = (char*) malloc(capacity);
+		block->size = 0;
+		block->capacity = capacity;
+		block->next = interner->blocks;
+		interner->blocks = block;
+		interner->arena_bytes += capacity;
+	}
+
+	char * stored = &(block->bytes[block->size]);
+	memcpy(stored,string,length);
+	stored[length] = '\0';
+	block->size += length+1;
+	return stored;
+}
+
+//Double the table once it is half full, so probe runs stay short.
+static void grow_string_slots(string_interner_t * interner){
+	free(interner->slots);
+	interner->n_slots *= 2;
+	interner->slots = (uint32_t*) malloc(sizeof(uint32_t)*interner->n_slots);
+	for(size_t i = 0;i < interner->n_slots;i++) interner->slots[i] = STRING_ID_NONE;
+
+	size_t mask = interner->n_slots - 1;
+	for(size_t id = 0;id < interner->n_strings;id++){
+		size_t slot = interner->hashes[id] & mask;
+		while(interner->slots[slot] != STRING_ID_NONE) slot = (slot+1) & mask;
+		interner->slots[slot] = id;
+	}
+}
+
+uint32_t intern_string(string_interner_t * interner,const char * string){
+	if(interner == NULL || string == NULL) return STRING_ID_NONE;
+
+	size_t length = strlen(string);
+	uint32_t hash = hash_string(string,length);
+	size_t slot = find_string_slot(interner,string,length,hash);
+	if(interner->slots[slot] != STRING_ID_NONE) return interner->slots[slot];
+
+	if(interner->n_strings == interner->strings_capacity){
+		interner->strings_capacity *= 2;
+		interner->strings = (const char**) realloc(interner->strings,sizeof(char*)*interner->strings_capacity);
+		interner->lengths = (uint32_t*) realloc(interner->lengths,sizeof(uint32_t)*interner->strings_capacity);
+		interner->hashes = (uint32_t*) realloc(interner->hashes,sizeof(uint32_t)*interner->strings_capacity);
+	}
+
+	uint32_t id = interner->n_strings;
+	interner->strings[id] = store_string(interner,string,length);
+	interner->lengths[id] = length;
+	interner->hashes[id] = hash;
+	interner->slots[slot] = id;
+	interner->n_strings++;
+
+	if(2*interner->n_strings > interner->n_slots) grow_string_slots(interner);
+	return id;
+}
+
+uint32_t find_interned_string(const string_interner_t * interner,const char * string){
+	if(interner == NULL || string == NULL) return STRING_ID_NONE;
+
+	size_t length = strlen(string);
+	return interner->slots[find_string_slot(interner,string,length,hash_string(string,length))];
+}
+
+const char * get_interned_string(const string_interner_t * interner,uint32_t id){
+	if(interner == NULL || id >= interner->n_strings) return NULL;
+
+	return interner->strings[id];
+}
+
+size_t get_string_interner_bytes(const string_interner_t * interner){
+	if(interner == NULL) return 0;
+
+	size_t per_string = sizeof(char*) + 2*sizeof(uint32_t);
+	size_t n_blocks = 0;
+	for(const string_arena_block_t * block = interner->blocks;block != NULL;block = block->next) n_blocks++;
+	return sizeof(string_interner_t) + interner->arena_bytes + n_blocks*sizeof(string_arena_block_t)
+		+ interner->strings_capacity*per_string + interner->n_slots*sizeof(uint32_t);
+}
+
+uint8_t * write_string_section(const string_interner_t * interner,size_t * buffer_size){
+	uint32_t n_strings = (interner == NULL) ? 0 : interner->n_strings;
+
+	*buffer_size = sizeof(uint32_t);
+	for(size_t id = 0;id < n_strings;id++) *buffer_size += interner->lengths[id]+1;
+
+	uint8_t * buffer = (uint8_t*) malloc(*buffer_size);
+	memcpy(buffer,&n_strings,sizeof(uint32_t));
+	size_t current_offset = sizeof(uint32_t);
+	for(size_t id = 0;id < n_strings;id++){
+		memcpy(buffer+current_offset,interner->strings[id],interner->lengths[id]+1);
+		current_offset += interner->lengths[id]+1;
+	}
+	return buffer;
+}
+
+bool read_string_section(string_interner_t * interner,const uint8_t * buffer,size_t buffer_size){
+	if(interner == NULL || buffer == NULL || buffer_size < sizeof(uint32_t)) return false;
+
+	uint32_t n_strings;
+	memcpy(&n_strings,buffer,sizeof(uint32_t));
+	size_t current_offset = sizeof(uint32_t);
+	for(uint32_t i = 0;i < n_strings;i++){
+		const char * string = (const char*) (buffer+current_offset);
+		const char * end = (const char*) memchr(string,'\0',buffer_size - current_offset);
+		if(end == NULL) return false;
+
+		intern_string(interner,string);
+		current_offset += (end - string)+1;
+	}
+	return true;
+}
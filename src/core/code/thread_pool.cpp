@@ -0,0 +1,193 @@
+#include "thread_pool.h"
+#include <unistd.h>
+
+#define RANGE_FIRST(range) ((uint32_t)((range) >> 32))
+#define RANGE_END(range) ((uint32_t)((range) & 0xFFFFFFFFu))
+#define MAKE_RANGE(first,end) ((((uint64_t)(first)) << 32) | ((uint64_t)(end)))
+
+typedef struct Thread_Pool_Start{
+	thread_pool_t * pool;
+	size_t worker_index;
+} thread_pool_start_t;
+
+size_t get_number_of_cpus(void){
+	long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	return (n_cpus < 1) ? 1 : (size_t) n_cpus;
+}
+
+/*
+ * Take the next task from the front of a worker's own range
+ */
+static bool pop_own_task(thread_pool_worker_t * worker,uint32_t * task_out){
+	uint64_t range = __atomic_load_n(&(worker->range),__ATOMIC_ACQUIRE);
+
+	while(RANGE_FIRST(range) < RANGE_END(range)){
+		uint64_t taken = MAKE_RANGE(RANGE_FIRST(range)+1,RANGE_END(range));
+		if(__atomic_compare_exchange_n(&(worker->range),&range,taken,false,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE)){
+			*task_out = RANGE_FIRST(range);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Move the back half of the biggest other range into this worker's range
+ */
+static bool steal_tasks(thread_pool_t * pool,size_t thief_index){
+	while(true){
+		size_t victim_index = pool->n_workers;
+		uint64_t victim_range = 0;
+		uint32_t most_remaining = 0;
+
+		for(size_t i = 0;i < pool->n_workers;i++){
+			if(i == thief_index) continue;
+			uint64_t range = __atomic_load_n(&(pool->workers[i].range),__ATOMIC_ACQUIRE);
+			uint32_t remaining = RANGE_END(range) - RANGE_FIRST(range);
+			if(RANGE_FIRST(range) < RANGE_END(range) && remaining > most_remaining){
+				most_remaining = remaining;
+				victim_index = i;
+				victim_range = range;
+			}
+		}
+
+		if(victim_index == pool->n_workers) return false;//nothing left anywhere
+
+		uint32_t first = RANGE_FIRST(victim_range);
+		uint32_t end = RANGE_END(victim_range);
+		uint32_t split = end - (uint32_t) ((((uint64_t) most_remaining)+1)/2);
+		uint64_t kept = MAKE_RANGE(first,split);
+
+		if(__atomic_compare_exchange_n(&(pool->workers[victim_index].range),&victim_range,kept,false,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE)){
+			__atomic_store_n(&(pool->workers[thief_index].range),MAKE_RANGE(split,end),__ATOMIC_RELEASE);
+			return true;
+		}
+		//the victim changed under us, look again
+	}
+}
+
+static void run_worker_tasks(thread_pool_t * pool,size_t worker_index){
+	thread_pool_worker_t * worker = &(pool->workers[worker_index]);
+	uint32_t task;
+
+	while(true){
+		while(pop_own_task(worker,&task)){
+			pool->task(pool->task_offset + task,worker_index,pool->user_data);
+		}
+		if(!steal_tasks(pool,worker_index)) break;
+	}
+}
+
+static void * thread_pool_worker_main(void * argument){
+	thread_pool_start_t * start = (thread_pool_start_t*) argument;
+	thread_pool_t * pool = start->pool;
+	size_t worker_index = start->worker_index;
+	free(start);
+
+	uint64_t last_generation = 0;
+
+	pthread_mutex_lock(&(pool->lock));
+	while(true){
+		while(pool->job_generation == last_generation && !pool->shutting_down){
+			pthread_cond_wait(&(pool->job_ready),&(pool->lock));
+		}
+		if(pool->shutting_down) break;
+		last_generation = pool->job_generation;
+
+		pthread_mutex_unlock(&(pool->lock));
+		run_worker_tasks(pool,worker_index);
+		pthread_mutex_lock(&(pool->lock));
+
+		pool->n_busy_workers--;
+		if(pool->n_busy_workers == 0) pthread_cond_signal(&(pool->job_done));
+	}
+	pthread_mutex_unlock(&(pool->lock));
+
+	return NULL;
+}
+
+thread_pool_t * create_thread_pool(size_t n_workers){
+	thread_pool_t * pool = (thread_pool_t*) malloc(sizeof(thread_pool_t));
+
+	pool->n_workers = (n_workers == 0) ? get_number_of_cpus() : n_workers;
+	pool->workers = (thread_pool_worker_t*) malloc(sizeof(thread_pool_worker_t)*pool->n_workers);
+
+	pthread_mutex_init(&(pool->lock),NULL);
+	pthread_cond_init(&(pool->job_ready),NULL);
+	pthread_cond_init(&(pool->job_done),NULL);
+	pool->job_generation = 0;
+	pool->task = NULL;
+	pool->user_data = NULL;
+	pool->n_busy_workers = 0;
+	pool->task_offset = 0;
+	pool->max_chunk_tasks = THREAD_POOL_MAX_CHUNK_TASKS;
+	pool->shutting_down = false;
+
+	for(size_t i = 0;i < pool->n_workers;i++){
+		pool->workers[i].range = MAKE_RANGE(0,0);
+
+		thread_pool_start_t * start = (thread_pool_start_t*) malloc(sizeof(thread_pool_start_t));
+		start->pool = pool;
+		start->worker_index = i;
+		pthread_create(&(pool->workers[i].thread),NULL,thread_pool_worker_main,start);
+	}
+
+	return pool;
+}
+
+void delete_thread_pool(thread_pool_t * pool){
+	if(pool == NULL) return;
+
+	pthread_mutex_lock(&(pool->lock));
+	pool->shutting_down = true;
+	pthread_cond_broadcast(&(pool->job_ready));
+	pthread_mutex_unlock(&(pool->lock));
+
+	for(size_t i = 0;i < pool->n_workers;i++){
+		pthread_join(pool->workers[i].thread,NULL);
+	}
+
+	pthread_cond_destroy(&(pool->job_done));
+	pthread_cond_destroy(&(pool->job_ready));
+	pthread_mutex_destroy(&(pool->lock));
+	free(pool->workers);
+	free(pool);
+}
+
+void run_thread_pool_tasks(thread_pool_t * pool,size_t n_tasks,void (*task)(size_t task_index,size_t worker_index,void * user_data),void * user_data){
+	if(pool == NULL || task == NULL || n_tasks == 0) return;
+
+	pthread_mutex_lock(&(pool->lock));
+	pool->task = task;
+	pool->user_data = user_data;
+
+	//a range only holds 32 bit task numbers, so bigger batches go in chunks
+	size_t max_chunk_tasks = pool->max_chunk_tasks;
+	if(max_chunk_tasks == 0 || max_chunk_tasks > THREAD_POOL_MAX_CHUNK_TASKS) max_chunk_tasks = THREAD_POOL_MAX_CHUNK_TASKS;
+	for(size_t offset = 0;offset < n_tasks;offset += max_chunk_tasks){
+		size_t n_chunk_tasks = n_tasks - offset;
+		if(n_chunk_tasks > max_chunk_tasks) n_chunk_tasks = max_chunk_tasks;
+
+		//hand every worker an equal contiguous share, stealing evens out the rest
+		for(size_t i = 0;i < pool->n_workers;i++){
+			uint64_t first = ((uint64_t) n_chunk_tasks*i)/pool->n_workers;
+			uint64_t end = ((uint64_t) n_chunk_tasks*(i+1))/pool->n_workers;
+			__atomic_store_n(&(pool->workers[i].range),MAKE_RANGE(first,end),__ATOMIC_RELEASE);
+		}
+
+		pool->task_offset = offset;
+		pool->n_busy_workers = pool->n_workers;
+		pool->job_generation++;
+		pthread_cond_broadcast(&(pool->job_ready));
+
+		while(pool->n_busy_workers > 0){
+			pthread_cond_wait(&(pool->job_done),&(pool->lock));
+		}
+	}
+
+	pool->task_offset = 0;
+	pool->task = NULL;
+	pool->user_data = NULL;
+	pthread_mutex_unlock(&(pool->lock));
+}
@@ -0,0 +1,59 @@
+#ifndef BUILDING_ROUTES_H
+#define BUILDING_ROUTES_H
+
+#include "routing.h"
+
+typedef struct Building_Portals building_portals_t;
+typedef struct Building_Routes building_routes_t;
+
+//node_building value of a node that is not in any building
+#define NODE_OUTDOORS UINT32_MAX
+
+/*
+ * The ways in and out of one building and what it costs to cross the building between them
+ */
+struct Building_Portals{
+	//only compared against, never dereferenced
+	const building_t * building;
+
+	//graph node indices of the building's nodes that have an edge leading out of the building
+	uint32_t n_entrances;
+	uint32_t * entrances;
+
+	//entrance_costs[profile][i*n_entrances + j] is the cheapest way from entrance i to entrance j
+	//staying inside the building, EDGE_COST_IMPASSABLE if there is none
+	float * entrance_costs[N_ROUTE_PROFILES];
+
+	//changes whenever an edge inside the building or an entrance changes
+	uint64_t interior_checksum;
+};
+
+/*
+ * Two level view of a graph: the outdoors plus a table of entrance to entrance costs for every building.
+ * A search only has to go inside the buildings it starts or ends in, the rest are crossed with the tables.
+ */
+struct Building_Routes{
+	size_t n_buildings;
+	building_portals_t * buildings;
+
+	//index into buildings of every graph node's building, NODE_OUTDOORS for nodes outside
+	uint32_t * node_building;
+
+	//index into its building's entrances of every graph node, UINT32_MAX if the node is not an entrance
+	uint32_t * node_entrance;
+
+	//how many buildings had their tables worked out, the rest were copied from the previous snapshot
+	size_t n_rebuilt;
+};
+
+/*
+ * Find the entrances of every building of a graph and work out their cost tables. The graph's edge
+ * weights must already exist. If previous is not NULL, buildings whose inside and entrances have not
+ * changed since that snapshot keep their old tables.
+ */
+building_routes_t * create_building_routes(const map_graph_t * graph,const map_graph_t * previous);
+
+//Delete building routes.
+void delete_building_routes(building_routes_t * routes);
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef CAMPUS_GENERATOR_H
+#define CAMPUS_GENERATOR_H
+
+#include "map.h"
+
+typedef struct Campus_Options campus_options_t;
+typedef struct Campus_Stats campus_stats_t;
+
+//the seed default_campus_options uses, any seed gives the same map every time
+#define DEFAULT_CAMPUS_SEED 447
+
+//blocks of the default campus along each side
+#define DEFAULT_CAMPUS_BLOCKS 4
+
+//side of a block and width of the streets between blocks in degrees, a block is about 100 meters across
+#define DEFAULT_CAMPUS_BLOCK_SIZE 0.0009
+#define DEFAULT_CAMPUS_STREET_WIDTH 0.0002
+
+//sidewalk edges along each side of a block and hallway nodes along each floor of a building
+#define DEFAULT_CAMPUS_BLOCK_NODES 8
+#define DEFAULT_CAMPUS_HALLWAY_NODES 12
+
+//tallest building, buildings get 1 to this many floors
+#define DEFAULT_CAMPUS_MAX_FLOORS 5
+
+/*
+ * A campus is a grid of blocks with a sidewalk around every block and crosswalks between the corners of
+ * neighbouring blocks. A block holds a building, a pond or else a park with a path across it.
+ */
+struct Campus_Options{
+	uint64_t seed;
+
+	//south west corner of the first block
+	cord_t origin;
+	uint32_t blocks_x;
+	uint32_t blocks_y;
+	double block_size;
+	double street_width;
+	uint32_t block_nodes;
+	uint32_t hallway_nodes;
+	uint8_t max_floors;
+
+	//chance of a block holding a building or a pond, the rest are parks
+	double building_probability;
+	double pond_probability;
+
+	//chance of a building having an elevator next to its stairs, of a door being automatic and of a sidewalk edge being a ramp
+	double elevator_probability;
+	double auto_door_probability;
+	double ramp_probability;
+
+	//put the nodes of the whole map in MAP_NODE_ORDER_HILBERT order afterwards, renumbering the nodes already in it
+	bool reorder_nodes;
+};
+
+struct Campus_Stats{
+	size_t n_blocks;
+	size_t n_buildings;
+	size_t n_parks;
+	size_t n_ponds;
+
+	//what was added to the map
+	size_t n_nodes;
+	size_t n_edges;
+	size_t n_mpos;
+
+	//edges added of every EDGE_TYPE_*
+	size_t n_edges_by_type[N_EDGE_TYPES];
+};
+
+//Options with the DEFAULT_CAMPUS_* values and probabilities that look like a real campus.
+campus_options_t default_campus_options(void);
+
+//The default options with as many blocks as it takes for the campus to have about n_nodes nodes, from a few hundred up to millions.
+campus_options_t campus_options_for_size(size_t n_nodes,uint64_t seed);
+
+//The number of nodes a campus is expected to have with these options, the actual number depends on the seed.
+double get_expected_campus_nodes(const campus_options_t * options);
+
+/*
+ * Add a made up campus to a map. Every building has a hallway on each floor, stairs at both ends of the hallways,
+ * maybe an elevator in the middle and a door to the sidewalk at both ends of its ground floor. Every other hallway
+ * node is a named room like "Hall 3 204". The same options and seed always give the same map.
+ * Returns false if the options have no blocks, fewer than 2 block or hallway nodes, no floors or more than 127 floors.
+ * stats may be NULL.
+ */
+bool generate_campus_map(map_t * map,const campus_options_t * options,campus_stats_t * stats);
+
+#endif
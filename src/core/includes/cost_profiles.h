@@ -0,0 +1,252 @@
+#ifndef COST_PROFILES_H
+#define COST_PROFILES_H
+
+#include "routing.h"
+#include "edge_weights.h"
+#include "search_filter.h"
+#include "floor_layers.h"
+#include "building_routes.h"
+#include "edge_closures.h"
+#include "schedules.h"
+
+/*
+ * Compile time edge cost profiles. The edge weights of every snapshot are measured with these tables,
+ * and the routing engine is a template over the *_Cost_Profile structs at the bottom so the cost of an
+ * edge is inlined into the search loop instead of a call through map_t::active_edge_cost_function.
+ *
+ * Every table is indexed by EDGE_TYPE_*, index 0 is used for unknown types.
+ * The calculate_*_edge_cost functions are defined with these tables so both always agree.
+ */
+
+static inline double get_profile_edge_cost(const double * type_multipliers,const map_edge_t * edge_ref){
+	double multiplier = type_multipliers[(edge_ref->type < N_EDGE_TYPES) ? edge_ref->type : 0];
+	if(isinf(multiplier)) return multiplier;//impassable, no need to measure it
+
+	return get_map_edge_length(edge_ref)*multiplier;
+}
+
+struct Wheelchair_Cost_Profile{
+	static constexpr uint8_t profile = ROUTE_PROFILE_WHEELCHAIR;
+	static constexpr double type_multipliers[N_EDGE_TYPES] = {
+		1.0,//unknown
+		1.0,//sidewalk
+		3.0,//road
+		EDGE_COST_IMPASSABLE,//stairs
+		1.1,//ramp
+		1.0,//hallway
+		1.0,//elevator shaft
+		1.0,//overpass
+		2.0,//door
+		1.0,//automatic door
+		1.2//crosswalk
+	};
+
+	static double edge_cost(const map_edge_t * edge_ref){
+		return get_profile_edge_cost(type_multipliers,edge_ref);
+	}
+};
+
+struct Walker_Cost_Profile{
+	static constexpr uint8_t profile = ROUTE_PROFILE_WALKER;
+	static constexpr double type_multipliers[N_EDGE_TYPES] = {
+		1.0,//unknown
+		1.0,//sidewalk
+		2.0,//road
+		1.2,//stairs
+		1.0,//ramp
+		1.0,//hallway
+		1.5,//elevator shaft, waiting for the elevator
+		1.0,//overpass
+		1.0,//door
+		1.0,//automatic door
+		1.0//crosswalk
+	};
+
+	static double edge_cost(const map_edge_t * edge_ref){
+		return get_profile_edge_cost(type_multipliers,edge_ref);
+	}
+};
+
+struct Deliverer_Cost_Profile{
+	static constexpr uint8_t profile = ROUTE_PROFILE_DELIVERER;
+	static constexpr double type_multipliers[N_EDGE_TYPES] = {
+		1.0,//unknown
+		1.0,//sidewalk
+		1.5,//road
+		EDGE_COST_IMPASSABLE,//stairs
+		1.2,//ramp
+		1.0,//hallway
+		1.0,//elevator shaft
+		1.0,//overpass
+		1.5,//door
+		1.0,//automatic door
+		1.0//crosswalk
+	};
+
+	static double edge_cost(const map_edge_t * edge_ref){
+		return get_profile_edge_cost(type_multipliers,edge_ref);
+	}
+};
+
+struct Driver_Cost_Profile{
+	static constexpr uint8_t profile = ROUTE_PROFILE_DRIVER;
+	static constexpr double type_multipliers[N_EDGE_TYPES] = {
+		EDGE_COST_IMPASSABLE,//unknown
+		EDGE_COST_IMPASSABLE,//sidewalk
+		1.0,//road
+		EDGE_COST_IMPASSABLE,//stairs
+		EDGE_COST_IMPASSABLE,//ramp
+		EDGE_COST_IMPASSABLE,//hallway
+		EDGE_COST_IMPASSABLE,//elevator shaft
+		EDGE_COST_IMPASSABLE,//overpass
+		EDGE_COST_IMPASSABLE,//door
+		EDGE_COST_IMPASSABLE,//automatic door
+		EDGE_COST_IMPASSABLE//crosswalk
+	};
+
+	static double edge_cost(const map_edge_t * edge_ref){
+		return get_profile_edge_cost(type_multipliers,edge_ref);
+	}
+};
+
+//The multiplier table of a ROUTE_PROFILE_*, NULL for an unknown profile.
+static inline const double * get_profile_type_multipliers(uint8_t profile){
+	switch(profile){
+		case ROUTE_PROFILE_WHEELCHAIR: return Wheelchair_Cost_Profile::type_multipliers;
+		case ROUTE_PROFILE_WALKER: return Walker_Cost_Profile::type_multipliers;
+		case ROUTE_PROFILE_DELIVERER: return Deliverer_Cost_Profile::type_multipliers;
+		case ROUTE_PROFILE_DRIVER: return Driver_Cost_Profile::type_multipliers;
+		default: return NULL;
+	}
+}
+
+/*
+ * Costs of a built in profile, read from the weights measured when the snapshot was taken
+ */
+struct Edge_Weights_Cost_Profile{
+	const float * weights;
+
+	double edge_cost(const map_graph_t * graph,uint32_t edge_index) const {
+		return weights[edge_index];
+	}
+};
+
+/*
+ * Fallback for cost functions that are only known at runtime, every edge goes through the pointer
+ */
+struct Function_Pointer_Cost_Profile{
+	edge_cost_function_t edge_cost_function;
+
+	double edge_cost(const map_graph_t * graph,uint32_t edge_index) const {
+		return edge_cost_function(&(graph->edges[edge_index]));
+	}
+};
+
+/*
+ * Any of the profiles above with the edges left out by a search filter made impassable.
+ * The filter is a bitset so this is one load and a bit test per relaxation.
+ */
+template<typename Cost_Profile>
+struct Filtered_Cost_Profile{
+	Cost_Profile cost_profile;
+	const uint64_t * allowed_edges;
+
+	double edge_cost(const map_graph_t * graph,uint32_t edge_index) const {
+		if(!search_filter_allows(allowed_edges,edge_index)) return EDGE_COST_IMPASSABLE;
+		return cost_profile.edge_cost(graph,edge_index);
+	}
+};
+
+/*
+ * Any of the profiles above kept to a set of floor layers, edges to a layer that is not
+ * allowed are impassable so its nodes are never reached.
+ */
+template<typename Cost_Profile>
+struct Floor_Layers_Cost_Profile{
+	Cost_Profile cost_profile;
+	const uint32_t * node_layer;
+	const uint8_t * allowed_layers;
+
+	double edge_cost(const map_graph_t * graph,uint32_t edge_index) const {
+		if(!allowed_layers[node_layer[graph->edge_nodes[2*edge_index]]]) return EDGE_COST_IMPASSABLE;
+		if(!allowed_layers[node_layer[graph->edge_nodes[2*edge_index+1]]]) return EDGE_COST_IMPASSABLE;
+		return cost_profile.edge_cost(graph,edge_index);
+	}
+};
+
+/*
+ * Any of the profiles above with the edges closed at some time made impassable
+ */
+template<typename Cost_Profile>
+struct Closures_Cost_Profile{
+	Cost_Profile cost_profile;
+	const edge_closures_t * closures;
+	int64_t time;
+
+	double edge_cost(const map_graph_t * graph,uint32_t edge_index) const {
+		if(map_graph_edge_closed(closures,edge_index,time)) return EDGE_COST_IMPASSABLE;
+		return cost_profile.edge_cost(graph,edge_index);
+	}
+};
+
+/*
+ * Any of the profiles above for a route leaving at departure_time, with every edge looked up in the schedule
+ * tables and the closures at the time the route gets to it. A closed edge costs the wait until it opens on top
+ * of its own cost, an edge whose closure ends is waited for the same way. Schedules and closures change on whole
+ * seconds, so an edge is open at a moment if it is open at the whole second before, and a wait lasts up to the
+ * exact second the edge opens. Getting to an edge later never gets over it sooner, which keeps the search exact.
+ * Costs depend on the cost so far, so only run_timed_route_search uses this profile.
+ */
+template<typename Cost_Profile>
+struct Schedules_Cost_Profile{
+	Cost_Profile cost_profile;
+	const schedule_tables_t * tables;
+	int64_t departure_time;
+	double meters_per_second;
+
+	//if not NULL edges closed when the route gets to them are waited for until their closure ends
+	const edge_closures_t * closures;
+
+	double edge_cost_at(const map_graph_t * graph,uint32_t edge_index,double cost_so_far) const {
+		double edge_cost = cost_profile.edge_cost(graph,edge_index);
+		if(isinf(edge_cost)) return edge_cost;
+
+		double seconds_so_far = cost_so_far/meters_per_second;
+		int64_t time = departure_time + (int64_t) floor(seconds_so_far);
+
+		double wait_seconds = get_schedule_wait_seconds(tables,edge_index,time);
+		if(isinf(wait_seconds)) return EDGE_COST_IMPASSABLE;
+		int64_t open_time = time + (int64_t) wait_seconds;
+
+		//past a closure the schedule may have closed the edge in the meantime, the closure can not come back
+		if(closures != NULL){
+			int64_t reopen_time = get_edge_reopen_time(closures,edge_index,open_time);
+			if(reopen_time == CLOSURE_ALWAYS_END) return EDGE_COST_IMPASSABLE;
+			if(reopen_time != open_time){
+				wait_seconds = get_schedule_wait_seconds(tables,edge_index,reopen_time);
+				if(isinf(wait_seconds)) return EDGE_COST_IMPASSABLE;
+				open_time = reopen_time + (int64_t) wait_seconds;
+			}
+		}
+
+		if(open_time == time) return edge_cost;
+		return edge_cost + ((double) (open_time - departure_time) - seconds_so_far)*meters_per_second;
+	}
+};
+
+/*
+ * Edge weights of a profile restricted to the inside of one building
+ */
+struct Building_Interior_Cost_Profile{
+	const float * weights;
+	const uint32_t * node_building;
+	uint32_t building_index;
+
+	double edge_cost(const map_graph_t * graph,uint32_t edge_index) const {
+		if(node_building[graph->edge_nodes[2*edge_index]] != building_index) return EDGE_COST_IMPASSABLE;
+		if(node_building[graph->edge_nodes[2*edge_index+1]] != building_index) return EDGE_COST_IMPASSABLE;
+		return weights[edge_index];
+	}
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef DISTANCE_MATRIX_H
+#define DISTANCE_MATRIX_H
+
+#include "routing.h"
+#include "thread_pool.h"
+
+/*
+ * One-to-many: fill row[j] with the cost from source to targets[j] for a ROUTE_PROFILE_* using a single search tree
+ * that stops as soon as every target is settled. Unreachable targets are INFINITY.
+ * Returns the number of reachable targets. A source or target outside the graph, a profile that is not a
+ * ROUTE_PROFILE_* or a context made for fewer nodes than the graph has gives a row of INFINITY and 0.
+ */
+size_t compute_distance_row(const map_graph_t * graph,route_search_context_t * context,uint32_t source,const uint32_t * targets,size_t n_targets,uint8_t profile,float * row);
+
+/*
+ * Many-to-many: a dense row-major n_sources by n_targets matrix of costs for a ROUTE_PROFILE_*.
+ * Element [i*n_targets + j] is the cost from sources[i] to targets[j], INFINITY if unreachable.
+ *
+ * Every distinct node is searched from only once, and because edges cost the same in both directions
+ * the searches run from whichever side has fewer distinct nodes and the result is transposed. Each of
+ * those rows is its own one-to-many search, nothing else is shared between them. The searches run in
+ * parallel on the pool.
+ * Free the result with free().
+ */
+float * compute_distance_matrix(thread_pool_t * pool,const map_graph_t * graph,const uint32_t * sources,size_t n_sources,const uint32_t * targets,size_t n_targets,uint8_t profile);
+
+//Write a matrix as comma separated values, one row per line. Unreachable entries are written as inf.
+void save_distance_matrix_csv(const float * matrix,size_t n_rows,size_t n_columns,FILE * file);
+
+#endif
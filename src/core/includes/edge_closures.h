@@ -0,0 +1,95 @@
+#ifndef EDGE_CLOSURES_H
+#define EDGE_CLOSURES_H
+
+#include "map_graph.h"
+
+typedef struct Edge_Closures edge_closures_t;
+
+//time windows of closures that have no start or no end
+#define CLOSURE_ALWAYS_START INT64_MIN
+#define CLOSURE_ALWAYS_END INT64_MAX
+
+/*
+ * Edges of a graph snapshot that are temporarily out of use, like a broken elevator or a sidewalk
+ * closed for construction, laid over the graph without changing it. Every derived structure of the
+ * graph stays valid: searches skip closed edges with one bit test, and buildings with closed edges
+ * inside are searched directly instead of crossed with their entrance tables.
+ *
+ * Closing and reopening an edge is O(1) and may happen while searches are running on other threads,
+ * a search sees the closure from its next relaxation of that edge on. The window of an edge is guarded
+ * by a sequence number so a search never sees the start of one window with the end of another.
+ */
+struct Edge_Closures{
+	//the closures hold a reference to their graph
+	map_graph_t * graph;
+
+	//bit j of word j/64 is set while edge j has a closure
+	uint64_t * closed_edges;
+
+	//when the closure of every edge applies, in seconds. Only meaningful while its bit is set.
+	int64_t * window_start;
+	int64_t * window_end;
+
+	//odd while the window of an edge is being written, read both ends with get_edge_closure_window
+	uint32_t * window_sequence;
+
+	//number of closed edges inside every building of graph->building_routes
+	uint32_t * building_closures;
+
+	size_t n_closed;
+};
+
+//Create an empty set of closures for a graph.
+edge_closures_t * create_edge_closures(map_graph_t * graph);
+
+/*
+ * Move every closure of previous over to a newer snapshot of the same map. Closed edges that are no
+ * longer in the map are dropped.
+ */
+edge_closures_t * carry_edge_closures(const edge_closures_t * previous,map_graph_t * graph);
+
+//Delete closures and release their graph.
+void delete_edge_closures(edge_closures_t * closures);
+
+//Close edge j from start_time up to but not including end_time, replacing any closure it had. O(1).
+void close_map_graph_edge(edge_closures_t * closures,uint32_t edge_index,int64_t start_time,int64_t end_time);
+
+//Remove the closure of edge j if it has one. O(1).
+void reopen_map_graph_edge(edge_closures_t * closures,uint32_t edge_index);
+
+//The window of edge j's closure as one consistent pair, retrying while a writer is changing it.
+static inline void get_edge_closure_window(const edge_closures_t * closures,uint32_t edge_index,int64_t * start_out,int64_t * end_out){
+	uint32_t before,after;
+	do{
+		before = __atomic_load_n(&(closures->window_sequence[edge_index]),__ATOMIC_ACQUIRE);
+		*start_out = __atomic_load_n(&(closures->window_start[edge_index]),__ATOMIC_RELAXED);
+		*end_out = __atomic_load_n(&(closures->window_end[edge_index]),__ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		after = __atomic_load_n(&(closures->window_sequence[edge_index]),__ATOMIC_RELAXED);
+	}while((before & 1) || before != after);
+}
+
+//Is edge j closed at a time?
+static inline bool map_graph_edge_closed(const edge_closures_t * closures,uint32_t edge_index,int64_t time){
+	uint64_t word = __atomic_load_n(&(closures->closed_edges[edge_index >> 6]),__ATOMIC_ACQUIRE);
+	if(!((word >> (edge_index & 63)) & 1)) return false;
+
+	int64_t start,end;
+	get_edge_closure_window(closures,edge_index,&start,&end);
+	return start <= time && time < end;
+}
+
+//The first time from time on that edge j is not closed, CLOSURE_ALWAYS_END if its closure never ends.
+static inline int64_t get_edge_reopen_time(const edge_closures_t * closures,uint32_t edge_index,int64_t time){
+	uint64_t word = __atomic_load_n(&(closures->closed_edges[edge_index >> 6]),__ATOMIC_ACQUIRE);
+	if(!((word >> (edge_index & 63)) & 1)) return time;
+
+	int64_t start,end;
+	get_edge_closure_window(closures,edge_index,&start,&end);
+	return (start <= time && time < end) ? end : time;
+}
+
+//Does a building of graph->building_routes have a closed edge inside? Its entrance table can not be trusted then.
+bool building_has_closures(const edge_closures_t * closures,uint32_t building_index);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef EDGE_WEIGHTS_H
+#define EDGE_WEIGHTS_H
+
+#include "routing.h"
+
+typedef struct Edge_Weights edge_weights_t;
+
+/*
+ * The cost of every edge of a graph for every ROUTE_PROFILE_*, worked out once when the snapshot is
+ * taken so a search reads one float per edge instead of measuring the edge again on every relaxation.
+ */
+struct Edge_Weights{
+	size_t n_edges;
+
+	//length of every edge in meters, see get_map_edge_length
+	float * lengths;
+
+	//profile_weights[profile][edge] is the cost of the edge, EDGE_COST_IMPASSABLE if it can not be used
+	float * profile_weights[N_ROUTE_PROFILES];
+
+	//how many edges had to be measured, the rest were copied from the previous snapshot
+	size_t n_refreshed;
+};
+
+/*
+ * Work out the weights of every edge of a graph. If previous is not NULL, edges whose type and end
+ * points are unchanged since that snapshot keep their old weights and only the rest are measured.
+ */
+edge_weights_t * create_edge_weights(const map_graph_t * graph,const map_graph_t * previous);
+
+//Delete edge weights.
+void delete_edge_weights(edge_weights_t * weights);
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef FLOOR_LAYERS_H
+#define FLOOR_LAYERS_H
+
+#include "map_graph.h"
+
+typedef struct Floor_Layer floor_layer_t;
+typedef struct Floor_Layers floor_layers_t;
+
+//most entries of a neighbouring floor whose shortcuts are measured, a floor with more is taken to have shortcuts
+#define FLOOR_LAYER_MAX_MEASURED_ENTRIES 16
+
+/*
+ * The nodes of a graph that share a building and a floor. Outdoor nodes have no building and
+ * no floor and form a layer of their own.
+ */
+struct Floor_Layer{
+	//only compared against, never dereferenced
+	const building_t * building;
+	int8_t floor_number;
+
+	//this layer's nodes are layer_nodes[first_node] up to layer_nodes[first_node+n_nodes-1]
+	uint32_t first_node;
+	uint32_t n_nodes;
+
+	//edges with both ends on this layer are layer_edges[first_edge] up to layer_edges[first_edge+n_edges-1]
+	uint32_t first_edge;
+	uint32_t n_edges;
+
+	//edges to other layers are layer_portals[first_portal] up to layer_portals[first_portal+n_portals-1]
+	uint32_t first_portal;
+	uint32_t n_portals;
+
+	//distinct layers reached through the portals are layer_neighbours[first_neighbour] onwards
+	uint32_t first_neighbour;
+	uint32_t n_neighbours;
+};
+
+/*
+ * A graph split into floors. Every layer owns a contiguous range of node and edge indices and the
+ * stairs, elevators and doors between layers are kept apart as portals, so one floor can be read in
+ * time proportional to its size and searches can leave out floors that can not be on a path.
+ */
+struct Floor_Layers{
+	size_t n_layers;
+	floor_layer_t * layers;
+
+	//graph node indices grouped by layer, and the layer of every graph node
+	uint32_t * layer_nodes;
+	uint32_t * node_layer;
+
+	//graph edge indices with both ends on the same layer, grouped by layer
+	uint32_t * layer_edges;
+
+	//graph edge indices between two layers, grouped by layer. Every portal is listed under both of its layers.
+	uint32_t * layer_portals;
+
+	//the distinct neighbouring layers of every layer, and how many portals lead to each of them
+	uint32_t * layer_neighbours;
+	uint32_t * layer_neighbour_portals;
+
+	//how many distinct nodes of the neighbour the portals end at
+	uint32_t * layer_neighbour_entries;
+
+	//bit p is set if going from the neighbour through this layer and back can be shorter for ROUTE_PROFILE_ p than
+	//staying on the neighbour. Worked out with searches between the entries for floors of the same building with
+	//up to FLOOR_LAYER_MAX_MEASURED_ENTRIES entries, any other neighbour with more than one entry has every bit set.
+	uint8_t * layer_neighbour_shortcuts;
+
+	//total number of edges between layers
+	size_t n_portal_edges;
+};
+
+//Split a graph into floor layers.
+floor_layers_t * create_floor_layers(const map_graph_t * graph);
+
+//Delete floor layers.
+void delete_floor_layers(floor_layers_t * layers);
+
+//Find the layer of a building's floor. building is NULL for outdoors. found is false if there is no such layer.
+uint32_t find_floor_layer(const floor_layers_t * layers,const building_t * building,int8_t floor_number,bool * found);
+
+/*
+ * Mark every layer that can be part of a shortest path between two graph nodes in allowed_layers (one byte per
+ * layer). A layer left with a single neighbouring layer is left out unless it holds the start or the end and
+ * either all its portals end at one node of the neighbour, so a path through it comes back where it started, or
+ * profile is a ROUTE_PROFILE_* for which no path from the neighbour through the layer and back is shorter than
+ * staying on the neighbour. Such layers are peeled off repeatedly, which leaves out things like the upper floors
+ * of a building that is only passed through. Pass N_ROUTE_PROFILES for any other cost function, only the first
+ * rule is used then. Returns the number of marked layers.
+ */
+size_t mark_floor_layers_for_route(const floor_layers_t * layers,uint32_t start,uint32_t end,uint8_t profile,uint8_t * allowed_layers);
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef IMAGE_CACHE_H
+#define IMAGE_CACHE_H
+
+#include <pthread.h>
+#include "map.h"
+
+typedef struct Cached_Image cached_image_t;
+typedef struct Image_Cache_Stats image_cache_stats_t;
+typedef struct Image_Cache image_cache_t;
+
+//the sizes pictures are decoded to, every size of a picture is cached on its own
+#define IMAGE_SIZE_ICON 0
+#define IMAGE_SIZE_THUMBNAIL 1
+#define IMAGE_SIZE_PREVIEW 2
+#define N_IMAGE_SIZES 3
+
+//the longest side of every IMAGE_SIZE_*, pictures are scaled down to fit and never scaled up
+#define IMAGE_ICON_SIDE 64
+#define IMAGE_THUMBNAIL_SIDE 256
+#define IMAGE_PREVIEW_SIDE 1024
+
+//memory a cache keeps decoded pictures in unless told otherwise (64MiB, about a thousand thumbnails)
+#define DEFAULT_IMAGE_CACHE_BYTES (64*1024*1024)
+
+//pictures waiting to be decoded, prefetches past this are dropped
+#define IMAGE_CACHE_MAX_QUEUED 256
+
+//where a cached picture is at
+#define CACHED_IMAGE_PENDING 0
+#define CACHED_IMAGE_READY 1
+#define CACHED_IMAGE_FAILED 2
+
+/*
+ * A picture decoded and scaled to one IMAGE_SIZE_*. Reference counted: the cache holds one reference while the
+ * picture is cached and get_cached_image hands out another, so an evicted picture lives on until it is released.
+ */
+struct Cached_Image{
+	//number of owners, the image is deleted when the last one releases it
+	uint32_t reference_count;
+
+	//the picture file and the size it was decoded to
+	char * path;
+	uint8_t size;
+
+	//CACHED_IMAGE_*, only READY images have pixels
+	uint8_t state;
+
+	//premultiplied ARGB in native endian uint32_t, width*4 bytes a row. The same layout as cairo's
+	//CAIRO_FORMAT_ARGB32 so the UI can draw it without converting.
+	uint32_t width;
+	uint32_t height;
+	uint32_t * pixels;
+
+	//true if a prefetch brought the picture in and nobody asked for it yet
+	bool prefetched;
+
+	//owned by the cache: the next image in the same hash bucket and the neighbours in least recently used order
+	cached_image_t * next_in_bucket;
+	cached_image_t * newer;
+	cached_image_t * older;
+
+	//owned by the cache: true while the image is in the least recently used list, and while the thread decodes it
+	bool in_recent;
+	bool in_flight;
+};
+
+struct Image_Cache_Stats{
+	//get_cached_image calls, the ones answered from memory and how many of those a prefetch brought in
+	size_t n_requests;
+	size_t n_hits;
+	size_t n_prefetch_hits;
+
+	//pictures decoded, pictures that could not be read, pictures dropped to stay within the memory budget
+	size_t n_decoded;
+	size_t n_failed;
+	size_t n_evicted;
+
+	//prefetches not queued because the queue was full
+	size_t n_prefetches_dropped;
+
+	//memory the cached pictures use
+	size_t bytes;
+};
+
+/*
+ * Decodes node pictures on a background thread and keeps the most recently used ones in memory, so selecting a
+ * node never waits on a file. A picture asked for with get_cached_image jumps the queue, prefetched pictures wait
+ * their turn behind it. PNG and JPEG files are read.
+ */
+struct Image_Cache{
+	pthread_t thread;
+
+	//protects everything below
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t idle;
+	bool shutting_down;
+
+	//every image in the cache, pending ones included. The number of buckets is a power of two.
+	cached_image_t ** buckets;
+	size_t n_buckets;
+	size_t n_images;
+
+	//ready and failed images, newest first. Pending images are not in the list and can not be evicted.
+	cached_image_t * newest;
+	cached_image_t * oldest;
+	size_t max_bytes;
+
+	//pending images to decode as a ring buffer, taken from the front
+	cached_image_t ** queue;
+	size_t queue_first;
+	size_t n_queued;
+
+	//true while the thread is decoding, with the lock released
+	bool decoding;
+
+	//called on the cache thread after a picture is decoded or failed to decode
+	void (*on_ready)(const char * path,uint8_t size,void * user_data);
+	void * user_data;
+
+	image_cache_stats_t stats;
+};
+
+//The longest side of an IMAGE_SIZE_*.
+uint32_t get_image_size_side(uint8_t size);
+
+/*
+ * Decode a PNG or JPEG file and scale it to fit an IMAGE_SIZE_* right away on the calling thread, with one
+ * reference held by the caller. The state is CACHED_IMAGE_FAILED if the file can not be read.
+ */
+cached_image_t * decode_cached_image(const char * path,uint8_t size);
+
+//Add an owner to an image. Safe to call from any thread.
+void retain_cached_image(cached_image_t * image);
+
+//Remove an owner from an image, deleting it if it was the last one. Safe to call from any thread.
+void release_cached_image(cached_image_t * image);
+
+//Create a cache keeping up to max_bytes of pictures and start its thread. on_ready may be NULL.
+image_cache_t * create_image_cache(size_t max_bytes,void (*on_ready)(const char * path,uint8_t size,void * user_data),void * user_data);
+
+//Stop the thread and delete the cache. Images still held by callers stay valid until they are released.
+void delete_image_cache(image_cache_t * cache);
+
+/*
+ * A picture in a size, with a reference the caller releases. On a miss the picture is queued ahead of any
+ * prefetches and NULL is returned, on_ready says when to ask again. Also NULL if the file could not be read.
+ */
+cached_image_t * get_cached_image(image_cache_t * cache,const char * path,uint8_t size);
+
+//Queue a picture to be decoded if it is not cached, without counting a request. Returns false if the queue is full.
+bool prefetch_cached_image(image_cache_t * cache,const char * path,uint8_t size);
+
+//Prefetch the pictures of the nodes along a path, in path order.
+void prefetch_map_path_images(image_cache_t * cache,const map_path_t * path,uint8_t size);
+
+//Prefetch the pictures of the nodes of a map inside a region, like the part of the map on screen.
+void prefetch_map_rect_images(image_cache_t * cache,const map_t * map,map_rect_t rect,uint8_t size);
+
+//Block until every queued picture has been decoded.
+void wait_for_image_cache(image_cache_t * cache);
+
+//A copy of the counters, taken under the lock.
+image_cache_stats_t get_image_cache_stats(image_cache_t * cache);
+
+//Fraction of requests answered from memory, 0 before the first request.
+double get_image_cache_hit_rate(const image_cache_stats_t * stats);
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef ISOCHRONE_H
+#define ISOCHRONE_H
+
+#include "routing.h"
+
+typedef struct Isochrone isochrone_t;
+
+/*
+ * Everything that can be reached from a start node within a cost budget for one ROUTE_PROFILE_*, like every
+ * building within five minutes by wheelchair. The search tree is kept, so growing the budget only searches
+ * the nodes between the old and the new limit.
+ */
+struct Isochrone{
+	//the isochrone holds a reference to its graph
+	map_graph_t * graph;
+	uint32_t start;
+	uint8_t profile;
+
+	//the tree grown so far, every settled node costs at most cost_limit
+	route_search_context_t * context;
+	double cost_limit;
+
+	//graph indices of the reachable nodes, those reached by earlier budgets come first
+	uint32_t * nodes;
+	size_t n_nodes;
+	size_t nodes_capacity;
+
+	//buildings with at least one reachable node, in the order they were reached
+	const building_t ** buildings;
+	size_t n_buildings;
+
+	//graph indices of the reachable building entrances, see building_routes.h
+	uint32_t * entrances;
+	size_t n_entrances;
+
+	//convex outline of the reachable nodes and of how far along the edges leaving them the budget goes,
+	//counter-clockwise
+	cord_t * outline;
+	size_t n_outline;
+
+	//reachable nodes with a usable edge to a node that is not reachable, the only old nodes whose outline
+	//points move when the budget grows
+	uint32_t * frontier;
+	size_t n_frontier;
+
+	//marks every building of graph->building_routes that has been reached
+	uint8_t * building_reached;
+};
+
+//Start an isochrone on a graph, only the start itself is reachable until grow_isochrone is called.
+isochrone_t * create_isochrone(map_graph_t * graph,uint32_t start,uint8_t profile);
+
+//Delete an isochrone and release its graph.
+void delete_isochrone(isochrone_t * isochrone);
+
+/*
+ * Set the budget of an isochrone and bring the reachable nodes, buildings, entrances and outline up to date.
+ * A higher budget than before goes on from the kept tree and only visits the newly reached nodes and the old
+ * frontier, the outline grows from the old one. A lower budget searches again from the start.
+ */
+void grow_isochrone(isochrone_t * isochrone,double cost_limit);
+
+#endif
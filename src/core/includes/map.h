@@ -26,6 +26,10 @@ typedef struct Map_Polygon_Object mpo_t;
 typedef struct Map_Path map_path_t;
 typedef struct Saved_Paths saved_paths_t;
 typedef struct Building building_t;
+typedef struct Search_Filter_Options search_filter_options_t;
+typedef struct Route_Repair route_repair_t;
+typedef struct Schedule schedule_t;
+typedef struct String_Interner string_interner_t;
 
 //---------------------------------------------------------- GEOMETRY PRIMITIVES BEGIN ------------------------------------------------
 /*
@@ -81,6 +85,9 @@ struct Map_Polygon_Object{
 	size_t n_cords;
 	uint8_t type;
 	char * name;
+	
+	//id of name in map_t::strings, STRING_ID_NONE while the mpo owns a copy of its name
+	uint32_t name_id;
 };
 
 //create a new map polygon object instance on the heap.
@@ -119,8 +126,14 @@ struct Building{
 	size_t n_possible_names;
 	size_t possible_names_capacity;
 	
+	//id of every name in map_t::strings, STRING_ID_NONE for names the building owns a copy of
+	uint32_t * possible_name_ids;
+	
 	//The number of floors in that building.
 	uint8_t n_floors;
+	
+	//When the inside of the building can be routed through, NULL if it is always open. Owned by the building.
+	schedule_t * opening_hours;
 };
 
 //Creating a new building instance in the heap. It will need to be deleted.
@@ -144,6 +157,9 @@ void set_building_floor_count(building_t * building,size_t new_floor_count);
 //change the bounding box of a building if it was incorrect
 void set_building_bounding_box(building_t * building,map_rect_t building_bounding_box);
 
+//Give a building opening hours, see schedules.h. The building takes the schedule and deletes any it had, NULL makes it always open.
+void set_building_opening_hours(building_t * building,schedule_t * opening_hours);
+
 //Get the main name of a building. (Warning) Might return NULL
 const char * get_primary_building_name(const building_t * building);
 
@@ -169,6 +185,10 @@ struct Map_Node{
 	//file path of node if applicable
 	char * picture_file_path;
 	
+	//ids of name and picture_file_path in map_t::strings, STRING_ID_NONE while the node owns a copy
+	uint32_t name_id;
+	uint32_t picture_id;
+	
 	//list of outgoing edges
 	map_edge_t ** outgoing_edges;
 	size_t n_outgoing_edges;
@@ -211,16 +231,16 @@ void set_map_node_picture(map_node_t * node,const char * file_path);
 //clear the file name field from a node
 void clear_map_node_picture(map_node_t * node);
 
-//Set a nodes floor number if applicable
+//Set a nodes floor number if applicable. For a node already in a map use set_map_node_floor_number_in_map.
 void set_map_node_floor_number(map_node_t * node,int8_t floor_number);
 
 //If a node doesn't have a floor number, like those outside then clear it
 void clear_map_node_floor_number(map_node_t * node);
 
-//Make a node selectable with the mouse or not.
+//Make a node selectable with the mouse or not. For a node already in a map use set_map_node_selectable_in_map.
 void set_map_node_selectable(map_node_t * node,bool selectable);
 
-//Set the building in which the node resides.
+//Set the building in which the node resides. For a node already in a map use set_map_node_building_in_map.
 void set_map_node_building(map_node_t * node,building_t * building);
 
 //If you accidently assigned a building to a node you can clear it.
@@ -229,9 +249,27 @@ void clear_map_node_building(map_node_t * node);
 //edit a misplaced coordinate
 void set_map_node_cord(map_node_t * node,cord_t new_cord);
 
-//is the node next to an automatic door?
+//is the node next to an automatic door? This scans the edges, see get_map_node_flags for a map's nodes.
 bool node_adjacent_to_auto_door(map_node_t * node);
 
+/*
+ * Facts about a node packed into one word. A map keeps one per node in map_t::node_flags so filtering and
+ * drawing can read them without following the node, edge and building pointers.
+ * The low byte holds the NODE_FLAG_* bits and the high byte holds the floor number.
+ */
+#define NODE_FLAG_ADJACENT_TO_AUTO_DOOR 0x01
+#define NODE_FLAG_INTERIOR 0x02
+#define NODE_FLAG_HAS_ELEVATOR 0x04
+#define NODE_FLAG_SELECTABLE 0x08
+
+//Work out the flag word of a node from scratch.
+uint16_t compute_map_node_flags(const map_node_t * node);
+
+//The floor number stored in a flag word, NODE_FLOOR_NUMBER_NONE if there is none.
+static inline int8_t get_node_flags_floor_number(uint16_t flags){
+	return (int8_t)(flags >> 8);
+}
+
 //Print out a map node and show all of its member data. Tabs value lets you add tabs to every line of output.
 void map_node_to_output_stream(const map_node_t * node,size_t tabs,FILE * stream);
 //---------------------------------------------------------- NODES END ----------------------------------------------------------------
@@ -269,10 +307,16 @@ void map_node_to_output_stream(const map_node_t * node,size_t tabs,FILE * stream
 //Does the edge use a crosswalk
 #define EDGE_TYPE_CROSSWALK 10
 
+//one more than the largest edge type, the size of tables indexed by edge type
+#define N_EDGE_TYPES 11
+
 struct Map_Edge{
 	map_node_t * a;
 	map_node_t * b;
 	uint8_t type;
+	
+	//when the edge can be used, like a door that is locked at night. NULL if always. Owned by the edge.
+	schedule_t * schedule;
 };
 
 //Create a map_edge_t object in the heap. This will need to be freed.
@@ -281,9 +325,12 @@ map_edge_t * create_map_edge(uint8_t type,map_node_t * a,map_node_t * b);
 //Delete a map_edge_t object.
 void delete_map_edge(map_edge_t * edge);
 
-//change the type of the edge
+//change the type of the edge. For an edge already in a map use set_map_edge_type_in_map.
 void set_map_edge_type(map_edge_t * edge,uint8_t type);
 
+//Give an edge a schedule, see schedules.h. The edge takes the schedule and deletes any it had, NULL makes it always usable.
+void set_map_edge_schedule(map_edge_t * edge,schedule_t * schedule);
+
 //Print out a map edge and show all of its member data. Tabs value lets you add tabs to every line of output.
 void map_edge_to_output_stream(const map_edge_t * edge,size_t tabs,FILE * stream);
 //---------------------------------------------------------- EDGES END ----------------------------------------------------------------
@@ -299,6 +346,13 @@ struct Search_Filter_Options{
 	bool exclude_interiors;
 };
 
+//the exclude_* options packed into one value, see compile_search_filter
+#define SEARCH_FILTER_NONE 0
+#define SEARCH_FILTER_EXCLUDE_STAIRS 1
+#define SEARCH_FILTER_EXCLUDE_NON_AUTO_DOORS 2
+#define SEARCH_FILTER_EXCLUDE_INTERIORS 4
+#define N_SEARCH_FILTERS 8
+
 
 
 /*
@@ -310,6 +364,9 @@ struct Map{
 	size_t n_nodes;
 	size_t node_capacity;
 	
+	//flag word of every node, node_flags[i] belongs to all_nodes[i]. See NODE_FLAG_*
+	uint16_t * node_flags;
+	
 	//array of edges (these are not manipulated directly)
 	map_edge_t ** all_edges;
 	size_t n_edges;
@@ -329,6 +386,18 @@ struct Map{
 	map_node_t * active_end;
 	map_path_t * active_path;
 	double (*active_edge_cost_function)(const map_edge_t * edge_ref);
+	
+	//search state behind active_path, repaired instead of searched again when only edge types changed
+	route_repair_t * active_route_repair;
+	
+	//edges changed in place since active_path was found, only kept while there is an active_route_repair.
+	//Adding or removing nodes or edges drops the repair instead.
+	map_edge_t ** changed_edges;
+	size_t n_changed_edges;
+	size_t changed_edges_capacity;
+	
+	//every name and picture path of the map stored once, see string_interner.h
+	string_interner_t * strings;
 };
 
 //Create a map object. Not on heap.
@@ -352,6 +421,9 @@ void remove_building_from_map_by_index(map_t * map,size_t index);
 //add node to map
 void add_node_to_map(map_t * map,map_node_t * node);
 
+//Make room for n_nodes more nodes and n_edges more edges at once, so importers adding many do not grow the arrays step by step.
+void reserve_map_capacity(map_t * map,size_t n_nodes,size_t n_edges);
+
 //remove node from map
 void remove_node_from_map(map_t * map,map_node_t * node);
 
@@ -361,6 +433,24 @@ void remove_node_by_name_from_map(map_t * map,const char * node_name);
 //remove node from map by index
 void remove_node_from_map_by_index(map_t * map,size_t index);
 
+//Get the flag word of the node at an index. Kept up to date as edges are connected, disconnected and retyped.
+uint16_t get_map_node_flags(const map_t * map,size_t index);
+
+//Call after changing the building, floor or selectability of a node that is already in the map.
+void refresh_map_node_flags(map_t * map,map_node_t * node);
+
+//Set the building of a node in the map, NULL for none, and update its flag word.
+void set_map_node_building_in_map(map_t * map,map_node_t * node,building_t * building);
+
+//Set the floor number of a node in the map, NODE_FLOOR_NUMBER_NONE for none, and update its flag word.
+void set_map_node_floor_number_in_map(map_t * map,map_node_t * node,int8_t floor_number);
+
+//Make a node in the map selectable or not and update its flag word.
+void set_map_node_selectable_in_map(map_t * map,map_node_t * node,bool selectable);
+
+//Change the type of an edge in the map and update the flag words of both of its nodes.
+void set_map_edge_type_in_map(map_t * map,map_edge_t * edge,uint8_t type);
+
 //connect two nodes in a map
 void connect_nodes_in_map(map_t * map,map_node_t * node_a,map_node_t * node_b,uint8_t edge_type);
 
@@ -391,6 +481,12 @@ void set_connection_type_for_nodes_by_name(map_t * map,const char * node_a,const
 //add a map polygon object to the map
 void add_mpo_to_map(map_t * map,mpo_t * mpo);
 
+/*
+ * Move the names and picture paths of every node, building and mpo into map_t::strings, freeing their own copies.
+ * Adding something to a map does this for it, the set_* functions keep a copy so call this after renaming.
+ */
+void intern_map_strings(map_t * map);
+
 //remove a map polygon object from the map
 void remove_mpo_from_map(map_t * map,mpo_t * mpo);
 
@@ -450,6 +546,11 @@ double calculate_driver_edge_cost(const map_edge_t * edge_ref);
  * Find a path which is the least cost given the edge_cost_function. Use Dijkstra's Algorithm
  * the start node is active_start and end node is active_end
  * store best path into active_path
+ * If only edges were changed in place since the last call with the same start, end and cost function, through
+ * set_map_edge_type_in_map, set_connection_type_for_nodes or set_map_node_floor_number_in_map, the last search
+ * is repaired on the same snapshot instead of run again, see route_repair.h. Adding or removing nodes or edges
+ * makes a new snapshot. Changes made to a node or edge without going through the map are not seen while the
+ * snapshot is kept.
  */
 void find_best_path(map_t * map_ref);
 
@@ -464,8 +565,9 @@ void find_best_path(map_t * map_ref);
 void set_map_path_name(map_path_t * map_path_ref,const char * path_name);
 
 /*
- * Delete the map_path_t object
- * dev-note: Ensure that the name is freed.
+ * Delete the map_path_t object: its nodes array, its name and the struct itself, so the path has to
+ * be on the heap. Paths on the stack that borrow a node array, like for prefetch_map_path_images, must
+ * not be passed here.
  */
 void delete_map_path(map_path_t * map_path_ref);
 
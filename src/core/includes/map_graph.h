@@ -0,0 +1,159 @@
+#ifndef MAP_GRAPH_H
+#define MAP_GRAPH_H
+
+#include "map.h"
+
+typedef struct Map_Graph map_graph_t;
+typedef struct Edge_Weights edge_weights_t;
+typedef struct Floor_Layers floor_layers_t;
+typedef struct Building_Routes building_routes_t;
+typedef struct Schedule_Tables schedule_tables_t;
+typedef struct Map_Projection map_projection_t;
+typedef struct Map_Graph_Node map_graph_node_t;
+typedef struct Map_Node_View map_node_view_t;
+
+/*
+ * The fields of a node that searches and snapshot building read. A full map_node_t is over a hundred bytes
+ * of names, edge lists and scratch fields, this keeps several nodes to a cache line.
+ */
+struct Map_Graph_Node{
+	cord_t coordinate;
+	int8_t floor_number;
+};
+
+/*
+ * An immutable snapshot of the routable part of a map.
+ * Node i is the i-th node of map_t::all_nodes and edge j is the j-th edge of map_t::all_edges
+ * at the time the snapshot was taken. Nodes and edges are copies, so a search running on
+ * another thread never reads memory that the map editor is changing.
+ */
+struct Map_Graph{
+	//number of owners, the graph is deleted when the last one releases it
+	uint32_t reference_count;
+
+	//increases every time a snapshot is taken
+	uint64_t version;
+
+	//the hot fields of every node, hot_nodes[i] is node i. Searches read these instead of nodes.
+	size_t n_nodes;
+	map_graph_node_t * hot_nodes;
+
+	//full copies of the map nodes, the cold side of hot_nodes. name, picture_file_path and outgoing_edges
+	//are always NULL. Kept so edge cost functions taking a map_edge_t can follow its a and b.
+	map_node_t * nodes;
+
+	//the map node each copy came from. Only compared against, never dereferenced by readers.
+	map_node_t ** source_nodes;
+
+	//copy of map_t::node_flags, see NODE_FLAG_*
+	uint16_t * node_flags;
+
+	//copies of the map edges. a and b point into nodes, schedule is always NULL.
+	size_t n_edges;
+	map_edge_t * edges;
+
+	//the node indices of every edge, edge j joins edge_nodes[2*j] and edge_nodes[2*j+1]
+	uint32_t * edge_nodes;
+
+	//the map edge each copy came from. Only compared against, never dereferenced by readers.
+	map_edge_t ** source_edges;
+
+	//adjacency list in compressed row form. The neighbours of node i are
+	//adjacency_nodes[adjacency_offsets[i]] up to adjacency_nodes[adjacency_offsets[i+1]-1]
+	//and adjacency_edges holds the edge index used to reach each of them.
+	size_t * adjacency_offsets;
+	uint32_t * adjacency_nodes;
+	uint32_t * adjacency_edges;
+
+	//the nodes in float meters on a plane, for distances without trigonometry, see projection.h
+	map_projection_t * projection;
+
+	//cost of every edge for every route profile, see edge_weights.h
+	edge_weights_t * weights;
+
+	//one bitset of allowed edges per combination of SEARCH_FILTER_* flags, NULL until a search first
+	//uses that combination. Filled in by get_search_filter_bitset, see search_filter.h
+	uint64_t * filter_bitsets[N_SEARCH_FILTERS];
+
+	//the nodes and edges grouped by building and floor, see floor_layers.h
+	floor_layers_t * floor_layers;
+
+	//entrances of every building and the cost of crossing it, see building_routes.h
+	building_routes_t * building_routes;
+
+	//the schedules of the edges and of the buildings compiled at snapshot time, see schedules.h
+	schedule_tables_t * schedule_tables;
+};
+
+/*
+ * Take a snapshot of a map on the heap with a reference count of one.
+ * dev-note: this writes index_temp of every map node so it must run on the thread editing the map.
+ */
+map_graph_t * create_map_graph(map_t * map_ref);
+
+/*
+ * Same as create_map_graph, but the edge weights of edges that have not changed since previous
+ * was taken are copied instead of measured again. previous may be NULL.
+ */
+map_graph_t * create_map_graph_from_previous(map_t * map_ref,const map_graph_t * previous);
+
+//Add an owner to a graph. Safe to call from any thread.
+void retain_map_graph(map_graph_t * graph);
+
+//Remove an owner from a graph, deleting it if it was the last one. Safe to call from any thread.
+void release_map_graph(map_graph_t * graph);
+
+//Find the index of a map node within the graph. found is false if the node is not in the snapshot.
+uint32_t get_map_graph_node_index(const map_graph_t * graph,const map_node_t * node,bool * found);
+
+//Find the index of a map edge within the graph by looking through the edges of its first node. found is false if the edge is not in the snapshot.
+uint32_t get_map_graph_edge_index(const map_graph_t * graph,const map_edge_t * edge,bool * found);
+
+//The node at the other end of edge edge_index from node.
+static inline uint32_t get_map_graph_other_node(const map_graph_t * graph,uint32_t edge_index,uint32_t node){
+	uint32_t a = graph->edge_nodes[2*edge_index];
+	return (a == node) ? graph->edge_nodes[2*edge_index+1] : a;
+}
+
+/*
+ * Node index of a snapshot seen as a node. The coordinate and floor come from hot_nodes and anything else from
+ * the full copy, so code that reads a map_node_t keeps working on a snapshot without searches paying for it.
+ */
+struct Map_Node_View{
+	const map_graph_t * graph;
+	uint32_t index;
+};
+
+static inline map_node_view_t get_map_graph_node_view(const map_graph_t * graph,uint32_t index){
+	map_node_view_t view = {graph,index};
+	return view;
+}
+
+static inline cord_t get_map_node_view_cord(map_node_view_t view){
+	return view.graph->hot_nodes[view.index].coordinate;
+}
+
+static inline int8_t get_map_node_view_floor_number(map_node_view_t view){
+	return view.graph->hot_nodes[view.index].floor_number;
+}
+
+//The NODE_FLAG_* word of the node.
+static inline uint16_t get_map_node_view_flags(map_node_view_t view){
+	return view.graph->node_flags[view.index];
+}
+
+static inline const building_t * get_map_node_view_building(map_node_view_t view){
+	return view.graph->nodes[view.index].associated_building;
+}
+
+//The full copy of the node, for the map_node_t functions that take a const node.
+static inline const map_node_t * get_map_node_view_node(map_node_view_t view){
+	return &(view.graph->nodes[view.index]);
+}
+
+//The map node the view was copied from. Only for the thread editing the map, like map_graph_t::source_nodes.
+static inline map_node_t * get_map_node_view_source(map_node_view_t view){
+	return view.graph->source_nodes[view.index];
+}
+
+#endif
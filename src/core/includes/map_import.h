@@ -0,0 +1,76 @@
+#ifndef MAP_IMPORT_H
+#define MAP_IMPORT_H
+
+#include "map.h"
+
+typedef struct Map_Import_Stats map_import_stats_t;
+
+//file formats import_map_file reads
+#define MAP_IMPORT_FORMAT_OSM_XML 0//.osm or .xml, an OpenStreetMap export
+#define MAP_IMPORT_FORMAT_GEOJSON 1//.geojson or .json, a FeatureCollection with OpenStreetMap tags as properties
+#define N_MAP_IMPORT_FORMATS 2
+
+//bytes read from the file at a time, the only part of the file in memory at once
+#define MAP_IMPORT_CHUNK_SIZE 65536
+
+//longest name kept, longer ones are cut
+#define MAP_IMPORT_MAX_NAME 256
+
+struct Map_Import_Stats{
+	//nodes, ways and relations of an OSM file or features of a GeoJSON file read
+	size_t n_elements;
+
+	//what was added to the map
+	size_t n_nodes;
+	size_t n_edges;
+	size_t n_buildings;
+	size_t n_mpos;
+
+	//times a node already in the map was used again by another way or feature instead of being added twice
+	size_t n_shared_nodes;
+
+	//ways and features with no tag the importer understands, and way references to nodes the file does not have
+	size_t n_skipped;
+	size_t n_missing_nodes;
+};
+
+/*
+ * Tags are read the same way from both formats:
+ *	highway=footway, path, pedestrian, living_street, cycleway or track is EDGE_TYPE_SIDEWALK, with footway=crossing
+ *		or highway=crossing EDGE_TYPE_CROSSWALK, with bridge EDGE_TYPE_OVERPASS and with incline or ramp=yes EDGE_TYPE_RAMP
+ *	highway=steps is EDGE_TYPE_STAIRS, highway=corridor or indoor=corridor EDGE_TYPE_HALLWAY and highway=elevator
+ *		EDGE_TYPE_ELEVATOR_SHAFT
+ *	any other highway is EDGE_TYPE_ROAD
+ *	door is EDGE_TYPE_DOOR, or EDGE_TYPE_AUTO_DOOR with automatic_door other than no or door=automatic
+ *	building is a building_t named by name with building:levels floors, and an MPO_TYPE_BUILDING outline
+ *	natural=water, water, waterway=riverbank or landuse=reservoir or basin is MPO_TYPE_WATER
+ *	natural=wood or scrub or landuse=forest or grass is MPO_TYPE_TREE
+ *	level is the floor number of the nodes of a way, the first number of a list like 0;1
+ *	name of an OSM node or a GeoJSON Point names the map node there and makes it selectable
+ * Nodes on hallways, stairs, elevators, doors or a level are put in the building whose box holds them.
+ * Relations and the inner rings of polygons are skipped.
+ */
+
+/*
+ * Add the ways and buildings of an OpenStreetMap XML file to a map in one pass, MAP_IMPORT_CHUNK_SIZE bytes at a
+ * time. Nodes are shared by their OSM id. Afterwards the nodes of the whole map are renumbered in
+ * MAP_NODE_ORDER_HILBERT order. Returns false if the file can not be read or is not well formed XML, leaving
+ * whatever was read before the error in the map. stats may be NULL.
+ */
+bool import_osm_xml_map(map_t * map,const char * path,map_import_stats_t * stats);
+
+/*
+ * Add the features of a GeoJSON file to a map in one pass, MAP_IMPORT_CHUNK_SIZE bytes at a time, the same way as
+ * import_osm_xml_map. Nodes are shared by their coordinate to 7 decimals: features on the same level share them,
+ * and features without a level share them with every level, so stairs without a level join the corridors they
+ * reach while corridors stacked on different floors stay apart.
+ */
+bool import_geojson_map(map_t * map,const char * path,map_import_stats_t * stats);
+
+//The MAP_IMPORT_FORMAT_* of a file by its extension, N_MAP_IMPORT_FORMATS if it has none of them.
+uint8_t get_map_import_format(const char * path);
+
+//import_osm_xml_map or import_geojson_map by the extension of the file.
+bool import_map_file(map_t * map,const char * path,map_import_stats_t * stats);
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef MAP_PUBLISHER_H
+#define MAP_PUBLISHER_H
+
+#include <pthread.h>
+#include "map_graph.h"
+
+typedef struct Map_Reader_Slot map_reader_slot_t;
+typedef struct Retired_Map_Graph retired_map_graph_t;
+typedef struct Map_Publisher map_publisher_t;
+
+//maximum number of threads that can read snapshots at the same time
+#define MAX_MAP_READERS 64
+
+//a reader slot with this epoch is not reading anything
+#define MAP_READER_IDLE 0
+
+#define DEFAULT_RETIRED_GRAPHS_CAPACITY 4
+
+/*
+ * Where a reader announces the epoch it started reading in.
+ * Padded to a cache line so readers on different cores do not contend.
+ */
+struct Map_Reader_Slot{
+	uint64_t epoch;
+	bool in_use;
+	uint8_t padding[64 - sizeof(uint64_t) - sizeof(bool)];
+};
+
+/*
+ * A snapshot that has been replaced but may still be read
+ */
+struct Retired_Map_Graph{
+	map_graph_t * graph;
+	uint64_t retire_epoch;
+};
+
+/*
+ * Publishes immutable snapshots of a map so that many readers can route while one editor changes it.
+ *
+ * Readers never lock: they announce the current epoch in their slot and load the snapshot pointer.
+ * Editors batch any number of changes between begin_map_edit and end_map_edit, which publishes one
+ * new snapshot with an atomic pointer swap. A replaced snapshot is released once every reader that
+ * could have seen it has moved on.
+ */
+struct Map_Publisher{
+	map_t * map;
+
+	//the newest snapshot, the publisher owns one reference to it
+	map_graph_t * current;
+
+	//advanced every time a snapshot is replaced
+	uint64_t global_epoch;
+
+	map_reader_slot_t reader_slots[MAX_MAP_READERS];
+
+	//only one editor at a time, readers never touch this
+	pthread_mutex_t editor_lock;
+
+	//replaced snapshots waiting for their readers to finish
+	retired_map_graph_t * retired;
+	size_t n_retired;
+	size_t retired_capacity;
+};
+
+//Create a publisher for a map and publish its first snapshot. The map must outlive the publisher.
+map_publisher_t * create_map_publisher(map_t * map_ref);
+
+//Delete the publisher and every snapshot it still owns. No reader may be active.
+void delete_map_publisher(map_publisher_t * publisher);
+
+//Claim a reader slot for the calling thread. Returns MAX_MAP_READERS if every slot is taken.
+size_t register_map_reader(map_publisher_t * publisher);
+
+//Give a reader slot back.
+void unregister_map_reader(map_publisher_t * publisher,size_t reader);
+
+/*
+ * Get the newest snapshot without locking. It stays valid until release_map_snapshot is called.
+ * To keep it longer than that call retain_map_graph on it before releasing.
+ */
+const map_graph_t * acquire_map_snapshot(map_publisher_t * publisher,size_t reader);
+
+//Finish reading the snapshot returned by acquire_map_snapshot.
+void release_map_snapshot(map_publisher_t * publisher,size_t reader);
+
+//Take the editor lock and get the map to change. Blocks other editors, never readers.
+map_t * begin_map_edit(map_publisher_t * publisher);
+
+//Publish every change made since begin_map_edit as one new snapshot and drop the editor lock.
+void end_map_edit(map_publisher_t * publisher);
+
+//Release replaced snapshots that no reader can still be looking at. Returns how many are left.
+size_t reclaim_map_snapshots(map_publisher_t * publisher);
+
+#endif
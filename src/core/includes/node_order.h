@@ -0,0 +1,31 @@
+#ifndef NODE_ORDER_H
+#define NODE_ORDER_H
+
+#include "map.h"
+
+//how reorder_map_nodes lays the nodes out
+#define MAP_NODE_ORDER_HILBERT 0//along a Hilbert curve over the coordinates, nodes near each other on the ground sit near each other
+#define MAP_NODE_ORDER_BFS 1//breadth first from the first node of every connected part, neighbours get close indices
+#define N_MAP_NODE_ORDERS 2
+
+//bits per axis of the grid the Hilbert curve is laid over
+#define HILBERT_ORDER_BITS 16
+
+/*
+ * The order a MAP_NODE_ORDER_* would put the nodes of a map in: order[k] is the index in map_t::all_nodes of the
+ * node that would become node k. Returns NULL for an unknown order. The caller frees the array.
+ * dev-note: the BFS order writes index_temp of every map node.
+ */
+uint32_t * compute_map_node_order(const map_t * map,uint8_t order);
+
+/*
+ * Renumber the nodes of a map in a MAP_NODE_ORDER_*, and sort the edges by their lower node so edge indices follow
+ * the same order. Searches on later snapshots then touch memory that is close together instead of jumping all over
+ * the node, edge and adjacency arrays. Node and edge pointers, paths and saved paths stay valid, only indices change.
+ * Run it after loading or importing a map, before the first snapshot. Snapshots taken earlier keep their own order.
+ * Returns false for an unknown order.
+ * dev-note: this writes index_temp of every map node so it must run on the thread editing the map.
+ */
+bool reorder_map_nodes(map_t * map,uint8_t order);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef PARETO_ROUTES_H
+#define PARETO_ROUTES_H
+
+#include "routing.h"
+
+typedef struct Pareto_Routes pareto_routes_t;
+
+//what a route can be measured by, combine them to choose the criteria of a search
+#define ROUTE_CRITERION_COST 0x01//the cost of the route profile
+#define ROUTE_CRITERION_MANUAL_DOORS 0x02//how many EDGE_TYPE_DOOR edges are crossed
+#define ROUTE_CRITERION_OUTDOORS 0x04//meters along edges that are not inside a building
+#define ROUTE_CRITERION_STAIRS 0x08//meters of stairs
+#define N_ROUTE_CRITERIA 4
+
+//default cap on how many routes to a single node are kept at once
+#define DEFAULT_PARETO_MAX_LABELS 16
+
+/*
+ * Every route between two nodes that no other route beats on all of the chosen criteria at once
+ */
+struct Pareto_Routes{
+	uint8_t criteria;
+
+	//the routes using the map's nodes, ordered by their first chosen criterion
+	size_t n_paths;
+	map_path_t ** paths;
+
+	//values[k*N_ROUTE_CRITERIA + c] is criterion 1 << c of route k, 0 for criteria that were not chosen
+	double * values;
+
+	//how many labels the search made, and whether a full label set at some node made it drop routes
+	size_t n_labels;
+	bool truncated;
+};
+
+/*
+ * Multi-criteria label setting search from start to end for a ROUTE_PROFILE_*. Only edges the profile can use
+ * are followed. criteria is a combination of ROUTE_CRITERION_* flags.
+ *
+ * Every node keeps a set of at most max_labels labels none of which dominates another. A label is dropped as
+ * soon as a label at its node, or a route already found to the end, is at least as good on every criterion.
+ * A tree grown from the end for every chosen criterion gives every node a lower bound on what is still to come,
+ * labels are compared against the routes found with those bounds added and are expanded in the order of their
+ * first criterion plus its bound, so routes to the end are found early.
+ * If a node's set is full its label with the worst first criterion is given up for a better one and truncated
+ * is set, the routes are then still Pareto optimal among each other but some may be missing.
+ * Returns NULL for invalid arguments or if end can not be reached.
+ */
+pareto_routes_t * find_pareto_routes(const map_graph_t * graph,uint32_t start,uint32_t end,uint8_t profile,uint8_t criteria,size_t max_labels);
+
+//Delete pareto routes and their paths.
+void delete_pareto_routes(pareto_routes_t * routes);
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef PROJECTION_H
+#define PROJECTION_H
+
+#include "routing.h"
+
+typedef struct Map_Projection map_projection_t;
+
+//how many edges compute_projected_edge_lengths works on at a time
+#define PROJECTION_BLOCK_SIZE 256
+
+/*
+ * Margin taken off the lower bound scale of every projection for float rounding and for a great circle being a
+ * little shorter than the parallel the projection follows, which is far less than this on maps up to hundreds of
+ * kilometers across.
+ */
+#define PROJECTION_LOWER_BOUND_MARGIN 0.999
+
+//latitudes closer to a pole than this get no lower bound, a projection across them is too stretched to guide a search
+#define PROJECTION_MAX_LATITUDE 85.0
+
+/*
+ * The nodes of a graph snapshot on a flat plane, in float meters east and north of the middle of the
+ * bounding rect of the nodes. An equirectangular projection is exact enough across a campus, and measuring
+ * on it is a few multiply-adds instead of the trigonometry of the haversine formula.
+ */
+struct Map_Projection{
+	cord_t origin;
+	double meters_per_degree_longitude;
+	double meters_per_degree_latitude;
+
+	/*
+	 * Projected distances times this are never longer than the haversine distance, so they can be used as a
+	 * lower bound. The projection uses the longitude scale of the origin's latitude, which is too long at the
+	 * latitude of the bounding rect farthest from the equator by cos(origin)/cos(farthest). 0 when the map
+	 * reaches past PROJECTION_MAX_LATITUDE.
+	 */
+	float lower_bound_scale;
+
+	//x[i], y[i] and z[i] are where node i of the graph is. z is the height of the node's floor
+	//above the ground floor, 0 for nodes without a floor number
+	size_t n_nodes;
+	float * x;
+	float * y;
+	float * z;
+};
+
+//Project every node of a graph.
+map_projection_t * create_map_projection(const map_graph_t * graph);
+
+//Delete a projection.
+void delete_map_projection(map_projection_t * projection);
+
+//Where a coordinate lands on the plane of a projection, in meters east and north of its origin.
+void project_cord(const map_projection_t * projection,cord_t cord,float * x_out,float * y_out);
+
+//Ground distance between two nodes on the plane, ignoring floors.
+static inline float get_projected_distance(const map_projection_t * projection,uint32_t a,uint32_t b){
+	float dx = projection->x[b] - projection->x[a];
+	float dy = projection->y[b] - projection->y[a];
+	return sqrtf(dx*dx + dy*dy);
+}
+
+/*
+ * Length of every edge of graph in meters, measured on the projection the same way get_map_edge_length
+ * measures it: the ground distance with the height of any floors climbed. lengths needs room for n_edges.
+ */
+void compute_projected_edge_lengths(const map_projection_t * projection,const map_graph_t * graph,float * lengths);
+
+#endif
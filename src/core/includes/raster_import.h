@@ -0,0 +1,70 @@
+#ifndef RASTER_IMPORT_H
+#define RASTER_IMPORT_H
+
+#include "map.h"
+
+typedef struct Raster_Import_Options raster_import_options_t;
+typedef struct Raster_Import_Stats raster_import_stats_t;
+
+//pixels greener than this (and greener than they are red or blue) are walkable, the old find_green_pixel.py threshold
+#define DEFAULT_RASTER_GREEN_THRESHOLD 150
+
+//how far in pixels a traced path may stray from the straight edges that replace it
+#define DEFAULT_RASTER_SIMPLIFY_TOLERANCE 1.5
+
+//dead ends shorter than this many pixels are stubs thinning leaves on the sides of wide paths, not real paths
+#define DEFAULT_RASTER_MIN_SPUR_PIXELS 6
+
+struct Raster_Import_Options{
+	//the area of the map the image covers, the top left pixel is at the north west corner
+	map_rect_t bounds;
+
+	//see DEFAULT_RASTER_*
+	uint8_t green_threshold;
+	double simplify_tolerance;
+	size_t min_spur_pixels;
+
+	//put the nodes of the whole map in MAP_NODE_ORDER_HILBERT order afterwards, renumbering the nodes already in it
+	bool reorder_nodes;
+};
+
+struct Raster_Import_Stats{
+	uint32_t width;
+	uint32_t height;
+
+	//pixels classified walkable and the ones left after thinning to one pixel wide lines
+	size_t n_walkable_pixels;
+	size_t n_skeleton_pixels;
+
+	//what was added to the map
+	size_t n_nodes;
+	size_t n_edges;
+};
+
+//Options with the DEFAULT_RASTER_* values for an image covering bounds.
+raster_import_options_t default_raster_import_options(map_rect_t bounds);
+
+/*
+ * One byte a pixel, 1 where an RGBA pixel (4 bytes a pixel, rows packed) is walkable and 0 elsewhere. A pixel is
+ * walkable when it is not transparent, its green is above green_threshold and above its red and blue.
+ * Runs 16 pixels at a time with SSE2 where there is SSE2. The caller frees the mask.
+ */
+uint8_t * classify_walkable_pixels(const uint8_t * rgba,uint32_t width,uint32_t height,uint8_t green_threshold,size_t * n_walkable);
+
+/*
+ * Thin a mask in place to lines one pixel wide along the middle of every walkable area (Zhang-Suen thinning),
+ * keeping every area connected. Returns the number of pixels left.
+ */
+size_t skeletonize_walkable_mask(uint8_t * mask,uint32_t width,uint32_t height);
+
+/*
+ * Turn the walkable parts of an RGBA image into nodes joined by EDGE_TYPE_SIDEWALK edges and add them to a map.
+ * Junctions and dead ends of the thinned mask become nodes, the lines between them are simplified into as few
+ * straight edges as the tolerance allows. stats may be NULL.
+ */
+bool import_raster_pixels(map_t * map,const uint8_t * rgba,uint32_t width,uint32_t height,const raster_import_options_t * options,raster_import_stats_t * stats);
+
+//import_raster_pixels on a PNG file. Returns false if the file can not be read.
+bool import_raster_map(map_t * map,const char * png_path,const raster_import_options_t * options,raster_import_stats_t * stats);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef ROUTE_ALTERNATIVES_H
+#define ROUTE_ALTERNATIVES_H
+
+#include "routing.h"
+
+typedef struct Route_Alternatives route_alternatives_t;
+
+/*
+ * Up to K loopless routes between two nodes, cheapest first, so a user can weigh a ramp route against a
+ * slightly longer one with automatic doors.
+ */
+struct Route_Alternatives{
+	size_t n_paths;
+
+	//the routes using the map's nodes and their costs, costs[0] is the best route
+	map_path_t ** paths;
+	double * costs;
+
+	//how many spur searches had to search the graph, the rest were answered by the tree to the end
+	size_t n_spur_searches;
+};
+
+/*
+ * Find up to max_paths loopless routes from start to end for a ROUTE_PROFILE_* with Yen's algorithm.
+ * Every route after the first leaves an earlier one at a spur node. Spur searches are kept cheap by:
+ *	only spurring from where a route left its parent (Lawler),
+ *	a shortest path tree grown once from the end: when its path from the spur node is not blocked it is the
+ *	spur path, and its cost is a lower bound used to skip spur nodes that can not beat the candidates kept,
+ *	and spur searches that do run are A* searches guided by the same tree, with a cost limit.
+ * context is used for the spur searches. Returns NULL if there is no route at all.
+ */
+route_alternatives_t * find_route_alternatives(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,uint8_t profile,size_t max_paths);
+
+//Delete alternatives and their paths.
+void delete_route_alternatives(route_alternatives_t * alternatives);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef ROUTE_BATCH_H
+#define ROUTE_BATCH_H
+
+#include "routing.h"
+#include "thread_pool.h"
+
+typedef struct Route_Query route_query_t;
+
+/*
+ * One path query of a batch, by node index of the graph
+ */
+struct Route_Query{
+	uint32_t start;
+	uint32_t end;
+
+	//one of ROUTE_PROFILE_*
+	uint8_t profile;
+
+	//combination of SEARCH_FILTER_* flags
+	uint8_t filter;
+};
+
+/*
+ * Answer many independent path queries in parallel on a thread pool. Each worker thread reuses
+ * its own search context for all the queries it runs and nothing goes through map_t::active_start
+ * or active_end.
+ *
+ * Returns an array of n_queries results in the same order as the queries. Paths are only
+ * extracted if want_paths is true, otherwise only found and cost are filled in.
+ * Free it with delete_route_batch_results.
+ */
+route_result_t * run_route_batch(thread_pool_t * pool,const map_graph_t * graph,const route_query_t * queries,size_t n_queries,bool want_paths);
+
+//Delete the result array of run_route_batch and every path in it.
+void delete_route_batch_results(route_result_t * results,size_t n_results);
+
+#endif
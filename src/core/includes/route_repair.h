@@ -0,0 +1,94 @@
+#ifndef ROUTE_REPAIR_H
+#define ROUTE_REPAIR_H
+
+#include "routing.h"
+#include "edge_closures.h"
+
+typedef struct Route_Repair route_repair_t;
+
+/*
+ * A route that is kept up to date as the costs of edges change, using Lifelong Planning A* with a zero
+ * heuristic. Every node keeps its cost g and a one step lookahead rhs worked out from its neighbours,
+ * when an edge changes only its two end points are checked again and only the nodes whose cost really
+ * changes are searched, instead of growing the whole tree again from the start.
+ *
+ * Edges change when a closure is added or removed (update_route_repair_edge) or when the map is edited
+ * and a new snapshot is taken (move_route_repair_to_graph).
+ */
+struct Route_Repair{
+	//the repair holds a reference to its graph
+	map_graph_t * graph;
+
+	//how edges are costed, the profile's edge weights are used when the function is a built in one
+	edge_cost_function_t edge_cost_function;
+	bool has_profile;
+	uint8_t profile;
+
+	//closures of graph, may be NULL, and the time they are looked at
+	const edge_closures_t * closures;
+	int64_t time;
+
+	uint32_t start;
+	uint32_t end;
+
+	//cost of every edge as last seen by the search
+	double * edge_costs;
+
+	//edges costed from their source edge in the map instead of the graph, see update_route_repair_source_edge.
+	//NULL until the first one.
+	uint8_t * costed_from_source;
+
+	//cost of every node, and the cost worked out from its neighbours. A node is consistent when they are equal.
+	double * g;
+	double * rhs;
+
+	//edge rhs was worked out through, UINT32_MAX for the start and unreached nodes
+	uint32_t * previous_edge;
+
+	//priority queue of inconsistent nodes, keyed by min(g,rhs). heap_position is UINT32_MAX for nodes not in it.
+	uint32_t * heap;
+	size_t heap_size;
+	double * key;
+	uint32_t * heap_position;
+
+	//how many nodes the last call to repair_route took off the queue
+	size_t n_updated;
+};
+
+/*
+ * Start keeping the route from start to end on a graph up to date. closures may be NULL.
+ * Nothing is searched until the first call to repair_route. Returns NULL for invalid arguments.
+ */
+route_repair_t * create_route_repair(map_graph_t * graph,const edge_closures_t * closures,int64_t time,uint32_t start,uint32_t end,edge_cost_function_t edge_cost_function);
+
+//Delete a route repair and release its graph.
+void delete_route_repair(route_repair_t * repair);
+
+//Bring the route up to date with every edge change seen so far. Returns false if the end can not be reached.
+bool repair_route(route_repair_t * repair);
+
+/*
+ * Look at the cost of one edge again, after it was closed or reopened. Returns true if its cost changed,
+ * the route is fixed by the next call to repair_route.
+ */
+bool update_route_repair_edge(route_repair_t * repair,uint32_t edge_index);
+
+/*
+ * Look at the cost of one edge again after its source edge was changed in place in the map, like with
+ * set_map_edge_type_in_map, without taking a new snapshot. From then on the edge is costed from the map
+ * until the repair moves to another graph. Returns true if its cost changed.
+ */
+bool update_route_repair_source_edge(route_repair_t * repair,uint32_t edge_index);
+
+/*
+ * Move a repair over to a newer snapshot of the same map, looking again at every edge whose cost changed,
+ * like after set_map_edge_type. closures belong to the new graph and may be NULL.
+ * Only edge costs can change this way: returns false and leaves the repair alone if nodes or edges were
+ * added or removed since the repair's graph was taken.
+ */
+bool move_route_repair_to_graph(route_repair_t * repair,map_graph_t * graph,const edge_closures_t * closures);
+
+//The route found by the last call to repair_route using the map's nodes, NULL if there is none.
+map_path_t * extract_repaired_route_path(const route_repair_t * repair);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef ROUTE_WORKER_H
+#define ROUTE_WORKER_H
+
+#include <pthread.h>
+#include "routing.h"
+
+typedef struct Route_Request route_request_t;
+typedef struct Route_Worker route_worker_t;
+
+/*
+ * A path query against a graph snapshot
+ */
+struct Route_Request{
+	map_graph_t * graph;
+	uint32_t start;
+	uint32_t end;
+	double (*edge_cost_function)(const map_edge_t * edge_ref);
+	uint8_t filter;
+	uint64_t generation;
+};
+
+/*
+ * Runs path queries on a background thread so the caller never blocks on a search.
+ * Only the newest query matters: submitting a query cancels the one being searched and
+ * replaces any that has not started yet.
+ */
+struct Route_Worker{
+	pthread_t thread;
+
+	//protects pending and shutting_down
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+
+	bool has_pending;
+	route_request_t pending;
+	bool shutting_down;
+
+	//generation of the newest query, a search stops once this moves past its own generation
+	uint64_t generation;
+
+	//called on the worker thread with every finished query that is still current, the callee owns the result
+	void (*on_result)(route_result_t * result,void * user_data);
+	void * user_data;
+
+	route_search_context_t * context;
+};
+
+//Create a worker and start its thread. on_result is called on the worker thread.
+route_worker_t * create_route_worker(void (*on_result)(route_result_t * result,void * user_data),void * user_data);
+
+//Cancel any running query, stop the thread and delete the worker.
+void delete_route_worker(route_worker_t * worker);
+
+/*
+ * Queue a path query between two map nodes on a snapshot. filter is a combination of SEARCH_FILTER_* flags.
+ * The worker holds a reference to the graph until the query finishes. Returns the generation of the query,
+ * or 0 if either node is not in the snapshot.
+ */
+uint64_t submit_route_query(route_worker_t * worker,map_graph_t * graph,const map_node_t * start,const map_node_t * end,double (*edge_cost_function)(const map_edge_t * edge_ref),uint8_t filter);
+
+//Cancel the current query without starting a new one. Call when the start, end or filter is cleared.
+void cancel_route_queries(route_worker_t * worker);
+
+//Generation of the newest query. A result whose generation differs from this is stale.
+uint64_t get_route_worker_generation(route_worker_t * worker);
+
+#endif
@@ -0,0 +1,213 @@
+#ifndef ROUTING_H
+#define ROUTING_H
+
+#include "map.h"
+#include "map_graph.h"
+#include <math.h>
+
+typedef struct Route_Heap_Entry route_heap_entry_t;
+typedef struct Route_Search_Context route_search_context_t;
+typedef struct Route_Result route_result_t;
+
+typedef double (*edge_cost_function_t)(const map_edge_t * edge_ref);
+typedef struct Edge_Closures edge_closures_t;
+
+//returned as the cost of an edge that can not be used
+#define EDGE_COST_IMPASSABLE INFINITY
+
+//used to give stairs and elevator shafts a length
+#define FLOOR_HEIGHT_METERS 4.0
+
+//mean earth radius used by the haversine formula
+#define EARTH_RADIUS_METERS 6371008.8
+
+//how many nodes are settled between checks for cancellation
+#define ROUTE_CANCEL_CHECK_INTERVAL 256
+
+//a previous_edge with this bit set is a shortcut across a building from the node in the low bits
+#define ROUTE_SHORTCUT_BIT 0x80000000u
+
+//who the route is for, each profile has its own calculate_*_edge_cost function
+#define ROUTE_PROFILE_WHEELCHAIR 0
+#define ROUTE_PROFILE_WALKER 1
+#define ROUTE_PROFILE_DELIVERER 2
+#define ROUTE_PROFILE_DRIVER 3
+#define N_ROUTE_PROFILES 4
+
+struct Route_Heap_Entry{
+	double cost;
+	uint32_t node;
+};
+
+/*
+ * Scratch memory for a single search. Reusing one context for many searches avoids
+ * allocating per query, and one context per thread lets searches run in parallel.
+ */
+struct Route_Search_Context{
+	size_t n_nodes;
+
+	//best known cost of every node, only meaningful when stamp[i] == current_stamp
+	double * cost;
+
+	//edge used to reach every node, UINT32_MAX for the start node
+	uint32_t * previous_edge;
+
+	//stamp[i] == current_stamp means node i has been reached in the current search
+	uint32_t * stamp;
+	uint32_t current_stamp;
+
+	//priority queue of nodes to visit, may contain outdated entries
+	route_heap_entry_t * heap;
+	size_t heap_size;
+	size_t heap_capacity;
+
+	//if not NULL the search gives up as soon as *cancel_counter no longer equals cancel_ticket
+	const uint64_t * cancel_counter;
+	uint64_t cancel_ticket;
+
+	//if not NULL every node is appended here when it is settled, see record_settled_nodes
+	uint32_t * settled;
+	size_t n_settled;
+};
+
+/*
+ * The outcome of a path query
+ */
+struct Route_Result{
+	//identifies the query of a route worker that produced this result, 0 in a batch
+	uint64_t generation;
+
+	//position of the query in its batch, see run_route_batch, 0 for a route worker
+	size_t query_index;
+
+	//false if the end can not be reached or the search was cancelled
+	bool found;
+
+	//total cost of the path, EDGE_COST_IMPASSABLE if not found
+	double cost;
+
+	//the path using the map's nodes, NULL if not found
+	map_path_t * path;
+};
+
+//Length of an edge in meters. Uses the haversine distance plus the height of any floors climbed.
+double get_map_edge_length(const map_edge_t * edge_ref);
+
+//Get the edge cost function of a ROUTE_PROFILE_*. Returns NULL for an unknown profile.
+edge_cost_function_t get_route_profile_cost_function(uint8_t profile);
+
+//Find which ROUTE_PROFILE_* a cost function belongs to. Returns false for custom cost functions.
+bool get_route_profile_of_cost_function(edge_cost_function_t edge_cost_function,uint8_t * profile_out);
+
+//Create a search context for graphs with up to n_nodes nodes on the heap.
+route_search_context_t * create_route_search_context(size_t n_nodes);
+
+//Delete a search context.
+void delete_route_search_context(route_search_context_t * context);
+
+/*
+ * Find the least cost path between two node indices of a graph using Dijkstra's Algorithm.
+ * Returns false if there is no path or the search was cancelled.
+ * The search tree is left in the context so the path can be extracted afterwards.
+ * The calculate_*_edge_cost functions are recognised and run the search of their profile,
+ * any other cost function falls back to search_map_graph_through_pointer.
+ */
+bool search_map_graph(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,double (*edge_cost_function)(const map_edge_t * edge_ref));
+
+//Same as search_map_graph but every edge cost is a call through edge_cost_function.
+bool search_map_graph_through_pointer(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,double (*edge_cost_function)(const map_edge_t * edge_ref));
+
+//Same as search_map_graph for a ROUTE_PROFILE_*, reading the edge costs from the snapshot's edge weights.
+bool search_map_graph_with_profile(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,uint8_t profile);
+
+/*
+ * Same as search_map_graph_with_profile as an A* search, guided toward end by the straight line distance on the
+ * graph's projection, see projection.h. Finds the same cost while settling far fewer nodes on open ground. The
+ * guidance weakens on maps spanning many degrees of latitude and is dropped on maps near the poles.
+ */
+bool search_map_graph_with_heuristic(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,uint8_t profile);
+
+//Same as search_map_graph but never uses an edge left out by filter, a combination of SEARCH_FILTER_* flags.
+bool search_map_graph_with_filter(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,double (*edge_cost_function)(const map_edge_t * edge_ref),uint8_t filter);
+
+/*
+ * Same as search_map_graph_with_profile but only edges whose bit is set in allowed_edges are used, bit j of
+ * word j/64 for edge j. Gives up once the path through the next node would cost more than cost_limit.
+ * end_tree may be NULL, or a tree grown from end by grow_route_search_tree for the same profile with every edge
+ * allowed. Its costs then guide the search to end as an A* heuristic.
+ */
+bool search_map_graph_with_allowed_edges(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,uint8_t profile,const uint64_t * allowed_edges,double cost_limit,const route_search_context_t * end_tree);
+
+/*
+ * Same as search_map_graph but never uses an edge closed at time, see edge_closures.h.
+ * closures must belong to graph.
+ */
+bool search_map_graph_with_closures(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,double (*edge_cost_function)(const map_edge_t * edge_ref),const edge_closures_t * closures,int64_t time);
+
+/*
+ * Same as search_map_graph_with_profile for a route leaving at departure_time, in seconds since the epoch.
+ * Every edge is checked against the schedules compiled into the graph, see schedules.h, at the time the
+ * route gets to it: a closed edge can still be used after waiting for it to open, and the wait is part of
+ * the cost. If closures is not NULL an edge closed at that time is waited for the same way until its closure
+ * ends, an edge closed for good is not used. Costs turn into times with
+ * route_profile_meters_per_second, get_route_arrival_time gives the arrival at end.
+ */
+bool search_map_graph_at_time(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,uint8_t profile,int64_t departure_time,const edge_closures_t * closures);
+
+/*
+ * Same as search_map_graph but floors that can not be on a shortest path, like the upper floors of a building
+ * that is only passed through, are never searched. The cost found is the same. See mark_floor_layers_for_route.
+ */
+bool search_map_graph_by_floor_layers(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,double (*edge_cost_function)(const map_edge_t * edge_ref));
+
+/*
+ * Grow a shortest path tree from start until every node marked in targets (n_targets of them) is
+ * settled, or until the next node would cost more than cost_limit. Pass NULL targets to grow the
+ * whole tree up to cost_limit. profile is a ROUTE_PROFILE_*. Returns false if some target could not be reached.
+ * Afterwards context->cost holds the exact cost of every settled node.
+ */
+bool grow_route_search_tree(const map_graph_t * graph,route_search_context_t * context,uint32_t start,const uint8_t * targets,size_t n_targets,double cost_limit,uint8_t profile);
+
+/*
+ * Go on growing a whole tree left in the context by grow_route_search_tree, up to a higher cost_limit and with
+ * the same graph and profile. Nodes that were already settled are not searched again.
+ */
+bool extend_route_search_tree(const map_graph_t * graph,route_search_context_t * context,double cost_limit,uint8_t profile);
+
+/*
+ * Make every later search with the context append the nodes it settles to context->settled, in the order they
+ * are settled. A new search starts the list over, extend_route_search_tree appends to it. A* searches guided by a
+ * heuristic do not record.
+ */
+void record_settled_nodes(route_search_context_t * context);
+
+//Grow the whole tree from start up to cost_limit with edge j costing weights[j], EDGE_COST_IMPASSABLE if it can not be used.
+bool grow_route_search_tree_with_weights(const map_graph_t * graph,route_search_context_t * context,uint32_t start,double cost_limit,const float * weights);
+
+/*
+ * Grow a shortest path tree from start over the inside of one building of routes, never leaving it.
+ * profile is a ROUTE_PROFILE_*.
+ */
+bool grow_building_interior_tree(const map_graph_t * graph,const building_routes_t * routes,route_search_context_t * context,uint32_t start,uint32_t building_index,uint8_t profile);
+
+/*
+ * Same as search_map_graph_with_profile but buildings that hold neither the start nor the end are never
+ * searched inside, they are crossed from entrance to entrance using the tables in graph->building_routes.
+ * If closures is not NULL edges closed at time are not used, and buildings with closed edges inside
+ * are searched directly. Extract the path with extract_building_route_path.
+ */
+bool search_map_graph_by_buildings(const map_graph_t * graph,route_search_context_t * context,uint32_t start,uint32_t end,uint8_t profile,const edge_closures_t * closures,int64_t time);
+
+//Same as extract_route_path for a search_map_graph_by_buildings search, filling in the way across every building.
+map_path_t * extract_building_route_path(const map_graph_t * graph,const route_search_context_t * context,uint32_t end,uint8_t profile);
+
+//Was a node reached by the last search in a context?
+bool route_search_reached(const route_search_context_t * context,uint32_t node);
+
+//Turn the search tree in a context into a path of map nodes ending at end. Returns NULL if end was not reached.
+map_path_t * extract_route_path(const map_graph_t * graph,const route_search_context_t * context,uint32_t end);
+
+//Delete a route result and its path.
+void delete_route_result(route_result_t * result);
+
+#endif
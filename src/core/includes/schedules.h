@@ -0,0 +1,110 @@
+#ifndef SCHEDULES_H
+#define SCHEDULES_H
+
+#include "routing.h"
+
+typedef struct Schedule schedule_t;
+typedef struct Schedule_Tables schedule_tables_t;
+
+#define SCHEDULE_DAY_SECONDS 86400
+#define SCHEDULE_WEEK_SECONDS 604800
+
+//schedules are kept to whole minutes, one table entry per minute of the week
+#define SCHEDULE_SLOT_SECONDS 60
+#define SCHEDULE_WEEK_SLOTS (SCHEDULE_WEEK_SECONDS/SCHEDULE_SLOT_SECONDS)
+
+//table entry of a slot from which the schedule never opens again
+#define SCHEDULE_NEVER_OPEN UINT16_MAX
+
+//edge_table value of an edge without a schedule
+#define SCHEDULE_ALWAYS_OPEN UINT32_MAX
+
+//how fast every ROUTE_PROFILE_* covers one unit of route cost, used to turn costs into times and back
+static const double route_profile_meters_per_second[N_ROUTE_PROFILES] = {
+	1.0,//wheelchair
+	1.3,//walker
+	1.2,//deliverer
+	8.0//driver
+};
+
+/*
+ * Weekly hours during which something is open, like a building's opening hours or an automatic door that
+ * is locked at night. Times are seconds since Monday 00:00, a week never has an interval open.
+ */
+struct Schedule{
+	int32_t * open;
+	int32_t * close;
+	size_t n_intervals;
+	size_t intervals_capacity;
+};
+
+/*
+ * Every schedule that applies to an edge of a graph snapshot, compiled into tables when the snapshot is taken.
+ * An edge follows its own map_edge_t::schedule and the opening hours of the buildings of both of its nodes,
+ * so the inside of a building and its doors are only usable while it is open.
+ * Edges whose schedules have the same intervals, added in the same order, share one table.
+ */
+struct Schedule_Tables{
+	size_t n_tables;
+
+	//wait_slots[t*SCHEDULE_WEEK_SLOTS + s] is how many slots table t waits from slot s until it is open,
+	//0 while it is open and SCHEDULE_NEVER_OPEN if it never opens
+	uint16_t * wait_slots;
+
+	//table of every edge, SCHEDULE_ALWAYS_OPEN for edges no schedule applies to
+	uint32_t * edge_table;
+};
+
+//Create an empty schedule on the heap, it is never open until intervals are added.
+schedule_t * create_schedule(void);
+
+//Delete a schedule.
+void delete_schedule(schedule_t * schedule);
+
+/*
+ * Open a schedule from open_time up to but not including close_time, in seconds since Monday 00:00.
+ * Both are rounded down to whole minutes. A close_time before open_time or past the end of the week wraps
+ * around into the next week, so Sunday 22:00 to Monday 02:00 is one interval.
+ */
+void add_schedule_interval(schedule_t * schedule,int32_t open_time,int32_t close_time);
+
+//Seconds since Monday 00:00 of a time in seconds since the epoch, which was on a Thursday.
+static inline int64_t get_schedule_week_time(int64_t time){
+	int64_t week_time = (time + 3*SCHEDULE_DAY_SECONDS) % SCHEDULE_WEEK_SECONDS;
+	return (week_time < 0) ? week_time + SCHEDULE_WEEK_SECONDS : week_time;
+}
+
+//Is a schedule open at a time since the epoch? Goes through every interval, searches use the tables.
+bool schedule_open_at(const schedule_t * schedule,int64_t time);
+
+/*
+ * Compile the schedules of every edge of a graph. Reads the schedules through the source edges and the
+ * buildings of the nodes, so it runs on the thread editing the map while the snapshot is taken.
+ */
+schedule_tables_t * create_schedule_tables(const map_graph_t * graph);
+
+//Delete compiled schedule tables.
+void delete_schedule_tables(schedule_tables_t * tables);
+
+/*
+ * Seconds to wait at time before edge j can be used, 0 if it is open and INFINITY if it never opens. O(1).
+ */
+static inline double get_schedule_wait_seconds(const schedule_tables_t * tables,uint32_t edge_index,int64_t time){
+	uint32_t table = tables->edge_table[edge_index];
+	if(table == SCHEDULE_ALWAYS_OPEN) return 0.0;
+
+	int64_t week_time = get_schedule_week_time(time);
+	uint16_t wait_slots = tables->wait_slots[(size_t) table*SCHEDULE_WEEK_SLOTS + week_time/SCHEDULE_SLOT_SECONDS];
+	if(wait_slots == 0) return 0.0;
+	if(wait_slots == SCHEDULE_NEVER_OPEN) return INFINITY;
+
+	//the wait starts from the beginning of the current slot
+	return (double) (wait_slots*SCHEDULE_SLOT_SECONDS - week_time % SCHEDULE_SLOT_SECONDS);
+}
+
+//Seconds since the epoch at which a route of a ROUTE_PROFILE_* that left at departure_time arrives, given its cost.
+static inline int64_t get_route_arrival_time(uint8_t profile,int64_t departure_time,double cost){
+	return departure_time + (int64_t) ceil(cost/route_profile_meters_per_second[profile]);
+}
+
+#endif
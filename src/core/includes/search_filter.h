@@ -0,0 +1,25 @@
+#ifndef SEARCH_FILTER_H
+#define SEARCH_FILTER_H
+
+#include "map_graph.h"
+
+//Pack the exclude_* options into SEARCH_FILTER_* flags. NULL options is SEARCH_FILTER_NONE.
+uint8_t compile_search_filter(const search_filter_options_t * options);
+
+//Is edge j of a graph left out by a combination of SEARCH_FILTER_* flags?
+bool map_graph_edge_excluded_by_filter(const map_graph_t * graph,uint32_t edge_index,uint8_t filter);
+
+/*
+ * Get the bitset of edges a filter allows, bit j of word j/64 is set if edge j may be used.
+ * The bitset is built the first time a filter is used on a graph and kept with the graph, so later
+ * searches with the same filter pay nothing extra. Returns NULL for SEARCH_FILTER_NONE.
+ * Safe to call from any thread.
+ */
+const uint64_t * get_search_filter_bitset(const map_graph_t * graph,uint8_t filter);
+
+//Is edge j allowed by a bitset from get_search_filter_bitset?
+static inline bool search_filter_allows(const uint64_t * bitset,uint32_t edge_index){
+	return (bitset[edge_index >> 6] >> (edge_index & 63)) & 1;
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef STRING_INTERNER_H
+#define STRING_INTERNER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct String_Interner string_interner_t;
+typedef struct String_Arena_Block string_arena_block_t;
+
+//the id of no string, for fields that have no interned string
+#define STRING_ID_NONE UINT32_MAX
+
+//bytes in one block of the arena, longer strings get a block of their own
+#define STRING_ARENA_BLOCK_SIZE 65536
+
+/*
+ * A piece of the arena. Blocks are never moved or grown, so a string keeps its address for as long as
+ * the interner lives and can be handed out as a plain const char *.
+ */
+struct String_Arena_Block{
+	char * bytes;
+	size_t size;
+	size_t capacity;
+	string_arena_block_t * next;
+};
+
+/*
+ * Every distinct string stored once in an arena and named by a 32-bit id. Interning the same text twice
+ * gives the same id and the same address, so comparing interned strings is comparing ids.
+ * Ids count up from 0 in the order strings were first interned, and nothing is ever removed.
+ */
+struct String_Interner{
+	//the text of string id is strings[id], lengths[id] bytes long without the '\0'
+	const char ** strings;
+	uint32_t * lengths;
+	uint32_t * hashes;
+	size_t n_strings;
+	size_t strings_capacity;
+
+	//open addressing table of ids, STRING_ID_NONE in empty slots. The number of slots is a power of two.
+	uint32_t * slots;
+	size_t n_slots;
+
+	//blocks of the arena, the one being filled first
+	string_arena_block_t * blocks;
+	size_t arena_bytes;
+};
+
+//Create an empty interner on the heap.
+string_interner_t * create_string_interner(void);
+
+//Delete an interner. Every string it handed out goes with it.
+void delete_string_interner(string_interner_t * interner);
+
+//Id of a string, storing it first if it is new.
+uint32_t intern_string(string_interner_t * interner,const char * string);
+
+//Id of a string if it was ever interned, STRING_ID_NONE if not. Never stores anything.
+uint32_t find_interned_string(const string_interner_t * interner,const char * string);
+
+//The text of an id, NULL for STRING_ID_NONE or an id the interner never gave out.
+const char * get_interned_string(const string_interner_t * interner,uint32_t id);
+
+//Heap bytes the interner uses, arena and tables together.
+size_t get_string_interner_bytes(const string_interner_t * interner);
+
+/*
+ * The string section of a map file: the number of strings as a uint32_t then every string with its '\0'
+ * in id order. Ids in the rest of the file stay valid because reading interns the strings in the same order.
+ * The caller frees the buffer.
+ */
+uint8_t * write_string_section(const string_interner_t * interner,size_t * buffer_size);
+
+//Intern every string of a section written by write_string_section into an empty interner, so the ids come out the same.
+//Returns false if the section is cut short.
+bool read_string_section(string_interner_t * interner,const uint8_t * buffer,size_t buffer_size);
+
+#endif
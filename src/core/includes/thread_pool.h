@@ -0,0 +1,72 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+//Most tasks handed out at once, the largest end a packed range can hold
+#define THREAD_POOL_MAX_CHUNK_TASKS ((size_t) UINT32_MAX)
+
+typedef struct Thread_Pool_Worker thread_pool_worker_t;
+typedef struct Thread_Pool thread_pool_t;
+
+/*
+ * The tasks a worker still owns, packed as (first << 32) | end so that the owner
+ * and thieves can both take tasks with a single compare and swap.
+ * Padded to a cache line so workers do not contend on each other's ranges.
+ */
+struct Thread_Pool_Worker{
+	pthread_t thread;
+	uint64_t range;
+	uint8_t padding[64 - sizeof(pthread_t) - sizeof(uint64_t)];
+};
+
+/*
+ * A fixed set of threads that run a batch of independent tasks.
+ * Every worker starts with an equal share of the batch and steals half of the biggest
+ * remaining share when it runs out, so uneven tasks still keep every core busy.
+ */
+struct Thread_Pool{
+	thread_pool_worker_t * workers;
+	size_t n_workers;
+
+	//protects everything below
+	pthread_mutex_t lock;
+	pthread_cond_t job_ready;
+	pthread_cond_t job_done;
+
+	//the current batch
+	uint64_t job_generation;
+	void (*task)(size_t task_index,size_t worker_index,void * user_data);
+	void * user_data;
+	size_t n_busy_workers;
+
+	//index of the first task of the current chunk, ranges only count within a chunk
+	size_t task_offset;
+
+	//most tasks per chunk, at most THREAD_POOL_MAX_CHUNK_TASKS, only lowered by tests
+	size_t max_chunk_tasks;
+
+	bool shutting_down;
+};
+
+//Number of cores available to this process.
+size_t get_number_of_cpus(void);
+
+//Create a pool with n_workers threads on the heap. Zero means one per core.
+thread_pool_t * create_thread_pool(size_t n_workers);
+
+//Stop every thread and delete the pool.
+void delete_thread_pool(thread_pool_t * pool);
+
+/*
+ * Run task(i,worker,user_data) for every i below n_tasks and wait until all are done.
+ * worker is below pool->n_workers and identifies the thread, use it to index per thread scratch memory.
+ * Only one batch runs at a time, and a task must not start another batch on the same pool.
+ * Ranges are packed in 32 bits so a batch of more than pool->max_chunk_tasks tasks runs as
+ * several chunks one after the other.
+ */
+void run_thread_pool_tasks(thread_pool_t * pool,size_t n_tasks,void (*task)(size_t task_index,size_t worker_index,void * user_data),void * user_data);
+
+#endif
@@ -1,6 +1,31 @@
 #include "tester.h"
 #include "map.h"
+#include "routing.h"
+#include "route_worker.h"
+#include "map_publisher.h"
+#include "route_batch.h"
+#include "distance_matrix.h"
+#include "edge_weights.h"
+#include "search_filter.h"
+#include "floor_layers.h"
+#include "building_routes.h"
+#include "edge_closures.h"
+#include "route_repair.h"
+#include "route_alternatives.h"
+#include "pareto_routes.h"
+#include "isochrone.h"
+#include "schedules.h"
+#include "projection.h"
+#include "node_order.h"
+#include "string_interner.h"
+#include "image_cache.h"
+#include "raster_import.h"
+#include "map_import.h"
+#include "campus_generator.h"
 #include <stdio.h>
+#include <string.h>
+#include <png.h>
+#include <jpeglib.h>
 
 int main(){
 	//building_data_structure_test();
@@ -8,6 +33,30 @@ int main(){
 	//mpo_data_structure_test();
 	
 	map_construction_test();
+	routing_test();
+	route_worker_test();
+	map_publisher_test();
+	route_batch_test();
+	distance_matrix_test();
+	edge_weights_test();
+	search_filter_test();
+	node_flags_test();
+	floor_layers_test();
+	building_routes_test();
+	edge_closures_test();
+	route_repair_test();
+	route_alternatives_test();
+	pareto_routes_test();
+	isochrone_test();
+	schedules_test();
+	projection_test();
+	node_order_test();
+	hot_nodes_test();
+	string_interner_test();
+	image_cache_test();
+	raster_import_test();
+	map_import_test();
+	campus_generator_test();
 	
 	do_thing();
 	fputs("End of program\n",stdout);
@@ -83,4 +132,1916 @@ void building_data_structure_test(){
 	building_to_output_stream(building,0,stdout);
 	
 	delete_building(building);
-}
\ No newline at end of file
+}
+
+/*
+ * A small map where the short way uses stairs and the long way uses a ramp
+ */
+static void build_stairs_or_ramp_map(map_t * map){
+	const char * names[5] = {"Lot","Stairs Top","Ramp Bottom","Ramp Top","Library"};
+	cord_t cords[5] = {
+		create_cord(-76.7130,39.2550),
+		create_cord(-76.7125,39.2552),
+		create_cord(-76.7130,39.2560),
+		create_cord(-76.7122,39.2562),
+		create_cord(-76.7120,39.2553)
+	};
+	
+	for(size_t i = 0;i < 5;i++){
+		map_node_t * node = create_map_node(cords[i]);
+		set_map_node_name(node,names[i]);
+		set_map_node_selectable(node,true);
+		add_node_to_map(map,node);
+	}
+	
+	connect_nodes_in_map_by_names(map,"Lot","Stairs Top",EDGE_TYPE_STAIRS);
+	connect_nodes_in_map_by_names(map,"Stairs Top","Library",EDGE_TYPE_SIDEWALK);
+	connect_nodes_in_map_by_names(map,"Lot","Ramp Bottom",EDGE_TYPE_SIDEWALK);
+	connect_nodes_in_map_by_names(map,"Ramp Bottom","Ramp Top",EDGE_TYPE_RAMP);
+	connect_nodes_in_map_by_names(map,"Ramp Top","Library",EDGE_TYPE_SIDEWALK);
+}
+
+/*
+ * Two outdoor paths joined through the ground floor of a three floor building with a room on every floor.
+ * Nodes are named "Outside West", "Outside East", "West Door", "East Door" and "Room 1" to "Room 3".
+ */
+static void build_multi_floor_map(map_t * map){
+	building_t * building = create_building("Engineering",create_map_rect(create_cord(-76.7140,39.2540),create_cord(-76.7120,39.2550)),3);
+	add_building_to_map(map,building);
+	
+	const char * outside_names[2] = {"Outside West","Outside East"};
+	cord_t outside_cords[2] = {create_cord(-76.7145,39.2545),create_cord(-76.7115,39.2545)};
+	for(size_t i = 0;i < 2;i++){
+		map_node_t * node = create_map_node(outside_cords[i]);
+		set_map_node_name(node,outside_names[i]);
+		add_node_to_map(map,node);
+	}
+	
+	const char * inside_names[5] = {"West Door","East Door","Room 1","Room 2","Room 3"};
+	cord_t inside_cords[5] = {
+		create_cord(-76.7139,39.2545),
+		create_cord(-76.7121,39.2545),
+		create_cord(-76.7130,39.2546),
+		create_cord(-76.7130,39.2546),
+		create_cord(-76.7130,39.2546)
+	};
+	int8_t inside_floors[5] = {1,1,1,2,3};
+	for(size_t i = 0;i < 5;i++){
+		map_node_t * node = create_map_node(inside_cords[i]);
+		set_map_node_name(node,inside_names[i]);
+		set_map_node_building(node,building);
+		set_map_node_floor_number(node,inside_floors[i]);
+		add_node_to_map(map,node);
+	}
+	
+	connect_nodes_in_map_by_names(map,"Outside West","West Door",EDGE_TYPE_AUTO_DOOR);
+	connect_nodes_in_map_by_names(map,"West Door","Room 1",EDGE_TYPE_HALLWAY);
+	connect_nodes_in_map_by_names(map,"Room 1","East Door",EDGE_TYPE_HALLWAY);
+	connect_nodes_in_map_by_names(map,"East Door","Outside East",EDGE_TYPE_AUTO_DOOR);
+	connect_nodes_in_map_by_names(map,"Room 1","Room 2",EDGE_TYPE_ELEVATOR_SHAFT);
+	connect_nodes_in_map_by_names(map,"Room 2","Room 3",EDGE_TYPE_ELEVATOR_SHAFT);
+}
+
+/*
+ * Two outdoor nodes joined through a two floor building. The ground floor hallway between the doors winds far to
+ * the south, the upper floor has a straight corridor between two stairs that land at the doors. Nodes are named
+ * "Outside West", "Outside East", "West Door", "East Door", "South West", "South East", "Upper West" and "Upper East".
+ */
+static void build_upper_shortcut_map(map_t * map){
+	building_t * building = create_building("Annex",create_map_rect(create_cord(-76.7140,39.2520),create_cord(-76.7120,39.2550)),2);
+	add_building_to_map(map,building);
+	
+	const char * outside_names[2] = {"Outside West","Outside East"};
+	cord_t outside_cords[2] = {create_cord(-76.7145,39.2545),create_cord(-76.7115,39.2545)};
+	for(size_t i = 0;i < 2;i++){
+		map_node_t * node = create_map_node(outside_cords[i]);
+		set_map_node_name(node,outside_names[i]);
+		add_node_to_map(map,node);
+	}
+	
+	const char * inside_names[6] = {"West Door","East Door","South West","South East","Upper West","Upper East"};
+	cord_t inside_cords[6] = {
+		create_cord(-76.7139,39.2545),
+		create_cord(-76.7121,39.2545),
+		create_cord(-76.7139,39.2521),
+		create_cord(-76.7121,39.2521),
+		create_cord(-76.7139,39.2545),
+		create_cord(-76.7121,39.2545)
+	};
+	int8_t inside_floors[6] = {1,1,1,1,2,2};
+	for(size_t i = 0;i < 6;i++){
+		map_node_t * node = create_map_node(inside_cords[i]);
+		set_map_node_name(node,inside_names[i]);
+		set_map_node_building(node,building);
+		set_map_node_floor_number(node,inside_floors[i]);
+		add_node_to_map(map,node);
+	}
+	
+	connect_nodes_in_map_by_names(map,"Outside West","West Door",EDGE_TYPE_AUTO_DOOR);
+	connect_nodes_in_map_by_names(map,"West Door","South West",EDGE_TYPE_HALLWAY);
+	connect_nodes_in_map_by_names(map,"South West","South East",EDGE_TYPE_HALLWAY);
+	connect_nodes_in_map_by_names(map,"South East","East Door",EDGE_TYPE_HALLWAY);
+	connect_nodes_in_map_by_names(map,"East Door","Outside East",EDGE_TYPE_AUTO_DOOR);
+	connect_nodes_in_map_by_names(map,"West Door","Upper West",EDGE_TYPE_STAIRS);
+	connect_nodes_in_map_by_names(map,"Upper West","Upper East",EDGE_TYPE_HALLWAY);
+	connect_nodes_in_map_by_names(map,"Upper East","East Door",EDGE_TYPE_STAIRS);
+}
+
+//Index of the edge between two nodes of a graph, UINT32_MAX if they are not connected
+static uint32_t find_graph_edge(const map_graph_t * graph,uint32_t a,uint32_t b){
+	for(size_t i = graph->adjacency_offsets[a];i < graph->adjacency_offsets[a+1];i++){
+		if(graph->adjacency_nodes[i] == b) return graph->adjacency_edges[i];
+	}
+	return UINT32_MAX;
+}
+
+static void print_path(const map_path_t * path){
+	if(path == NULL){
+		fputs("\tno path\n",stdout);
+		return;
+	}
+	for(size_t i = 0;i < path->n_nodes;i++){
+		fprintf(stdout,"\t%s\n",path->nodes[i]->name);
+	}
+}
+
+void routing_test(){
+	map_t map = init_map();
+	build_stairs_or_ramp_map(&map);
+	
+	map.active_start = map.all_nodes[0];
+	map.active_end = map.all_nodes[4];
+	
+	map.active_edge_cost_function = calculate_walker_edge_cost;
+	find_best_path(&map);
+	fputs("Walker path:\n",stdout);
+	print_path(map.active_path);
+	
+	map.active_edge_cost_function = calculate_wheelchair_edge_cost;
+	find_best_path(&map);
+	fputs("Wheelchair path:\n",stdout);
+	print_path(map.active_path);
+	
+	map.active_edge_cost_function = calculate_driver_edge_cost;
+	find_best_path(&map);
+	fputs("Driver path:\n",stdout);
+	print_path(map.active_path);
+	
+	clear_map(&map);
+}
+
+typedef struct Route_Worker_Test_State{
+	pthread_mutex_t lock;
+	pthread_cond_t done;
+	route_result_t * result;
+} route_worker_test_state_t;
+
+static void route_worker_test_on_result(route_result_t * result,void * user_data){
+	route_worker_test_state_t * state = (route_worker_test_state_t*) user_data;
+	
+	pthread_mutex_lock(&(state->lock));
+	state->result = result;
+	pthread_cond_signal(&(state->done));
+	pthread_mutex_unlock(&(state->lock));
+}
+
+void route_worker_test(){
+	map_t map = init_map();
+	build_stairs_or_ramp_map(&map);
+	
+	route_worker_test_state_t state;
+	pthread_mutex_init(&(state.lock),NULL);
+	pthread_cond_init(&(state.done),NULL);
+	state.result = NULL;
+	
+	route_worker_t * worker = create_route_worker(route_worker_test_on_result,&state);
+	map_graph_t * graph = create_map_graph(&map);
+	
+	//the first query is replaced before it can be delivered
+	submit_route_query(worker,graph,map.all_nodes[0],map.all_nodes[1],calculate_walker_edge_cost,SEARCH_FILTER_NONE);
+	uint64_t generation = submit_route_query(worker,graph,map.all_nodes[0],map.all_nodes[4],calculate_wheelchair_edge_cost,SEARCH_FILTER_NONE);
+	
+	pthread_mutex_lock(&(state.lock));
+	while(state.result == NULL || state.result->generation != generation){
+		if(state.result != NULL){
+			delete_route_result(state.result);
+			state.result = NULL;
+		}
+		pthread_cond_wait(&(state.done),&(state.lock));
+	}
+	pthread_mutex_unlock(&(state.lock));
+	
+	fprintf(stdout,"Background wheelchair path (cost %.1lf):\n",state.result->cost);
+	print_path(state.result->path);
+	
+	delete_route_result(state.result);
+	delete_route_worker(worker);
+	release_map_graph(graph);
+	pthread_cond_destroy(&(state.done));
+	pthread_mutex_destroy(&(state.lock));
+	clear_map(&map);
+}
+
+typedef struct Publisher_Test_Reader{
+	pthread_t thread;
+	map_publisher_t * publisher;
+	bool * stop;
+	size_t n_snapshots_read;
+} publisher_test_reader_t;
+
+static void * publisher_test_reader_main(void * argument){
+	publisher_test_reader_t * reader = (publisher_test_reader_t*) argument;
+	size_t slot = register_map_reader(reader->publisher);
+	route_search_context_t * context = NULL;
+	
+	while(!__atomic_load_n(reader->stop,__ATOMIC_ACQUIRE)){
+		const map_graph_t * graph = acquire_map_snapshot(reader->publisher,slot);
+		
+		if(context == NULL || context->n_nodes < graph->n_nodes){
+			delete_route_search_context(context);
+			context = create_route_search_context(graph->n_nodes);
+		}
+		search_map_graph(graph,context,0,graph->n_nodes-1,calculate_walker_edge_cost);
+		
+		release_map_snapshot(reader->publisher,slot);
+		reader->n_snapshots_read++;
+	}
+	
+	delete_route_search_context(context);
+	unregister_map_reader(reader->publisher,slot);
+	return NULL;
+}
+
+void map_publisher_test(){
+	map_t map = init_map();
+	build_stairs_or_ramp_map(&map);
+	
+	map_publisher_t * publisher = create_map_publisher(&map);
+	bool stop = false;
+	
+	publisher_test_reader_t readers[2];
+	for(size_t i = 0;i < 2;i++){
+		readers[i].publisher = publisher;
+		readers[i].stop = &stop;
+		readers[i].n_snapshots_read = 0;
+		pthread_create(&(readers[i].thread),NULL,publisher_test_reader_main,&(readers[i]));
+	}
+	
+	//extend a path of sidewalks while the readers search, one snapshot per batch of two edits
+	for(size_t i = 0;i < 50;i++){
+		map_t * edited = begin_map_edit(publisher);
+		map_node_t * last = edited->all_nodes[edited->n_nodes-1];
+		map_node_t * next = create_map_node(create_cord(last->coordinate.longitude+0.0001,last->coordinate.latitude));
+		add_node_to_map(edited,next);
+		connect_nodes_in_map(edited,last,next,EDGE_TYPE_SIDEWALK);
+		end_map_edit(publisher);
+	}
+	
+	__atomic_store_n(&stop,true,__ATOMIC_RELEASE);
+	for(size_t i = 0;i < 2;i++) pthread_join(readers[i].thread,NULL);
+	
+	size_t n_left = reclaim_map_snapshots(publisher);
+	size_t slot = register_map_reader(publisher);
+	const map_graph_t * newest = acquire_map_snapshot(publisher,slot);
+	fprintf(stdout,"Published snapshot has %lu nodes, %lu old snapshots left after readers drained\n",newest->n_nodes,n_left);
+	release_map_snapshot(publisher,slot);
+	unregister_map_reader(publisher,slot);
+	
+	delete_map_publisher(publisher);
+	clear_map(&map);
+}
+
+void route_batch_test(){
+	map_t map = init_map();
+	build_stairs_or_ramp_map(&map);
+	map_graph_t * graph = create_map_graph(&map);
+	
+	//every node to every node for every profile
+	size_t n_queries = graph->n_nodes*graph->n_nodes*N_ROUTE_PROFILES;
+	route_query_t * queries = (route_query_t*) malloc(sizeof(route_query_t)*n_queries);
+	size_t at = 0;
+	for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+		for(uint32_t start = 0;start < graph->n_nodes;start++){
+			for(uint32_t end = 0;end < graph->n_nodes;end++){
+				queries[at].start = start;
+				queries[at].end = end;
+				queries[at].profile = profile;
+				queries[at].filter = SEARCH_FILTER_NONE;
+				at++;
+			}
+		}
+	}
+	
+	thread_pool_t * pool = create_thread_pool(4);
+	route_result_t * results = run_route_batch(pool,graph,queries,n_queries,true);
+	
+	//compare against one search at a time
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	size_t n_mismatches = 0;
+	size_t n_found = 0;
+	for(size_t i = 0;i < n_queries;i++){
+		bool found = search_map_graph_through_pointer(graph,context,queries[i].start,queries[i].end,get_route_profile_cost_function(queries[i].profile));
+		if(found != results[i].found || results[i].query_index != i) n_mismatches++;
+		//edge weights are stored as floats so allow for rounding
+		if(found && fabs(context->cost[queries[i].end] - results[i].cost) > 1e-4*(1.0 + context->cost[queries[i].end])) n_mismatches++;
+		if(found) n_found++;
+	}
+	fprintf(stdout,"Batch of %lu queries: %lu routes found, %lu differ from the function pointer search\n",n_queries,n_found,n_mismatches);
+	delete_route_batch_results(results,n_queries);
+	
+	//the same batch handed out in small chunks, as a batch beyond 32 bit ranges would be
+	pool->max_chunk_tasks = 7;
+	results = run_route_batch(pool,graph,queries,n_queries,false);
+	size_t n_chunk_mismatches = 0;
+	for(size_t i = 0;i < n_queries;i++){
+		bool found = search_map_graph_through_pointer(graph,context,queries[i].start,queries[i].end,get_route_profile_cost_function(queries[i].profile));
+		if(found != results[i].found || results[i].query_index != i) n_chunk_mismatches++;
+	}
+	fprintf(stdout,"Batch in chunks of %lu: %lu differ\n",pool->max_chunk_tasks,n_chunk_mismatches);
+	
+	delete_route_search_context(context);
+	delete_route_batch_results(results,n_queries);
+	delete_thread_pool(pool);
+	free(queries);
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+void edge_weights_test(){
+	map_t map = init_map();
+	build_stairs_or_ramp_map(&map);
+	map_graph_t * first = create_map_graph(&map);
+	
+	//one edge changes type and one is removed, which shifts the edges after it
+	set_connection_type_for_nodes_by_name(&map,"Ramp Bottom","Ramp Top",EDGE_TYPE_STAIRS);
+	disconnect_nodes_in_map_by_names(&map,"Lot","Stairs Top");
+	map_graph_t * second = create_map_graph_from_previous(&map,first);
+	
+	size_t n_mismatches = 0;
+	for(size_t i = 0;i < second->n_edges;i++){
+		for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+			double expected = get_route_profile_cost_function(profile)(&(second->edges[i]));
+			double weight = second->weights->profile_weights[profile][i];
+			if(isinf(expected) != isinf(weight) || (!isinf(expected) && fabs(expected - weight) > 1e-3)) n_mismatches++;
+		}
+	}
+	fprintf(stdout,"Edge weights: %lu of %lu edges measured again, %lu weights differ from the cost functions\n",
+		second->weights->n_refreshed,second->n_edges,n_mismatches);
+	
+	release_map_graph(second);
+	release_map_graph(first);
+	clear_map(&map);
+}
+
+void search_filter_test(){
+	map_t map = init_map();
+	build_stairs_or_ramp_map(&map);
+	map_graph_t * graph = create_map_graph(&map);
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	
+	search_filter_options_t options;
+	options.start_position_text = NULL;
+	options.end_position_text = NULL;
+	options.exclude_stairs = true;
+	options.exclude_non_auto_doors = false;
+	options.exclude_interiors = false;
+	uint8_t filter = compile_search_filter(&options);
+	
+	//walkers take the stairs unless they are filtered out
+	fputs("Walker path without stairs:\n",stdout);
+	if(search_map_graph_with_filter(graph,context,0,4,calculate_walker_edge_cost,filter)){
+		map_path_t * path = extract_route_path(graph,context,4);
+		print_path(path);
+		delete_map_path(path);
+	}else{
+		print_path(NULL);
+	}
+	
+	const uint64_t * first = get_search_filter_bitset(graph,filter);
+	const uint64_t * second = get_search_filter_bitset(graph,filter);
+	fprintf(stdout,"Filter bitset is %s\n",(first == second) ? "reused" : "built again");
+	
+	delete_route_search_context(context);
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+void node_flags_test(){
+	map_t map = init_map();
+	build_stairs_or_ramp_map(&map);
+	
+	connect_nodes_in_map_by_names(&map,"Library","Ramp Bottom",EDGE_TYPE_AUTO_DOOR);
+	bool adjacent_after_connect = get_map_node_flags(&map,4) & NODE_FLAG_ADJACENT_TO_AUTO_DOOR;
+	
+	set_connection_type_for_nodes_by_name(&map,"Library","Ramp Bottom",EDGE_TYPE_ELEVATOR_SHAFT);
+	bool adjacent_after_retype = get_map_node_flags(&map,4) & NODE_FLAG_ADJACENT_TO_AUTO_DOOR;
+	bool elevator_after_retype = get_map_node_flags(&map,2) & NODE_FLAG_HAS_ELEVATOR;
+	
+	disconnect_nodes_in_map_by_names(&map,"Library","Ramp Bottom");
+	remove_node_by_name_from_map(&map,"Stairs Top");
+	
+	//changing a node or edge already in the map updates the flags of the nodes it touches
+	building_t * building = create_building("Hall",create_map_rect(create_cord(-1,-1),create_cord(1,1)),2);
+	add_building_to_map(&map,building);
+	map_node_t * changed = map.all_nodes[1];
+	set_map_node_building_in_map(&map,changed,building);
+	set_map_node_floor_number_in_map(&map,changed,2);
+	set_map_node_selectable_in_map(&map,changed,true);
+	uint16_t changed_flags = get_map_node_flags(&map,1);
+	bool changed_set = (changed_flags & NODE_FLAG_INTERIOR) && (changed_flags & NODE_FLAG_SELECTABLE) && get_node_flags_floor_number(changed_flags) == 2;
+	map_edge_t * retyped = changed->outgoing_edges[0];
+	set_map_edge_type_in_map(&map,retyped,EDGE_TYPE_AUTO_DOOR);
+	bool retyped_set = (get_map_node_flags(&map,1) & NODE_FLAG_ADJACENT_TO_AUTO_DOOR) != 0;
+	set_map_node_building_in_map(&map,changed,NULL);
+	set_map_node_floor_number_in_map(&map,changed,NODE_FLOOR_NUMBER_NONE);
+	set_map_node_selectable_in_map(&map,changed,false);
+	set_map_edge_type_in_map(&map,retyped,EDGE_TYPE_SIDEWALK);
+	fprintf(stdout,"Node flags after changing a node in the map: set %d, auto door %d, cleared %d\n",
+		changed_set,retyped_set,(get_map_node_flags(&map,1) & 0xFF) == 0);
+	
+	//the kept flags have to match flags worked out from scratch
+	size_t n_mismatches = 0;
+	for(size_t i = 0;i < map.n_nodes;i++){
+		if(get_map_node_flags(&map,i) != compute_map_node_flags(map.all_nodes[i])) n_mismatches++;
+	}
+	
+	fprintf(stdout,"Node flags: auto door after connect %d, after retype %d, elevator after retype %d, %lu stale\n",
+		adjacent_after_connect,adjacent_after_retype,elevator_after_retype,n_mismatches);
+	
+	clear_map(&map);
+}
+
+void floor_layers_test(){
+	map_t map = init_map();
+	build_multi_floor_map(&map);
+	map_graph_t * graph = create_map_graph(&map);
+	const floor_layers_t * layers = graph->floor_layers;
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	
+	bool found = false;
+	uint32_t second_floor = find_floor_layer(layers,map.all_buildings[0],2,&found);
+	fprintf(stdout,"Floor layers: %lu layers, %lu portals, second floor has %u nodes\n",
+		layers->n_layers,layers->n_portal_edges,found ? layers->layers[second_floor].n_nodes : 0);
+	
+	//passing through the building never needs the upper floors, going up to room 3 does
+	uint8_t * allowed_layers = (uint8_t*) malloc(layers->n_layers);
+	size_t n_through = mark_floor_layers_for_route(layers,0,1,ROUTE_PROFILE_WHEELCHAIR,allowed_layers);
+	size_t n_upstairs = mark_floor_layers_for_route(layers,0,6,ROUTE_PROFILE_WHEELCHAIR,allowed_layers);
+	fprintf(stdout,"Layers searched passing through: %lu, going to the third floor: %lu\n",n_through,n_upstairs);
+	free(allowed_layers);
+	
+	//the same costs as a search over every floor
+	size_t n_mismatches = 0;
+	for(uint32_t start = 0;start < graph->n_nodes;start++){
+		for(uint32_t end = 0;end < graph->n_nodes;end++){
+			bool layered_found = search_map_graph_by_floor_layers(graph,context,start,end,calculate_wheelchair_edge_cost);
+			double layered_cost = layered_found ? context->cost[end] : EDGE_COST_IMPASSABLE;
+			bool plain_found = search_map_graph(graph,context,start,end,calculate_wheelchair_edge_cost);
+			double plain_cost = plain_found ? context->cost[end] : EDGE_COST_IMPASSABLE;
+			if(layered_found != plain_found || layered_cost != plain_cost) n_mismatches++;
+		}
+	}
+	fprintf(stdout,"Layered searches that differ from full searches: %lu\n",n_mismatches);
+	delete_route_search_context(context);
+	release_map_graph(graph);
+	clear_map(&map);
+	
+	//upper floors reached by two stairs each are dead ends when their corridors are no shorter, ground floors with two doors are kept as shortcuts
+	campus_options_t options = default_campus_options();
+	options.blocks_x = 2;
+	options.blocks_y = 1;
+	options.building_probability = 1.0;
+	options.max_floors = 4;
+	options.seed = 5;//buildings of 3 and 4 floors
+	map = init_map();
+	generate_campus_map(&map,&options,NULL);
+	graph = create_map_graph(&map);
+	layers = graph->floor_layers;
+	context = create_route_search_context(graph->n_nodes);
+	uint32_t outside_a = UINT32_MAX,outside_b = UINT32_MAX,top = UINT32_MAX;
+	size_t n_ground_floors = 0;
+	for(uint32_t i = 0;i < graph->n_nodes;i++){
+		const map_node_t * node = graph->source_nodes[i];
+		if(node->associated_building == NULL){
+			if(outside_a == UINT32_MAX) outside_a = i;
+			outside_b = i;
+		}else if(node->floor_number == node->associated_building->n_floors && node->associated_building->n_floors > 1){
+			top = i;
+		}
+	}
+	for(size_t l = 0;l < layers->n_layers;l++) n_ground_floors += layers->layers[l].floor_number == 1;
+	allowed_layers = (uint8_t*) malloc(layers->n_layers);
+	n_through = mark_floor_layers_for_route(layers,outside_a,outside_b,ROUTE_PROFILE_WALKER,allowed_layers);
+	n_upstairs = (top != UINT32_MAX) ? mark_floor_layers_for_route(layers,outside_a,top,ROUTE_PROFILE_WALKER,allowed_layers) : 0;
+	n_mismatches = 0;
+	edge_cost_function_t cost_functions[2] = {calculate_walker_edge_cost,calculate_wheelchair_edge_cost};
+	for(uint32_t start = 0;start < graph->n_nodes;start += 7){
+		for(uint32_t end = 0;end < graph->n_nodes;end += 5){
+			edge_cost_function_t cost_function = cost_functions[(start + end) % 2];
+			bool layered_found = search_map_graph_by_floor_layers(graph,context,start,end,cost_function);
+			double layered_cost = layered_found ? context->cost[end] : EDGE_COST_IMPASSABLE;
+			bool plain_found = search_map_graph(graph,context,start,end,cost_function);
+			double plain_cost = plain_found ? context->cost[end] : EDGE_COST_IMPASSABLE;
+			if(layered_found != plain_found || layered_cost != plain_cost) n_mismatches++;
+		}
+	}
+	fprintf(stdout,"Multi stair campus: %lu layers, %lu ground floors, passing by keeps %lu, going to a top floor keeps more: %s, %lu differ\n",
+		layers->n_layers,n_ground_floors,n_through,(n_upstairs > n_through) ? "yes" : "no",n_mismatches);
+	free(allowed_layers);
+	
+	delete_route_search_context(context);
+	release_map_graph(graph);
+	clear_map(&map);
+	
+	//a winding ground floor hallway with a straight corridor above it, walkers take the stairs up and back down
+	map = init_map();
+	build_upper_shortcut_map(&map);
+	graph = create_map_graph(&map);
+	layers = graph->floor_layers;
+	context = create_route_search_context(graph->n_nodes);
+	uint32_t upper_floor = find_floor_layer(layers,map.all_buildings[0],2,&found);
+	allowed_layers = (uint8_t*) malloc(layers->n_layers);
+	mark_floor_layers_for_route(layers,0,1,ROUTE_PROFILE_WALKER,allowed_layers);
+	bool walker_keeps = found && allowed_layers[upper_floor];
+	mark_floor_layers_for_route(layers,0,1,ROUTE_PROFILE_WHEELCHAIR,allowed_layers);
+	bool wheelchair_keeps = found && allowed_layers[upper_floor];
+	n_mismatches = 0;
+	for(uint32_t start = 0;start < graph->n_nodes;start++){
+		for(uint32_t end = 0;end < graph->n_nodes;end++){
+			for(size_t f = 0;f < 2;f++){
+				bool layered_found = search_map_graph_by_floor_layers(graph,context,start,end,cost_functions[f]);
+				double layered_cost = layered_found ? context->cost[end] : EDGE_COST_IMPASSABLE;
+				bool plain_found = search_map_graph(graph,context,start,end,cost_functions[f]);
+				double plain_cost = plain_found ? context->cost[end] : EDGE_COST_IMPASSABLE;
+				if(layered_found != plain_found || layered_cost != plain_cost) n_mismatches++;
+			}
+		}
+	}
+	fprintf(stdout,"Upper floor shortcut: kept for walkers: %s, kept for wheelchairs: %s, %lu differ\n",
+		walker_keeps ? "yes" : "no",wheelchair_keeps ? "yes" : "no",n_mismatches);
+	free(allowed_layers);
+	
+	delete_route_search_context(context);
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+void building_routes_test(){
+	map_t map = init_map();
+	build_multi_floor_map(&map);
+	map_graph_t * graph = create_map_graph(&map);
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	
+	//the building is only passed through so it is crossed with its entrance table
+	fputs("Path through the building:\n",stdout);
+	if(search_map_graph_by_buildings(graph,context,0,1,ROUTE_PROFILE_WHEELCHAIR,NULL,0)){
+		map_path_t * path = extract_building_route_path(graph,context,1,ROUTE_PROFILE_WHEELCHAIR);
+		print_path(path);
+		delete_map_path(path);
+	}else{
+		print_path(NULL);
+	}
+	
+	size_t n_mismatches = 0;
+	for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+		for(uint32_t start = 0;start < graph->n_nodes;start++){
+			for(uint32_t end = 0;end < graph->n_nodes;end++){
+				bool found = search_map_graph_by_buildings(graph,context,start,end,profile,NULL,0);
+				double cost = found ? context->cost[end] : EDGE_COST_IMPASSABLE;
+				bool plain_found = search_map_graph_with_profile(graph,context,start,end,profile);
+				double plain_cost = plain_found ? context->cost[end] : EDGE_COST_IMPASSABLE;
+				if(found != plain_found || (found && fabs(cost - plain_cost) > 1e-3)) n_mismatches++;
+			}
+		}
+	}
+	fprintf(stdout,"Building searches that differ from full searches: %lu\n",n_mismatches);
+	
+	//an outdoor edit keeps the table, an edit inside the building rebuilds it
+	connect_nodes_in_map_by_names(&map,"Outside West","Outside East",EDGE_TYPE_ROAD);
+	map_graph_t * outdoor_edit = create_map_graph_from_previous(&map,graph);
+	set_connection_type_for_nodes_by_name(&map,"Room 1","East Door",EDGE_TYPE_DOOR);
+	map_graph_t * indoor_edit = create_map_graph_from_previous(&map,outdoor_edit);
+	fprintf(stdout,"Buildings rebuilt after an outdoor edit: %lu, after an indoor edit: %lu\n",
+		outdoor_edit->building_routes->n_rebuilt,indoor_edit->building_routes->n_rebuilt);
+	
+	release_map_graph(indoor_edit);
+	release_map_graph(outdoor_edit);
+	delete_route_search_context(context);
+	release_map_graph(graph);
+	clear_map(&map);
+	
+	//every building of a campus is found again in the previous snapshot
+	map = init_map();
+	campus_options_t options = default_campus_options();
+	options.blocks_x = 6;
+	options.blocks_y = 6;
+	options.building_probability = 1.0;
+	generate_campus_map(&map,&options,NULL);
+	graph = create_map_graph(&map);
+	add_node_to_map(&map,create_map_node(create_cord(options.origin.longitude - 0.001,options.origin.latitude)));
+	outdoor_edit = create_map_graph_from_previous(&map,graph);
+	fprintf(stdout,"Campus buildings rebuilt after an outdoor edit: %lu of %lu\n",
+		outdoor_edit->building_routes->n_rebuilt,outdoor_edit->building_routes->n_buildings);
+	
+	release_map_graph(outdoor_edit);
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+typedef struct Closure_Test_Reader{
+	pthread_t thread;
+	const edge_closures_t * closures;
+	uint32_t edge_index;
+	bool * stop;
+	size_t n_torn;
+} closure_test_reader_t;
+
+//the writer only ever sets the windows [0,10) and [100,110), any other pair is a torn read
+static void * closure_test_reader_main(void * argument){
+	closure_test_reader_t * reader = (closure_test_reader_t*) argument;
+	while(!__atomic_load_n(reader->stop,__ATOMIC_ACQUIRE)){
+		int64_t start,end;
+		get_edge_closure_window(reader->closures,reader->edge_index,&start,&end);
+		if(end != start + 10 || (start != 0 && start != 100)) reader->n_torn++;
+		if(map_graph_edge_closed(reader->closures,reader->edge_index,50)) reader->n_torn++;
+	}
+	return NULL;
+}
+
+void edge_closures_test(){
+	map_t map = init_map();
+	build_multi_floor_map(&map);
+	map_graph_t * graph = create_map_graph(&map);
+	edge_closures_t * closures = create_edge_closures(graph);
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	
+	//nodes 0 and 1 are outside, 4 to 6 are the rooms on floors 1 to 3
+	uint32_t elevator = find_graph_edge(graph,4,5);
+	uint32_t hallway = find_graph_edge(graph,4,3);
+	
+	//the elevator is out of order between 100 and 200
+	close_map_graph_edge(closures,elevator,100,200);
+	bool before = search_map_graph_with_closures(graph,context,0,6,calculate_wheelchair_edge_cost,closures,50);
+	bool during = search_map_graph_with_closures(graph,context,0,6,calculate_wheelchair_edge_cost,closures,150);
+	fprintf(stdout,"Third floor reachable before the elevator closure: %d, during it: %d\n",before,during);
+	
+	//with the east hallway closed the building can not be crossed, with or without its entrance table
+	close_map_graph_edge(closures,hallway,CLOSURE_ALWAYS_START,CLOSURE_ALWAYS_END);
+	bool crossed = search_map_graph_with_closures(graph,context,0,1,calculate_walker_edge_cost,closures,0);
+	bool crossed_by_buildings = search_map_graph_by_buildings(graph,context,0,1,ROUTE_PROFILE_WALKER,closures,0);
+	fprintf(stdout,"Building crossed with the hallway closed: %d, by buildings: %d, %lu edges closed\n",
+		crossed,crossed_by_buildings,closures->n_closed);
+	
+	//reopening works without a new snapshot
+	reopen_map_graph_edge(closures,hallway);
+	bool reopened = search_map_graph_by_buildings(graph,context,0,1,ROUTE_PROFILE_WALKER,closures,0);
+	fprintf(stdout,"Building crossed after reopening: %d\n",reopened);
+	
+	//a timed search waits for the elevator to reopen, and leaving later never arrives sooner
+	size_t n_found = 0;
+	size_t n_waiting = 0;
+	bool in_order = true;
+	int64_t last_arrival = INT64_MIN;
+	for(int64_t departure = 0;departure < 300;departure++){
+		if(!search_map_graph_at_time(graph,context,0,6,ROUTE_PROFILE_WHEELCHAIR,departure,closures)) continue;
+		int64_t arrival = get_route_arrival_time(ROUTE_PROFILE_WHEELCHAIR,departure,context->cost[6]);
+		if(arrival < last_arrival) in_order = false;
+		if(arrival == last_arrival) n_waiting++;
+		last_arrival = arrival;
+		n_found++;
+	}
+	fprintf(stdout,"Timed routes to the third floor: %lu of 300, in departure order: %d, arriving with the one before: %lu\n",
+		n_found,in_order,n_waiting);
+	
+	//the elevator closure survives an edit of the map
+	connect_nodes_in_map_by_names(&map,"Outside West","Outside East",EDGE_TYPE_ROAD);
+	map_graph_t * edited = create_map_graph_from_previous(&map,graph);
+	edge_closures_t * carried = carry_edge_closures(closures,edited);
+	bool carried_during = search_map_graph_with_closures(edited,context,0,6,calculate_wheelchair_edge_cost,carried,150);
+	fprintf(stdout,"Closures carried to the edited map: %lu, third floor reachable during the closure: %d\n",
+		carried->n_closed,carried_during);
+	
+	//a search reading a window while it is moved sees the old or the new window, never half of each
+	bool stop = false;
+	close_map_graph_edge(closures,hallway,0,10);
+	closure_test_reader_t reader;
+	reader.closures = closures;
+	reader.edge_index = hallway;
+	reader.stop = &stop;
+	reader.n_torn = 0;
+	pthread_create(&(reader.thread),NULL,closure_test_reader_main,&reader);
+	for(size_t i = 0;i < 200000;i++){
+		int64_t start = (i & 1) ? 0 : 100;
+		close_map_graph_edge(closures,hallway,start,start+10);
+	}
+	__atomic_store_n(&stop,true,__ATOMIC_RELEASE);
+	pthread_join(reader.thread,NULL);
+	fprintf(stdout,"Torn closure windows read while moving one: %lu\n",reader.n_torn);
+	
+	delete_edge_closures(carried);
+	release_map_graph(edited);
+	delete_route_search_context(context);
+	delete_edge_closures(closures);
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+void route_repair_test(){
+	map_t map = init_map();
+	build_stairs_or_ramp_map(&map);
+	
+	map.active_start = map.all_nodes[0];
+	map.active_end = map.all_nodes[4];
+	map.active_edge_cost_function = calculate_wheelchair_edge_cost;
+	find_best_path(&map);
+	route_repair_t * first_repair = map.active_route_repair;
+	const map_graph_t * first_graph = first_repair->graph;
+	
+	//the stairs are rebuilt as a ramp, the wheelchair route is repaired onto the short way on the same snapshot
+	set_map_edge_type_in_map(&map,map.all_edges[0],EDGE_TYPE_RAMP);
+	find_best_path(&map);
+	fprintf(stdout,"Wheelchair path after the stairs became a ramp (%s, %s):\n",(map.active_route_repair == first_repair) ? "repaired" : "searched again",
+		(map.active_route_repair->graph == first_graph) ? "same snapshot" : "new snapshot");
+	print_path(map.active_path);
+	
+	//and back to stairs, then a new node drops the repair
+	set_connection_type_for_nodes_by_indices(&map,0,1,EDGE_TYPE_STAIRS);
+	find_best_path(&map);
+	size_t n_back = (map.active_path != NULL) ? map.active_path->n_nodes : 0;
+	add_node_to_map(&map,create_map_node(create_cord(-76.7130,39.2550)));
+	bool dropped = map.active_route_repair == NULL;
+	find_best_path(&map);
+	size_t n_again = (map.active_path != NULL) ? map.active_path->n_nodes : 0;
+	fprintf(stdout,"Stairs again: %lu nodes repaired, dropped after adding a node: %s, %lu nodes searched again\n",n_back,dropped ? "yes" : "no",n_again);
+	
+	//closures opened and closed at random on a grid always give the same cost as a full search
+	map_t grid = init_map();
+	const uint8_t edge_types[4] = {EDGE_TYPE_SIDEWALK,EDGE_TYPE_RAMP,EDGE_TYPE_SIDEWALK,EDGE_TYPE_STAIRS};
+	const size_t side = 15;
+	for(size_t y = 0;y < side;y++){
+		for(size_t x = 0;x < side;x++){
+			add_node_to_map(&grid,create_map_node(create_cord(-76.7130 + x*0.0001,39.2550 + y*0.0001)));
+		}
+	}
+	for(size_t y = 0;y < side;y++){
+		for(size_t x = 0;x < side;x++){
+			size_t index = y*side + x;
+			if(x+1 < side) connect_nodes_in_map_by_indices(&grid,index,index+1,edge_types[(x+y)%4]);
+			if(y+1 < side) connect_nodes_in_map_by_indices(&grid,index,index+side,edge_types[(x+2*y)%4]);
+		}
+	}
+	
+	map_graph_t * graph = create_map_graph(&grid);
+	edge_closures_t * closures = create_edge_closures(graph);
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	route_repair_t * repair = create_route_repair(graph,closures,0,0,graph->n_nodes-1,calculate_wheelchair_edge_cost);
+	repair_route(repair);
+	size_t full_updates = repair->n_updated;
+	
+	size_t n_mismatches = 0;
+	size_t repair_updates = 0;
+	uint32_t random_state = 4321;
+	for(size_t i = 0;i < 200;i++){
+		random_state = random_state*1664525u + 1013904223u;
+		uint32_t edge_index = (random_state >> 8) % graph->n_edges;
+		if(map_graph_edge_closed(closures,edge_index,0)){
+			reopen_map_graph_edge(closures,edge_index);
+		}else{
+			close_map_graph_edge(closures,edge_index,CLOSURE_ALWAYS_START,CLOSURE_ALWAYS_END);
+		}
+		update_route_repair_edge(repair,edge_index);
+		
+		bool found = repair_route(repair);
+		repair_updates += repair->n_updated;
+		bool full_found = search_map_graph_with_closures(graph,context,0,graph->n_nodes-1,calculate_wheelchair_edge_cost,closures,0);
+		if(found != full_found || (found && fabs(repair->g[repair->end] - context->cost[graph->n_nodes-1]) > 1e-6)) n_mismatches++;
+	}
+	fprintf(stdout,"Repairs that differ from full searches: %lu, first search updated %lu nodes, repairs %.1f on average\n",
+		n_mismatches,full_updates,repair_updates/200.0);
+	
+	delete_route_repair(repair);
+	delete_route_search_context(context);
+	delete_edge_closures(closures);
+	release_map_graph(graph);
+	clear_map(&grid);
+	clear_map(&map);
+}
+
+/*
+ * Cost of every loopless route from node to end, by trying them all
+ */
+static void enumerate_route_costs(const map_graph_t * graph,const float * weights,uint32_t node,uint32_t end,double cost,uint8_t * visited,double * costs,size_t * n_costs){
+	if(node == end){
+		costs[*n_costs] = cost;
+		(*n_costs)++;
+		return;
+	}
+	
+	visited[node] = 1;
+	for(size_t i = graph->adjacency_offsets[node];i < graph->adjacency_offsets[node+1];i++){
+		uint32_t neighbour = graph->adjacency_nodes[i];
+		float weight = weights[graph->adjacency_edges[i]];
+		if(visited[neighbour] || isinf(weight)) continue;
+		enumerate_route_costs(graph,weights,neighbour,end,cost + weight,visited,costs,n_costs);
+	}
+	visited[node] = 0;
+}
+
+static int compare_route_costs(const void * a,const void * b){
+	double cost_a = *((const double*) a);
+	double cost_b = *((const double*) b);
+	return (cost_a > cost_b) - (cost_a < cost_b);
+}
+
+void route_alternatives_test(){
+	map_t map = init_map();
+	build_stairs_or_ramp_map(&map);
+	map_graph_t * graph = create_map_graph(&map);
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	
+	//a walker can take the stairs or the ramp, and there is no third way
+	route_alternatives_t * alternatives = find_route_alternatives(graph,context,0,4,ROUTE_PROFILE_WALKER,3);
+	for(size_t k = 0;k < alternatives->n_paths;k++){
+		fprintf(stdout,"Walker alternative %lu (cost %.1f):\n",k+1,alternatives->costs[k]);
+		print_path(alternatives->paths[k]);
+	}
+	delete_route_alternatives(alternatives);
+	delete_route_search_context(context);
+	release_map_graph(graph);
+	clear_map(&map);
+	
+	//on a small grid the alternatives are the cheapest of every possible route
+	map_t grid = init_map();
+	const uint8_t edge_types[4] = {EDGE_TYPE_SIDEWALK,EDGE_TYPE_RAMP,EDGE_TYPE_ROAD,EDGE_TYPE_STAIRS};
+	const size_t side = 5;
+	for(size_t y = 0;y < side;y++){
+		for(size_t x = 0;x < side;x++){
+			add_node_to_map(&grid,create_map_node(create_cord(-76.7130 + x*0.0001,39.2550 + y*0.0001)));
+		}
+	}
+	for(size_t y = 0;y < side;y++){
+		for(size_t x = 0;x < side;x++){
+			size_t index = y*side + x;
+			if(x+1 < side) connect_nodes_in_map_by_indices(&grid,index,index+1,edge_types[(x+y)%4]);
+			if(y+1 < side) connect_nodes_in_map_by_indices(&grid,index,index+side,edge_types[(x+2*y)%4]);
+		}
+	}
+	graph = create_map_graph(&grid);
+	context = create_route_search_context(graph->n_nodes);
+	
+	double * costs = (double*) malloc(sizeof(double)*10000);
+	uint8_t * visited = (uint8_t*) calloc(graph->n_nodes,sizeof(uint8_t));
+	size_t n_mismatches = 0;
+	size_t n_spur_searches = 0;
+	for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+		size_t n_costs = 0;
+		enumerate_route_costs(graph,graph->weights->profile_weights[profile],0,graph->n_nodes-1,0,visited,costs,&n_costs);
+		qsort(costs,n_costs,sizeof(double),compare_route_costs);
+		
+		alternatives = find_route_alternatives(graph,context,0,graph->n_nodes-1,profile,8);
+		size_t n_paths = (alternatives != NULL) ? alternatives->n_paths : 0;
+		if(n_paths != ((n_costs < 8) ? n_costs : 8)) n_mismatches++;
+		for(size_t k = 0;k < n_paths && k < n_costs;k++){
+			if(fabs(alternatives->costs[k] - costs[k]) > 1e-6*costs[k]) n_mismatches++;
+		}
+		if(alternatives != NULL) n_spur_searches += alternatives->n_spur_searches;
+		delete_route_alternatives(alternatives);
+	}
+	fprintf(stdout,"Alternatives that differ from trying every route: %lu, %lu spur searches\n",n_mismatches,n_spur_searches);
+	
+	free(visited);
+	free(costs);
+	delete_route_search_context(context);
+	release_map_graph(graph);
+	clear_map(&grid);
+}
+
+/*
+ * Values of every loopless route from node to end for pareto_routes_test, by trying them all
+ */
+static void enumerate_route_values(const map_graph_t * graph,const float * weights,uint32_t node,uint32_t end,const double * values,uint8_t * visited,double * all_values,size_t * n_routes){
+	if(node == end){
+		for(size_t c = 0;c < N_ROUTE_CRITERIA;c++) all_values[(*n_routes)*N_ROUTE_CRITERIA + c] = values[c];
+		(*n_routes)++;
+		return;
+	}
+	
+	visited[node] = 1;
+	for(size_t i = graph->adjacency_offsets[node];i < graph->adjacency_offsets[node+1];i++){
+		uint32_t neighbour = graph->adjacency_nodes[i];
+		uint32_t edge_index = graph->adjacency_edges[i];
+		if(visited[neighbour] || isinf(weights[edge_index])) continue;
+		
+		const map_edge_t * edge_ref = &(graph->edges[edge_index]);
+		double length = graph->weights->lengths[edge_index];
+		double next_values[N_ROUTE_CRITERIA] = {
+			values[0] + weights[edge_index],
+			values[1] + ((edge_ref->type == EDGE_TYPE_DOOR) ? 1.0 : 0.0),
+			values[2] + length,//the grid has no buildings so everything is outdoors
+			values[3] + ((edge_ref->type == EDGE_TYPE_STAIRS) ? length : 0.0)
+		};
+		enumerate_route_values(graph,weights,neighbour,end,next_values,visited,all_values,n_routes);
+	}
+	visited[node] = 0;
+}
+
+void pareto_routes_test(){
+	map_t map = init_map();
+	build_stairs_or_ramp_map(&map);
+	map_graph_t * graph = create_map_graph(&map);
+	
+	//the stairs are shorter, the ramp has no stairs, so a walker gets both
+	pareto_routes_t * routes = find_pareto_routes(graph,0,4,ROUTE_PROFILE_WALKER,ROUTE_CRITERION_COST | ROUTE_CRITERION_STAIRS,DEFAULT_PARETO_MAX_LABELS);
+	for(size_t k = 0;k < routes->n_paths;k++){
+		fprintf(stdout,"Walker pareto route %lu (cost %.1f, %.1f meters of stairs):\n",k+1,routes->values[k*N_ROUTE_CRITERIA],routes->values[k*N_ROUTE_CRITERIA + 3]);
+		print_path(routes->paths[k]);
+	}
+	delete_pareto_routes(routes);
+	release_map_graph(graph);
+	clear_map(&map);
+	
+	//on a small grid the routes are exactly the pareto front of every possible route
+	map_t grid = init_map();
+	const uint8_t edge_types[5] = {EDGE_TYPE_SIDEWALK,EDGE_TYPE_DOOR,EDGE_TYPE_STAIRS,EDGE_TYPE_ROAD,EDGE_TYPE_RAMP};
+	const size_t side = 4;
+	for(size_t y = 0;y < side;y++){
+		for(size_t x = 0;x < side;x++){
+			add_node_to_map(&grid,create_map_node(create_cord(-76.7130 + x*0.0001,39.2550 + y*0.00013)));
+		}
+	}
+	for(size_t y = 0;y < side;y++){
+		for(size_t x = 0;x < side;x++){
+			size_t index = y*side + x;
+			if(x+1 < side) connect_nodes_in_map_by_indices(&grid,index,index+1,edge_types[(x+y)%5]);
+			if(y+1 < side) connect_nodes_in_map_by_indices(&grid,index,index+side,edge_types[(x+2*y)%5]);
+		}
+	}
+	graph = create_map_graph(&grid);
+	
+	const uint8_t all_criteria = ROUTE_CRITERION_COST | ROUTE_CRITERION_MANUAL_DOORS | ROUTE_CRITERION_OUTDOORS | ROUTE_CRITERION_STAIRS;
+	double * all_values = (double*) malloc(sizeof(double)*N_ROUTE_CRITERIA*1000);
+	uint8_t * visited = (uint8_t*) calloc(graph->n_nodes,sizeof(uint8_t));
+	double zero[N_ROUTE_CRITERIA] = {0};
+	size_t n_routes = 0;
+	enumerate_route_values(graph,graph->weights->profile_weights[ROUTE_PROFILE_WALKER],0,graph->n_nodes-1,zero,visited,all_values,&n_routes);
+	
+	//count the distinct routes no other route dominates
+	uint8_t * on_front = (uint8_t*) calloc(n_routes,sizeof(uint8_t));
+	size_t n_front = 0;
+	for(size_t i = 0;i < n_routes;i++){
+		bool dominated = false;
+		for(size_t j = 0;j < n_routes && !dominated;j++){
+			bool at_least_as_good = true;
+			bool better = false;
+			for(size_t c = 0;c < N_ROUTE_CRITERIA;c++){
+				double a = all_values[j*N_ROUTE_CRITERIA + c];
+				double b = all_values[i*N_ROUTE_CRITERIA + c];
+				if(a > b + 1e-9) at_least_as_good = false;
+				if(a < b - 1e-9) better = true;
+			}
+			//identical routes count once, the one found first
+			dominated = at_least_as_good && (better || j < i);
+		}
+		if(!dominated){
+			on_front[i] = 1;
+			n_front++;
+		}
+	}
+	
+	routes = find_pareto_routes(graph,0,graph->n_nodes-1,ROUTE_PROFILE_WALKER,all_criteria,64);
+	size_t n_off_front = 0;
+	for(size_t k = 0;k < routes->n_paths;k++){
+		bool matched = false;
+		for(size_t i = 0;i < n_routes && !matched;i++){
+			if(!on_front[i]) continue;
+			matched = true;
+			for(size_t c = 0;c < N_ROUTE_CRITERIA;c++){
+				if(fabs(routes->values[k*N_ROUTE_CRITERIA + c] - all_values[i*N_ROUTE_CRITERIA + c]) > 1e-6) matched = false;
+			}
+		}
+		if(!matched) n_off_front++;
+	}
+	fprintf(stdout,"Pareto routes on the grid: %lu, pareto front of all %lu routes: %lu, %lu not on it, %s\n",routes->n_paths,n_routes,n_front,
+		n_off_front,routes->truncated ? "truncated" : "complete");
+	delete_pareto_routes(routes);
+	
+	//a tight cap keeps the search bounded
+	routes = find_pareto_routes(graph,0,graph->n_nodes-1,ROUTE_PROFILE_WALKER,all_criteria,2);
+	fprintf(stdout,"Pareto routes with 2 labels a node: %lu, %s\n",routes->n_paths,routes->truncated ? "truncated" : "complete");
+	delete_pareto_routes(routes);
+	
+	free(on_front);
+	free(visited);
+	free(all_values);
+	release_map_graph(graph);
+	clear_map(&grid);
+}
+
+void distance_matrix_test(){
+	map_t map = init_map();
+	build_stairs_or_ramp_map(&map);
+	map_graph_t * graph = create_map_graph(&map);
+	thread_pool_t * pool = create_thread_pool(2);
+	
+	//duplicate sources share one search, more sources than targets searches from the targets
+	uint32_t sources[4] = {0,1,0,3};
+	uint32_t targets[2] = {4,2};
+	
+	float * matrix = compute_distance_matrix(pool,graph,sources,4,targets,2,ROUTE_PROFILE_WHEELCHAIR);
+	fputs("Wheelchair distance matrix:\n",stdout);
+	save_distance_matrix_csv(matrix,4,2,stdout);
+	
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	size_t n_mismatches = 0;
+	for(size_t i = 0;i < 4;i++){
+		for(size_t j = 0;j < 2;j++){
+			bool found = search_map_graph(graph,context,sources[i],targets[j],calculate_wheelchair_edge_cost);
+			float expected = found ? (float) context->cost[targets[j]] : INFINITY;
+			if(fabsf(expected - matrix[i*2 + j]) > 0.01f && !(isinf(expected) && isinf(matrix[i*2 + j]))) n_mismatches++;
+		}
+	}
+	fprintf(stdout,"Matrix entries that differ from point to point searches: %lu\n",n_mismatches);
+	
+	//a bad source or a context too small reads nothing left over from the searches before
+	float row[2];
+	size_t n_bad_source = compute_distance_row(graph,context,graph->n_nodes,targets,2,ROUTE_PROFILE_WHEELCHAIR,row);
+	bool bad_source_unreached = isinf(row[0]) && isinf(row[1]);
+	route_search_context_t * small = create_route_search_context(2);
+	size_t n_small = compute_distance_row(graph,small,0,targets,2,ROUTE_PROFILE_WHEELCHAIR,row);
+	fprintf(stdout,"Row from a bad source: %lu reachable, all infinite: %s, with a small context: %lu reachable, all infinite: %s\n",
+		n_bad_source,bad_source_unreached ? "yes" : "no",n_small,(isinf(row[0]) && isinf(row[1])) ? "yes" : "no");
+	delete_route_search_context(small);
+	uint32_t bad_targets[2] = {targets[0],(uint32_t) graph->n_nodes};
+	row[0] = row[1] = 0.0f;
+	size_t n_bad_target = compute_distance_row(graph,context,sources[0],bad_targets,2,ROUTE_PROFILE_WHEELCHAIR,row);
+	bool bad_target_unreached = isinf(row[0]) && isinf(row[1]);
+	row[0] = row[1] = 0.0f;
+	size_t n_bad_profile = compute_distance_row(graph,context,sources[0],targets,2,N_ROUTE_PROFILES,row);
+	fprintf(stdout,"Row with a bad target: %lu reachable, all infinite: %s, with a bad profile: %lu reachable, all infinite: %s\n",
+		n_bad_target,bad_target_unreached ? "yes" : "no",n_bad_profile,(isinf(row[0]) && isinf(row[1])) ? "yes" : "no");
+	
+	delete_route_search_context(context);
+	free(matrix);
+	delete_thread_pool(pool);
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+void isochrone_test(){
+	map_t map = init_map();
+	build_multi_floor_map(&map);
+	map_graph_t * graph = create_map_graph(&map);
+	
+	//the budget grows past the doors, then the rooms upstairs
+	isochrone_t * isochrone = create_isochrone(graph,0,ROUTE_PROFILE_WHEELCHAIR);
+	const double budgets[4] = {0,50,150,1000};
+	for(size_t i = 0;i < 4;i++){
+		grow_isochrone(isochrone,budgets[i]);
+		fprintf(stdout,"Wheelchair isochrone within %.0f: %lu nodes, %lu buildings, %lu entrances, %lu outline points\n",budgets[i],
+			isochrone->n_nodes,isochrone->n_buildings,isochrone->n_entrances,isochrone->n_outline);
+	}
+	for(size_t i = 0;i < isochrone->n_nodes;i++){
+		fprintf(stdout,"\t%s\n",graph->source_nodes[isochrone->nodes[i]]->name);
+	}
+	delete_isochrone(isochrone);
+	release_map_graph(graph);
+	clear_map(&map);
+	
+	//growing a kept tree reaches the same nodes and outline as a new isochrone for every budget, shrinking too
+	map_t grid = init_map();
+	const uint8_t edge_types[4] = {EDGE_TYPE_SIDEWALK,EDGE_TYPE_STAIRS,EDGE_TYPE_ROAD,EDGE_TYPE_RAMP};
+	const size_t side = 8;
+	for(size_t y = 0;y < side;y++){
+		for(size_t x = 0;x < side;x++){
+			add_node_to_map(&grid,create_map_node(create_cord(-76.7130 + x*0.0001,39.2550 + y*0.0001)));
+		}
+	}
+	for(size_t y = 0;y < side;y++){
+		for(size_t x = 0;x < side;x++){
+			size_t index = y*side + x;
+			if(x+1 < side) connect_nodes_in_map_by_indices(&grid,index,index+1,edge_types[(x+y)%4]);
+			if(y+1 < side) connect_nodes_in_map_by_indices(&grid,index,index+side,edge_types[(x*y)%4]);
+		}
+	}
+	graph = create_map_graph(&grid);
+	
+	isochrone = create_isochrone(graph,0,ROUTE_PROFILE_WHEELCHAIR);
+	size_t n_mismatches = 0;
+	const double grid_budgets[6] = {10,40,80,160,60,320};
+	for(size_t i = 0;i < 6;i++){
+		grow_isochrone(isochrone,grid_budgets[i]);
+		isochrone_t * fresh = create_isochrone(graph,0,ROUTE_PROFILE_WHEELCHAIR);
+		grow_isochrone(fresh,grid_budgets[i]);
+		if(fresh->n_nodes != isochrone->n_nodes || fresh->n_outline != isochrone->n_outline) n_mismatches++;
+		for(size_t k = 0;k < fresh->n_outline && k < isochrone->n_outline;k++){
+			if(fabs(fresh->outline[k].longitude - isochrone->outline[k].longitude) > 1e-12) n_mismatches++;
+			if(fabs(fresh->outline[k].latitude - isochrone->outline[k].latitude) > 1e-12) n_mismatches++;
+		}
+		
+		uint8_t * reached = (uint8_t*) calloc(graph->n_nodes,sizeof(uint8_t));
+		for(size_t k = 0;k < isochrone->n_nodes;k++) reached[isochrone->nodes[k]] = 1;
+		for(size_t k = 0;k < fresh->n_nodes;k++){
+			if(!reached[fresh->nodes[k]]) n_mismatches++;
+		}
+		free(reached);
+		delete_isochrone(fresh);
+	}
+	fprintf(stdout,"Grown isochrones that differ from new ones: %lu, %lu of %lu nodes within %.0f\n",n_mismatches,
+		isochrone->n_nodes,graph->n_nodes,isochrone->cost_limit);
+	delete_isochrone(isochrone);
+	
+	release_map_graph(graph);
+	clear_map(&grid);
+}
+
+//Print a time since the epoch as the day of the week and the time of day.
+static void print_week_time(int64_t time){
+	const char * days[7] = {"Mon","Tue","Wed","Thu","Fri","Sat","Sun"};
+	int64_t week_time = get_schedule_week_time(time);
+	int64_t day_time = week_time % SCHEDULE_DAY_SECONDS;
+	fprintf(stdout,"%s %02d:%02d",days[week_time/SCHEDULE_DAY_SECONDS],(int) (day_time/3600),(int) ((day_time/60) % 60));
+}
+
+void schedules_test(){
+	map_t map = init_map();
+	build_multi_floor_map(&map);
+	connect_nodes_in_map_by_names(&map,"Outside West","Outside East",EDGE_TYPE_ROAD);
+	
+	//the building is open 8:00 to 18:00 on weekdays, its east door is locked from 22:00 to 6:00
+	schedule_t * opening_hours = create_schedule();
+	for(int32_t day = 0;day < 5;day++){
+		add_schedule_interval(opening_hours,day*SCHEDULE_DAY_SECONDS + 8*3600,day*SCHEDULE_DAY_SECONDS + 18*3600);
+	}
+	set_building_opening_hours(map.all_buildings[0],opening_hours);
+	schedule_t * door_hours = create_schedule();
+	for(int32_t day = 0;day < 7;day++){
+		add_schedule_interval(door_hours,day*SCHEDULE_DAY_SECONDS + 6*3600,day*SCHEDULE_DAY_SECONDS + 22*3600);
+	}
+	for(size_t i = 0;i < map.n_edges;i++){
+		if(map.all_edges[i]->type == EDGE_TYPE_AUTO_DOOR && strcmp(map.all_edges[i]->b->name,"Outside East") == 0){
+			set_map_edge_schedule(map.all_edges[i],door_hours);
+		}
+	}
+	
+	map_graph_t * graph = create_map_graph(&map);
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	fprintf(stdout,"Schedule tables: %lu\n",graph->schedule_tables->n_tables);
+	
+	//2024-01-01 was a Monday
+	const int64_t monday = 1704067200;
+	const int64_t departures[4] = {monday + 12*3600,monday + 20*3600,monday + 5*SCHEDULE_DAY_SECONDS + 12*3600,monday + 7*3600 + 59*60};
+	for(size_t i = 0;i < 4;i++){
+		for(uint8_t profile = ROUTE_PROFILE_WHEELCHAIR;profile <= ROUTE_PROFILE_WALKER;profile++){
+			fputs(profile == ROUTE_PROFILE_WHEELCHAIR ? "Wheelchair" : "Walker",stdout);
+			fputs(" leaving at ",stdout);
+			print_week_time(departures[i]);
+			if(search_map_graph_at_time(graph,context,0,1,profile,departures[i],NULL)){
+				fputs(" arrives at ",stdout);
+				print_week_time(get_route_arrival_time(profile,departures[i],context->cost[1]));
+				fputs(":\n",stdout);
+				map_path_t * path = extract_route_path(graph,context,1);
+				print_path(path);
+				delete_map_path(path);
+			}else{
+				fputs(":\n",stdout);
+				print_path(NULL);
+			}
+		}
+	}
+	
+	//the tables agree with the schedules, and with nothing closed the timed search matches the untimed one
+	size_t n_mismatches = 0;
+	uint32_t random_state = 77;
+	for(size_t i = 0;i < 2000;i++){
+		random_state = random_state*1664525u + 1013904223u;
+		int64_t time = monday + (random_state >> 8) % (2*SCHEDULE_WEEK_SECONDS);
+		for(uint32_t j = 0;j < graph->n_edges;j++){
+			const map_edge_t * edge_ref = graph->source_edges[j];
+			bool open = schedule_open_at(edge_ref->schedule,time);
+			if(edge_ref->a->associated_building != NULL) open = open && schedule_open_at(edge_ref->a->associated_building->opening_hours,time);
+			if(edge_ref->b->associated_building != NULL) open = open && schedule_open_at(edge_ref->b->associated_building->opening_hours,time);
+			if(open != (get_schedule_wait_seconds(graph->schedule_tables,j,time) == 0.0)) n_mismatches++;
+		}
+	}
+	for(uint32_t start = 0;start < graph->n_nodes;start++){
+		for(uint32_t end = 0;end < graph->n_nodes;end++){
+			bool found = search_map_graph_at_time(graph,context,start,end,ROUTE_PROFILE_WALKER,monday + 12*3600,NULL);
+			double cost = found ? context->cost[end] : EDGE_COST_IMPASSABLE;
+			bool plain_found = search_map_graph_with_profile(graph,context,start,end,ROUTE_PROFILE_WALKER);
+			double plain_cost = plain_found ? context->cost[end] : EDGE_COST_IMPASSABLE;
+			if(found != plain_found || (found && fabs(cost - plain_cost) > 1e-6)) n_mismatches++;
+		}
+	}
+	fprintf(stdout,"Schedule lookups and timed searches that differ: %lu\n",n_mismatches);
+	
+	delete_route_search_context(context);
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+void projection_test(){
+	map_t map = init_map();
+	build_multi_floor_map(&map);
+	
+	//a grid around the building so there are many equally short routes for A* to choose from
+	const uint8_t edge_types[4] = {EDGE_TYPE_SIDEWALK,EDGE_TYPE_STAIRS,EDGE_TYPE_ROAD,EDGE_TYPE_RAMP};
+	const size_t side = 8;
+	size_t first = map.n_nodes;
+	for(size_t y = 0;y < side;y++){
+		for(size_t x = 0;x < side;x++){
+			add_node_to_map(&map,create_map_node(create_cord(-76.7150 + x*0.0005,39.2530 + y*0.0004)));
+		}
+	}
+	for(size_t y = 0;y < side;y++){
+		for(size_t x = 0;x < side;x++){
+			size_t index = first + y*side + x;
+			if(x+1 < side) connect_nodes_in_map_by_indices(&map,index,index+1,edge_types[(x+y)%4]);
+			if(y+1 < side) connect_nodes_in_map_by_indices(&map,index,index+side,edge_types[(x*y)%4]);
+		}
+	}
+	connect_nodes_in_map_by_indices(&map,0,first + 3*side + 1,EDGE_TYPE_SIDEWALK);
+	connect_nodes_in_map_by_indices(&map,1,first + 3*side + 7,EDGE_TYPE_SIDEWALK);
+	map_graph_t * graph = create_map_graph(&map);
+	
+	//projected lengths are within a tiny fraction of the haversine lengths
+	float * lengths = (float*) malloc(sizeof(float)*graph->n_edges);
+	compute_projected_edge_lengths(graph->projection,graph,lengths);
+	double worst_error = 0;
+	for(size_t i = 0;i < graph->n_edges;i++){
+		double length = get_map_edge_length(&(graph->edges[i]));
+		double error = fabs(lengths[i] - length)/fmax(length,1.0);
+		if(error > worst_error) worst_error = error;
+	}
+	fprintf(stdout,"Projected edge lengths within %s of the haversine lengths\n",worst_error < 1e-4 ? "0.01%" : "more than 0.01%");
+	free(lengths);
+	
+	//A* finds the same costs as Dijkstra's Algorithm
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	size_t n_mismatches = 0;
+	for(uint8_t profile = 0;profile < N_ROUTE_PROFILES;profile++){
+		for(uint32_t start = 0;start < graph->n_nodes;start++){
+			for(uint32_t end = 0;end < graph->n_nodes;end++){
+				bool found = search_map_graph_with_heuristic(graph,context,start,end,profile);
+				double cost = found ? context->cost[end] : EDGE_COST_IMPASSABLE;
+				bool plain_found = search_map_graph_with_profile(graph,context,start,end,profile);
+				double plain_cost = plain_found ? context->cost[end] : EDGE_COST_IMPASSABLE;
+				if(found != plain_found || (found && fabs(cost - plain_cost) > 1e-3)) n_mismatches++;
+			}
+		}
+	}
+	fprintf(stdout,"A* searches that differ from full searches: %lu\n",n_mismatches);
+	
+	delete_route_search_context(context);
+	release_map_graph(graph);
+	clear_map(&map);
+	
+	//a map hundreds of kilometers tall, where the longitude scale of the middle is far too long at the top
+	map = init_map();
+	const size_t wide_side = 6;
+	for(size_t y = 0;y < wide_side;y++){
+		for(size_t x = 0;x < wide_side;x++){
+			add_node_to_map(&map,create_map_node(create_cord(10.0 + x*1.0,40.0 + y*5.0)));
+		}
+	}
+	for(size_t y = 0;y < wide_side;y++){
+		for(size_t x = 0;x < wide_side;x++){
+			size_t index = y*wide_side + x;
+			if(x+1 < wide_side) connect_nodes_in_map_by_indices(&map,index,index+1,EDGE_TYPE_SIDEWALK);
+			if(y+1 < wide_side) connect_nodes_in_map_by_indices(&map,index,index+wide_side,EDGE_TYPE_SIDEWALK);
+			if(x+1 < wide_side && y+1 < wide_side) connect_nodes_in_map_by_indices(&map,index,index+wide_side+1,EDGE_TYPE_SIDEWALK);
+		}
+	}
+	graph = create_map_graph(&map);
+	
+	lengths = (float*) malloc(sizeof(float)*graph->n_edges);
+	compute_projected_edge_lengths(graph->projection,graph,lengths);
+	size_t n_too_long = 0;
+	for(size_t i = 0;i < graph->n_edges;i++){
+		if(lengths[i]*graph->projection->lower_bound_scale > get_map_edge_length(&(graph->edges[i]))) n_too_long++;
+	}
+	free(lengths);
+	
+	context = create_route_search_context(graph->n_nodes);
+	n_mismatches = 0;
+	for(uint32_t start = 0;start < graph->n_nodes;start++){
+		for(uint32_t end = 0;end < graph->n_nodes;end++){
+			bool found = search_map_graph_with_heuristic(graph,context,start,end,ROUTE_PROFILE_WALKER);
+			double cost = found ? context->cost[end] : EDGE_COST_IMPASSABLE;
+			bool plain_found = search_map_graph_with_profile(graph,context,start,end,ROUTE_PROFILE_WALKER);
+			double plain_cost = plain_found ? context->cost[end] : EDGE_COST_IMPASSABLE;
+			if(found != plain_found || (found && fabs(cost - plain_cost) > 1e-3*plain_cost)) n_mismatches++;
+		}
+	}
+	fprintf(stdout,"Map across 25 degrees of latitude: lower bound scale %.2f, scaled edges longer than haversine: %lu, A* searches that differ: %lu\n",
+		graph->projection->lower_bound_scale,n_too_long,n_mismatches);
+	
+	delete_route_search_context(context);
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+void node_order_test(){
+	map_t map = init_map();
+	build_stairs_or_ramp_map(&map);
+	reorder_map_nodes(&map,MAP_NODE_ORDER_HILBERT);
+	fputs("Nodes along the Hilbert curve:\n",stdout);
+	for(size_t i = 0;i < map.n_nodes;i++) fprintf(stdout,"\t%s\n",map.all_nodes[i]->name);
+	clear_map(&map);
+	
+	//every order keeps the same routes between the same nodes, and the flags stay with their nodes
+	map = init_map();
+	build_multi_floor_map(&map);
+	const size_t side = 6;
+	size_t first = map.n_nodes;
+	for(size_t i = 0;i < side*side;i++){
+		//scattered insertion order, like an imported map
+		size_t cell = (i*7) % (side*side);
+		add_node_to_map(&map,create_map_node(create_cord(-76.7150 + (cell % side)*0.0005,39.2530 + (cell / side)*0.0004)));
+	}
+	for(size_t i = 0;i < side*side;i++){
+		size_t cell = (i*7) % (side*side);
+		for(size_t j = 0;j < side*side;j++){
+			size_t other = (j*7) % (side*side);
+			bool right = other == cell+1 && cell % side != side-1;
+			bool up = other == cell+side;
+			if(right || up) connect_nodes_in_map_by_indices(&map,first+i,first+j,(i+j) % 2 ? EDGE_TYPE_SIDEWALK : EDGE_TYPE_RAMP);
+		}
+	}
+	connect_nodes_in_map_by_indices(&map,0,first,EDGE_TYPE_SIDEWALK);
+	
+	map_graph_t * graph = create_map_graph(&map);
+	route_search_context_t * context = create_route_search_context(graph->n_nodes);
+	size_t n = graph->n_nodes;
+	double * costs = (double*) malloc(sizeof(double)*n*n);
+	map_node_t ** nodes = (map_node_t**) malloc(sizeof(map_node_t*)*n);
+	for(size_t i = 0;i < n;i++) nodes[i] = map.all_nodes[i];
+	for(size_t a = 0;a < n;a++){
+		for(size_t b = 0;b < n;b++){
+			costs[a*n + b] = search_map_graph_with_profile(graph,context,a,b,ROUTE_PROFILE_WHEELCHAIR) ? context->cost[b] : EDGE_COST_IMPASSABLE;
+		}
+	}
+	release_map_graph(graph);
+	
+	size_t n_mismatches = 0;
+	for(uint8_t order = 0;order < N_MAP_NODE_ORDERS;order++){
+		reorder_map_nodes(&map,order);
+		graph = create_map_graph(&map);
+		for(size_t i = 0;i < n;i++){
+			if(map.node_flags[i] != compute_map_node_flags(map.all_nodes[i])) n_mismatches++;
+		}
+		for(size_t a = 0;a < n;a++){
+			bool found = false;
+			uint32_t start = get_map_graph_node_index(graph,nodes[a],&found);
+			for(size_t b = 0;b < n;b++){
+				uint32_t end = get_map_graph_node_index(graph,nodes[b],&found);
+				double cost = search_map_graph_with_profile(graph,context,start,end,ROUTE_PROFILE_WHEELCHAIR) ? context->cost[end] : EDGE_COST_IMPASSABLE;
+				if(isinf(cost) != isinf(costs[a*n + b]) || (!isinf(cost) && fabs(cost - costs[a*n + b]) > 1e-3)) n_mismatches++;
+			}
+		}
+		release_map_graph(graph);
+	}
+	fprintf(stdout,"Reordered routes or flags that differ: %lu\n",n_mismatches);
+	
+	free(nodes);
+	free(costs);
+	delete_route_search_context(context);
+	clear_map(&map);
+}
+
+void hot_nodes_test(){
+	map_t map = init_map();
+	build_multi_floor_map(&map);
+	map_graph_t * graph = create_map_graph(&map);
+	fprintf(stdout,"Bytes per node, hot: %lu full copy: %lu\n",sizeof(map_graph_node_t),sizeof(map_node_t));
+	
+	//a view reads the same node the map has, from whichever side of the split holds the field
+	size_t n_mismatches = 0;
+	for(size_t i = 0;i < graph->n_nodes;i++){
+		map_node_view_t view = get_map_graph_node_view(graph,i);
+		const map_node_t * source = get_map_node_view_source(view);
+		cord_t cord = get_map_node_view_cord(view);
+		if(source != map.all_nodes[i]) n_mismatches++;
+		if(cord.longitude != source->coordinate.longitude || cord.latitude != source->coordinate.latitude) n_mismatches++;
+		if(get_map_node_view_floor_number(view) != source->floor_number) n_mismatches++;
+		if(get_map_node_view_building(view) != source->associated_building) n_mismatches++;
+		if(get_map_node_view_flags(view) != compute_map_node_flags(source)) n_mismatches++;
+		if(get_map_node_view_node(view)->selectable != source->selectable) n_mismatches++;
+	}
+	for(size_t j = 0;j < graph->n_edges;j++){
+		uint32_t a = graph->edge_nodes[2*j];
+		uint32_t b = graph->edge_nodes[2*j+1];
+		if(graph->source_nodes[a] != map.all_edges[j]->a || graph->source_nodes[b] != map.all_edges[j]->b) n_mismatches++;
+		if(get_map_graph_other_node(graph,j,a) != b || get_map_graph_other_node(graph,j,b) != a) n_mismatches++;
+	}
+	fprintf(stdout,"Node views or edge ends that differ from the map: %lu\n",n_mismatches);
+	
+	release_map_graph(graph);
+	clear_map(&map);
+}
+
+void string_interner_test(){
+	//the same text gets the same id and address however many strings come after it
+	string_interner_t * interner = create_string_interner();
+	uint32_t first = intern_string(interner,"pictures/ite/lobby.png");
+	const char * first_address = get_interned_string(interner,first);
+	char text[64];
+	size_t n_wrong = 0;
+	for(size_t i = 0;i < 20000;i++){
+		snprintf(text,sizeof(text),"pictures/building %lu/room %lu.png",i % 100,i);
+		uint32_t id = intern_string(interner,text);
+		if(id != i+1 || strcmp(get_interned_string(interner,id),text) != 0) n_wrong++;
+	}
+	if(intern_string(interner,"pictures/ite/lobby.png") != first || get_interned_string(interner,first) != first_address) n_wrong++;
+	if(find_interned_string(interner,"never interned") != STRING_ID_NONE || interner->n_strings != 20001) n_wrong++;
+	
+	//reading the string section back into an empty interner gives every string its id again
+	size_t section_size = 0;
+	uint8_t * section = write_string_section(interner,&section_size);
+	string_interner_t * read_back = create_string_interner();
+	if(!read_string_section(read_back,section,section_size) || read_back->n_strings != interner->n_strings) n_wrong++;
+	for(uint32_t id = 0;id < interner->n_strings;id++){
+		if(strcmp(get_interned_string(read_back,id),get_interned_string(interner,id)) != 0) n_wrong++;
+	}
+	if(read_string_section(read_back,section,section_size-1)) n_wrong++;
+	fprintf(stdout,"Interned strings: %lu, section of %lu bytes, wrong ids or texts: %lu\n",interner->n_strings,section_size,n_wrong);
+	free(section);
+	delete_string_interner(read_back);
+	delete_string_interner(interner);
+	
+	//a map keeps one copy of every name and path, and names are still found after renaming
+	map_t map = init_map();
+	building_t * building = create_building("Engineering",create_map_rect(create_cord(0,0),create_cord(1,1)),3);
+	add_building_alias_name(building,"ENG");
+	add_building_to_map(&map,building);
+	for(size_t i = 0;i < 4;i++){
+		map_node_t * node = create_map_node(create_cord(0.1*i,0.1));
+		snprintf(text,sizeof(text),"Engineering %lu",i);
+		set_map_node_name(node,text);
+		set_map_node_picture(node,"pictures/eng/hall.png");
+		add_node_to_map(&map,node);
+	}
+	bool shared = map.all_nodes[0]->picture_file_path == map.all_nodes[3]->picture_file_path;
+	set_map_node_name(map.all_nodes[2],"Renamed");
+	remove_node_by_name_from_map(&map,"Renamed");
+	remove_node_by_name_from_map(&map,"Engineering 1");
+	intern_map_strings(&map);
+	fprintf(stdout,"Pictures shared: %s, nodes left: %lu %s %s, strings: %lu\n",shared ? "yes" : "no",map.n_nodes,map.all_nodes[0]->name,map.all_nodes[1]->name,map.strings->n_strings);
+	
+	remove_building_by_name_from_map(&map,"ENG");
+	fprintf(stdout,"Buildings left: %lu\n",map.n_buildings);
+	clear_map(&map);
+}
+
+//Write a picture of one color to a PNG file.
+static void write_test_png(const char * path,uint32_t width,uint32_t height,uint8_t red,uint8_t green,uint8_t blue,uint8_t alpha){
+	uint8_t * pixels = (uint8_t*) malloc((size_t) width*height*4);
+	for(size_t i = 0;i < (size_t) width*height;i++){
+		pixels[4*i] = red;
+		pixels[4*i+1] = green;
+		pixels[4*i+2] = blue;
+		pixels[4*i+3] = alpha;
+	}
+	png_image image;
+	memset(&image,0,sizeof(png_image));
+	image.version = PNG_IMAGE_VERSION;
+	image.width = width;
+	image.height = height;
+	image.format = PNG_FORMAT_RGBA;
+	png_image_write_to_file(&image,path,0,pixels,0,NULL);
+	free(pixels);
+}
+
+//Write a picture of one color to a JPEG file.
+static void write_test_jpeg(const char * path,uint32_t width,uint32_t height,uint8_t red,uint8_t green,uint8_t blue){
+	FILE * file = fopen(path,"wb");
+	struct jpeg_compress_struct info;
+	struct jpeg_error_mgr error_manager;
+	info.err = jpeg_std_error(&error_manager);
+	jpeg_create_compress(&info);
+	jpeg_stdio_dest(&info,file);
+	info.image_width = width;
+	info.image_height = height;
+	info.input_components = 3;
+	info.in_color_space = JCS_RGB;
+	jpeg_set_defaults(&info);
+	jpeg_set_quality(&info,95,TRUE);
+	jpeg_start_compress(&info,TRUE);
+	uint8_t * row = (uint8_t*) malloc((size_t) width*3);
+	for(uint32_t x = 0;x < width;x++){
+		row[3*x] = red;
+		row[3*x+1] = green;
+		row[3*x+2] = blue;
+	}
+	while(info.next_scanline < height){
+		JSAMPROW rows[1] = {row};
+		jpeg_write_scanlines(&info,rows,1);
+	}
+	jpeg_finish_compress(&info);
+	jpeg_destroy_compress(&info);
+	free(row);
+	fclose(file);
+}
+
+static void count_ready_image(const char * path,uint8_t size,void * user_data){
+	__atomic_add_fetch((size_t*) user_data,1,__ATOMIC_RELAXED);
+}
+
+void image_cache_test(){
+	write_test_png("/tmp/image_cache_test_0.png",600,400,255,0,0,255);
+	write_test_png("/tmp/image_cache_test_1.png",40,30,0,0,255,128);
+	write_test_jpeg("/tmp/image_cache_test_2.jpg",1200,900,0,255,0);
+	
+	//decoding right away scales to fit and premultiplies
+	cached_image_t * image = decode_cached_image("/tmp/image_cache_test_0.png",IMAGE_SIZE_THUMBNAIL);
+	fprintf(stdout,"Decoded PNG: %ux%u pixel %08x\n",image->width,image->height,image->pixels[0]);
+	release_cached_image(image);
+	image = decode_cached_image("/tmp/image_cache_test_1.png",IMAGE_SIZE_PREVIEW);
+	fprintf(stdout,"Decoded small PNG: %ux%u pixel %08x\n",image->width,image->height,image->pixels[0]);
+	release_cached_image(image);
+	image = decode_cached_image("/tmp/image_cache_test_2.jpg",IMAGE_SIZE_ICON);
+	uint32_t green = (image->pixels[0] >> 8) & 0xFF;
+	fprintf(stdout,"Decoded JPEG: %ux%u green %s\n",image->width,image->height,(green > 240 && (image->pixels[0] >> 24) == 255) ? "yes" : "no");
+	release_cached_image(image);
+	image = decode_cached_image("/tmp/image_cache_test_missing.png",IMAGE_SIZE_ICON);
+	fprintf(stdout,"Missing file failed: %s\n",(image->state == CACHED_IMAGE_FAILED) ? "yes" : "no");
+	release_cached_image(image);
+	
+	//a miss queues the picture and a later request finds it
+	size_t n_ready = 0;
+	image_cache_t * cache = create_image_cache(DEFAULT_IMAGE_CACHE_BYTES,count_ready_image,&n_ready);
+	image = get_cached_image(cache,"/tmp/image_cache_test_0.png",IMAGE_SIZE_ICON);
+	bool first_missed = image == NULL;
+	wait_for_image_cache(cache);
+	image = get_cached_image(cache,"/tmp/image_cache_test_0.png",IMAGE_SIZE_ICON);
+	fprintf(stdout,"First request missed: %s, second hit: %s %ux%u\n",first_missed ? "yes" : "no",(image != NULL) ? "yes" : "no",image->width,image->height);
+	release_cached_image(image);
+	
+	//prefetching a path makes selecting its nodes hits
+	map_t map = init_map();
+	for(size_t i = 0;i < 4;i++){
+		map_node_t * node = create_map_node(create_cord(0.001*i,0.0));
+		const char * pictures[3] = {"/tmp/image_cache_test_0.png","/tmp/image_cache_test_1.png","/tmp/image_cache_test_2.jpg"};
+		if(i < 3) set_map_node_picture(node,pictures[i]);
+		add_node_to_map(&map,node);
+	}
+	map_path_t path = {map.all_nodes,map.n_nodes,NULL};
+	prefetch_map_path_images(cache,&path,IMAGE_SIZE_THUMBNAIL);
+	prefetch_map_rect_images(cache,&map,create_map_rect(create_cord(-1,-1),create_cord(1,1)),IMAGE_SIZE_PREVIEW);
+	wait_for_image_cache(cache);
+	size_t n_found = 0;
+	for(size_t i = 0;i < 3;i++){
+		cached_image_t * thumbnail = get_cached_image(cache,map.all_nodes[i]->picture_file_path,IMAGE_SIZE_THUMBNAIL);
+		cached_image_t * preview = get_cached_image(cache,map.all_nodes[i]->picture_file_path,IMAGE_SIZE_PREVIEW);
+		n_found += (thumbnail != NULL) + (preview != NULL);
+		release_cached_image(thumbnail);
+		release_cached_image(preview);
+	}
+	image_cache_stats_t stats = get_image_cache_stats(cache);
+	fprintf(stdout,"Prefetched pictures found: %lu of 6, %lu requests, %lu hits (%lu prefetched), hit rate %.2f, %lu decoded, %lu ready calls\n",
+		n_found,stats.n_requests,stats.n_hits,stats.n_prefetch_hits,get_image_cache_hit_rate(&stats),stats.n_decoded,n_ready);
+	delete_image_cache(cache);
+	
+	//a budget of about two previews keeps the most recently used ones, and a held picture outlives eviction
+	cache = create_image_cache(2*(IMAGE_PREVIEW_SIDE*768*4 + 1024),NULL,NULL);
+	get_cached_image(cache,"/tmp/image_cache_test_2.jpg",IMAGE_SIZE_PREVIEW);
+	wait_for_image_cache(cache);
+	cached_image_t * held = get_cached_image(cache,"/tmp/image_cache_test_2.jpg",IMAGE_SIZE_PREVIEW);
+	get_cached_image(cache,"/tmp/image_cache_test_0.png",IMAGE_SIZE_PREVIEW);
+	wait_for_image_cache(cache);
+	write_test_jpeg("/tmp/image_cache_test_3.jpg",1200,900,0,0,0);
+	get_cached_image(cache,"/tmp/image_cache_test_3.jpg",IMAGE_SIZE_PREVIEW);
+	wait_for_image_cache(cache);
+	stats = get_image_cache_stats(cache);
+	cached_image_t * oldest = get_cached_image(cache,"/tmp/image_cache_test_2.jpg",IMAGE_SIZE_PREVIEW);
+	fprintf(stdout,"Evicted: %lu, oldest still cached: %s, held picture %ux%u, within budget: %s\n",stats.n_evicted,(oldest != NULL) ? "yes" : "no",held->width,held->height,(stats.bytes <= cache->max_bytes) ? "yes" : "no");
+	release_cached_image(oldest);
+	delete_image_cache(cache);
+	release_cached_image(held);
+	clear_map(&map);
+	
+	//asking again for a picture the thread is decoding neither queues nor decodes it a second time
+	write_test_png("/tmp/image_cache_test_4.png",3000,3000,0,128,255,255);
+	cache = create_image_cache(DEFAULT_IMAGE_CACHE_BYTES,NULL,NULL);
+	get_cached_image(cache,"/tmp/image_cache_test_4.png",IMAGE_SIZE_PREVIEW);
+	bool in_flight = false;
+	while(true){
+		pthread_mutex_lock(&(cache->lock));
+		in_flight = cache->decoding;
+		bool done = cache->n_queued == 0 && !cache->decoding;
+		pthread_mutex_unlock(&(cache->lock));
+		if(in_flight || done) break;
+	}
+	cached_image_t * again = get_cached_image(cache,"/tmp/image_cache_test_4.png",IMAGE_SIZE_PREVIEW);
+	release_cached_image(again);
+	wait_for_image_cache(cache);
+	stats = get_image_cache_stats(cache);
+	image = get_cached_image(cache,"/tmp/image_cache_test_4.png",IMAGE_SIZE_PREVIEW);
+	bool one_charged = image != NULL && stats.bytes == sizeof(cached_image_t) + strlen(image->path)+1 + (size_t) image->width*image->height*4;
+	fprintf(stdout,"Requested while decoding: %lu decoded, charged once: %s, list intact: %s\n",stats.n_decoded,one_charged ? "yes" : "no",
+		(cache->newest == image && cache->oldest == image && image->older == NULL && image->newer == NULL) ? "yes" : "no");
+	release_cached_image(image);
+	delete_image_cache(cache);
+	
+	for(size_t i = 0;i < 5;i++){
+		char file_name[64];
+		snprintf(file_name,sizeof(file_name),(i == 2 || i == 3) ? "/tmp/image_cache_test_%lu.jpg" : "/tmp/image_cache_test_%lu.png",i);
+		remove(file_name);
+	}
+}
+
+//Paint a rectangle of an RGBA picture.
+static void fill_test_rect(uint8_t * rgba,uint32_t width,uint32_t x0,uint32_t y0,uint32_t x1,uint32_t y1,uint32_t color){
+	for(uint32_t y = y0;y < y1;y++){
+		for(uint32_t x = x0;x < x1;x++) memcpy(rgba + 4*((size_t) y*width + x),&color,4);
+	}
+}
+
+void raster_import_test(){
+	//the vectorized classification against the rule pixel by pixel, on a width that leaves a tail
+	const uint32_t noise_width = 37,noise_height = 11;
+	uint8_t * noise = (uint8_t*) malloc(noise_width*noise_height*4);
+	uint32_t random_state = 77;
+	for(size_t i = 0;i < noise_width*noise_height*4;i++){
+		random_state = random_state*1103515245u + 12345u;
+		noise[i] = (uint8_t) (random_state >> 16);
+	}
+	size_t n_walkable = 0;
+	uint8_t * mask = classify_walkable_pixels(noise,noise_width,noise_height,100,&n_walkable);
+	size_t n_mismatches = 0,n_expected = 0;
+	for(size_t i = 0;i < noise_width*noise_height;i++){
+		const uint8_t * pixel = noise + 4*i;
+		uint8_t expected = pixel[1] > 100 && pixel[1] > pixel[0] && pixel[1] > pixel[2] && pixel[3] > 127;
+		n_mismatches += mask[i] != expected;
+		n_expected += expected;
+	}
+	fprintf(stdout,"Classified %lu walkable of %u noise pixels, %lu expected, %lu mismatches\n",n_walkable,noise_width*noise_height,n_expected,n_mismatches);
+	free(mask);
+	free(noise);
+	
+	//a green cross, a green ring, a few green specks and a blue bar on white
+	const uint32_t width = 200,height = 160;
+	const uint32_t white = 0xFFFFFFFF,green = 0xFF30C040,blue = 0xFFC04020;
+	uint8_t * rgba = (uint8_t*) malloc(width*height*4);
+	fill_test_rect(rgba,width,0,0,width,height,white);
+	fill_test_rect(rgba,width,20,70,180,79,green);
+	fill_test_rect(rgba,width,96,10,105,150,green);
+	fill_test_rect(rgba,width,20,100,70,108,blue);
+	for(uint32_t y = 0;y < height;y++){
+		for(uint32_t x = 0;x < width;x++){
+			double distance = hypot(x - 155.0,y - 125.0);
+			if(distance >= 14 && distance <= 19) memcpy(rgba + 4*((size_t) y*width + x),&green,4);
+		}
+	}
+	fill_test_rect(rgba,width,10,20,11,21,green);
+	fill_test_rect(rgba,width,40,140,42,142,green);
+	
+	//thinning leaves lines one pixel wide down the middle of the bars
+	mask = classify_walkable_pixels(rgba,width,height,DEFAULT_RASTER_GREEN_THRESHOLD,&n_walkable);
+	size_t n_skeleton = skeletonize_walkable_mask(mask,width,height);
+	size_t n_thick = 0;
+	for(uint32_t y = 0;y+1 < height;y++){
+		for(uint32_t x = 0;x+1 < width;x++){
+			n_thick += mask[y*width + x] && mask[y*width + x+1] && mask[(y+1)*width + x] && mask[(y+1)*width + x+1];
+		}
+	}
+	fprintf(stdout,"Thinned %lu walkable pixels to %lu, middle of the horizontal bar kept: %s, 2x2 blocks left: %lu\n",n_walkable,n_skeleton,mask[74*width + 50] ? "yes" : "no",n_thick);
+	free(mask);
+	
+	//the cross becomes a junction with four straight arms, the ring a loop, the specks nothing
+	map_t map = init_map();
+	map_rect_t bounds = create_map_rect(create_cord(-76.7200,39.2500),create_cord(-76.7100,39.2580));
+	raster_import_options_t options = default_raster_import_options(bounds);
+	raster_import_stats_t stats;
+	import_raster_pixels(&map,rgba,width,height,&options,&stats);
+	size_t n_junctions = 0,n_dead_ends = 0,n_outside = 0,n_not_sidewalk = 0;
+	for(size_t i = 0;i < map.n_nodes;i++){
+		const map_node_t * node = map.all_nodes[i];
+		n_junctions += node->n_outgoing_edges == 4;
+		n_dead_ends += node->n_outgoing_edges == 1;
+		n_outside += !(node->coordinate.longitude > bounds.bottom_left.longitude && node->coordinate.longitude < bounds.top_right.longitude
+			&& node->coordinate.latitude > bounds.bottom_left.latitude && node->coordinate.latitude < bounds.top_right.latitude);
+	}
+	for(size_t j = 0;j < map.n_edges;j++) n_not_sidewalk += map.all_edges[j]->type != EDGE_TYPE_SIDEWALK;
+	fprintf(stdout,"Imported %ux%u: %lu nodes, %lu edges, %lu four way junctions, %lu dead ends, %lu outside the bounds, %lu not sidewalks\n",
+		stats.width,stats.height,stats.n_nodes,stats.n_edges,n_junctions,n_dead_ends,n_outside,n_not_sidewalk);
+	
+	//the junction sits where the bars cross, pixel 100.5, 74.5 of 200x160
+	cord_t expected = create_cord(-76.7200 + 100.5/width*0.0100,39.2580 - 74.5/height*0.0080);
+	for(size_t i = 0;i < map.n_nodes;i++){
+		if(map.all_nodes[i]->n_outgoing_edges != 4) continue;
+		cord_t cord = map.all_nodes[i]->coordinate;
+		fprintf(stdout,"Junction within a pixel of the crossing: %s\n",(fabs(cord.longitude - expected.longitude) < 0.0100/width && fabs(cord.latitude - expected.latitude) < 0.0080/height) ? "yes" : "no");
+	}
+	clear_map(&map);
+	
+	//the same picture from a PNG file, added to a map that already has a node
+	png_image image;
+	memset(&image,0,sizeof(png_image));
+	image.version = PNG_IMAGE_VERSION;
+	image.width = width;
+	image.height = height;
+	image.format = PNG_FORMAT_RGBA;
+	png_image_write_to_file(&image,"/tmp/raster_import_test.png",0,rgba,0,NULL);
+	map = init_map();
+	add_node_to_map(&map,create_map_node(create_cord(-76.7150,39.2540)));
+	raster_import_stats_t file_stats;
+	bool imported = import_raster_map(&map,"/tmp/raster_import_test.png",&options,&file_stats);
+	bool missing = import_raster_map(&map,"/tmp/raster_import_test_missing.png",&options,NULL);
+	fprintf(stdout,"Imported from file: %s, same graph: %s, map nodes %lu, missing file imported: %s\n",imported ? "yes" : "no",
+		(file_stats.n_nodes == stats.n_nodes && file_stats.n_edges == stats.n_edges) ? "yes" : "no",map.n_nodes,missing ? "yes" : "no");
+	clear_map(&map);
+	remove("/tmp/raster_import_test.png");
+	free(rgba);
+}
+
+//What an import added to a map, by the names and types the test files use.
+static void print_imported_map(const char * format,const map_t * map,const map_import_stats_t * stats){
+	size_t n_by_type[N_EDGE_TYPES] = {0};
+	for(size_t j = 0;j < map->n_edges;j++) n_by_type[map->all_edges[j]->type]++;
+	fprintf(stdout,"%s: %lu elements, %lu nodes, %lu edges (%lu sidewalk, %lu crosswalk, %lu stairs, %lu hallway, %lu auto door), %lu buildings, %lu mpos, %lu shared, %lu skipped, %lu missing\n",
+		format,stats->n_elements,stats->n_nodes,stats->n_edges,n_by_type[EDGE_TYPE_SIDEWALK],n_by_type[EDGE_TYPE_CROSSWALK],n_by_type[EDGE_TYPE_STAIRS],n_by_type[EDGE_TYPE_HALLWAY],n_by_type[EDGE_TYPE_AUTO_DOOR],
+		stats->n_buildings,stats->n_mpos,stats->n_shared_nodes,stats->n_skipped,stats->n_missing_nodes);
+	
+	for(size_t i = 0;i < map->n_nodes;i++){
+		const map_node_t * node = map->all_nodes[i];
+		if(node->name != NULL) fprintf(stdout,"\tnode %s at %.7f, %.7f selectable: %s\n",node->name,node->coordinate.longitude,node->coordinate.latitude,node->selectable ? "yes" : "no");
+		if(node->associated_building != NULL) fprintf(stdout,"\tnode in %s on floor %d, interior flag: %s\n",get_primary_building_name(node->associated_building),node->floor_number,(map->node_flags[i] & NODE_FLAG_INTERIOR) ? "yes" : "no");
+	}
+	for(size_t b = 0;b < map->n_buildings;b++) fprintf(stdout,"\tbuilding %s with %u floors\n",get_primary_building_name(map->all_buildings[b]),map->all_buildings[b]->n_floors);
+	for(size_t m = 0;m < map->n_mpos;m++) fprintf(stdout,"\tmpo type %u with %lu cords named %s\n",map->all_mpos[m]->type,map->all_mpos[m]->n_cords,(map->all_mpos[m]->name != NULL) ? map->all_mpos[m]->name : "-");
+}
+
+void map_import_test(){
+	//a walk with a crosswalk and an automatic door into a building with a corridor upstairs, a lawn, a fence,
+	//a relation and a way reaching a node the file does not have
+	FILE * file = fopen("/tmp/map_import_test.osm","w");
+	fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<osm version=\"0.6\">\n"
+		" <node id=\"1\" lat=\"39.2550000\" lon=\"-76.7130000\"/>\n"
+		" <node id=\"2\" lat=\"39.2551000\" lon=\"-76.7130000\"><tag k=\"name\" v=\"Fountain &amp; Benches\"/></node>\n"
+		" <node id=\"3\" lat=\"39.2552000\" lon=\"-76.7130000\"/>\n"
+		" <node id=\"4\" lat=\"39.2552000\" lon=\"-76.7128000\"/>\n"
+		" <node id=\"5\" lat=\"39.2552000\" lon=\"-76.7126000\"/>\n"
+		" <node id=\"10\" lat=\"39.2551000\" lon=\"-76.7126500\"/>\n"
+		" <node id=\"11\" lat=\"39.2551000\" lon=\"-76.7123000\"/>\n"
+		" <node id=\"12\" lat=\"39.2554000\" lon=\"-76.7123000\"/>\n"
+		" <node id=\"13\" lat=\"39.2554000\" lon=\"-76.7126500\"/>\n"
+		" <node id=\"14\" lat=\"39.2552000\" lon=\"-76.7125000\"/>\n"
+		" <node id=\"15\" lat=\"39.2553000\" lon=\"-76.7124000\"/>\n"
+		" <node id=\"20\" lat=\"39.2545000\" lon=\"-76.7135000\"/>\n"
+		" <node id=\"21\" lat=\"39.2545000\" lon=\"-76.7132000\"/>\n"
+		" <node id=\"22\" lat=\"39.2547000\" lon=\"-76.7133000\"/>\n"
+		" <way id=\"100\"><nd ref=\"1\"/><nd ref=\"2\"/><nd ref=\"3\"/><tag k=\"highway\" v=\"footway\"/></way>\n"
+		" <way id=\"101\"><nd ref=\"3\"/><nd ref=\"4\"/><tag k=\"highway\" v=\"footway\"/><tag k=\"footway\" v=\"crossing\"/></way>\n"
+		" <way id=\"102\"><nd ref=\"4\"/><nd ref=\"5\"/><tag k=\"door\" v=\"yes\"/><tag k=\"automatic_door\" v=\"button\"/></way>\n"
+		" <way id=\"103\"><nd ref=\"5\"/><nd ref=\"14\"/><tag k=\"highway\" v=\"steps\"/></way>\n"
+		" <way id=\"104\"><nd ref=\"14\"/><nd ref=\"15\"/><nd ref=\"99\"/><tag k=\"highway\" v=\"corridor\"/><tag k=\"level\" v=\"1\"/></way>\n"
+		" <way id=\"105\"><nd ref=\"10\"/><nd ref=\"11\"/><nd ref=\"12\"/><nd ref=\"13\"/><nd ref=\"10\"/><tag k=\"building\" v=\"university\"/><tag k=\"name\" v=\"Library\"/><tag k=\"building:levels\" v=\"3\"/></way>\n"
+		" <way id=\"106\"><nd ref=\"20\"/><nd ref=\"21\"/><nd ref=\"22\"/><nd ref=\"20\"/><tag k=\"landuse\" v=\"grass\"/></way>\n"
+		" <way id=\"107\"><nd ref=\"20\"/><nd ref=\"21\"/><tag k=\"barrier\" v=\"fence\"/></way>\n"
+		" <relation id=\"200\"><member type=\"way\" ref=\"105\" role=\"outer\"/><tag k=\"type\" v=\"multipolygon\"/></relation>\n"
+		"</osm>\n",file);
+	fclose(file);
+	
+	map_t map = init_map();
+	map_import_stats_t stats;
+	bool imported = import_map_file(&map,"/tmp/map_import_test.osm",&stats);
+	fprintf(stdout,"OSM file read: %s\n",imported ? "yes" : "no");
+	print_imported_map("OSM",&map,&stats);
+	clear_map(&map);
+	
+	//the same campus as a FeatureCollection: OSM tags nested under tags, the lawn a MultiPolygon with a hole,
+	//the name on a Point before the line through it, and an escaped building name
+	file = fopen("/tmp/map_import_test.geojson","w");
+	fputs("{\"type\": \"FeatureCollection\", \"generator\": {\"name\": \"test\", \"version\": [1, 2]}, \"features\": [\n"
+		" {\"type\": \"Feature\", \"properties\": {\"name\": \"Fountain & Benches\"}, \"geometry\": {\"type\": \"Point\", \"coordinates\": [-76.7130000, 39.2551000]}},\n"
+		" {\"type\": \"Feature\", \"properties\": {\"tags\": {\"highway\": \"footway\"}, \"id\": 100}, \"geometry\": {\"type\": \"LineString\", \"coordinates\": [[-76.713, 39.255], [-76.713, 39.2551], [-76.713, 39.2552]]}},\n"
+		" {\"type\": \"Feature\", \"geometry\": {\"coordinates\": [[-76.713, 39.2552], [-76.7128, 39.2552, 12.5]], \"type\": \"LineString\"}, \"properties\": {\"highway\": \"footway\", \"footway\": \"crossing\"}},\n"
+		" {\"type\": \"Feature\", \"properties\": {\"door\": \"automatic\"}, \"geometry\": {\"type\": \"LineString\", \"coordinates\": [[-76.7128, 39.2552], [-76.7126, 39.2552]]}},\n"
+		" {\"type\": \"Feature\", \"properties\": {\"highway\": \"steps\"}, \"geometry\": {\"type\": \"LineString\", \"coordinates\": [[-76.7126, 39.2552], [-76.7125, 39.2552]]}},\n"
+		" {\"type\": \"Feature\", \"properties\": {\"highway\": \"corridor\", \"level\": 1}, \"geometry\": {\"type\": \"LineString\", \"coordinates\": [[-76.7125, 39.2552], [-76.7124, 39.2553]]}},\n"
+		" {\"type\": \"Feature\", \"properties\": {\"building\": \"university\", \"name\": \"Libr\\u00e4ry \\\"Main\\\"\", \"building:levels\": 3}, \"geometry\": {\"type\": \"Polygon\", \"coordinates\": [[[-76.71265, 39.2551], [-76.7123, 39.2551], [-76.7123, 39.2554], [-76.71265, 39.2554], [-76.71265, 39.2551]]]}},\n"
+		" {\"type\": \"Feature\", \"properties\": {\"landuse\": \"grass\"}, \"geometry\": {\"type\": \"MultiPolygon\", \"coordinates\": [[[[-76.7135, 39.2545], [-76.7132, 39.2545], [-76.7133, 39.2547], [-76.7135, 39.2545]], [[-76.7134, 39.25455], [-76.7133, 39.25455], [-76.7133, 39.2546], [-76.7134, 39.25455]]]]}},\n"
+		" {\"type\": \"Feature\", \"properties\": {\"barrier\": \"fence\", \"note\": null, \"height\": 1.2e0, \"gate\": false}, \"geometry\": {\"type\": \"LineString\", \"coordinates\": [[-76.7135, 39.2545], [-76.7132, 39.2545]]}}\n"
+		"]}\n",file);
+	fclose(file);
+	
+	map = init_map();
+	imported = import_map_file(&map,"/tmp/map_import_test.geojson",&stats);
+	fprintf(stdout,"GeoJSON file read: %s\n",imported ? "yes" : "no");
+	print_imported_map("GeoJSON",&map,&stats);
+	clear_map(&map);
+	
+	//broken files keep what came before the error
+	file = fopen("/tmp/map_import_test_broken.geojson","w");
+	fputs("{\"features\": [{\"properties\": {\"highway\": \"path\"}, \"geometry\": {\"type\": \"LineString\", \"coordinates\": [[0, 0], [0, 1]]}}, {\"properties\": {\"highway\": ",file);
+	fclose(file);
+	map = init_map();
+	imported = import_map_file(&map,"/tmp/map_import_test_broken.geojson",&stats);
+	fprintf(stdout,"Broken GeoJSON read: %s, nodes kept %lu, unknown extension read: %s\n",imported ? "yes" : "no",map.n_nodes,import_map_file(&map,"/tmp/map_import_test.txt",NULL) ? "yes" : "no");
+	clear_map(&map);
+	
+	remove("/tmp/map_import_test.osm");
+	remove("/tmp/map_import_test.geojson");
+	remove("/tmp/map_import_test_broken.geojson");
+}
+
+//true if two maps have the same nodes at the same indices joined by the same edges
+static bool is_same_campus_map(const map_t * a,const map_t * b){
+	if(a->n_nodes != b->n_nodes || a->n_edges != b->n_edges || a->n_mpos != b->n_mpos) return false;
+	for(size_t i = 0;i < a->n_nodes;i++){
+		const map_node_t * node_a = a->all_nodes[i];
+		const map_node_t * node_b = b->all_nodes[i];
+		if(node_a->coordinate.longitude != node_b->coordinate.longitude || node_a->coordinate.latitude != node_b->coordinate.latitude) return false;
+		if(node_a->floor_number != node_b->floor_number || a->node_flags[i] != b->node_flags[i]) return false;
+	}
+	for(size_t j = 0;j < a->n_edges;j++){
+		if(a->all_edges[j]->type != b->all_edges[j]->type) return false;
+		if(a->all_edges[j]->a->coordinate.longitude != b->all_edges[j]->a->coordinate.longitude) return false;
+		if(a->all_edges[j]->b->coordinate.latitude != b->all_edges[j]->b->coordinate.latitude) return false;
+	}
+	return true;
+}
+
+void campus_generator_test(){
+	campus_options_t options = default_campus_options();
+	campus_stats_t stats;
+	map_t map = init_map();
+	bool generated = generate_campus_map(&map,&options,&stats);
+	fprintf(stdout,"Campus generated: %s, %lu blocks, %lu buildings, %lu parks, %lu ponds, %lu nodes, %lu edges, %lu mpos, %lu buildings in the map\n",
+		generated ? "yes" : "no",stats.n_blocks,stats.n_buildings,stats.n_parks,stats.n_ponds,stats.n_nodes,stats.n_edges,stats.n_mpos,map.n_buildings);
+	fputs("Edges by type:",stdout);
+	for(uint8_t type = 1;type < N_EDGE_TYPES;type++) fprintf(stdout," %lu",stats.n_edges_by_type[type]);
+	fputc('\n',stdout);
+	
+	//indoor nodes sit on a floor of their building and inside it, outdoor nodes have no floor
+	size_t n_misplaced = 0,n_rooms = 0,n_rooms_selectable = 0,n_elevator_flags = 0;
+	for(size_t i = 0;i < map.n_nodes;i++){
+		const map_node_t * node = map.all_nodes[i];
+		const building_t * building = node->associated_building;
+		if(building == NULL){
+			n_misplaced += node->floor_number != NODE_FLOOR_NUMBER_NONE;
+		}else{
+			map_rect_t box = building->building_bounding_box;
+			n_misplaced += node->floor_number < 1 || node->floor_number > building->n_floors;
+			n_misplaced += node->coordinate.longitude < box.bottom_left.longitude || node->coordinate.longitude > box.top_right.longitude;
+			n_misplaced += node->coordinate.latitude < box.bottom_left.latitude || node->coordinate.latitude > box.top_right.latitude;
+		}
+		if(node->name != NULL){
+			n_rooms++;
+			n_rooms_selectable += (map.node_flags[i] & NODE_FLAG_SELECTABLE) != 0;
+		}
+		n_elevator_flags += (map.node_flags[i] & NODE_FLAG_HAS_ELEVATOR) != 0;
+	}
+	fprintf(stdout,"Misplaced nodes: %lu, named rooms %lu, selectable %lu, next to elevators %lu, first building %s\n",
+		n_misplaced,n_rooms,n_rooms_selectable,n_elevator_flags,get_primary_building_name(map.all_buildings[0]));
+	
+	//every room and sidewalk can be reached from every other
+	map_graph_t * graph = create_map_graph(&map);
+	uint8_t * reached = (uint8_t*) calloc(graph->n_nodes,1);
+	uint32_t * queue = (uint32_t*) malloc(sizeof(uint32_t)*graph->n_nodes);
+	size_t head = 0,tail = 0;
+	queue[tail++] = 0;
+	reached[0] = 1;
+	while(head < tail){
+		uint32_t node = queue[head++];
+		for(size_t i = graph->adjacency_offsets[node];i < graph->adjacency_offsets[node+1];i++){
+			uint32_t next = graph->adjacency_nodes[i];
+			if(reached[next]) continue;
+			reached[next] = 1;
+			queue[tail++] = next;
+		}
+	}
+	fprintf(stdout,"Reached %lu of %lu nodes from the first\n",tail,(size_t) graph->n_nodes);
+	free(queue);
+	free(reached);
+	release_map_graph(graph);
+	
+	//the same seed gives the same map, another seed another one
+	map_t again = init_map();
+	generate_campus_map(&again,&options,NULL);
+	map_t other = init_map();
+	options.seed = DEFAULT_CAMPUS_SEED + 1;
+	generate_campus_map(&other,&options,NULL);
+	fprintf(stdout,"Same seed same map: %s, other seed same map: %s\n",is_same_campus_map(&map,&again) ? "yes" : "no",is_same_campus_map(&map,&other) ? "yes" : "no");
+	clear_map(&again);
+	clear_map(&other);
+	clear_map(&map);
+	
+	//sizes from hundreds to tens of thousands land near the size asked for
+	const size_t sizes[3] = {300,5000,40000};
+	for(size_t s = 0;s < 3;s++){
+		options = campus_options_for_size(sizes[s],7);
+		map = init_map();
+		generate_campus_map(&map,&options,&stats);
+		fprintf(stdout,"Asked for %lu nodes: %ux%u blocks, within a quarter: %s\n",sizes[s],options.blocks_x,options.blocks_y,
+			(stats.n_nodes > 0.75*sizes[s] && stats.n_nodes < 1.25*sizes[s]) ? "yes" : "no");
+		clear_map(&map);
+	}
+	
+	options = default_campus_options();
+	options.hallway_nodes = 1;
+	map = init_map();
+	fprintf(stdout,"One hallway node generated: %s, nodes %lu\n",generate_campus_map(&map,&options,NULL) ? "yes" : "no",map.n_nodes);
+	clear_map(&map);
+}
@@ -5,5 +5,29 @@ void building_data_structure_test();
 void node_edge_data_structure_test();
 void mpo_data_structure_test();
 void map_construction_test();
+void routing_test();
+void route_worker_test();
+void map_publisher_test();
+void route_batch_test();
+void distance_matrix_test();
+void edge_weights_test();
+void search_filter_test();
+void node_flags_test();
+void floor_layers_test();
+void building_routes_test();
+void edge_closures_test();
+void route_repair_test();
+void route_alternatives_test();
+void pareto_routes_test();
+void isochrone_test();
+void schedules_test();
+void projection_test();
+void node_order_test();
+void hot_nodes_test();
+void string_interner_test();
+void image_cache_test();
+void raster_import_test();
+void map_import_test();
+void campus_generator_test();
 
 #endif
\ No newline at end of file
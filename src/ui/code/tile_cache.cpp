@@ -0,0 +1,530 @@
+#include "tile_cache.h"
+#include <math.h>
+
+//widest line drawn on a tile, tiles are padded by this much so strokes are not clipped at tile borders
+#define MAX_STROKE_PIXELS 4.0
+
+static void set_mpo_color(cairo_t * cr,uint8_t type){
+	if(type == MPO_TYPE_WATER){
+		cairo_set_source_rgb(cr,0.60,0.78,0.95);
+	}else if(type == MPO_TYPE_TREE){
+		cairo_set_source_rgb(cr,0.62,0.82,0.58);
+	}else if(type == MPO_TYPE_BUILDING){
+		cairo_set_source_rgb(cr,0.80,0.78,0.75);
+	}else{
+		cairo_set_source_rgb(cr,0.90,0.90,0.90);
+	}
+}
+
+//returns the stroke width in pixels
+static double set_edge_style(cairo_t * cr,uint8_t type){
+	if(type == EDGE_TYPE_ROAD){
+		cairo_set_source_rgb(cr,0.45,0.45,0.45);
+		return 4.0;
+	}else if(type == EDGE_TYPE_STAIRS){
+		cairo_set_source_rgb(cr,0.85,0.30,0.25);
+		return 2.0;
+	}else if(type == EDGE_TYPE_RAMP){
+		cairo_set_source_rgb(cr,0.20,0.60,0.30);
+		return 2.0;
+	}else if(type == EDGE_TYPE_HALLWAY){
+		cairo_set_source_rgb(cr,0.65,0.60,0.50);
+		return 1.5;
+	}else if(type == EDGE_TYPE_ELEVATOR_SHAFT){
+		cairo_set_source_rgb(cr,0.55,0.30,0.70);
+		return 2.0;
+	}else if(type == EDGE_TYPE_OVERPASS){
+		cairo_set_source_rgb(cr,0.35,0.35,0.55);
+		return 3.0;
+	}else if(type == EDGE_TYPE_DOOR){
+		cairo_set_source_rgb(cr,0.60,0.40,0.20);
+		return 2.0;
+	}else if(type == EDGE_TYPE_AUTO_DOOR){
+		cairo_set_source_rgb(cr,0.15,0.45,0.80);
+		return 2.0;
+	}else if(type == EDGE_TYPE_CROSSWALK){
+		cairo_set_source_rgb(cr,0.95,0.75,0.10);
+		return 3.0;
+	}
+
+	//sidewalk and anything unknown
+	cairo_set_source_rgb(cr,0.30,0.30,0.30);
+	return 2.0;
+}
+
+static bool map_rects_overlap(map_rect_t a,map_rect_t b){
+	if(a.top_right.longitude < b.bottom_left.longitude) return false;
+	if(b.top_right.longitude < a.bottom_left.longitude) return false;
+	if(a.top_right.latitude < b.bottom_left.latitude) return false;
+	if(b.top_right.latitude < a.bottom_left.latitude) return false;
+	return true;
+}
+
+map_rect_t get_map_edge_bounding_rect(const map_edge_t * edge){
+	cord_t a = edge->a->coordinate;
+	cord_t b = edge->b->coordinate;
+
+	return create_map_rect(
+		create_cord(fmin(a.longitude,b.longitude),fmin(a.latitude,b.latitude)),
+		create_cord(fmax(a.longitude,b.longitude),fmax(a.latitude,b.latitude))
+	);
+}
+
+map_rect_t get_mpo_bounding_rect(const mpo_t * mpo){
+	if(mpo->n_cords == 0) return create_map_rect(create_cord(0,0),create_cord(0,0));
+
+	map_rect_t out = create_map_rect(mpo->cords[0],mpo->cords[0]);
+	for(size_t i = 1;i < mpo->n_cords;i++){
+		cord_t c = mpo->cords[i];
+		out.bottom_left.longitude = fmin(out.bottom_left.longitude,c.longitude);
+		out.bottom_left.latitude = fmin(out.bottom_left.latitude,c.latitude);
+		out.top_right.longitude = fmax(out.top_right.longitude,c.longitude);
+		out.top_right.latitude = fmax(out.top_right.latitude,c.latitude);
+	}
+	return out;
+}
+
+//an MPO gathered for one tile, with the order it is painted in
+typedef struct Tile_Mpo{
+	const mpo_t * mpo;
+	uint64_t order;
+} tile_mpo_t;
+
+static int compare_tile_mpos(const void * a,const void * b){
+	uint64_t order_a = ((const tile_mpo_t*) a)->order;
+	uint64_t order_b = ((const tile_mpo_t*) b)->order;
+	return (order_a > order_b) - (order_a < order_b);
+}
+
+//the buckets a region of the world overlaps, clamped to the grid
+static void get_bucket_range(const tile_cache_t * cache,map_rect_t region,int64_t * first_x,int64_t * first_y,int64_t * last_x,int64_t * last_y){
+	double left,top,right,bottom;
+	tile_cache_world_to_pixel(cache,TILE_CACHE_BUCKET_ZOOM,create_cord(region.bottom_left.longitude,region.top_right.latitude),&left,&top);
+	tile_cache_world_to_pixel(cache,TILE_CACHE_BUCKET_ZOOM,create_cord(region.top_right.longitude,region.bottom_left.latitude),&right,&bottom);
+
+	const double last = TILE_CACHE_BUCKETS_PER_SIDE - 1;
+	*first_x = (int64_t) fmin(fmax(floor(left/TILE_SIZE_PIXELS),0.0),last);
+	*first_y = (int64_t) fmin(fmax(floor(top/TILE_SIZE_PIXELS),0.0),last);
+	*last_x = (int64_t) fmin(fmax(floor(right/TILE_SIZE_PIXELS),0.0),last);
+	*last_y = (int64_t) fmin(fmax(floor(bottom/TILE_SIZE_PIXELS),0.0),last);
+}
+
+static tile_bucket_t * get_bucket(tile_cache_t * cache,int64_t bucket_x,int64_t bucket_y){
+	return &(cache->buckets[bucket_y*TILE_CACHE_BUCKETS_PER_SIDE + bucket_x]);
+}
+
+static void bucket_edge(tile_cache_t * cache,const map_edge_t * edge){
+	int64_t first_x,first_y,last_x,last_y;
+	get_bucket_range(cache,get_map_edge_bounding_rect(edge),&first_x,&first_y,&last_x,&last_y);
+
+	for(int64_t bucket_y = first_y;bucket_y <= last_y;bucket_y++){
+		for(int64_t bucket_x = first_x;bucket_x <= last_x;bucket_x++){
+			tile_bucket_t * bucket = get_bucket(cache,bucket_x,bucket_y);
+			if(bucket->n_edges == bucket->max_edges){
+				bucket->max_edges = (bucket->max_edges == 0) ? 16 : 2*bucket->max_edges;
+				bucket->edges = (const map_edge_t**) realloc(bucket->edges,sizeof(const map_edge_t*)*bucket->max_edges);
+			}
+			bucket->edges[bucket->n_edges++] = edge;
+		}
+	}
+}
+
+static void bucket_mpo(tile_cache_t * cache,const mpo_t * mpo){
+	int64_t first_x,first_y,last_x,last_y;
+	get_bucket_range(cache,get_mpo_bounding_rect(mpo),&first_x,&first_y,&last_x,&last_y);
+
+	uint64_t order = cache->next_mpo_order++;
+	for(int64_t bucket_y = first_y;bucket_y <= last_y;bucket_y++){
+		for(int64_t bucket_x = first_x;bucket_x <= last_x;bucket_x++){
+			tile_bucket_t * bucket = get_bucket(cache,bucket_x,bucket_y);
+			if(bucket->n_mpos == bucket->max_mpos){
+				bucket->max_mpos = (bucket->max_mpos == 0) ? 16 : 2*bucket->max_mpos;
+				bucket->mpos = (const mpo_t**) realloc(bucket->mpos,sizeof(const mpo_t*)*bucket->max_mpos);
+				bucket->mpo_order = (uint64_t*) realloc(bucket->mpo_order,sizeof(uint64_t)*bucket->max_mpos);
+			}
+			bucket->mpos[bucket->n_mpos] = mpo;
+			bucket->mpo_order[bucket->n_mpos] = order;
+			bucket->n_mpos++;
+		}
+	}
+}
+
+//empty every bucket and fill them again from the map
+static void bucket_map(tile_cache_t * cache){
+	for(size_t i = 0;i < TILE_CACHE_BUCKETS_PER_SIDE*TILE_CACHE_BUCKETS_PER_SIDE;i++){
+		cache->buckets[i].n_edges = 0;
+		cache->buckets[i].n_mpos = 0;
+	}
+	cache->next_mpo_order = 0;
+
+	const map_t * map = cache->map;
+	for(size_t i = 0;i < map->n_edges;i++) bucket_edge(cache,map->all_edges[i]);
+	for(size_t i = 0;i < map->n_mpos;i++) bucket_mpo(cache,map->all_mpos[i]);
+}
+
+tile_cache_t * create_tile_cache(const map_t * map,size_t max_tiles){
+	tile_cache_t * cache = (tile_cache_t*) malloc(sizeof(tile_cache_t));
+
+	cache->map = map;
+	cache->max_tiles = (max_tiles == 0) ? DEFAULT_MAX_CACHED_TILES : max_tiles;
+	cache->tiles = (map_tile_t*) malloc(sizeof(map_tile_t)*cache->max_tiles);
+	cache->n_tiles = 0;
+	cache->current_frame = 0;
+	cache->n_tile_renders = 0;
+	cache->n_tile_hits = 0;
+
+	size_t n_slots = 16;
+	while(n_slots < 2*cache->max_tiles) n_slots *= 2;
+	cache->tile_slot_mask = n_slots - 1;
+	cache->tile_slots = (uint32_t*) malloc(sizeof(uint32_t)*n_slots);
+	for(size_t i = 0;i < n_slots;i++) cache->tile_slots[i] = UINT32_MAX;
+
+	//anchor pixel space so that zoom 0 fits the whole map in one tile, with longitude shrunk to its width on the ground
+	map_rect_t bounds = get_map_bounding_rect(map);
+	double middle_latitude = (bounds.bottom_left.latitude + bounds.top_right.latitude)/2.0;
+	cache->longitude_scale = fmax(cos(middle_latitude*(M_PI/180.0)),TILE_CACHE_MIN_LONGITUDE_SCALE);
+	double width = (bounds.top_right.longitude - bounds.bottom_left.longitude)*cache->longitude_scale;
+	double height = bounds.top_right.latitude - bounds.bottom_left.latitude;
+	double extent = fmax(width,height);
+
+	cache->origin = create_cord(bounds.bottom_left.longitude,bounds.top_right.latitude);
+	cache->base_scale = (extent > 0.0) ? TILE_SIZE_PIXELS/extent : 1.0;
+
+	size_t n_buckets = TILE_CACHE_BUCKETS_PER_SIDE*TILE_CACHE_BUCKETS_PER_SIDE;
+	cache->buckets = (tile_bucket_t*) malloc(sizeof(tile_bucket_t)*n_buckets);
+	for(size_t i = 0;i < n_buckets;i++){
+		tile_bucket_t * bucket = &(cache->buckets[i]);
+		bucket->edges = NULL;
+		bucket->n_edges = 0;
+		bucket->max_edges = 0;
+		bucket->mpos = NULL;
+		bucket->mpo_order = NULL;
+		bucket->n_mpos = 0;
+		bucket->max_mpos = 0;
+	}
+	bucket_map(cache);
+
+	return cache;
+}
+
+void delete_tile_cache(tile_cache_t * cache){
+	if(cache == NULL) return;
+
+	for(size_t i = 0;i < cache->n_tiles;i++){
+		if(cache->tiles[i].surface != NULL) cairo_surface_destroy(cache->tiles[i].surface);
+	}
+	free(cache->tiles);
+	free(cache->tile_slots);
+	for(size_t i = 0;i < TILE_CACHE_BUCKETS_PER_SIDE*TILE_CACHE_BUCKETS_PER_SIDE;i++){
+		free(cache->buckets[i].edges);
+		free(cache->buckets[i].mpos);
+		free(cache->buckets[i].mpo_order);
+	}
+	free(cache->buckets);
+	free(cache);
+}
+
+double get_tile_cache_scale(const tile_cache_t * cache,int zoom_level){
+	return ldexp(cache->base_scale,zoom_level);
+}
+
+void tile_cache_world_to_pixel(const tile_cache_t * cache,int zoom_level,cord_t cord,double * x_out,double * y_out){
+	double scale = get_tile_cache_scale(cache,zoom_level);
+	*x_out = (cord.longitude - cache->origin.longitude)*cache->longitude_scale*scale;
+	*y_out = (cache->origin.latitude - cord.latitude)*scale;//screen y grows downward
+}
+
+cord_t tile_cache_pixel_to_world(const tile_cache_t * cache,int zoom_level,double x,double y){
+	double scale = get_tile_cache_scale(cache,zoom_level);
+	return create_cord(cache->origin.longitude + x/(scale*cache->longitude_scale),cache->origin.latitude - y/scale);
+}
+
+/*
+ * The region of the world a tile shows, padded by the widest stroke so that
+ * lines just outside the tile that bleed into it are still drawn.
+ */
+static map_rect_t get_tile_world_rect(const tile_cache_t * cache,int zoom_level,int64_t tile_x,int64_t tile_y){
+	double padding = MAX_STROKE_PIXELS;
+	cord_t top_left = tile_cache_pixel_to_world(cache,zoom_level,
+		tile_x*TILE_SIZE_PIXELS - padding,tile_y*TILE_SIZE_PIXELS - padding);
+	cord_t bottom_right = tile_cache_pixel_to_world(cache,zoom_level,
+		(tile_x+1)*TILE_SIZE_PIXELS + padding,(tile_y+1)*TILE_SIZE_PIXELS + padding);
+
+	return create_map_rect(
+		create_cord(top_left.longitude,bottom_right.latitude),
+		create_cord(bottom_right.longitude,top_left.latitude)
+	);
+}
+
+/*
+ * Rasterize polygons and then edges (one stroke per edge type) into the tile's image. Only the buckets under
+ * the tile are visited, something in several of them is taken from the first one both it and the tile overlap.
+ */
+static void render_tile(tile_cache_t * cache,map_tile_t * tile){
+	if(tile->surface == NULL){
+		tile->surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,TILE_SIZE_PIXELS,TILE_SIZE_PIXELS);
+	}
+
+	map_rect_t tile_rect = get_tile_world_rect(cache,tile->zoom_level,tile->tile_x,tile->tile_y);
+	int64_t first_x,first_y,last_x,last_y;
+	get_bucket_range(cache,tile_rect,&first_x,&first_y,&last_x,&last_y);
+
+	size_t max_edges = 0;
+	size_t max_mpos = 0;
+	for(int64_t bucket_y = first_y;bucket_y <= last_y;bucket_y++){
+		for(int64_t bucket_x = first_x;bucket_x <= last_x;bucket_x++){
+			max_edges += get_bucket(cache,bucket_x,bucket_y)->n_edges;
+			max_mpos += get_bucket(cache,bucket_x,bucket_y)->n_mpos;
+		}
+	}
+	const map_edge_t ** edges = (const map_edge_t**) malloc(sizeof(const map_edge_t*)*(max_edges+1));
+	tile_mpo_t * mpos = (tile_mpo_t*) malloc(sizeof(tile_mpo_t)*(max_mpos+1));
+	size_t n_edges = 0;
+	size_t n_mpos = 0;
+
+	for(int64_t bucket_y = first_y;bucket_y <= last_y;bucket_y++){
+		for(int64_t bucket_x = first_x;bucket_x <= last_x;bucket_x++){
+			const tile_bucket_t * bucket = get_bucket(cache,bucket_x,bucket_y);
+			int64_t item_first_x,item_first_y,item_last_x,item_last_y;
+
+			for(size_t i = 0;i < bucket->n_mpos;i++){
+				map_rect_t rect = get_mpo_bounding_rect(bucket->mpos[i]);
+				get_bucket_range(cache,rect,&item_first_x,&item_first_y,&item_last_x,&item_last_y);
+				if(fmax(item_first_x,first_x) != bucket_x || fmax(item_first_y,first_y) != bucket_y) continue;
+				if(bucket->mpos[i]->n_cords < 3 || !map_rects_overlap(tile_rect,rect)) continue;
+
+				mpos[n_mpos].mpo = bucket->mpos[i];
+				mpos[n_mpos].order = bucket->mpo_order[i];
+				n_mpos++;
+			}
+
+			for(size_t i = 0;i < bucket->n_edges;i++){
+				map_rect_t rect = get_map_edge_bounding_rect(bucket->edges[i]);
+				get_bucket_range(cache,rect,&item_first_x,&item_first_y,&item_last_x,&item_last_y);
+				if(fmax(item_first_x,first_x) != bucket_x || fmax(item_first_y,first_y) != bucket_y) continue;
+				if(!map_rects_overlap(tile_rect,rect)) continue;
+
+				edges[n_edges++] = bucket->edges[i];
+			}
+		}
+	}
+	qsort(mpos,n_mpos,sizeof(tile_mpo_t),compare_tile_mpos);
+
+	cairo_t * cr = cairo_create(tile->surface);
+
+	//clear to transparent
+	cairo_set_operator(cr,CAIRO_OPERATOR_CLEAR);
+	cairo_paint(cr);
+	cairo_set_operator(cr,CAIRO_OPERATOR_OVER);
+
+	//shift pixel space so the tile's top left corner is (0,0)
+	cairo_translate(cr,-(double)(tile->tile_x*TILE_SIZE_PIXELS),-(double)(tile->tile_y*TILE_SIZE_PIXELS));
+
+	double x;
+	double y;
+
+	//polygon layer
+	for(size_t i = 0;i < n_mpos;i++){
+		const mpo_t * mpo = mpos[i].mpo;
+
+		for(size_t j = 0;j < mpo->n_cords;j++){
+			tile_cache_world_to_pixel(cache,tile->zoom_level,mpo->cords[j],&x,&y);
+			if(j == 0){
+				cairo_move_to(cr,x,y);
+			}else{
+				cairo_line_to(cr,x,y);
+			}
+		}
+		cairo_close_path(cr);
+		set_mpo_color(cr,mpo->type);
+		cairo_fill(cr);
+	}
+
+	//edge layers, batched so every edge type is a single stroke
+	cairo_set_line_cap(cr,CAIRO_LINE_CAP_ROUND);
+	for(uint8_t type = EDGE_TYPE_SIDEWALK;type <= EDGE_TYPE_CROSSWALK;type++){
+		bool any_edges = false;
+
+		for(size_t i = 0;i < n_edges;i++){
+			const map_edge_t * edge = edges[i];
+			if(edge->type != type) continue;
+
+			tile_cache_world_to_pixel(cache,tile->zoom_level,edge->a->coordinate,&x,&y);
+			cairo_move_to(cr,x,y);
+			tile_cache_world_to_pixel(cache,tile->zoom_level,edge->b->coordinate,&x,&y);
+			cairo_line_to(cr,x,y);
+			any_edges = true;
+		}
+
+		if(!any_edges) continue;
+		cairo_set_line_width(cr,set_edge_style(cr,type));
+		cairo_stroke(cr);
+	}
+
+	cairo_destroy(cr);
+	cairo_surface_flush(tile->surface);
+	free(edges);
+	free(mpos);
+
+	tile->valid = true;
+	cache->n_tile_renders++;
+}
+
+static size_t get_tile_slot(const tile_cache_t * cache,int zoom_level,int64_t tile_x,int64_t tile_y){
+	uint64_t key = (uint64_t) tile_x*0x9E3779B97F4A7C15ULL ^ (uint64_t) tile_y*0xC2B2AE3D27D4EB4FULL ^ (uint64_t) zoom_level*0x165667B19E3779F9ULL;
+	key ^= key >> 29;
+	return (size_t) key & cache->tile_slot_mask;
+}
+
+//take a tile out of the chain of its hash slot
+static void unlink_tile(tile_cache_t * cache,uint32_t index){
+	map_tile_t * tile = &(cache->tiles[index]);
+	uint32_t * link = &(cache->tile_slots[get_tile_slot(cache,tile->zoom_level,tile->tile_x,tile->tile_y)]);
+	while(*link != index) link = &(cache->tiles[*link].next_in_slot);
+	*link = tile->next_in_slot;
+}
+
+/*
+ * Find a tile in the cache. If it isn't there reuse the least recently used slot.
+ */
+static map_tile_t * get_tile(tile_cache_t * cache,int zoom_level,int64_t tile_x,int64_t tile_y){
+	size_t slot = get_tile_slot(cache,zoom_level,tile_x,tile_y);
+	for(uint32_t i = cache->tile_slots[slot];i != UINT32_MAX;i = cache->tiles[i].next_in_slot){
+		map_tile_t * tile = &(cache->tiles[i]);
+		if(tile->zoom_level == zoom_level && tile->tile_x == tile_x && tile->tile_y == tile_y){
+			tile->last_used_frame = cache->current_frame;
+			return tile;
+		}
+	}
+
+	//only a miss, which renders a whole tile, looks through every tile
+	uint32_t index;
+	if(cache->n_tiles < cache->max_tiles){
+		index = cache->n_tiles;
+		cache->tiles[index].surface = NULL;
+		cache->n_tiles++;
+	}else{
+		//evict the least recently used tile and reuse its image
+		index = 0;
+		for(size_t i = 1;i < cache->n_tiles;i++){
+			if(cache->tiles[i].last_used_frame < cache->tiles[index].last_used_frame) index = i;
+		}
+		unlink_tile(cache,index);
+	}
+
+	map_tile_t * tile = &(cache->tiles[index]);
+	tile->zoom_level = zoom_level;
+	tile->tile_x = tile_x;
+	tile->tile_y = tile_y;
+	tile->valid = false;
+	tile->last_used_frame = cache->current_frame;
+	tile->next_in_slot = cache->tile_slots[slot];
+	cache->tile_slots[slot] = index;
+
+	return tile;
+}
+
+void draw_tile_cache(tile_cache_t * cache,cairo_t * cr,int zoom_level,double view_x,double view_y,int width,int height){
+	if(cache == NULL || cr == NULL) return;
+
+	cache->current_frame++;
+
+	int64_t first_x = (int64_t) floor(view_x/TILE_SIZE_PIXELS);
+	int64_t first_y = (int64_t) floor(view_y/TILE_SIZE_PIXELS);
+	int64_t last_x = (int64_t) floor((view_x + width)/TILE_SIZE_PIXELS);
+	int64_t last_y = (int64_t) floor((view_y + height)/TILE_SIZE_PIXELS);
+
+	//round the view offset so tiles are blitted on whole pixels and never resampled
+	double offset_x = round(view_x);
+	double offset_y = round(view_y);
+
+	for(int64_t tile_y = first_y;tile_y <= last_y;tile_y++){
+		for(int64_t tile_x = first_x;tile_x <= last_x;tile_x++){
+			map_tile_t * tile = get_tile(cache,zoom_level,tile_x,tile_y);
+			if(tile->valid){
+				cache->n_tile_hits++;
+			}else{
+				render_tile(cache,tile);
+			}
+
+			cairo_set_source_surface(cr,tile->surface,
+				tile_x*TILE_SIZE_PIXELS - offset_x,tile_y*TILE_SIZE_PIXELS - offset_y);
+			cairo_paint(cr);
+		}
+	}
+}
+
+void invalidate_tile_cache_region(tile_cache_t * cache,map_rect_t region){
+	if(cache == NULL) return;
+
+	for(size_t i = 0;i < cache->n_tiles;i++){
+		map_tile_t * tile = &(cache->tiles[i]);
+		if(!tile->valid) continue;
+
+		map_rect_t tile_rect = get_tile_world_rect(cache,tile->zoom_level,tile->tile_x,tile->tile_y);
+		if(map_rects_overlap(tile_rect,region)) tile->valid = false;
+	}
+}
+
+void invalidate_tile_cache(tile_cache_t * cache){
+	if(cache == NULL) return;
+
+	for(size_t i = 0;i < cache->n_tiles;i++){
+		cache->tiles[i].valid = false;
+	}
+	bucket_map(cache);
+}
+
+void add_edge_to_tile_cache(tile_cache_t * cache,const map_edge_t * edge){
+	if(cache == NULL || edge == NULL) return;
+
+	bucket_edge(cache,edge);
+	invalidate_tile_cache_region(cache,get_map_edge_bounding_rect(edge));
+}
+
+void remove_edge_from_tile_cache(tile_cache_t * cache,const map_edge_t * edge,map_rect_t old_rect){
+	if(cache == NULL || edge == NULL) return;
+
+	int64_t first_x,first_y,last_x,last_y;
+	get_bucket_range(cache,old_rect,&first_x,&first_y,&last_x,&last_y);
+	for(int64_t bucket_y = first_y;bucket_y <= last_y;bucket_y++){
+		for(int64_t bucket_x = first_x;bucket_x <= last_x;bucket_x++){
+			tile_bucket_t * bucket = get_bucket(cache,bucket_x,bucket_y);
+			for(size_t i = 0;i < bucket->n_edges;i++){
+				if(bucket->edges[i] != edge) continue;
+
+				bucket->edges[i] = bucket->edges[--bucket->n_edges];
+				break;
+			}
+		}
+	}
+	invalidate_tile_cache_region(cache,old_rect);
+}
+
+void add_mpo_to_tile_cache(tile_cache_t * cache,const mpo_t * mpo){
+	if(cache == NULL || mpo == NULL) return;
+
+	bucket_mpo(cache,mpo);
+	invalidate_tile_cache_region(cache,get_mpo_bounding_rect(mpo));
+}
+
+void remove_mpo_from_tile_cache(tile_cache_t * cache,const mpo_t * mpo,map_rect_t old_rect){
+	if(cache == NULL || mpo == NULL) return;
+
+	int64_t first_x,first_y,last_x,last_y;
+	get_bucket_range(cache,old_rect,&first_x,&first_y,&last_x,&last_y);
+	for(int64_t bucket_y = first_y;bucket_y <= last_y;bucket_y++){
+		for(int64_t bucket_x = first_x;bucket_x <= last_x;bucket_x++){
+			tile_bucket_t * bucket = get_bucket(cache,bucket_x,bucket_y);
+			for(size_t i = 0;i < bucket->n_mpos;i++){
+				if(bucket->mpos[i] != mpo) continue;
+
+				bucket->n_mpos--;
+				bucket->mpos[i] = bucket->mpos[bucket->n_mpos];
+				bucket->mpo_order[i] = bucket->mpo_order[bucket->n_mpos];
+				break;
+			}
+		}
+	}
+	invalidate_tile_cache_region(cache,old_rect);
+}
@@ -1,11 +1,303 @@
 #include <gtk/gtk.h>
+#include "ui.h"
+
+/*
+ * The active route changes with every query so it is drawn live on top of the cached tiles
+ */
+static void draw_route_overlay(navigator_t * nav,cairo_t * cr){
+	const map_path_t * path = nav->map.active_path;
+	if(path == NULL || path->n_nodes < 2) return;
+
+	double x;
+	double y;
+	for(size_t i = 0;i < path->n_nodes;i++){
+		tile_cache_world_to_pixel(nav->tile_cache,nav->zoom_level,path->nodes[i]->coordinate,&x,&y);
+		if(i == 0){
+			cairo_move_to(cr,x - nav->view_x,y - nav->view_y);
+		}else{
+			cairo_line_to(cr,x - nav->view_x,y - nav->view_y);
+		}
+	}
+
+	cairo_set_line_cap(cr,CAIRO_LINE_CAP_ROUND);
+	cairo_set_line_join(cr,CAIRO_LINE_JOIN_ROUND);
+	cairo_set_line_width(cr,5.0);
+	cairo_set_source_rgba(cr,0.10,0.40,0.95,0.85);
+	cairo_stroke(cr);
+}
+
+/*
+ * The picture of the node picked last in the top left corner. Until it is decoded nothing is drawn, the image
+ * cache queues a redraw once it is ready.
+ */
+static void draw_selected_picture(navigator_t * nav,cairo_t * cr){
+	const map_node_t * node = (nav->map.active_end != NULL) ? nav->map.active_end : nav->map.active_start;
+	if(node == NULL || node->picture_file_path == NULL) return;
+
+	cached_image_t * image = get_cached_image(nav->image_cache,node->picture_file_path,IMAGE_SIZE_THUMBNAIL);
+	if(image == NULL) return;
+
+	//the pixels are already in cairo's layout, so the surface just borrows them while the image is held
+	const double margin = 10.0;
+	cairo_surface_t * surface = cairo_image_surface_create_for_data((unsigned char*) image->pixels,CAIRO_FORMAT_ARGB32,image->width,image->height,image->width*4);
+	cairo_set_source_surface(cr,surface,margin,margin);
+	cairo_paint(cr);
+	cairo_surface_destroy(surface);
+	release_cached_image(image);
+}
+
+/*
+ * Decode the pictures of the nodes on screen before any of them is picked
+ */
+static void prefetch_view_pictures(navigator_t * nav){
+	double width = gtk_widget_get_width(nav->drawing_area);
+	double height = gtk_widget_get_height(nav->drawing_area);
+	cord_t top_left = tile_cache_pixel_to_world(nav->tile_cache,nav->zoom_level,nav->view_x,nav->view_y);
+	cord_t bottom_right = tile_cache_pixel_to_world(nav->tile_cache,nav->zoom_level,nav->view_x + width,nav->view_y + height);
+	map_rect_t view = create_map_rect(create_cord(top_left.longitude,bottom_right.latitude),create_cord(bottom_right.longitude,top_left.latitude));
+	prefetch_map_rect_images(nav->image_cache,&(nav->map),view,IMAGE_SIZE_THUMBNAIL);
+}
+
+static void draw_map(GtkDrawingArea * area,cairo_t * cr,int width,int height,gpointer user_data){
+	navigator_t * nav = (navigator_t*) user_data;
+
+	cairo_set_source_rgb(cr,0.96,0.95,0.92);
+	cairo_paint(cr);
+
+	draw_tile_cache(nav->tile_cache,cr,nav->zoom_level,nav->view_x,nav->view_y,width,height);
+	draw_route_overlay(nav,cr);
+	draw_selected_picture(nav,cr);
+}
+
+static void drag_begin(GtkGestureDrag * gesture,double start_x,double start_y,gpointer user_data){
+	navigator_t * nav = (navigator_t*) user_data;
+
+	nav->drag_start_view_x = nav->view_x;
+	nav->drag_start_view_y = nav->view_y;
+}
+
+static void drag_end(GtkGestureDrag * gesture,double offset_x,double offset_y,gpointer user_data){
+	navigator_t * nav = (navigator_t*) user_data;
+
+	prefetch_view_pictures(nav);
+}
+
+static void drag_update(GtkGestureDrag * gesture,double offset_x,double offset_y,gpointer user_data){
+	navigator_t * nav = (navigator_t*) user_data;
+
+	//panning only moves the view, the tiles themselves are not re-rendered
+	nav->view_x = nav->drag_start_view_x - offset_x;
+	nav->view_y = nav->drag_start_view_y - offset_y;
+	gtk_widget_queue_draw(nav->drawing_area);
+}
+
+static gboolean scroll_zoom(GtkEventControllerScroll * controller,double dx,double dy,gpointer user_data){
+	navigator_t * nav = (navigator_t*) user_data;
+
+	int new_zoom_level = nav->zoom_level + ((dy < 0) ? 1 : -1);
+	if(new_zoom_level < TILE_CACHE_MIN_ZOOM || new_zoom_level > TILE_CACHE_MAX_ZOOM) return TRUE;
+
+	//keep the center of the view fixed while zooming
+	double half_width = gtk_widget_get_width(nav->drawing_area)/2.0;
+	double half_height = gtk_widget_get_height(nav->drawing_area)/2.0;
+	double factor = (new_zoom_level > nav->zoom_level) ? 2.0 : 0.5;
+
+	nav->view_x = (nav->view_x + half_width)*factor - half_width;
+	nav->view_y = (nav->view_y + half_height)*factor - half_height;
+	nav->zoom_level = new_zoom_level;
+
+	prefetch_view_pictures(nav);
+	gtk_widget_queue_draw(nav->drawing_area);
+	return TRUE;
+}
+
+typedef struct Route_Delivery{
+	navigator_t * nav;
+	route_result_t * result;
+} route_delivery_t;
+
+/*
+ * Runs on the main loop. Results of queries which were replaced while they were in flight are dropped.
+ */
+static gboolean deliver_route_result(gpointer user_data){
+	route_delivery_t * delivery = (route_delivery_t*) user_data;
+	navigator_t * nav = delivery->nav;
+	route_result_t * result = delivery->result;
+
+	if(result->generation == get_route_worker_generation(nav->route_worker)){
+		delete_map_path(nav->map.active_path);
+		nav->map.active_path = result->path;
+		result->path = NULL;
+
+		//the pictures along the route are the ones most likely to be picked next
+		if(nav->map.active_path != NULL) prefetch_map_path_images(nav->image_cache,nav->map.active_path,IMAGE_SIZE_THUMBNAIL);
+		gtk_widget_queue_draw(nav->drawing_area);
+	}
+
+	delete_route_result(result);
+	free(delivery);
+	return G_SOURCE_REMOVE;
+}
+
+/*
+ * Runs on the route worker thread, hands the result over to the main loop
+ */
+static void on_route_result(route_result_t * result,void * user_data){
+	route_delivery_t * delivery = (route_delivery_t*) malloc(sizeof(route_delivery_t));
+	delivery->nav = (navigator_t*) user_data;
+	delivery->result = result;
+
+	g_idle_add(deliver_route_result,delivery);
+}
+
+static gboolean redraw_for_picture(gpointer user_data){
+	navigator_t * nav = (navigator_t*) user_data;
+
+	if(nav->drawing_area != NULL) gtk_widget_queue_draw(nav->drawing_area);
+	return G_SOURCE_REMOVE;
+}
+
+/*
+ * Runs on the image cache thread, a picture that was asked for may be drawable now
+ */
+static void on_picture_ready(const char * path,uint8_t size,void * user_data){
+	g_idle_add(redraw_for_picture,user_data);
+}
+
+/*
+ * Ask the worker for a path between active_start and active_end. Anything still being searched is cancelled.
+ * dev-note: after editing the map release nav->graph and set it to NULL so a new snapshot is taken.
+ */
+static void request_active_route(navigator_t * nav){
+	delete_map_path(nav->map.active_path);
+	nav->map.active_path = NULL;
+
+	if(nav->map.active_start == NULL || nav->map.active_end == NULL){
+		cancel_route_queries(nav->route_worker);
+		return;
+	}
+
+	if(nav->graph == NULL) nav->graph = create_map_graph(&(nav->map));
+
+	submit_route_query(nav->route_worker,nav->graph,nav->map.active_start,nav->map.active_end,nav->map.active_edge_cost_function,compile_search_filter(&(nav->filter_options)));
+}
+
+/*
+ * The selectable node closest to a point on screen, NULL if none is within reach
+ */
+static map_node_t * pick_node(navigator_t * nav,double screen_x,double screen_y){
+	const double max_pick_distance_pixels = 12.0;
+
+	map_node_t * closest = NULL;
+	double closest_distance = max_pick_distance_pixels*max_pick_distance_pixels;
+
+	for(size_t i = 0;i < nav->map.n_nodes;i++){
+		if(!(nav->map.node_flags[i] & NODE_FLAG_SELECTABLE)) continue;
+		map_node_t * node = nav->map.all_nodes[i];
+
+		double x;
+		double y;
+		tile_cache_world_to_pixel(nav->tile_cache,nav->zoom_level,node->coordinate,&x,&y);
+		double dx = x - nav->view_x - screen_x;
+		double dy = y - nav->view_y - screen_y;
+		double distance = dx*dx + dy*dy;
+
+		if(distance <= closest_distance){
+			closest_distance = distance;
+			closest = node;
+		}
+	}
+
+	return closest;
+}
+
+/*
+ * The first click picks the start and the second click picks the end of the route
+ */
+static void click_select(GtkGestureClick * gesture,int n_press,double x,double y,gpointer user_data){
+	navigator_t * nav = (navigator_t*) user_data;
+
+	map_node_t * node = pick_node(nav,x,y);
+	if(node == NULL) return;
+
+	if(nav->map.active_start == NULL || nav->map.active_end != NULL){
+		nav->map.active_start = node;
+		nav->map.active_end = NULL;
+	}else{
+		nav->map.active_end = node;
+	}
+
+	request_active_route(nav);
+	gtk_widget_queue_draw(nav->drawing_area);
+}
+
+/*
+ * The tile cache is anchored to the map it was made for, so it is made again whenever the map is replaced and
+ * the view goes back to the top left corner of the new map.
+ */
+static void rebuild_tile_cache(navigator_t * nav){
+	delete_tile_cache(nav->tile_cache);
+	nav->tile_cache = create_tile_cache(&(nav->map),DEFAULT_MAX_CACHED_TILES);
+
+	nav->zoom_level = TILE_CACHE_MIN_ZOOM;
+	nav->view_x = 0.0;
+	nav->view_y = 0.0;
+	if(nav->drawing_area != NULL) gtk_widget_queue_draw(nav->drawing_area);
+}
+
+/*
+ * Replace the map with one read from a file. Queries on the old map are cancelled first since their results
+ * point at its nodes.
+ */
+static bool load_navigator_map(navigator_t * nav,const char * path){
+	cancel_route_queries(nav->route_worker);
+	release_map_graph(nav->graph);
+	nav->graph = NULL;
+
+	double (*edge_cost_function)(const map_edge_t * edge_ref) = nav->map.active_edge_cost_function;
+	clear_map(&(nav->map));
+	nav->map = init_map();
+	nav->map.active_edge_cost_function = edge_cost_function;
+
+	bool loaded = import_map_file(&(nav->map),path,NULL);
+	if(!loaded) fprintf(stderr,"could not read the map %s\n",path);
+
+	rebuild_tile_cache(nav);
+	return loaded;
+}
 
 static void activate (GtkApplication *app,gpointer user_data){
+	navigator_t * nav = (navigator_t*) user_data;
 	GtkWidget *window;
 
 	window = gtk_application_window_new (app);
 	gtk_window_set_title (GTK_WINDOW (window), "Window");
 	gtk_window_set_default_size (GTK_WINDOW (window), 200, 200);
+
+	if(nav->map_path != NULL){
+		load_navigator_map(nav,nav->map_path);
+	}else{
+		rebuild_tile_cache(nav);
+	}
+
+	nav->drawing_area = gtk_drawing_area_new();
+	gtk_drawing_area_set_draw_func(GTK_DRAWING_AREA(nav->drawing_area),draw_map,nav,NULL);
+
+	GtkGesture * drag = gtk_gesture_drag_new();
+	g_signal_connect(drag,"drag-begin",G_CALLBACK(drag_begin),nav);
+	g_signal_connect(drag,"drag-update",G_CALLBACK(drag_update),nav);
+	g_signal_connect(drag,"drag-end",G_CALLBACK(drag_end),nav);
+	gtk_widget_add_controller(nav->drawing_area,GTK_EVENT_CONTROLLER(drag));
+
+	GtkEventController * scroll = gtk_event_controller_scroll_new(GTK_EVENT_CONTROLLER_SCROLL_VERTICAL);
+	g_signal_connect(scroll,"scroll",G_CALLBACK(scroll_zoom),nav);
+	gtk_widget_add_controller(nav->drawing_area,scroll);
+
+	GtkGesture * click = gtk_gesture_click_new();
+	g_signal_connect(click,"pressed",G_CALLBACK(click_select),nav);
+	gtk_widget_add_controller(nav->drawing_area,GTK_EVENT_CONTROLLER(click));
+
+	gtk_window_set_child(GTK_WINDOW(window),nav->drawing_area);
 	gtk_window_present (GTK_WINDOW (window));
 }
 
@@ -13,10 +305,44 @@ int main (int argc,char **argv){
 	GtkApplication *app;
 	int status;
 
+	navigator_t nav;
+	nav.map = init_map();
+	nav.tile_cache = NULL;
+	nav.drawing_area = NULL;
+	nav.zoom_level = TILE_CACHE_MIN_ZOOM;
+	nav.view_x = 0.0;
+	nav.view_y = 0.0;
+	nav.drag_start_view_x = 0.0;
+	nav.drag_start_view_y = 0.0;
+	nav.graph = NULL;
+	nav.map.active_edge_cost_function = calculate_wheelchair_edge_cost;
+	nav.route_worker = create_route_worker(on_route_result,&nav);
+	nav.filter_options.start_position_text = NULL;
+	nav.filter_options.end_position_text = NULL;
+	nav.filter_options.exclude_stairs = false;
+	nav.filter_options.exclude_non_auto_doors = false;
+	nav.filter_options.exclude_interiors = false;
+	nav.image_cache = create_image_cache(DEFAULT_IMAGE_CACHE_BYTES,on_picture_ready,&nav);
+
+	//the first argument is the map to open, GTK gets the rest
+	nav.map_path = NULL;
+	if(argc > 1){
+		nav.map_path = argv[1];
+		argv[1] = argv[0];
+		argc--;
+		argv++;
+	}
+
 	app = gtk_application_new ("org.gtk.example", G_APPLICATION_DEFAULT_FLAGS);
-	g_signal_connect (app, "activate", G_CALLBACK (activate), NULL);
+	g_signal_connect (app, "activate", G_CALLBACK (activate), &nav);
 	status = g_application_run (G_APPLICATION (app), argc, argv);
 	g_object_unref (app);
 
+	delete_route_worker(nav.route_worker);
+	delete_image_cache(nav.image_cache);
+	release_map_graph(nav.graph);
+	delete_tile_cache(nav.tile_cache);
+	clear_map(&(nav.map));
+
 	return status;
 }
@@ -0,0 +1,146 @@
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+
+#include <gtk/gtk.h>
+#include "map.h"
+
+typedef struct Map_Tile map_tile_t;
+typedef struct Tile_Bucket tile_bucket_t;
+typedef struct Tile_Cache tile_cache_t;
+
+//width and height of a single tile in pixels
+#define TILE_SIZE_PIXELS 256
+
+//maximum number of rendered tiles kept in memory (256 tiles * 256KiB = 64MiB)
+#define DEFAULT_MAX_CACHED_TILES 256
+
+//zoom levels are powers of two, zoom 0 fits the whole map into a single tile
+#define TILE_CACHE_MIN_ZOOM 0
+#define TILE_CACHE_MAX_ZOOM 12
+
+//edges and MPOs are bucketed by the tiles of this zoom level, 16 by 16 buckets over the map at the time the cache was created
+#define TILE_CACHE_BUCKET_ZOOM 4
+#define TILE_CACHE_BUCKETS_PER_SIDE (1 << TILE_CACHE_BUCKET_ZOOM)
+
+//smallest width of a degree of longitude against a degree of latitude, so maps reaching a pole do not collapse
+#define TILE_CACHE_MIN_LONGITUDE_SCALE 0.01
+
+/*
+ * A pre-rendered square of the static map layers (MPOs and edges) at one zoom level.
+ */
+struct Map_Tile{
+	int zoom_level;
+	int64_t tile_x;
+	int64_t tile_y;
+
+	//ARGB32 image of the static layers, NULL until the tile is first rendered
+	cairo_surface_t * surface;
+
+	//false when an edit touched this tile and it needs to be re-rendered
+	bool valid;
+
+	//frame number of last use, used to evict the least recently used tile
+	uint64_t last_used_frame;
+
+	//next tile in the same hash slot, UINT32_MAX for the last one
+	uint32_t next_in_slot;
+};
+
+/*
+ * The edges and MPOs whose bounding rects overlap one square of the bucket grid. Things outside the grid
+ * are kept in the nearest bucket along its border.
+ */
+struct Tile_Bucket{
+	const map_edge_t ** edges;
+	size_t n_edges;
+	size_t max_edges;
+
+	//mpo_order[i] is when mpos[i] was added to the cache, polygons are painted oldest first like the map's MPO list
+	const mpo_t ** mpos;
+	uint64_t * mpo_order;
+	size_t n_mpos;
+	size_t max_mpos;
+};
+
+/*
+ * Caches rasterized tiles of the static map layers so that panning only composites images.
+ * Pixel space is anchored to the map bounding rect at the time the cache was created so
+ * tiles stay put while the map is being edited. When another map is loaded make a new cache.
+ */
+struct Tile_Cache{
+	const map_t * map;
+
+	//world coordinate which is pixel (0,0) at every zoom level
+	cord_t origin;
+
+	//pixels per degree of latitude at zoom level 0
+	double base_scale;
+
+	//cos of the latitude in the middle of the map, a degree of longitude is this much narrower than a degree of latitude
+	double longitude_scale;
+
+	//array of tiles
+	map_tile_t * tiles;
+	size_t n_tiles;
+	size_t max_tiles;
+
+	//first tile of every hash slot by zoom level and position, UINT32_MAX for an empty slot
+	uint32_t * tile_slots;
+	size_t tile_slot_mask;
+
+	uint64_t current_frame;
+
+	//TILE_CACHE_BUCKETS_PER_SIDE squared buckets row by row, so a tile is rendered from what is near it instead of the whole map
+	tile_bucket_t * buckets;
+	uint64_t next_mpo_order;
+
+	//statistics
+	size_t n_tile_renders;
+	size_t n_tile_hits;
+};
+
+//Create a tile cache for a map on the heap. The map must outlive the cache.
+tile_cache_t * create_tile_cache(const map_t * map,size_t max_tiles);
+
+//Free all tile images and the cache itself.
+void delete_tile_cache(tile_cache_t * cache);
+
+//Number of pixels per degree of latitude at a zoom level. A degree of longitude is longitude_scale times as wide.
+double get_tile_cache_scale(const tile_cache_t * cache,int zoom_level);
+
+//Convert a world coordinate into pixel space of a zoom level.
+void tile_cache_world_to_pixel(const tile_cache_t * cache,int zoom_level,cord_t cord,double * x_out,double * y_out);
+
+//Convert a pixel of a zoom level back into a world coordinate.
+cord_t tile_cache_pixel_to_world(const tile_cache_t * cache,int zoom_level,double x,double y);
+
+/*
+ * Composite all tiles which overlap the viewport onto cr. The viewport starts at pixel
+ * (view_x,view_y) of the zoom level and is width by height pixels. Missing or invalidated
+ * tiles are rendered on demand.
+ */
+void draw_tile_cache(tile_cache_t * cache,cairo_t * cr,int zoom_level,double view_x,double view_y,int width,int height);
+
+//Mark every cached tile which overlaps a region of the world as stale. Call this after an edit.
+void invalidate_tile_cache_region(tile_cache_t * cache,map_rect_t region);
+
+//Mark every cached tile as stale and bucket the whole map again. Use when the whole map was replaced.
+void invalidate_tile_cache(tile_cache_t * cache);
+
+/*
+ * Keep the buckets in step with edits of the map. An edge or MPO that was added is added to the cache, one that
+ * was deleted is removed with the bounding rect it had, and one that moved is removed with its old rect and added
+ * again. Both invalidate the tiles under the rect, so no other call to invalidate_tile_cache_region is needed.
+ */
+void add_edge_to_tile_cache(tile_cache_t * cache,const map_edge_t * edge);
+void remove_edge_from_tile_cache(tile_cache_t * cache,const map_edge_t * edge,map_rect_t old_rect);
+void add_mpo_to_tile_cache(tile_cache_t * cache,const mpo_t * mpo);
+void remove_mpo_from_tile_cache(tile_cache_t * cache,const mpo_t * mpo,map_rect_t old_rect);
+
+//Get the region of the world covered by an edge, use with invalidate_tile_cache_region.
+map_rect_t get_map_edge_bounding_rect(const map_edge_t * edge);
+
+//Get the region of the world covered by a map polygon object, use with invalidate_tile_cache_region.
+map_rect_t get_mpo_bounding_rect(const mpo_t * mpo);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef UI_H
+#define UI_H
+
+#include <gtk/gtk.h>
+#include "map.h"
+#include "tile_cache.h"
+#include "map_graph.h"
+#include "route_worker.h"
+#include "search_filter.h"
+#include "image_cache.h"
+#include "map_import.h"
+
+typedef struct Navigator navigator_t;
+
+/*
+ * Everything the navigator window needs to draw and pan the map
+ */
+struct Navigator{
+	map_t map;
+
+	//pre-rendered static layers
+	tile_cache_t * tile_cache;
+
+	GtkWidget * drawing_area;
+
+	//current zoom level of the tile cache
+	int zoom_level;
+
+	//pixel of the current zoom level shown at the top left of the drawing area
+	double view_x;
+	double view_y;
+
+	//view position when the current drag started
+	double drag_start_view_x;
+	double drag_start_view_y;
+
+	//snapshot of the map the route worker searches, retaken after edits
+	map_graph_t * graph;
+
+	//computes paths off the main loop
+	route_worker_t * route_worker;
+
+	//what the user wants routes to avoid
+	search_filter_options_t filter_options;
+
+	//node pictures decoded off the main loop
+	image_cache_t * image_cache;
+
+	//file the map is loaded from when the window opens, NULL for an empty map
+	const char * map_path;
+};
+
+#endif